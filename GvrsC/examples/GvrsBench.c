@@ -0,0 +1,903 @@
+/* --------------------------------------------------------------------
+ *
+ * The MIT License
+ *
+ * Copyright (C) 2024  Gary W. Lucas.
+
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ * ---------------------------------------------------------------------
+ */
+
+#include "GvrsFramework.h"
+#include "Gvrs.h"
+#include "GvrsBuilder.h"
+#include "GvrsCodec.h"
+#include "GvrsInterpolation.h"
+#include "GvrsError.h"
+#include <math.h>
+
+const char* usage[] = {
+
+	"Benchmark suite for the GVRS API",
+	"",
+	"Usage:  gvrs_bench [options]",
+	"",
+	"Options:",
+	"   -size <nRows> <nColumns>      dimensions of the synthetic rasters (default 1000 1000)",
+	"   -tile <nRows> <nColumns>      dimensions of the tiles (default 100 100)",
+	"   -n <count>                    operations for the point and interpolation tests (default 100000)",
+	"   -dir <path>                   folder for the temporary GVRS files (default .)",
+	"   -o <path>                     output file for the JSON results (default standard output)",
+	"   -seed <value>                 seed for the random-number generator (default 1)",
+	"   -keep                         keep the GVRS files after the benchmark completes",
+	"",
+	"The program generates six synthetic data sets: smooth terrain, terrain",
+	"with random noise, and sparse terrain (isolated populated blocks with fill",
+	"values elsewhere), each stored as both a float and an integer element.",
+	"For each data set, it measures the time required to build the file",
+	"(write all cells and close), random point reads, block reads,",
+	"B-spline interpolation, open/close, and the encoding and decoding of",
+	"tile data by each of the registered codecs.  A final test measures",
+	"checksum throughput.",
+	"",
+	"Results are written as JSON. Each result gives the number of operations,",
+	"the elapsed time, the throughput, and the latency percentiles for",
+	"individual operations in microseconds.  The output is intended to be",
+	"archived and compared between releases to detect performance regressions.",
+	0
+};
+
+typedef enum {
+	PatternTerrain = 0,
+	PatternNoisy,
+	PatternSparse
+} DataPattern;
+
+typedef struct DatasetSpecTag {
+	const char* name;
+	DataPattern pattern;
+	int integral;
+}DatasetSpec;
+
+static const DatasetSpec datasets[] = {
+	{ "terrain-float", PatternTerrain, 0 },
+	{ "terrain-int",   PatternTerrain, 1 },
+	{ "noisy-float",   PatternNoisy,   0 },
+	{ "noisy-int",     PatternNoisy,   1 },
+	{ "sparse-float",  PatternSparse,  0 },
+	{ "sparse-int",    PatternSparse,  1 },
+};
+#define N_DATASETS (int)(sizeof(datasets)/sizeof(datasets[0]))
+
+typedef struct BenchConfigTag {
+	int nRows;
+	int nCols;
+	int nRowsInTile;
+	int nColsInTile;
+	int nOperations;
+	uint64_t seed;
+	const char* folder;
+	const char* outputPath;
+	int keepFiles;
+}BenchConfig;
+
+// The results are collected as the tests run and written
+// when all tests are complete.  Individual latencies are
+// retained only long enough to compute the percentiles.
+#define MAX_RESULTS 128
+
+typedef struct BenchResultTag {
+	char benchmark[48];
+	char dataset[24];
+	int64_t nOperations;
+	int64_t nBytes;
+	int64_t elapsedNS;
+	int isEncoding;           // non-zero for codec encoding tests
+	int64_t nCompressed;      // for encoding tests, the number of tiles the codec reduced in size
+	double compressionRatio;  // for encoding tests, uncompressed to compressed size of those tiles
+	double latencyMean;       // all latencies in microseconds
+	double latencyP50;
+	double latencyP90;
+	double latencyP99;
+	double latencyP999;
+	double latencyMax;
+}BenchResult;
+
+static BenchResult results[MAX_RESULTS];
+static int nResults;
+
+typedef struct LatencySamplesTag {
+	int64_t time0;
+	int nSamples;
+	int nSamplesAllocated;
+	int64_t* samples;
+}LatencySamples;
+
+
+static int64_t nextRandom(uint64_t* state) {
+	// xorshift64*, adequate for choosing test coordinates
+	uint64_t x = *state;
+	x ^= x >> 12;
+	x ^= x << 25;
+	x ^= x >> 27;
+	*state = x;
+	return (int64_t)((x * 0x2545F4914F6CDD1DULL) >> 1);
+}
+
+static uint64_t hashCell(uint64_t seed, int row, int col) {
+	// splitmix64 finalizer applied to the cell coordinates
+	uint64_t z = seed + ((uint64_t)(uint32_t)row << 32) + (uint32_t)col + 0x9E3779B97F4A7C15ULL;
+	z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+	z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+	return z ^ (z >> 31);
+}
+
+/**
+* Computes the synthetic value for a cell.  The terrain pattern is a sum of
+* sinusoids at several scales (a few hundred meters of relief).  The noisy
+* pattern adds uniform noise with an amplitude of 25 units.  The sparse pattern
+* uses the terrain values within randomly selected 32-by-32 blocks
+* (about 10 percent of the raster) and leaves the remaining cells unwritten.
+* @return one if the cell is populated; zero if it should retain the fill value.
+*/
+static int syntheticValue(DataPattern pattern, uint64_t seed, int row, int col, double* value) {
+	double x = col;
+	double y = row;
+	double z = 500
+		+ 200 * sin(x / 157.0) * cos(y / 211.0)
+		+ 60 * sin((x + y) / 53.0)
+		+ 15 * cos((x - 2 * y) / 17.0)
+		+ 4 * sin(x / 5.3) * sin(y / 6.1);
+	if (pattern == PatternNoisy) {
+		double u = (double)(hashCell(seed, row, col) >> 11) / 9007199254740992.0;
+		z += 50 * (u - 0.5);
+	}
+	else if (pattern == PatternSparse) {
+		if ((hashCell(seed, row >> 5, col >> 5) % 10) != 0) {
+			return 0;
+		}
+	}
+	*value = z;
+	return 1;
+}
+
+static int samplesInit(LatencySamples* s, int nSamples) {
+	memset(s, 0, sizeof(LatencySamples));
+	s->samples = (int64_t*)malloc((nSamples > 0 ? nSamples : 1) * sizeof(int64_t));
+	if (!s->samples) {
+		return GVRSERR_NOMEM;
+	}
+	s->nSamplesAllocated = nSamples;
+	return 0;
+}
+
+static void samplesStart(LatencySamples* s) {
+	s->time0 = GvrsTimeNS();
+}
+
+static void samplesStop(LatencySamples* s) {
+	if (s->nSamples < s->nSamplesAllocated) {
+		s->samples[s->nSamples++] = GvrsTimeNS() - s->time0;
+	}
+}
+
+static int compareSamples(const void* a, const void* b) {
+	int64_t x = *(const int64_t*)a;
+	int64_t y = *(const int64_t*)b;
+	return x < y ? -1 : (x > y ? 1 : 0);
+}
+
+static double percentile(LatencySamples* s, double p) {
+	// nearest-rank method on the sorted samples
+	if (s->nSamples == 0) {
+		return 0;
+	}
+	int k = (int)ceil(p * s->nSamples) - 1;
+	if (k < 0) {
+		k = 0;
+	}
+	else if (k >= s->nSamples) {
+		k = s->nSamples - 1;
+	}
+	return s->samples[k] / 1000.0;
+}
+
+/**
+* Adds a result to the collection, computing the latency statistics
+* from the samples and releasing their memory.
+*/
+static BenchResult* addResult(const char* benchmark, const char* dataset,
+	int64_t nOperations, int64_t nBytes, int64_t elapsedNS, LatencySamples* s) {
+	BenchResult* r = 0;
+	if (nResults < MAX_RESULTS) {
+		r = results + nResults++;
+		memset(r, 0, sizeof(BenchResult));
+		GvrsStrncpy(r->benchmark, sizeof(r->benchmark), benchmark);
+		GvrsStrncpy(r->dataset, sizeof(r->dataset), dataset);
+		r->nOperations = nOperations;
+		r->nBytes = nBytes;
+		r->elapsedNS = elapsedNS;
+		if (s->nSamples > 0) {
+			double sum = 0;
+			for (int i = 0; i < s->nSamples; i++) {
+				sum += s->samples[i];
+			}
+			qsort(s->samples, s->nSamples, sizeof(int64_t), compareSamples);
+			r->latencyMean = sum / s->nSamples / 1000.0;
+			r->latencyP50 = percentile(s, 0.50);
+			r->latencyP90 = percentile(s, 0.90);
+			r->latencyP99 = percentile(s, 0.99);
+			r->latencyP999 = percentile(s, 0.999);
+			r->latencyMax = s->samples[s->nSamples - 1] / 1000.0;
+		}
+	}
+	free(s->samples);
+	memset(s, 0, sizeof(LatencySamples));
+	return r;
+}
+
+static void makePath(const BenchConfig* cfg, const DatasetSpec* spec, char* path, size_t pathSize) {
+	snprintf(path, pathSize, "%s/gvrs_bench_%s.gvrs", cfg->folder, spec->name);
+}
+
+/**
+* Creates the file for a data set, writing every populated cell in
+* row-major order.  The elapsed time includes the close operation, which
+* flushes the tile cache and computes checksums.  Latency is
+* recorded for each row of the raster.
+*/
+static int benchBuild(const BenchConfig* cfg, const DatasetSpec* spec, const char* path) {
+	GvrsBuilder* builder;
+	GvrsElementSpec* eSpec;
+	Gvrs* gvrs;
+	int status = GvrsBuilderInit(&builder, cfg->nRows, cfg->nCols);
+	if (status) {
+		return status;
+	}
+	GvrsBuilderSetTileSize(builder, cfg->nRowsInTile, cfg->nColsInTile);
+	GvrsBuilderSetChecksumEnabled(builder, 1);
+	GvrsBuilderRegisterStandardDataCompressionCodecs(builder);
+	if (spec->integral) {
+		status = GvrsBuilderAddElementInt(builder, "z", &eSpec);
+	}
+	else {
+		status = GvrsBuilderAddElementFloat(builder, "z", &eSpec);
+	}
+	if (status) {
+		GvrsBuilderFree(builder);
+		return status;
+	}
+
+	LatencySamples s;
+	status = samplesInit(&s, cfg->nRows);
+	if (status) {
+		GvrsBuilderFree(builder);
+		return status;
+	}
+
+	int64_t time0 = GvrsTimeNS();
+	status = GvrsBuilderOpenNewGvrs(builder, path, &gvrs);
+	GvrsBuilderFree(builder);
+	if (status) {
+		free(s.samples);
+		return status;
+	}
+	// A large cache holds a full row of tiles, so each tile is written once
+	GvrsSetTileCacheSize(gvrs, GvrsTileCacheSizeLarge);
+	GvrsElement* e = GvrsGetElementByIndex(gvrs, 0);
+	int64_t nCellsWritten = 0;
+	double v;
+	for (int iRow = 0; iRow < cfg->nRows && !status; iRow++) {
+		samplesStart(&s);
+		for (int iCol = 0; iCol < cfg->nCols; iCol++) {
+			if (syntheticValue(spec->pattern, cfg->seed, iRow, iCol, &v)) {
+				if (spec->integral) {
+					status = GvrsElementWriteInt(e, iRow, iCol, (int32_t)floor(v + 0.5));
+				}
+				else {
+					status = GvrsElementWriteFloat(e, iRow, iCol, (float)v);
+				}
+				if (status) {
+					break;
+				}
+				nCellsWritten++;
+			}
+		}
+		samplesStop(&s);
+	}
+	int closeStatus = GvrsClose(gvrs);
+	int64_t elapsed = GvrsTimeNS() - time0;
+	if (status || closeStatus) {
+		free(s.samples);
+		return status ? status : closeStatus;
+	}
+	addResult("build", spec->name, nCellsWritten, nCellsWritten * 4, elapsed, &s);
+	return 0;
+}
+
+static int openForReading(const char* path, GvrsTileCacheSizeType cacheSize, Gvrs** gvrs, GvrsElement** e) {
+	int status = GvrsOpen(gvrs, path, "r");
+	if (status) {
+		return status;
+	}
+	GvrsSetTileCacheSize(*gvrs, cacheSize);
+	*e = GvrsGetElementByIndex(*gvrs, 0);
+	if (!*e) {
+		GvrsClose(*gvrs);
+		return GVRSERR_ELEMENT_NOT_FOUND;
+	}
+	return 0;
+}
+
+/**
+* Reads individual cells at random positions.  Because the positions are
+* uniformly distributed, the latency percentiles separate tile-cache hits
+* from tile reads.
+*/
+static int benchRandomPoint(const BenchConfig* cfg, const DatasetSpec* spec, const char* path) {
+	Gvrs* gvrs;
+	GvrsElement* e;
+	LatencySamples s;
+	int status = openForReading(path, GvrsTileCacheSizeMedium, &gvrs, &e);
+	if (status) {
+		return status;
+	}
+	status = samplesInit(&s, cfg->nOperations);
+	if (status) {
+		GvrsClose(gvrs);
+		return status;
+	}
+	uint64_t state = cfg->seed * 2654435761ULL + 1;
+	int32_t iValue;
+	float fValue;
+	int64_t time0 = GvrsTimeNS();
+	for (int i = 0; i < cfg->nOperations; i++) {
+		int row = (int)(nextRandom(&state) % cfg->nRows);
+		int col = (int)(nextRandom(&state) % cfg->nCols);
+		samplesStart(&s);
+		if (spec->integral) {
+			status = GvrsElementReadInt(e, row, col, &iValue);
+		}
+		else {
+			status = GvrsElementReadFloat(e, row, col, &fValue);
+		}
+		samplesStop(&s);
+		if (status) {
+			break;
+		}
+	}
+	int64_t elapsed = GvrsTimeNS() - time0;
+	GvrsClose(gvrs);
+	if (status) {
+		free(s.samples);
+		return status;
+	}
+	addResult("random-point-read", spec->name, cfg->nOperations, (int64_t)cfg->nOperations * 4, elapsed, &s);
+	return 0;
+}
+
+/**
+* Reads 64-by-64 blocks of cells at random positions, one value at a time.
+* Latency is recorded for each block.
+*/
+static int benchBlock(const BenchConfig* cfg, const DatasetSpec* spec, const char* path) {
+	Gvrs* gvrs;
+	GvrsElement* e;
+	LatencySamples s;
+	int nRowsInBlock = cfg->nRows < 64 ? cfg->nRows : 64;
+	int nColsInBlock = cfg->nCols < 64 ? cfg->nCols : 64;
+	int nBlocks = cfg->nOperations / (nRowsInBlock * nColsInBlock);
+	if (nBlocks < 16) {
+		nBlocks = 16;
+	}
+	int status = openForReading(path, GvrsTileCacheSizeMedium, &gvrs, &e);
+	if (status) {
+		return status;
+	}
+	status = samplesInit(&s, nBlocks);
+	if (status) {
+		GvrsClose(gvrs);
+		return status;
+	}
+	uint64_t state = cfg->seed * 40503ULL + 7;
+	int32_t iValue;
+	float fValue;
+	int64_t time0 = GvrsTimeNS();
+	for (int i = 0; i < nBlocks && !status; i++) {
+		int row0 = (int)(nextRandom(&state) % (cfg->nRows - nRowsInBlock + 1));
+		int col0 = (int)(nextRandom(&state) % (cfg->nCols - nColsInBlock + 1));
+		samplesStart(&s);
+		for (int iRow = row0; iRow < row0 + nRowsInBlock && !status; iRow++) {
+			for (int iCol = col0; iCol < col0 + nColsInBlock; iCol++) {
+				if (spec->integral) {
+					status = GvrsElementReadInt(e, iRow, iCol, &iValue);
+				}
+				else {
+					status = GvrsElementReadFloat(e, iRow, iCol, &fValue);
+				}
+				if (status) {
+					break;
+				}
+			}
+		}
+		samplesStop(&s);
+	}
+	int64_t elapsed = GvrsTimeNS() - time0;
+	GvrsClose(gvrs);
+	if (status) {
+		free(s.samples);
+		return status;
+	}
+	int64_t nCells = (int64_t)nBlocks * nRowsInBlock * nColsInBlock;
+	addResult("block-read", spec->name, nBlocks, nCells * 4, elapsed, &s);
+	return 0;
+}
+
+/**
+* Performs B-spline interpolations, with first derivatives, at random
+* positions in the interior of the raster.
+*/
+static int benchInterpolation(const BenchConfig* cfg, const DatasetSpec* spec, const char* path) {
+	Gvrs* gvrs;
+	GvrsElement* e;
+	LatencySamples s;
+	GvrsInterpolationResult result;
+	int status = openForReading(path, GvrsTileCacheSizeMedium, &gvrs, &e);
+	if (status) {
+		return status;
+	}
+	status = samplesInit(&s, cfg->nOperations);
+	if (status) {
+		GvrsClose(gvrs);
+		return status;
+	}
+	uint64_t state = cfg->seed * 69069ULL + 11;
+	double x, y;
+	int64_t time0 = GvrsTimeNS();
+	for (int i = 0; i < cfg->nOperations; i++) {
+		double row = 1 + (nextRandom(&state) % 1000000) * (cfg->nRows - 3) / 1000000.0;
+		double col = 1 + (nextRandom(&state) % 1000000) * (cfg->nCols - 3) / 1000000.0;
+		GvrsMapGridToModel(gvrs, row, col, &x, &y);
+		samplesStart(&s);
+		status = GvrsInterpolateBspline(e, x, y, 1, &result);
+		samplesStop(&s);
+		if (status) {
+			break;
+		}
+	}
+	int64_t elapsed = GvrsTimeNS() - time0;
+	GvrsClose(gvrs);
+	if (status) {
+		free(s.samples);
+		return status;
+	}
+	addResult("interpolation", spec->name, cfg->nOperations, 0, elapsed, &s);
+	return 0;
+}
+
+/**
+* Opens and closes the file repeatedly.  The operation includes reading
+* the header and element definitions, but not the tile data.
+*/
+static int benchOpenClose(const DatasetSpec* spec, const char* path) {
+	LatencySamples s;
+	int nRepeats = 200;
+	int status = samplesInit(&s, nRepeats);
+	if (status) {
+		return status;
+	}
+	int64_t time0 = GvrsTimeNS();
+	for (int i = 0; i < nRepeats; i++) {
+		Gvrs* gvrs;
+		samplesStart(&s);
+		status = GvrsOpen(&gvrs, path, "r");
+		if (status) {
+			break;
+		}
+		status = GvrsClose(gvrs);
+		samplesStop(&s);
+		if (status) {
+			break;
+		}
+	}
+	int64_t elapsed = GvrsTimeNS() - time0;
+	if (status) {
+		free(s.samples);
+		return status;
+	}
+	addResult("open-close", spec->name, nRepeats, 0, elapsed, &s);
+	return 0;
+}
+
+static int allocateStandardCodecs(GvrsCodec** codecs) {
+	// The order matches GvrsBuilderRegisterStandardDataCompressionCodecs,
+	// so the position of each codec is also the index it would be assigned in a file.
+	int n = 0;
+	codecs[n++] = GvrsCodecHuffmanAlloc();
+#ifdef GVRS_ZLIB
+	codecs[n++] = GvrsCodecDeflateAlloc();
+	codecs[n++] = GvrsCodecFloatAlloc();
+	codecs[n++] = GvrsCodecLsopAlloc();
+#endif
+	return n;
+}
+
+/**
+* Encodes and decodes the populated, full-sized tiles of a data set with each
+* standard codec that supports the data type, calling the codec functions
+* directly.  The tile data is read from the file beforehand so that the
+* measurements exclude file access.  Latency is recorded per tile.
+*/
+static int benchCodecs(const DatasetSpec* spec, const char* path) {
+	Gvrs* gvrs;
+	GvrsElement* e;
+	int status = openForReading(path, GvrsTileCacheSizeSmall, &gvrs, &e);
+	if (status) {
+		return status;
+	}
+
+	int nRowsInTile = gvrs->nRowsInTile;
+	int nColsInTile = gvrs->nColsInTile;
+	int nCellsInTile = nRowsInTile * nColsInTile;
+	int nRowsOfFullTiles = gvrs->nRowsInRaster / nRowsInTile;
+	int nColsOfFullTiles = gvrs->nColsInRaster / nColsInTile;
+	int nTilesAllocated = nRowsOfFullTiles * nColsOfFullTiles;
+	size_t tileSize = (size_t)nCellsInTile * 4;
+	uint8_t* tileData = (uint8_t*)malloc((nTilesAllocated > 0 ? nTilesAllocated : 1) * tileSize);
+	uint8_t** packings = (uint8_t**)calloc((nTilesAllocated > 0 ? nTilesAllocated : 1), sizeof(uint8_t*));
+	int* packingLengths = (int*)calloc((nTilesAllocated > 0 ? nTilesAllocated : 1), sizeof(int));
+	uint8_t* output = (uint8_t*)malloc(tileSize);
+	if (!tileData || !packings || !packingLengths || !output) {
+		free(tileData);
+		free(packings);
+		free(packingLengths);
+		free(output);
+		GvrsClose(gvrs);
+		return GVRSERR_NOMEM;
+	}
+
+	int nTiles = 0;
+	for (int tileRow = 0; tileRow < nRowsOfFullTiles && !status; tileRow++) {
+		for (int tileCol = 0; tileCol < nColsOfFullTiles && !status; tileCol++) {
+			if (!GvrsIsTilePopulated(gvrs, tileRow * gvrs->nColsOfTiles + tileCol)) {
+				continue;
+			}
+			uint8_t* p = tileData + nTiles * tileSize;
+			int k = 0;
+			for (int iRow = 0; iRow < nRowsInTile && !status; iRow++) {
+				int row = tileRow * nRowsInTile + iRow;
+				for (int iCol = 0; iCol < nColsInTile; iCol++) {
+					int col = tileCol * nColsInTile + iCol;
+					if (spec->integral) {
+						status = GvrsElementReadInt(e, row, col, (int32_t*)p + k);
+					}
+					else {
+						status = GvrsElementReadFloat(e, row, col, (float*)p + k);
+					}
+					if (status) {
+						break;
+					}
+					k++;
+				}
+			}
+			nTiles++;
+		}
+	}
+	GvrsClose(gvrs);
+
+	GvrsCodec* codecs[8];
+	int nCodecs = allocateStandardCodecs(codecs);
+	char name[64];
+	for (int iCodec = 0; iCodec < nCodecs && !status && nTiles > 0; iCodec++) {
+		GvrsCodec* codec = codecs[iCodec];
+		if (!codec) {
+			continue;
+		}
+		int canEncode = spec->integral ? codec->encodeInt != 0 : codec->encodeFloat != 0;
+		if (!canEncode) {
+			continue;
+		}
+		LatencySamples s;
+		status = samplesInit(&s, nTiles);
+		if (status) {
+			break;
+		}
+		int64_t nBytesEncoded = 0;
+		int nEncoded = 0;
+		int64_t time0 = GvrsTimeNS();
+		for (int iTile = 0; iTile < nTiles; iTile++) {
+			uint8_t* p = tileData + iTile * tileSize;
+			samplesStart(&s);
+			int encodeStatus;
+			if (spec->integral) {
+				encodeStatus = codec->encodeInt(nRowsInTile, nColsInTile, (int32_t*)p, iCodec, packingLengths + iTile, packings + iTile, codec->appInfo);
+			}
+			else {
+				encodeStatus = codec->encodeFloat(nRowsInTile, nColsInTile, (float*)p, iCodec, packingLengths + iTile, packings + iTile, codec->appInfo);
+			}
+			samplesStop(&s);
+			if (encodeStatus == GVRSERR_COMPRESSION_FAILURE) {
+				// the codec could not reduce the size of the data (a normal outcome)
+				packings[iTile] = 0;
+				packingLengths[iTile] = 0;
+			}
+			else if (encodeStatus) {
+				status = encodeStatus;
+				break;
+			}
+			else {
+				nBytesEncoded += packingLengths[iTile];
+				nEncoded++;
+			}
+		}
+		int64_t elapsed = GvrsTimeNS() - time0;
+		snprintf(name, sizeof(name), "encode-%s", codec->identification);
+		BenchResult* r = addResult(name, spec->name, nTiles, (int64_t)nTiles * tileSize, elapsed, &s);
+		if (r) {
+			r->isEncoding = 1;
+			r->nCompressed = nEncoded;
+			if (nBytesEncoded > 0) {
+				r->compressionRatio = (double)nEncoded * tileSize / (double)nBytesEncoded;
+			}
+		}
+
+		int canDecode = spec->integral ? codec->decodeInt != 0 : codec->decodeFloat != 0;
+		if (!status && nEncoded > 0 && canDecode) {
+			status = samplesInit(&s, nEncoded);
+			time0 = GvrsTimeNS();
+			for (int iTile = 0; iTile < nTiles && !status; iTile++) {
+				if (!packings[iTile]) {
+					continue;
+				}
+				samplesStart(&s);
+				if (spec->integral) {
+					status = codec->decodeInt(nRowsInTile, nColsInTile, packingLengths[iTile], packings[iTile], (int32_t*)output, codec->appInfo);
+				}
+				else {
+					status = codec->decodeFloat(nRowsInTile, nColsInTile, packingLengths[iTile], packings[iTile], (float*)output, codec->appInfo);
+				}
+				samplesStop(&s);
+				if (!status && memcmp(output, tileData + iTile * tileSize, tileSize)) {
+					fprintf(stderr, "Decoded data does not match the source for codec %s, data set %s\n",
+						codec->identification, spec->name);
+					status = GVRSERR_COMPRESSION_FAILURE;
+				}
+			}
+			elapsed = GvrsTimeNS() - time0;
+			snprintf(name, sizeof(name), "decode-%s", codec->identification);
+			if (status) {
+				free(s.samples);
+			}
+			else {
+				addResult(name, spec->name, nEncoded, (int64_t)nEncoded * tileSize, elapsed, &s);
+			}
+		}
+		for (int iTile = 0; iTile < nTiles; iTile++) {
+			free(packings[iTile]);
+			packings[iTile] = 0;
+		}
+	}
+
+	for (int iCodec = 0; iCodec < nCodecs; iCodec++) {
+		if (codecs[iCodec] && codecs[iCodec]->destroyCodec) {
+			codecs[iCodec]->destroyCodec(codecs[iCodec]);
+		}
+	}
+	free(tileData);
+	free(packings);
+	free(packingLengths);
+	free(output);
+	return status;
+}
+
+/**
+* Measures the throughput of the checksum computation that is applied to
+* each record when checksums are enabled.  Latency is recorded per
+* 64 KB block.
+*/
+static int benchChecksum(const BenchConfig* cfg) {
+	int nBytesInBlock = 65536;
+	int nBlocks = 1024;
+	LatencySamples s;
+	uint8_t* block = (uint8_t*)malloc(nBytesInBlock);
+	if (!block) {
+		return GVRSERR_NOMEM;
+	}
+	int status = samplesInit(&s, nBlocks);
+	if (status) {
+		free(block);
+		return status;
+	}
+	uint64_t state = cfg->seed + 17;
+	for (int i = 0; i < nBytesInBlock; i++) {
+		block[i] = (uint8_t)nextRandom(&state);
+	}
+	unsigned long crc = 0;
+	int64_t time0 = GvrsTimeNS();
+	for (int i = 0; i < nBlocks; i++) {
+		samplesStart(&s);
+		crc = GvrsChecksumUpdateArray(block, 0, nBytesInBlock, crc);
+		samplesStop(&s);
+	}
+	int64_t elapsed = GvrsTimeNS() - time0;
+	free(block);
+	if (crc == 0) {
+		// prevents the compiler from eliminating the loop
+		fprintf(stderr, "Unexpected zero checksum\n");
+	}
+	addResult("checksum", "random-bytes", nBlocks, (int64_t)nBlocks * nBytesInBlock, elapsed, &s);
+	return 0;
+}
+
+static void writeResults(const BenchConfig* cfg, FILE* fp) {
+	fprintf(fp, "{\n");
+	fprintf(fp, "  \"program\": \"gvrs_bench\",\n");
+	fprintf(fp, "  \"configuration\": {\"nRows\": %d, \"nColumns\": %d, \"nRowsInTile\": %d, \"nColumnsInTile\": %d, \"nOperations\": %d, \"seed\": %llu},\n",
+		cfg->nRows, cfg->nCols, cfg->nRowsInTile, cfg->nColsInTile, cfg->nOperations, (unsigned long long)cfg->seed);
+	fprintf(fp, "  \"results\": [");
+	for (int i = 0; i < nResults; i++) {
+		BenchResult* r = results + i;
+		double seconds = r->elapsedNS / 1.0e9;
+		fprintf(fp, "%s\n    {\"benchmark\": \"%s\", \"dataset\": \"%s\", \"operations\": %lld, \"seconds\": %.6f",
+			i == 0 ? "" : ",", r->benchmark, r->dataset, (long long)r->nOperations, seconds);
+		fprintf(fp, ", \"operationsPerSecond\": %.1f", seconds > 0 ? r->nOperations / seconds : 0.0);
+		if (r->nBytes > 0) {
+			fprintf(fp, ", \"megabytesPerSecond\": %.3f", seconds > 0 ? r->nBytes / seconds / 1.0e6 : 0.0);
+		}
+		if (r->isEncoding) {
+			fprintf(fp, ", \"tilesCompressed\": %lld", (long long)r->nCompressed);
+			if (r->compressionRatio > 0) {
+				fprintf(fp, ", \"compressionRatio\": %.4f", r->compressionRatio);
+			}
+		}
+		fprintf(fp, ",\n      \"latencyMicroseconds\": {\"mean\": %.3f, \"p50\": %.3f, \"p90\": %.3f, \"p99\": %.3f, \"p999\": %.3f, \"max\": %.3f}}",
+			r->latencyMean, r->latencyP50, r->latencyP90, r->latencyP99, r->latencyP999, r->latencyMax);
+	}
+	fprintf(fp, "\n  ]\n}\n");
+}
+
+static int parseInt(int argc, char* argv[], int i, int* value) {
+	if (i >= argc) {
+		fprintf(stderr, "Missing value for option %s\n", argv[i - 1]);
+		return 0;
+	}
+	*value = atoi(argv[i]);
+	if (*value <= 0) {
+		fprintf(stderr, "Invalid value for option %s: %s\n", argv[i - 1], argv[i]);
+		return 0;
+	}
+	return 1;
+}
+
+/**
+* Runs the GVRS benchmark suite and writes the results as JSON.
+* @param argc the number of command-line arguments, including command vector, always one or greater.
+* @param argv the command vector giving the options described in the usage text.
+* @return zero on successful completion; otherwise, a non-zero value.
+*/
+int main(int argc, char* argv[]) {
+	BenchConfig cfg;
+	memset(&cfg, 0, sizeof(cfg));
+	cfg.nRows = 1000;
+	cfg.nCols = 1000;
+	cfg.nRowsInTile = 100;
+	cfg.nColsInTile = 100;
+	cfg.nOperations = 100000;
+	cfg.seed = 1;
+	cfg.folder = ".";
+
+	for (int i = 1; i < argc; i++) {
+		const char* arg = argv[i];
+		int ok = 1;
+		if (strcmp(arg, "-size") == 0) {
+			ok = parseInt(argc, argv, ++i, &cfg.nRows) && parseInt(argc, argv, ++i, &cfg.nCols);
+		}
+		else if (strcmp(arg, "-tile") == 0) {
+			ok = parseInt(argc, argv, ++i, &cfg.nRowsInTile) && parseInt(argc, argv, ++i, &cfg.nColsInTile);
+		}
+		else if (strcmp(arg, "-n") == 0) {
+			ok = parseInt(argc, argv, ++i, &cfg.nOperations);
+		}
+		else if (strcmp(arg, "-seed") == 0) {
+			int seed;
+			ok = parseInt(argc, argv, ++i, &seed);
+			cfg.seed = (uint64_t)seed;
+		}
+		else if (strcmp(arg, "-dir") == 0 && i + 1 < argc) {
+			cfg.folder = argv[++i];
+		}
+		else if (strcmp(arg, "-o") == 0 && i + 1 < argc) {
+			cfg.outputPath = argv[++i];
+		}
+		else if (strcmp(arg, "-keep") == 0) {
+			cfg.keepFiles = 1;
+		}
+		else {
+			ok = 0;
+		}
+		if (!ok) {
+			const char** p = usage;
+			while (*p) {
+				fprintf(stderr, "%s\n", *p);
+				p++;
+			}
+			exit(1);
+		}
+	}
+	if (cfg.nRows < 4 || cfg.nCols < 4) {
+		fprintf(stderr, "The raster must be at least 4 by 4 cells\n");
+		exit(1);
+	}
+
+	char path[1024];
+	int status = 0;
+	for (int iSet = 0; iSet < N_DATASETS && !status; iSet++) {
+		const DatasetSpec* spec = datasets + iSet;
+		makePath(&cfg, spec, path, sizeof(path));
+		fprintf(stderr, "Running benchmarks for %s\n", spec->name);
+		const char* testName = "build";
+		status = benchBuild(&cfg, spec, path);
+		if (!status) {
+			testName = "random-point-read";
+			status = benchRandomPoint(&cfg, spec, path);
+		}
+		if (!status) {
+			testName = "block-read";
+			status = benchBlock(&cfg, spec, path);
+		}
+		if (!status) {
+			testName = "interpolation";
+			status = benchInterpolation(&cfg, spec, path);
+		}
+		if (!status) {
+			testName = "open-close";
+			status = benchOpenClose(spec, path);
+		}
+		if (!status) {
+			testName = "codecs";
+			status = benchCodecs(spec, path);
+		}
+		if (status) {
+			fprintf(stderr, "Benchmark %s failed for %s with error %d\n", testName, spec->name, status);
+		}
+		if (!cfg.keepFiles) {
+			remove(path);
+		}
+	}
+	if (!status) {
+		status = benchChecksum(&cfg);
+	}
+	if (status) {
+		exit(1);
+	}
+
+	if (cfg.outputPath) {
+		FILE* fp = fopen(cfg.outputPath, "w");
+		if (!fp) {
+			fprintf(stderr, "Unable to open output file %s\n", cfg.outputPath);
+			exit(1);
+		}
+		writeResults(&cfg, fp);
+		fclose(fp);
+	}
+	else {
+		writeResults(&cfg, stdout);
+	}
+	exit(0);
+}
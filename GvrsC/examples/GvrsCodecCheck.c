@@ -0,0 +1,573 @@
+/* --------------------------------------------------------------------
+ *
+ * The MIT License
+ *
+ * Copyright (C) 2024  Gary W. Lucas.
+
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ * ---------------------------------------------------------------------
+ */
+
+#include "GvrsFramework.h"
+#include "Gvrs.h"
+#include "GvrsCodec.h"
+#include "GvrsStatistics.h"
+#include "GvrsError.h"
+#include <math.h>
+
+const char* usage[] = {
+
+	"Codec conformance and performance check using the GVRS sample files",
+	"",
+	"Usage:  gvrs_codec_check <samples folder> [-repeat n] [-json path]",
+	"",
+	"The samples folder is normally test/resources/samples.",
+	"",
+	"The program performs two checks:",
+	"",
+	"Sample conformance",
+	"Every cell of every element in the sample files is read through the API,",
+	"decoding each tile with the codec that was used to store it, and compared",
+	"with the values the samples were generated from.  The compressed samples",
+	"(Sample04 to Sample07, Sample14) and their uncompressed twins are",
+	"populated from the same formulas, so the check verifies each decoder",
+	"against the known values.  Decoding times are taken from the",
+	"instance statistics.",
+	"",
+	"Codec round trip",
+	"Every tile of every sample is encoded and then decoded by each standard",
+	"codec that supports the data type.  The decoded values must match the",
+	"original bit-for-bit. Encode and decode throughput (MB/s of uncompressed",
+	"data) and compression ratio are reported for each codec and the predictor",
+	"it selected. Each operation is repeated n times (default 20)",
+	"to obtain stable timing for the small sample tiles.",
+	"Codecs that only provide a decoder (LSOP12) cannot be round-tripped.",
+	"They are verified by the sample conformance check (Sample14 for LSOP12).",
+	"The check fails if any codec is not exercised by at least one tile.",
+	"",
+	"The program exits with a status of zero if all checks pass; otherwise,",
+	"it exits with a status of one.",
+	0
+};
+
+typedef enum {
+	ValuesNotChecked = 0,
+	ValuesGridIndex,   // value = row * nColumns + column - 1
+	ValuesSinSin       // value = sin(x * PI) * sin(y * PI) from the model coordinates
+} ValuePattern;
+
+typedef struct SampleSpecTag {
+	const char* fileName;
+	ValuePattern pattern;
+}SampleSpec;
+
+static const SampleSpec samples[] = {
+	{ "Sample00_ShortNoComp.gvrs", ValuesGridIndex },
+	{ "Sample01_IntNoComp.gvrs", ValuesGridIndex },
+	{ "Sample02_FltNoComp.gvrs", ValuesGridIndex },
+	{ "Sample03_ICFNoComp.gvrs", ValuesGridIndex },
+	{ "Sample04_ShortComp.gvrs", ValuesGridIndex },
+	{ "Sample05_IntComp.gvrs", ValuesGridIndex },
+	{ "Sample06_FltComp.gvrs", ValuesGridIndex },
+	{ "Sample07_ICFComp.gvrs", ValuesGridIndex },
+	{ "Sample08_MixedTypes.gvrs", ValuesGridIndex },
+	{ "Sample09_ShortNoComp.gvrs", ValuesGridIndex },
+	{ "Sample10_IntNoComp.gvrs", ValuesGridIndex },
+	{ "Sample11_FltNoComp.gvrs", ValuesGridIndex },
+	{ "Sample12_ICFNoComp.gvrs", ValuesGridIndex },
+	{ "Sample13_ModelCoord.gvrs", ValuesSinSin },
+	{ "Sample14_LSOP.gvrs", ValuesSinSin },
+	{ "SampleMetadata.gvrs", ValuesNotChecked },
+	{ "SamplePartialTileCover.gvrs", ValuesNotChecked },
+};
+#define N_SAMPLES (int)(sizeof(samples)/sizeof(samples[0]))
+
+// Results for the round-trip test are tabulated by codec and by
+// the predictor the codec selected (zero for codecs that do not use predictors).
+#define MAX_CODEC_RESULTS 32
+#define N_CODECS_MAX 8
+
+typedef struct CodecResultTag {
+	char codec[GVRS_CODEC_IDENTIFICATION_MAXLEN + 1];
+	int predictor;
+	int64_t nTiles;
+	int64_t nBytesIn;
+	int64_t nBytesOut;
+	int64_t nsEncoding;
+	int64_t nsDecoding;
+}CodecResult;
+
+typedef struct CodecSummaryTag {
+	char codec[GVRS_CODEC_IDENTIFICATION_MAXLEN + 1];
+	int64_t nTilesTested;
+	int64_t nIncompressible;
+	int64_t nMismatches;
+	int64_t nsEncoding;   // including attempts that did not reduce the size of the data
+}CodecSummary;
+
+typedef struct FileDecodeResultTag {
+	char codec[GVRS_CODEC_IDENTIFICATION_MAXLEN + 1];
+	int64_t nDecoded;
+	int64_t nBytesDecoded;
+	int64_t nsDecoding;
+}FileDecodeResult;
+
+static CodecResult codecResults[MAX_CODEC_RESULTS];
+static int nCodecResults;
+static CodecSummary codecSummaries[N_CODECS_MAX];
+static FileDecodeResult fileDecodeResults[MAX_CODEC_RESULTS];
+static int nFileDecodeResults;
+static int nFailures;
+
+
+static CodecResult* getCodecResult(const char* codec, int predictor) {
+	for (int i = 0; i < nCodecResults; i++) {
+		if (codecResults[i].predictor == predictor && strcmp(codecResults[i].codec, codec) == 0) {
+			return codecResults + i;
+		}
+	}
+	if (nCodecResults == MAX_CODEC_RESULTS) {
+		return 0;
+	}
+	CodecResult* r = codecResults + nCodecResults++;
+	memset(r, 0, sizeof(CodecResult));
+	GvrsStrncpy(r->codec, sizeof(r->codec), codec);
+	r->predictor = predictor;
+	return r;
+}
+
+static FileDecodeResult* getFileDecodeResult(const char* codec) {
+	for (int i = 0; i < nFileDecodeResults; i++) {
+		if (strcmp(fileDecodeResults[i].codec, codec) == 0) {
+			return fileDecodeResults + i;
+		}
+	}
+	if (nFileDecodeResults == MAX_CODEC_RESULTS) {
+		return 0;
+	}
+	FileDecodeResult* r = fileDecodeResults + nFileDecodeResults++;
+	memset(r, 0, sizeof(FileDecodeResult));
+	GvrsStrncpy(r->codec, sizeof(r->codec), codec);
+	return r;
+}
+
+static int allocateStandardCodecs(GvrsCodec** codecs) {
+	// The order matches GvrsBuilderRegisterStandardDataCompressionCodecs
+	int n = 0;
+	codecs[n++] = GvrsCodecHuffmanAlloc();
+#ifdef GVRS_ZLIB
+	codecs[n++] = GvrsCodecDeflateAlloc();
+	codecs[n++] = GvrsCodecFloatAlloc();
+	codecs[n++] = GvrsCodecLsopAlloc();
+#endif
+	return n;
+}
+
+/**
+* Reads every cell of every element and compares it with the value
+* given by the pattern for the sample.
+* @return the number of cells that did not match.
+*/
+static int checkSampleValues(Gvrs* gvrs, const SampleSpec* spec) {
+	int nElements;
+	GvrsElement** elements = GvrsGetElements(gvrs, &nElements);
+	int nMismatches = 0;
+	for (int iElement = 0; iElement < nElements; iElement++) {
+		GvrsElement* e = elements[iElement];
+		double tolerance = 0;
+		if (spec->pattern == ValuesSinSin) {
+			if (e->elementType == GvrsElementTypeIntCodedFloat) {
+				tolerance = 0.5 / e->elementSpec.intFloatSpec.scale + 1.0e-6;
+			}
+			else {
+				tolerance = 1.0e-6;
+			}
+		}
+		for (int iRow = 0; iRow < gvrs->nRowsInRaster; iRow++) {
+			for (int iCol = 0; iCol < gvrs->nColsInRaster; iCol++) {
+				float value;
+				int status = GvrsElementReadFloat(e, iRow, iCol, &value);
+				if (status) {
+					printf("   %s, element %s: read failed at row %d, column %d with error %d\n",
+						spec->fileName, e->name, iRow, iCol, status);
+					return nMismatches + 1;
+				}
+				double expected;
+				if (spec->pattern == ValuesGridIndex) {
+					expected = (double)iRow * gvrs->nColsInRaster + iCol - 1;
+				}
+				else {
+					double x, y;
+					GvrsMapGridToModel(gvrs, iRow, iCol, &x, &y);
+					expected = sin(x * M_PI) * sin(y * M_PI);
+				}
+				if (!(fabs(value - expected) <= tolerance)) {
+					if (nMismatches < 5) {
+						printf("   %s, element %s: mismatch at row %d, column %d, expected %f, found %f\n",
+							spec->fileName, e->name, iRow, iCol, expected, value);
+					}
+					nMismatches++;
+				}
+			}
+		}
+	}
+	return nMismatches;
+}
+
+/**
+* Gets the content of a tile as it is presented to the codecs: integral
+* elements as 32-bit integers (the scaled integer codes for integer-coded floats)
+* and float elements as floats.  Cells beyond the edge of the raster are
+* given the fill value, as they are in the tile.
+*/
+static int getTileData(Gvrs* gvrs, GvrsElement* e, int tileRow, int tileCol, void* data) {
+	int integral = GvrsElementIsIntegral(e);
+	int k = 0;
+	for (int iRow = 0; iRow < gvrs->nRowsInTile; iRow++) {
+		int row = tileRow * gvrs->nRowsInTile + iRow;
+		for (int iCol = 0; iCol < gvrs->nColsInTile; iCol++) {
+			int col = tileCol * gvrs->nColsInTile + iCol;
+			int status = 0;
+			if (row >= gvrs->nRowsInRaster || col >= gvrs->nColsInRaster) {
+				if (integral) {
+					((int32_t*)data)[k] = e->fillValueInt;
+				}
+				else {
+					((float*)data)[k] = e->fillValueFloat;
+				}
+			}
+			else if (integral) {
+				status = GvrsElementReadInt(e, row, col, (int32_t*)data + k);
+			}
+			else {
+				status = GvrsElementReadFloat(e, row, col, (float*)data + k);
+			}
+			if (status) {
+				return status;
+			}
+			k++;
+		}
+	}
+	return 0;
+}
+
+/**
+* Encodes and decodes each populated tile of each element with each codec
+* that supports the data type, verifying that the decoded data matches the
+* original.
+*/
+static int roundTripSample(Gvrs* gvrs, const SampleSpec* spec, GvrsCodec** codecs, int nCodecs, int nRepeats) {
+	int nCellsInTile = gvrs->nRowsInTile * gvrs->nColsInTile;
+	size_t nBytesInTile = (size_t)nCellsInTile * 4;
+	uint8_t* source = (uint8_t*)malloc(nBytesInTile);
+	uint8_t* output = (uint8_t*)malloc(nBytesInTile);
+	if (!source || !output) {
+		free(source);
+		free(output);
+		return GVRSERR_NOMEM;
+	}
+	int nElements;
+	GvrsElement** elements = GvrsGetElements(gvrs, &nElements);
+	int status = 0;
+	for (int iElement = 0; iElement < nElements && !status; iElement++) {
+		GvrsElement* e = elements[iElement];
+		int integral = GvrsElementIsIntegral(e);
+		for (int tileRow = 0; tileRow < gvrs->nRowsOfTiles && !status; tileRow++) {
+			for (int tileCol = 0; tileCol < gvrs->nColsOfTiles && !status; tileCol++) {
+				if (!GvrsIsTilePopulated(gvrs, tileRow * gvrs->nColsOfTiles + tileCol)) {
+					continue;
+				}
+				status = getTileData(gvrs, e, tileRow, tileCol, source);
+				if (status) {
+					break;
+				}
+				for (int iCodec = 0; iCodec < nCodecs; iCodec++) {
+					GvrsCodec* codec = codecs[iCodec];
+					int canEncode = integral ? codec->encodeInt != 0 : codec->encodeFloat != 0;
+					int canDecode = integral ? codec->decodeInt != 0 : codec->decodeFloat != 0;
+					if (!canEncode || !canDecode) {
+						continue;
+					}
+					CodecSummary* summary = codecSummaries + iCodec;
+					summary->nTilesTested++;
+
+					int packingLength = 0;
+					uint8_t* packing = 0;
+					int encodeStatus = 0;
+					int64_t time0 = GvrsTimeNS();
+					for (int iRepeat = 0; iRepeat < nRepeats; iRepeat++) {
+						free(packing);
+						packing = 0;
+						if (integral) {
+							encodeStatus = codec->encodeInt(gvrs->nRowsInTile, gvrs->nColsInTile,
+								(int32_t*)source, iCodec, &packingLength, &packing, codec->appInfo);
+						}
+						else {
+							encodeStatus = codec->encodeFloat(gvrs->nRowsInTile, gvrs->nColsInTile,
+								(float*)source, iCodec, &packingLength, &packing, codec->appInfo);
+						}
+						if (encodeStatus) {
+							break;
+						}
+					}
+					int64_t nsEncoding = GvrsTimeNS() - time0;
+					summary->nsEncoding += nsEncoding;
+					if (encodeStatus == GVRSERR_COMPRESSION_FAILURE || (!encodeStatus && !packing)) {
+						// the codec could not reduce the size of the data (a normal outcome)
+						summary->nIncompressible++;
+						continue;
+					}
+					if (encodeStatus) {
+						printf("   %s, element %s, tile %d,%d: codec %s failed to encode with error %d\n",
+							spec->fileName, e->name, tileRow, tileCol, codec->identification, encodeStatus);
+						summary->nMismatches++;
+						nFailures++;
+						continue;
+					}
+
+					int decodeStatus = 0;
+					time0 = GvrsTimeNS();
+					for (int iRepeat = 0; iRepeat < nRepeats && !decodeStatus; iRepeat++) {
+						if (integral) {
+							decodeStatus = codec->decodeInt(gvrs->nRowsInTile, gvrs->nColsInTile,
+								packingLength, packing, (int32_t*)output, codec->appInfo);
+						}
+						else {
+							decodeStatus = codec->decodeFloat(gvrs->nRowsInTile, gvrs->nColsInTile,
+								packingLength, packing, (float*)output, codec->appInfo);
+						}
+					}
+					int64_t nsDecoding = GvrsTimeNS() - time0;
+					if (decodeStatus || memcmp(source, output, nBytesInTile)) {
+						printf("   %s, element %s, tile %d,%d: codec %s round trip failed (status %d)\n",
+							spec->fileName, e->name, tileRow, tileCol, codec->identification, decodeStatus);
+						summary->nMismatches++;
+						nFailures++;
+					}
+					else {
+						// packing[0] is the codec index and packing[1] the predictor
+						// (zero for codecs that do not use predictors)
+						int predictor = packingLength > 1 ? packing[1] : 0;
+						CodecResult* r = getCodecResult(codec->identification, predictor);
+						if (r) {
+							r->nTiles++;
+							r->nBytesIn += (int64_t)nBytesInTile;
+							r->nBytesOut += packingLength;
+							r->nsEncoding += nsEncoding / nRepeats;
+							r->nsDecoding += nsDecoding / nRepeats;
+						}
+					}
+					free(packing);
+				}
+			}
+		}
+	}
+	free(source);
+	free(output);
+	return status;
+}
+
+static double megabytesPerSecond(int64_t nBytes, int64_t ns) {
+	return ns > 0 ? (nBytes / 1.0e6) / (ns / 1.0e9) : 0;
+}
+
+static void writeJSON(FILE* fp, int nCodecs, GvrsCodec** codecs) {
+	fprintf(fp, "{\n  \"program\": \"gvrs_codec_check\",\n  \"failures\": %d,\n", nFailures);
+	fprintf(fp, "  \"fileDecoding\": [");
+	for (int i = 0; i < nFileDecodeResults; i++) {
+		FileDecodeResult* r = fileDecodeResults + i;
+		fprintf(fp, "%s\n    {\"codec\": \"%s\", \"segments\": %lld, \"decodeMBps\": %.3f}",
+			i == 0 ? "" : ",", r->codec, (long long)r->nDecoded, megabytesPerSecond(r->nBytesDecoded, r->nsDecoding));
+	}
+	fprintf(fp, "\n  ],\n  \"codecs\": [");
+	for (int i = 0; i < nCodecs; i++) {
+		CodecSummary* s = codecSummaries + i;
+		fprintf(fp, "%s\n    {\"codec\": \"%s\", \"tilesTested\": %lld, \"incompressible\": %lld, \"mismatches\": %lld}",
+			i == 0 ? "" : ",", codecs[i]->identification, (long long)s->nTilesTested,
+			(long long)s->nIncompressible, (long long)s->nMismatches);
+	}
+	fprintf(fp, "\n  ],\n  \"roundTrip\": [");
+	for (int i = 0; i < nCodecResults; i++) {
+		CodecResult* r = codecResults + i;
+		fprintf(fp, "%s\n    {\"codec\": \"%s\", \"predictor\": %d, \"tiles\": %lld, \"compressionRatio\": %.4f, \"encodeMBps\": %.3f, \"decodeMBps\": %.3f}",
+			i == 0 ? "" : ",", r->codec, r->predictor, (long long)r->nTiles,
+			r->nBytesOut > 0 ? (double)r->nBytesIn / r->nBytesOut : 0.0,
+			megabytesPerSecond(r->nBytesIn, r->nsEncoding), megabytesPerSecond(r->nBytesIn, r->nsDecoding));
+	}
+	fprintf(fp, "\n  ]\n}\n");
+}
+
+/**
+* Checks the standard codecs against the GVRS sample files.
+* @param argc the number of command-line arguments, including command vector, always one or greater.
+* @param argv the command vector, argv[1] giving the path to the samples folder.
+* @return zero if all checks pass; otherwise, one.
+*/
+int main(int argc, char* argv[]) {
+	if (argc < 2) {
+		const char** p = usage;
+		while (*p) {
+			printf("%s\n", *p);
+			p++;
+		}
+		exit(0);
+	}
+	const char* folder = argv[1];
+	const char* jsonPath = 0;
+	int nRepeats = 20;
+	for (int i = 2; i < argc; i++) {
+		if (strcmp(argv[i], "-repeat") == 0 && i + 1 < argc) {
+			nRepeats = atoi(argv[++i]);
+			if (nRepeats < 1) {
+				nRepeats = 1;
+			}
+		}
+		else if (strcmp(argv[i], "-json") == 0 && i + 1 < argc) {
+			jsonPath = argv[++i];
+		}
+		else {
+			printf("Unrecognized option %s\n", argv[i]);
+			exit(1);
+		}
+	}
+
+	GvrsCodec* codecs[N_CODECS_MAX];
+	int nCodecs = allocateStandardCodecs(codecs);
+	for (int i = 0; i < nCodecs; i++) {
+		if (!codecs[i]) {
+			printf("Failed to allocate codecs\n");
+			exit(1);
+		}
+		GvrsStrncpy(codecSummaries[i].codec, sizeof(codecSummaries[i].codec), codecs[i]->identification);
+	}
+
+	printf("Sample conformance\n");
+	char path[1024];
+	for (int iSample = 0; iSample < N_SAMPLES; iSample++) {
+		const SampleSpec* spec = samples + iSample;
+		snprintf(path, sizeof(path), "%s/%s", folder, spec->fileName);
+		Gvrs* gvrs;
+		int status = GvrsOpen(&gvrs, path, "r");
+		if (status) {
+			printf("   %-30s FAILED to open, error %d\n", spec->fileName, status);
+			nFailures++;
+			continue;
+		}
+		GvrsSetTimingEnabled(gvrs, 1);
+		if (spec->pattern == ValuesNotChecked) {
+			printf("   %-30s values not checked\n", spec->fileName);
+		}
+		else {
+			int nMismatches = checkSampleValues(gvrs, spec);
+			printf("   %-30s %s\n", spec->fileName, nMismatches ? "FAILED" : "passed");
+			if (nMismatches) {
+				nFailures++;
+			}
+		}
+
+		// Tabulate the decoding performed while the values were read
+		GvrsStatistics statistics;
+		if (GvrsGetStatistics(gvrs, &statistics) == 0) {
+			int64_t nBytesInSegment = (int64_t)gvrs->nRowsInTile * gvrs->nColsInTile * 4;
+			for (int i = 0; i < statistics.nCodecs; i++) {
+				GvrsCodecStatistics* c = statistics.codecs + i;
+				if (c->nDecoded > 0) {
+					FileDecodeResult* r = getFileDecodeResult(c->identification);
+					if (r) {
+						r->nDecoded += c->nDecoded;
+						r->nBytesDecoded += c->nDecoded * nBytesInSegment;
+						r->nsDecoding += c->nsDecoding;
+					}
+				}
+			}
+		}
+
+		status = roundTripSample(gvrs, spec, codecs, nCodecs, nRepeats);
+		if (status) {
+			printf("   %-30s round trip FAILED, error %d\n", spec->fileName, status);
+			nFailures++;
+		}
+		GvrsClose(gvrs);
+	}
+
+	printf("\nDecoding of sample tiles\n");
+	printf("   Codec             Segments    Decode MB/s\n");
+	for (int i = 0; i < nFileDecodeResults; i++) {
+		FileDecodeResult* r = fileDecodeResults + i;
+		printf("   %-16s %9lld  %12.1f\n", r->codec, (long long)r->nDecoded,
+			megabytesPerSecond(r->nBytesDecoded, r->nsDecoding));
+	}
+
+	printf("\nCodec round trip\n");
+	printf("   Codec            Tested  Incompressible  Mismatches\n");
+	for (int i = 0; i < nCodecs; i++) {
+		CodecSummary* s = codecSummaries + i;
+		if (!codecs[i]->encodeInt && !codecs[i]->encodeFloat) {
+			printf("   %-16s decode only\n", s->codec);
+			continue;
+		}
+		printf("   %-16s %6lld  %14lld  %10lld\n", s->codec, (long long)s->nTilesTested,
+			(long long)s->nIncompressible, (long long)s->nMismatches);
+	}
+	printf("\n   Codec            Predictor  Tiles   Ratio   Encode MB/s   Decode MB/s\n");
+	for (int i = 0; i < nCodecResults; i++) {
+		CodecResult* r = codecResults + i;
+		printf("   %-16s %9d  %5lld  %6.2f  %12.1f  %12.1f\n", r->codec, r->predictor, (long long)r->nTiles,
+			r->nBytesOut > 0 ? (double)r->nBytesIn / r->nBytesOut : 0.0,
+			megabytesPerSecond(r->nBytesIn, r->nsEncoding), megabytesPerSecond(r->nBytesIn, r->nsDecoding));
+	}
+
+	// Every codec must be exercised by at least one tile, either by a successful
+	// round trip or, for a codec that only provides a decoder, by a sample file.
+	for (int i = 0; i < nCodecs; i++) {
+		CodecSummary* s = codecSummaries + i;
+		int64_t nExercised = s->nTilesTested - s->nIncompressible;
+		if (!codecs[i]->encodeInt && !codecs[i]->encodeFloat) {
+			nExercised = 0;
+			for (int j = 0; j < nFileDecodeResults; j++) {
+				if (strcmp(fileDecodeResults[j].codec, s->codec) == 0) {
+					nExercised = fileDecodeResults[j].nDecoded;
+				}
+			}
+		}
+		if (nExercised == 0) {
+			printf("\n   Codec %s was not exercised by any tile\n", s->codec);
+			nFailures++;
+		}
+	}
+
+	if (jsonPath) {
+		FILE* fp = fopen(jsonPath, "w");
+		if (fp) {
+			writeJSON(fp, nCodecs, codecs);
+			fclose(fp);
+		}
+		else {
+			printf("Unable to open %s\n", jsonPath);
+			nFailures++;
+		}
+	}
+
+	for (int i = 0; i < nCodecs; i++) {
+		codecs[i]->destroyCodec(codecs[i]);
+	}
+
+	printf("\n%s: %d failure%s\n", nFailures ? "FAILED" : "PASSED", nFailures, nFailures == 1 ? "" : "s");
+	exit(nFailures ? 1 : 0);
+}
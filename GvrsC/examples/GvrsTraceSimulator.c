@@ -0,0 +1,425 @@
+/* --------------------------------------------------------------------
+ *
+ * The MIT License
+ *
+ * Copyright (C) 2024  Gary W. Lucas.
+
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ * ---------------------------------------------------------------------
+ */
+
+#include "Gvrs.h"
+#include "GvrsAccessTrace.h"
+#include "GvrsError.h"
+
+const char* usage[] = {
+	"Tile-Cache Simulator for GVRS access traces",
+	"",
+	"Usage:  GvrsTraceSimulator <trace file> [cache size ...]",
+	"",
+	"Replays a trace recorded using GvrsAccessTraceStart against simulated",
+	"tile caches using the LRU, CLOCK, 2Q, and ARC replacement policies.",
+	"For each cache size, the hit rate and the miss cost (the number of",
+	"bytes that would be read from the file) are reported for each policy.",
+	"If no cache sizes are given, a series of sizes from 1 tile to the",
+	"number of distinct tiles in the trace is used.",
+	"",
+	"The miss cost for a tile is taken from the size of its record as",
+	"it was recorded in the trace. Tiles that were never read from the file",
+	"during the trace are assigned the average record size.",
+	0
+};
+
+// The lists used by the policies are stored as arrays indexed by tile index.
+// Each tile belongs to at most one list at a time.
+
+#define NO_LIST  -1
+
+typedef struct SimListTag {
+	int head;
+	int tail;
+	int size;
+}SimList;
+
+typedef struct SimTag {
+	int nTiles;
+	int* prior;
+	int* next;
+	int* member;   // the list that contains the tile, or NO_LIST
+	SimList lists[4];
+	int* slot;     // CLOCK: the slot that holds the tile, or -1
+	int* slotTile; // CLOCK: the tile that occupies a slot, or -1
+	uint8_t* referenced;
+}Sim;
+
+static void listInit(Sim* sim) {
+	int i;
+	for (i = 0; i < sim->nTiles; i++) {
+		sim->member[i] = NO_LIST;
+	}
+	for (i = 0; i < 4; i++) {
+		sim->lists[i].head = -1;
+		sim->lists[i].tail = -1;
+		sim->lists[i].size = 0;
+	}
+}
+
+static void listRemove(Sim* sim, int tile) {
+	SimList* list = sim->lists + sim->member[tile];
+	int p = sim->prior[tile];
+	int n = sim->next[tile];
+	if (p >= 0) {
+		sim->next[p] = n;
+	}
+	else {
+		list->head = n;
+	}
+	if (n >= 0) {
+		sim->prior[n] = p;
+	}
+	else {
+		list->tail = p;
+	}
+	list->size--;
+	sim->member[tile] = NO_LIST;
+}
+
+static void listPushHead(Sim* sim, int listIndex, int tile) {
+	SimList* list = sim->lists + listIndex;
+	sim->prior[tile] = -1;
+	sim->next[tile] = list->head;
+	if (list->head >= 0) {
+		sim->prior[list->head] = tile;
+	}
+	else {
+		list->tail = tile;
+	}
+	list->head = tile;
+	list->size++;
+	sim->member[tile] = listIndex;
+}
+
+static int listPopTail(Sim* sim, int listIndex) {
+	int tile = sim->lists[listIndex].tail;
+	if (tile >= 0) {
+		listRemove(sim, tile);
+	}
+	return tile;
+}
+
+static int accessLRU(Sim* sim, int capacity, int tile) {
+	if (sim->member[tile] == 0) {
+		listRemove(sim, tile);
+		listPushHead(sim, 0, tile);
+		return 1;
+	}
+	if (sim->lists[0].size >= capacity) {
+		listPopTail(sim, 0);
+	}
+	listPushHead(sim, 0, tile);
+	return 0;
+}
+
+static int clockHand;
+
+static int accessCLOCK(Sim* sim, int capacity, int tile) {
+	if (sim->slot[tile] >= 0) {
+		sim->referenced[tile] = 1;
+		return 1;
+	}
+	for (;;) {
+		int victim = sim->slotTile[clockHand];
+		if (victim < 0 || !sim->referenced[victim]) {
+			if (victim >= 0) {
+				sim->slot[victim] = -1;
+			}
+			sim->slotTile[clockHand] = tile;
+			sim->slot[tile] = clockHand;
+			sim->referenced[tile] = 0;
+			clockHand = (clockHand + 1) % capacity;
+			return 0;
+		}
+		sim->referenced[victim] = 0;
+		clockHand = (clockHand + 1) % capacity;
+	}
+}
+
+// 2Q, as described by Johnson and Shasha (1994), with the recommended
+// parameters Kin = 25 percent of the cache and Kout = 50 percent.
+//   list 0:  A1in, a FIFO of tiles seen once recently (resident)
+//   list 1:  A1out, a FIFO of tiles evicted from A1in (not resident)
+//   list 2:  Am, an LRU list of frequently used tiles (resident)
+static int access2Q(Sim* sim, int capacity, int tile) {
+	int kIn = capacity / 4;
+	int kOut = capacity / 2;
+	if (kIn < 1) {
+		kIn = 1;
+	}
+	if (kOut < 1) {
+		kOut = 1;
+	}
+	int m = sim->member[tile];
+	if (m == 2) {
+		listRemove(sim, tile);
+		listPushHead(sim, 2, tile);
+		return 1;
+	}
+	if (m == 0) {
+		return 1;
+	}
+	if (m == 1) {
+		// a ghost entry.  remove it so that it is not discarded while reclaiming a slot
+		listRemove(sim, tile);
+	}
+	if (sim->lists[0].size + sim->lists[2].size >= capacity) {
+		// reclaim a slot
+		if (sim->lists[0].size > kIn || sim->lists[2].size == 0) {
+			int victim = listPopTail(sim, 0);
+			listPushHead(sim, 1, victim);
+			if (sim->lists[1].size > kOut) {
+				listPopTail(sim, 1);
+			}
+		}
+		else {
+			listPopTail(sim, 2);
+		}
+	}
+	if (m == 1) {
+		listPushHead(sim, 2, tile);
+	}
+	else {
+		listPushHead(sim, 0, tile);
+	}
+	return 0;
+}
+
+// ARC, as described by Megiddo and Modha (2003).
+//   list 0: T1, list 1: T2 (resident)
+//   list 2: B1, list 3: B2 (ghost entries)
+static int arcTarget;
+
+static void arcReplace(Sim* sim, int tile) {
+	int t1 = sim->lists[0].size;
+	if (t1 > 0 && (t1 > arcTarget || (sim->member[tile] == 3 && t1 == arcTarget))) {
+		listPushHead(sim, 2, listPopTail(sim, 0));
+	}
+	else if (sim->lists[1].size > 0) {
+		listPushHead(sim, 3, listPopTail(sim, 1));
+	}
+	else {
+		listPushHead(sim, 2, listPopTail(sim, 0));
+	}
+}
+
+static int accessARC(Sim* sim, int capacity, int tile) {
+	int m = sim->member[tile];
+	if (m == 0 || m == 1) {
+		listRemove(sim, tile);
+		listPushHead(sim, 1, tile);
+		return 1;
+	}
+	int b1 = sim->lists[2].size;
+	int b2 = sim->lists[3].size;
+	if (m == 2) {
+		int delta = b1 >= b2 ? 1 : b2 / b1;
+		arcTarget = arcTarget + delta > capacity ? capacity : arcTarget + delta;
+		arcReplace(sim, tile);
+		listRemove(sim, tile);
+		listPushHead(sim, 1, tile);
+		return 0;
+	}
+	if (m == 3) {
+		int delta = b2 >= b1 ? 1 : b1 / b2;
+		arcTarget = arcTarget - delta < 0 ? 0 : arcTarget - delta;
+		arcReplace(sim, tile);
+		listRemove(sim, tile);
+		listPushHead(sim, 1, tile);
+		return 0;
+	}
+	int l1 = sim->lists[0].size + b1;
+	int total = l1 + sim->lists[1].size + b2;
+	if (l1 == capacity) {
+		if (sim->lists[0].size < capacity) {
+			listPopTail(sim, 2);
+			arcReplace(sim, tile);
+		}
+		else {
+			listPopTail(sim, 0);
+		}
+	}
+	else if (l1 < capacity && total >= capacity) {
+		if (total == 2 * capacity) {
+			listPopTail(sim, 3);
+		}
+		arcReplace(sim, tile);
+	}
+	listPushHead(sim, 0, tile);
+	return 0;
+}
+
+typedef int (*AccessFunction)(Sim* sim, int capacity, int tile);
+
+static const char* policyNames[] = { "LRU", "CLOCK", "2Q", "ARC" };
+static AccessFunction policies[] = { accessLRU, accessCLOCK, access2Q, accessARC };
+
+static void simulate(Sim* sim, GvrsAccessTrace* trace, double averageSize,
+	int policy, int capacity, int64_t* nHits, double* missCost) {
+	int i;
+	listInit(sim);
+	for (i = 0; i < sim->nTiles; i++) {
+		sim->slot[i] = -1;
+		sim->referenced[i] = 0;
+	}
+	for (i = 0; i < capacity; i++) {
+		sim->slotTile[i] = -1;
+	}
+	clockHand = 0;
+	arcTarget = 0;
+
+	int64_t k;
+	*nHits = 0;
+	*missCost = 0;
+	AccessFunction f = policies[policy];
+	for (k = 0; k < trace->nAccesses; k++) {
+		int tile = trace->tileIndices[k];
+		if (f(sim, capacity, tile)) {
+			(*nHits)++;
+		}
+		else {
+			int32_t size = trace->recordSizes[tile];
+			*missCost += size > 0 ? (double)size : averageSize;
+		}
+	}
+}
+
+int main(int argc, char* argv[]) {
+	int i;
+	if (argc < 2) {
+		for (i = 0; usage[i]; i++) {
+			printf("%s\n", usage[i]);
+		}
+		exit(0);
+	}
+
+	GvrsAccessTrace* trace;
+	int status = GvrsAccessTraceRead(argv[1], &trace);
+	if (status) {
+		printf("Error %d reading trace file %s\n", status, argv[1]);
+		exit(1);
+	}
+	int nTiles = trace->nRowsOfTiles * trace->nColsOfTiles;
+
+	// count the distinct tiles and compute the average record size
+	int nDistinct = 0;
+	int nSized = 0;
+	double sumSize = 0;
+	uint8_t* seen = calloc((size_t)nTiles, 1);
+	int64_t k;
+	for (k = 0; k < trace->nAccesses; k++) {
+		int tile = trace->tileIndices[k];
+		if (!seen[tile]) {
+			seen[tile] = 1;
+			nDistinct++;
+			if (trace->recordSizes[tile] > 0) {
+				nSized++;
+				sumSize += trace->recordSizes[tile];
+			}
+		}
+	}
+	free(seen);
+	double averageSize = nSized > 0 ? sumSize / nSized : 0;
+
+	printf("Trace:                     %s\n", argv[1]);
+	printf("Tiles in raster:           %d (%d rows by %d columns)\n", nTiles, trace->nRowsOfTiles, trace->nColsOfTiles);
+	printf("Memory per tile:           %d bytes\n", trace->nBytesForTileData);
+	printf("Cache size during trace:   %d\n", trace->maxTileCacheSize);
+	printf("Accesses:                  %lld\n", (long long)trace->nAccesses);
+	printf("Distinct tiles:            %d\n", nDistinct);
+	printf("Average record size:       %.1f bytes\n", averageSize);
+	printf("Compulsory miss cost:      %.3f MB\n", nDistinct * averageSize / 1048576.0);
+	printf("\n");
+	if (trace->nAccesses == 0) {
+		GvrsAccessTraceFree(trace);
+		exit(0);
+	}
+
+	int nSizes = 0;
+	int* sizes = calloc((size_t)(argc + 32), sizeof(int));
+	if (argc > 2) {
+		for (i = 2; i < argc; i++) {
+			int s = atoi(argv[i]);
+			if (s > 0) {
+				sizes[nSizes++] = s;
+			}
+		}
+	}
+	else {
+		int s;
+		for (s = 1; s < nDistinct && nSizes < 30; s *= 2) {
+			sizes[nSizes++] = s;
+		}
+		sizes[nSizes++] = nDistinct;
+	}
+
+	Sim sim;
+	memset(&sim, 0, sizeof(sim));
+	sim.nTiles = nTiles;
+	sim.prior = malloc((size_t)nTiles * sizeof(int));
+	sim.next = malloc((size_t)nTiles * sizeof(int));
+	sim.member = malloc((size_t)nTiles * sizeof(int));
+	sim.slot = malloc((size_t)nTiles * sizeof(int));
+	sim.referenced = malloc((size_t)nTiles);
+	if (!sim.prior || !sim.next || !sim.member || !sim.slot || !sim.referenced) {
+		printf("Unable to allocate memory for simulation\n");
+		exit(1);
+	}
+
+	printf("  Cache   Memory MB");
+	int policy;
+	for (policy = 0; policy < 4; policy++) {
+		printf("  %5s hit%%   miss MB", policyNames[policy]);
+	}
+	printf("\n");
+	for (i = 0; i < nSizes; i++) {
+		int capacity = sizes[i];
+		sim.slotTile = malloc((size_t)capacity * sizeof(int));
+		if (!sim.slotTile) {
+			printf("Unable to allocate memory for simulation\n");
+			exit(1);
+		}
+		printf("%7d %11.2f", capacity, (double)capacity * trace->nBytesForTileData / 1048576.0);
+		for (policy = 0; policy < 4; policy++) {
+			int64_t nHits;
+			double missCost;
+			simulate(&sim, trace, averageSize, policy, capacity, &nHits, &missCost);
+			printf("  %10.2f %9.3f", 100.0 * (double)nHits / (double)trace->nAccesses, missCost / 1048576.0);
+		}
+		printf("\n");
+		free(sim.slotTile);
+	}
+
+	free(sim.prior);
+	free(sim.next);
+	free(sim.member);
+	free(sim.slot);
+	free(sim.referenced);
+	free(sizes);
+	GvrsAccessTraceFree(trace);
+	return 0;
+}
@@ -63,8 +63,38 @@ typedef enum {
 	GvrsTileCacheSizeMedium = 1,
 	GvrsTileCacheSizeLarge = 2,
 	GvrsTileCacheSizeExtraLarge = 3,
+	GvrsTileCacheSizeAutomatic = 4,
 } GvrsTileCacheSizeType;
 
+/**
+* The default size for the block read when tiles are accessed sequentially (see GvrsSetReadAhead).
+*/
+#define GVRS_READ_AHEAD_DEFAULT_SIZE 262144
+
+/**
+* Specifies the arrangement of the cells within the in-memory data for a tile.
+* The layout does not affect the format of the file.
+*/
+typedef enum {
+	GvrsTileLayoutRowMajor = 0,
+	GvrsTileLayoutMorton = 1
+} GvrsTileLayout;
+
+/**
+* Specifies the order in which tile records are placed in the file written
+* by GvrsCopy (see GvrsCopyOptions).  The sequential placement transfers
+* tiles in the order in which they are stored in the source file, so the source
+* is read sequentially.  Tiles that must be decoded and re-tiled are written
+* after them as they are completed.  The Morton and Hilbert placements order all tiles along
+* a space-filling curve over the tile row and column so that tiles that are
+* near each other in the grid tend to be near each other in the file.
+*/
+typedef enum {
+	GvrsTilePlacementSequential = 0,
+	GvrsTilePlacementMorton = 1,
+	GvrsTilePlacementHilbert = 2
+} GvrsTilePlacement;
+
 
 /**
 * Defines specifications for indicating the data type for a GVRS element.
@@ -156,6 +186,10 @@ typedef struct GvrsElementTag {
 	// the dependent variable (the element value) is isotropic to the underlying
 	// (model) coordinates.  In the "does not apply" cases, just set this value to 1.
 	double unitsToMeters;
+
+	// For integer-coded float elements, 1/scale.  It is precomputed by the library
+	// so that conversions may multiply rather than divide.
+	float icfInverseScale;
 }GvrsElement;
 
 
@@ -229,6 +263,33 @@ typedef struct GvrsTag {
 
 	int deleteOnClose;
 
+	// non-null when the instance shares its immutable resources with reader clones
+	void* sharedState;
+
+	// an optional cache of decoded tiles shared across instances and processes (see GvrsSharedCache.h)
+	void* sharedTileCache;
+
+	// an optional background loader for tiles (see GvrsTileLoader.h)
+	void* tileLoader;
+
+	// an optional recorder for the sequence of tile accesses (see GvrsAccessTrace.h)
+	void* accessTrace;
+
+	// the maximum number of tiles for the automatic tile-cache size, zero for the default
+	int32_t tileCacheCeiling;
+
+	// optional timing statistics (see GvrsStatistics.h)
+	void* statistics;
+
+	// optional callbacks for tile-cache and file events (see GvrsEvents.h)
+	void* eventHooks;
+
+	// the in-memory cell layout for tiles (see GvrsSetTileLayout)
+	GvrsTileLayout tileLayout;
+
+	// the size of the block read when tile records are accessed sequentially (see GvrsSetReadAhead)
+	int readAheadSize;
+
 } Gvrs;
 
 
@@ -256,6 +317,49 @@ typedef struct GvrsTag {
  */
 int GvrsOpen(Gvrs** gvrs, const char* path, const char* accessMode);
 
+/**
+* Creates a lightweight read-only instance that shares the immutable resources of an
+* open GVRS instance.  The clone shares the tile directory, metadata directory, element
+* specifications, and path of the source through a reference count.  It has its own
+* file pointer, tile cache, and codec instances (obtained through allocateNewCodec).
+* So a clone may be used in one thread while the source, or other clones, are used
+* in other threads without synchronization.
+* <p>
+* The clone must be disposed of using GvrsClose.  The source and its clones may be
+* closed in any order.  Clones may also be created from other clones.
+* <p>
+* If the source is opened for writing, any pending tiles are written to the file
+* before the clone is created.  The source must not be modified while its clones are
+* in use, because they share its tile and metadata directories.  This function must not be called
+* concurrently for the same source.
+* @param gvrs a valid GVRS instance.
+* @param clone a pointer to a variable to receive the clone.
+* @return if successful, zero; otherwise, an error code.
+*/
+int GvrsOpenReaderClone(Gvrs* gvrs, Gvrs** clone);
+
+/**
+* Creates an instance that can be used to write tiles to a file from a separate thread.
+* The writer clone has its own tile cache and codec instances, so tiles are
+* compressed in parallel.  It shares the file, tile directory, and file-space
+* manager of the source.  Access to these shared resources is serialized so
+* that file-space allocation, the writing of tile records, and tile-directory updates
+* are performed by one thread at a time.
+* <p>
+* Each thread must write to a set of tiles that is disjoint from the sets of
+* tiles written by all other threads (including the thread using the source). Metadata
+* must not be written while writer clones are in use.
+* <p>
+* All writer clones must be closed using GvrsClose before the source is closed.
+* Closing a writer clone writes its pending tiles.  The completion operations
+* for the file are performed when the source is closed.  If the source is closed while
+* writer clones remain open, GvrsClose returns an error and the source remains open.
+* @param gvrs a valid GVRS instance that was opened for writing.
+* @param clone a pointer to a variable to receive the clone.
+* @return if successful, zero; otherwise, an error code.
+*/
+int GvrsOpenWriterClone(Gvrs* gvrs, Gvrs** clone);
+
 /**
 * Disposes of a GVRS virtual raster store, frees all associated memory,
 * and closes the associated file.
@@ -274,11 +378,152 @@ int GvrsClose(Gvrs *gvrs);
 * prefered when iterating over a GVRS data set in row-major order.  It allocates
 * sufficient memory to represent an entire row of tiles.  The <i>Small</i> and
 * <i>Medium</i> settings allocate less memory and are suitable for localized processing.
+* <p>
+* The <i>Automatic</i> setting adjusts the size of the cache to suit the pattern
+* of data access.  The cache tracks recently discarded tiles and grows when tiles are
+* read again soon after they are discarded (as happens when a raster is
+* traversed in column-major order with a cache that is smaller than the
+* number of rows of tiles).  It shrinks, releasing memory, when nearly all accesses are
+* satisfied from the cache.  The cache never exceeds the ceiling set by
+* GvrsSetTileCacheCeiling (by default, the size for <i>Extra Large</i>).
 * @param gvrs a pointer to a valid raster file store.
 * @param cacheSize an enumerated type giving the size of the cache.
 */
 int   GvrsSetTileCacheSize(Gvrs* gvrs, GvrsTileCacheSizeType cacheSize);
 
+/**
+* Sets the maximum number of tiles that may be held by a tile cache
+* that uses the <i>Automatic</i> size setting.  If the cache currently uses
+* the automatic setting, it is replaced.
+* @param gvrs a pointer to a valid raster file store.
+* @param maxTiles the maximum number of tiles; or zero to use the default
+* (the size for <i>Extra Large</i>).
+* @return if successful, zero; otherwise an error code.
+*/
+int   GvrsSetTileCacheCeiling(Gvrs* gvrs, int maxTiles);
+
+/**
+* Sets the arrangement of the cells within the in-memory data for tiles.
+* By default, cells are stored in row-major order.  In the Morton (Z-order) layout,
+* the cells of each 2-by-2, 4-by-4, 8-by-8 (etc.) square block are stored
+* contiguously, so neighborhoods such as the 4-by-4 cells used by the B-spline
+* interpolation and column-wise traversals touch fewer cache lines in large tiles.
+* The file format is not affected.
+* <p>
+* The Morton layout requires tiles with dimensions that are integral powers of two
+* (for example, 128-by-128 or 256-by-512).  Tiles with pending writes are written
+* to the file and tiles that are already in memory are rearranged.  Clones
+* of the instance use the same layout.  The layout may not be changed while the
+* background tile loader is enabled.
+* @param gvrs a valid GVRS instance.
+* @param tileLayout the layout.
+* @return if successful, zero; otherwise an error code.
+*/
+int   GvrsSetTileLayout(Gvrs* gvrs, GvrsTileLayout tileLayout);
+
+/**
+* Sets the size of the block that is read from the file when tiles are accessed
+* in the order in which they are stored.  When a tile record directly follows the
+* record that was read before it, a block of the specified size is read in
+* a single operation and the records for subsequent tiles that lie within it
+* are decoded from memory.  Read-ahead is applied only to files opened for read-only
+* access.  By default, the size is GVRS_READ_AHEAD_DEFAULT_SIZE.  Clones of the instance
+* use the same setting.  Specifying a smaller size than is required to hold a tile
+* stored without compression results in the larger size being used.
+* @param gvrs a valid GVRS instance.
+* @param nBytes the size of the block in bytes, or zero to disable read-ahead.
+* @return if successful, zero; otherwise an error code.
+*/
+int   GvrsSetReadAhead(Gvrs* gvrs, int nBytes);
+
+/**
+* Reads the record headers for all populated tiles and retains the size of each
+* tile record in memory so that each subsequent tile read is a single read of the
+* exact size of the record.  Without this call, the size of a record is obtained from
+* its header the first time the tile is read.  The headers are read in the order in
+* which the records are stored in the file.  The sizes are not stored in the file.
+* <p>
+* The sizes are shared with clones of the instance, including the sizes that any of
+* them obtain when tiles are read.  Access to the sizes is synchronized, so this function
+* may be called while clones are open.  But clones that read tiles during the call wait
+* until it is complete.  So, when tiles are to be read in parallel, it is most effective to
+* call it before the clones are opened.
+* @param gvrs a valid GVRS instance.
+* @return if successful, zero; otherwise an error code.
+*/
+int   GvrsLoadTileRecordSizes(Gvrs* gvrs);
+
+/**
+* Loads the tiles for a region into memory and pins them so that they remain
+* in memory until they are unpinned.  Pinned tiles are held in addition to the tiles in
+* the tile cache and do not count against its size.  Reads from a pinned region never
+* access the file.  Tiles that are not populated are not loaded (reads report the
+* fill value without file access).
+* <p>
+* Tiles that are not already in memory are read in the order in which they are stored
+* in the file using multiple threads (each of which has its own reader clone of the instance).
+* Pins may be nested: a tile that is pinned by more than one call
+* remains pinned until it is unpinned the same number of times.  Changing the tile-cache
+* size does not release pinned tiles.  This function may be used only with instances
+* opened for read-only access.
+* @param gvrs a valid GVRS instance.
+* @param row0 the first row of the region, inclusive.
+* @param col0 the first column of the region, inclusive.
+* @param row1 the last row of the region, inclusive.
+* @param col1 the last column of the region, inclusive.
+* @param nBytesPinned a pointer to a variable to receive the total memory used by the pinned
+* tiles of the instance after the operation; or a null if the value is not required.
+* @return if successful, zero; otherwise an error code.
+*/
+int GvrsPinRegion(Gvrs* gvrs, int row0, int col0, int row1, int col1, int64_t* nBytesPinned);
+
+/**
+* Releases the pins on the tiles in a region.  Tiles that are no longer pinned are
+* returned to the tile cache, where they are subject to the usual replacement policy.
+* Tiles in the region that are not pinned are ignored.
+* @param gvrs a valid GVRS instance.
+* @param row0 the first row of the region, inclusive.
+* @param col0 the first column of the region, inclusive.
+* @param row1 the last row of the region, inclusive.
+* @param col1 the last column of the region, inclusive.
+* @param nBytesPinned a pointer to a variable to receive the total memory used by the pinned
+* tiles of the instance after the operation; or a null if the value is not required.
+* @return if successful, zero; otherwise an error code.
+*/
+int GvrsUnpinRegion(Gvrs* gvrs, int row0, int col0, int row1, int col1, int64_t* nBytesPinned);
+
+/**
+* Saves a manifest listing the tiles that are resident in the tile cache so that
+* a later session can restore the cache using GvrsLoadCacheManifest.  The tiles are
+* listed from most-recently used to least-recently used.  Pinned tiles are not included.
+* If a path is given, the manifest is written to a small file of its own. If the path is
+* null, the manifest is stored in the GVRS file as a metadata record named "GvrsCacheManifest"
+* (this option requires an instance opened for writing).
+* @param gvrs a valid GVRS instance.
+* @param path the path for the manifest file; or a null to store the manifest as metadata.
+* @return if successful, zero; otherwise an error code.
+*/
+int GvrsSaveCacheManifest(Gvrs* gvrs, const char* path);
+
+/**
+* Loads the tiles listed in a manifest saved by GvrsSaveCacheManifest into the tile cache.
+* The tiles are read in the order in which they are stored in the file using
+* multiple threads and are installed so that the order of the cache matches the order
+* at the time the manifest was saved.  If the manifest lists more tiles than the cache can hold,
+* only the most-recently used tiles are loaded.  A manifest file that was saved for
+* a different GVRS file is rejected with GVRSERR_INVALID_PARAMETER.  Files are identified
+* by their UUIDs, so files created without a UUID (which earlier versions of this library
+* did not assign) cannot be distinguished from other files with the same tile grid.
+* This function may be used only with instances opened for read-only access.
+* @param gvrs a valid GVRS instance.
+* @param path the path for the manifest file; or a null to read the manifest from the
+* "GvrsCacheManifest" metadata record.
+* @param nTilesLoaded a pointer to a variable to receive the number of tiles that were
+* read from the file; or a null if the value is not required.
+* @return if successful, zero; otherwise an error code.
+*/
+int GvrsLoadCacheManifest(Gvrs* gvrs, const char* path, int* nTilesLoaded);
+
 /**
 * Searches a GVRS instance for an element with the specified name.
 * @param gvrs a valid instance.
@@ -365,6 +610,35 @@ int GvrsElementReadFloat(GvrsElement* element, int row, int column, float* value
 int GvrsElementWriteInt(GvrsElement* element, int gridRow, int gridColumn, int32_t value);
 int GvrsElementWriteFloat(GvrsElement* element, int gridRow, int gridColumn, float value);
 
+/**
+* Reads a rectangular block of floating-point values from GVRS.  The block is processed
+* one tile at a time, so this function is considerably faster than reading the
+* cells individually.  Integer-coded-float values are converted in bulk and
+* unpopulated cells are assigned the element's floating-point fill value.
+* @param element a valid instance associated with an open GVRS file.
+* @param row0 the first row of the block.
+* @param col0 the first column of the block.
+* @param nRows the number of rows in the block.
+* @param nCols the number of columns in the block.
+* @param values an array of dimension nRows*nCols to accept the values in row-major order.
+* @return if successful, a zero; otherwise an error code.
+*/
+int GvrsElementReadBlockFloat(GvrsElement* element, int row0, int col0, int nRows, int nCols, float* values);
+
+/**
+* Writes a rectangular block of floating-point values to the GVRS store.
+* For integer-coded-float elements, the values are converted in bulk using
+* code = floor((value - offset) * scale + 0.5); NaNs are stored as the fill value.
+* @param element a valid instance associated with a GVRS file opened for writing.
+* @param row0 the first row of the block.
+* @param col0 the first column of the block.
+* @param nRows the number of rows in the block.
+* @param nCols the number of columns in the block.
+* @param values an array of dimension nRows*nCols giving the values in row-major order.
+* @return if successful, a zero; otherwise an error code.
+*/
+int GvrsElementWriteBlockFloat(GvrsElement* element, int row0, int col0, int nRows, int nCols, const float* values);
+
 /**
 * Uses the element as a counter, reads the existing value at the cell, increments it by one,
 * and stores it in the raster. This operation is defined elements having a data type of either
@@ -0,0 +1,99 @@
+/* --------------------------------------------------------------------
+ *
+ * The MIT License
+ *
+ * Copyright (C) 2024  Gary W. Lucas.
+
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ * ---------------------------------------------------------------------
+ */
+
+#include "Gvrs.h"
+
+#ifndef GVRS_ACCESS_TRACE_H
+#define GVRS_ACCESS_TRACE_H
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/**
+* Records the sequence of tile accesses made by a GVRS instance so that it can be
+* replayed against simulated tile caches of different sizes and replacement policies
+* (see examples/GvrsTraceSimulator.c).  Each request for a tile that reaches the
+* tile cache is recorded.  Repeated accesses to the tile at the head of the cache
+* are served without consulting the cache and are not recorded, so consecutive
+* accesses to the same tile appear in the trace only once.  Requests for tiles
+* that are not populated are not recorded.  When a tile is read from the file, the
+* size of its record is included in the trace so that the simulation can estimate the
+* cost of cache misses.
+* <p>
+* The trace is written in a compact binary form in which each access is given
+* as a variable-length, zig-zag encoded difference from the previous tile index.
+*/
+typedef struct GvrsAccessTraceTag {
+	int32_t nRowsOfTiles;
+	int32_t nColsOfTiles;
+	int32_t nBytesForTileData;  // the memory required for one decoded tile
+	int32_t maxTileCacheSize;   // the tile-cache size when the trace was started
+	int64_t nAccesses;
+	int32_t* tileIndices;       // the tile index for each access
+	int32_t* recordSizes;       // the record size by tile index, zero if not known
+}GvrsAccessTrace;
+
+/**
+* Starts recording the tile accesses of a GVRS instance to a file.  If a trace is
+* already in progress, it is finished before the new trace is started.  The trace is
+* finished when the instance is closed.
+* @param gvrs a valid GVRS instance.
+* @param path the path of the trace file to be written.
+* @return if successful, zero; otherwise an error code.
+*/
+int GvrsAccessTraceStart(Gvrs* gvrs, const char* path);
+
+/**
+* Finishes a trace started by GvrsAccessTraceStart and closes the trace file.
+* If no trace is in progress, no action is taken.
+* @param gvrs a valid GVRS instance.
+* @return if successful, zero; otherwise an error code.
+*/
+int GvrsAccessTraceStop(Gvrs* gvrs);
+
+/**
+* Reads a trace file into memory.
+* @param path the path of a trace file.
+* @param trace a pointer to a variable to receive the trace.
+* @return if successful, zero; otherwise an error code.
+*/
+int GvrsAccessTraceRead(const char* path, GvrsAccessTrace** trace);
+
+/**
+* Frees the memory associated with a trace.
+* @param trace a valid trace; or a null.
+* @return a null pointer.
+*/
+GvrsAccessTrace* GvrsAccessTraceFree(GvrsAccessTrace* trace);
+
+#ifdef __cplusplus
+}
+#endif
+
+
+#endif
@@ -211,6 +211,19 @@ extern "C"
 	int GvrsBuilderAddElementFloat(GvrsBuilder* builder, const char* name, GvrsElementSpec** spec);
 	int GvrsBuilderAddElementIntCodedFloat(GvrsBuilder* builder, const char* name, float scale, float offset, GvrsElementSpec** spec);
 
+	/**
+	* Adds an element specification that duplicates the definition of an element
+	* from an existing GVRS instance, including its data type, range and fill values,
+	* continuity setting, units-to-meters factor, label, description, and unit of measure.
+	* @param builder a valid pointer to a builder structure.
+	* @param name the name for the new element; or a null to use the name of the source element.
+	* @param source a valid element from an existing GVRS instance.
+	* @param spec a pointer to a variable to receive the new specification; or a null
+	* if the application does not need to modify the specification.
+	* @return if successful, zero; otherwise an error code.
+	*/
+	int GvrsBuilderAddElementCopy(GvrsBuilder* builder, const char* name, GvrsElement* source, GvrsElementSpec** spec);
+
 
 	int GvrsElementSpecSetRangeFloat(GvrsElementSpec* eSpec, float min, float max);
 	int GvrsElementSpecSetRangeInt(GvrsElementSpec* eSpec, int32_t iMin, int32_t iMax);
@@ -293,6 +306,98 @@ extern "C"
 	int GvrsBuilderOpenNewGvrs(GvrsBuilder* builder, const char* path, Gvrs** gvrs);
 
 
+	/**
+	* Specifies the treatment of data compression when copying the content of a GVRS file.
+	*/
+	typedef enum {
+		GvrsCopyCompressionSource = 0,   // use the same codecs as the source file
+		GvrsCopyCompressionNone = 1,     // store the output without data compression
+		GvrsCopyCompressionStandard = 2  // use the standard codecs
+	} GvrsCopyCompression;
+
+	/**
+	* Provides options for the GvrsCopy function.  Applications should use
+	* GvrsCopyOptionsInit to populate the structure before modifying its settings.
+	*/
+	typedef struct GvrsCopyOptionsTag {
+		int nRowsInTile;
+		int nColsInTile;
+		GvrsCopyCompression compression;
+		int checksumEnabled;
+		int copyMetadata;
+
+		// The order for the tile records in the output.  When a placement other than
+		// sequential is specified, the tiles are written along the space-filling curve,
+		// so copying a file serves as a compaction pass that also reorders its tiles.
+		// This is the only means of placing tile records along a curve: tiles written
+		// through the tile cache are placed in the order in which they are evicted.
+		GvrsTilePlacement tilePlacement;
+
+		// The number of threads used to decode and re-tile the tiles that cannot be
+		// transferred as stored.  If zero or negative, the number of processors is used.
+		int nThreads;
+
+		// The following values are populated by the copy operation.
+		// Tiles that can be transferred as stored in the source file
+		// are counted as "raw".  Tiles that have to be decoded and re-encoded
+		// (or re-tiled) are counted as "transcoded".
+		int64_t nTilesCopiedRaw;
+		int64_t nTilesTranscoded;
+	}GvrsCopyOptions;
+
+	/**
+	* Initializes a copy-options structure so that the output of a copy operation
+	* will use the same tile size, data compression, and checksum settings as the source.
+	* @param source a valid GVRS instance.
+	* @param options a valid pointer to a structure to receive the settings.
+	* @return if successful, zero; otherwise an error code.
+	*/
+	int GvrsCopyOptionsInit(Gvrs* source, GvrsCopyOptions* options);
+
+	/**
+	* Creates a new GVRS file containing the content of the source, including its coordinate
+	* system, element specifications, and (optionally) metadata.
+	* <p>
+	* When the tile size of the output matches the source and the output uses codecs
+	* with the same identification as those that were used to compress a tile,
+	* the tile record is transferred directly from the source file to the output
+	* without decompressing it.  Otherwise, the tile is decoded and written using
+	* the conventional tile-cache mechanism.  The source may be opened for either
+	* read-only or read-write access.  If it is opened for writing, any pending tiles
+	* will be written to the source file before the copy is performed.
+	* <p>
+	* The output contains no free space.  When the tilePlacement option specifies
+	* a space-filling curve, the tile records are also reordered along the curve,
+	* so copying a file that has been extensively modified serves as a compaction pass.
+	* @param source a valid GVRS instance.
+	* @param path the path for the output file; must not be the same as the path for the source.
+	* @param options a pointer to a valid options structure, or a null to use the settings of the source.
+	* @return if successful, zero; otherwise an error code.
+	*/
+	int GvrsCopy(Gvrs* source, const char* path, GvrsCopyOptions* options);
+
+	/**
+	* Creates a new GVRS file containing a rectangular subset of the source.  The output
+	* carries over the element specifications, the metadata (optionally), and
+	* the coordinate system of the source, adjusted so that each cell in the output has
+	* the same model coordinates as the corresponding cell in the source.
+	* <p>
+	* When the output uses the same tile size as the source and the first row and column
+	* of the subset fall on tile boundaries, the tiles that lie entirely inside the subset
+	* are transferred as stored in the source file (see GvrsCopy).  Only the tiles along
+	* the edges of the subset are decoded and re-tiled.  The decoding is performed
+	* by multiple threads as specified by the nThreads option.
+	* @param source a valid GVRS instance.
+	* @param row0 the first row of the subset, inclusive.
+	* @param col0 the first column of the subset, inclusive.
+	* @param row1 the last row of the subset, inclusive.
+	* @param col1 the last column of the subset, inclusive.
+	* @param path the path for the output file; must not be the same as the path for the source.
+	* @param options a pointer to a valid options structure, or a null to use the settings of the source.
+	* @return if successful, zero; otherwise an error code.
+	*/
+	int GvrsExtractSubset(Gvrs* source, int row0, int col0, int row1, int col1, const char* path, GvrsCopyOptions* options);
+
 
 
 	
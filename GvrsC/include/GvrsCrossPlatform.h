@@ -46,6 +46,13 @@ extern "C"
  */ 
 int64_t GvrsTimeMS();
 
+/**
+ * Gets the value of a monotonic clock in nanoseconds.  The value is suitable only
+ * for measuring elapsed time; its origin is not specified.
+ * @return a positive integer.
+ */
+int64_t GvrsTimeNS();
+
 
 /**
 * Performs a robust string copy operation.  While this function is similar to the POSIX strncpy,
@@ -60,6 +67,112 @@ int64_t GvrsTimeMS();
 int GvrsStrncpy(char* destination, size_t destinationSize, const char* source);
 
 
+/**
+* An opaque structure for a mutual-exclusion lock.  The implementation uses
+* POSIX threads or the Windows synchronization functions depending on the platform.
+*/
+typedef struct GvrsMutexTag GvrsMutex;
+
+/**
+* An opaque structure for a condition variable.  A condition variable is always
+* used together with a mutex.
+*/
+typedef struct GvrsConditionTag GvrsCondition;
+
+/**
+* An opaque structure for a thread of execution.
+*/
+typedef struct GvrsThreadTag GvrsThread;
+
+/**
+* Allocates and initializes a mutex.
+* @param mutex a pointer to a variable to receive the mutex.
+* @return if successful, zero; otherwise, an error code.
+*/
+int GvrsMutexInit(GvrsMutex** mutex);
+
+/**
+* Acquires the lock for the mutex, blocking until it becomes available.
+* @param mutex a valid mutex.
+*/
+void GvrsMutexLock(GvrsMutex* mutex);
+
+/**
+* Releases the lock for the mutex.
+* @param mutex a valid mutex that is held by the calling thread.
+*/
+void GvrsMutexUnlock(GvrsMutex* mutex);
+
+/**
+* Frees the resources associated with a mutex.  The mutex must not be locked.
+* @param mutex a valid mutex, or a null.
+* @return a null pointer.
+*/
+GvrsMutex* GvrsMutexFree(GvrsMutex* mutex);
+
+/**
+* Allocates and initializes a condition variable.
+* @param condition a pointer to a variable to receive the condition variable.
+* @return if successful, zero; otherwise, an error code.
+*/
+int GvrsConditionInit(GvrsCondition** condition);
+
+/**
+* Releases the mutex and blocks until the condition variable is signaled,
+* then re-acquires the mutex.  As with the underlying platform functions,
+* the wait may end without a signal (a "spurious wakeup"), so the calling code
+* should test its condition in a loop.
+* @param condition a valid condition variable.
+* @param mutex a valid mutex that is held by the calling thread.
+*/
+void GvrsConditionWait(GvrsCondition* condition, GvrsMutex* mutex);
+
+/**
+* Wakes all threads that are waiting on the condition variable.
+* @param condition a valid condition variable.
+*/
+void GvrsConditionSignal(GvrsCondition* condition);
+
+/**
+* Frees the resources associated with a condition variable.  No threads may be waiting on it.
+* @param condition a valid condition variable, or a null.
+* @return a null pointer.
+*/
+GvrsCondition* GvrsConditionFree(GvrsCondition* condition);
+
+/**
+* Starts a new thread that runs the specified function.
+* @param thread a pointer to a variable to receive the thread reference.
+* @param function the function to be run by the thread.
+* @param argument the argument to be passed to the function.
+* @return if successful, zero; otherwise, an error code.
+*/
+int GvrsThreadStart(GvrsThread** thread, int (*function)(void*), void* argument);
+
+/**
+* Waits for a thread to complete and frees its resources.
+* @param thread a thread obtained from GvrsThreadStart.
+* @return the value returned by the thread function, or an error code if the join failed.
+*/
+int GvrsThreadJoin(GvrsThread* thread);
+
+/**
+* Gets the number of processors available to the process.
+* @return a positive integer.
+*/
+int GvrsGetProcessorCount();
+
+/**
+* Advises the operating system that a portion of a file will be accessed in the
+* near future so that it may begin reading it in the background.  On platforms that
+* do not support such advice, no action is taken.
+* @param fp a valid file.
+* @param offset the position of the first byte of the portion of the file.
+* @param length the number of bytes in the portion of the file.
+*/
+void GvrsAdviseWillNeed(FILE* fp, int64_t offset, int64_t length);
+
+
 
 #ifdef __cplusplus
 }
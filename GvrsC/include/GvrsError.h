@@ -59,6 +59,12 @@ extern "C"
 #define GVRSERR_NAME_NOT_UNIQUE             -22
 #define GVRSERR_INVALID_PARAMETER           -23
 #define GVRSERR_COUNTER_OVERFLOW            -24
+#define GVRSERR_THREAD_FAILURE              -25    // unable to create or join a thread
+#define GVRSERR_HANDLE_LIMIT                -26    // all handles in a pool are in use
+
+// The following status codes are not errors.  They indicate that an
+// operation did not produce a result, but may succeed if tried again later.
+#define GVRS_NOT_CACHED                      1    // a tile is not in memory and was queued for loading
 
 
 #ifdef __cplusplus
@@ -0,0 +1,137 @@
+/* --------------------------------------------------------------------
+ *
+ * The MIT License
+ *
+ * Copyright (C) 2024  Gary W. Lucas.
+
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ * ---------------------------------------------------------------------
+ */
+
+#include "Gvrs.h"
+
+#ifndef GVRS_EVENTS_H
+#define GVRS_EVENTS_H
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/**
+* Identifies the tile-lifecycle events that may be reported to an application.
+*/
+typedef enum {
+	GvrsEventMissStart = 0,         // a tile that is not in the cache is about to be read
+	GvrsEventMissEnd = 1,           // the read for a tile is complete (status indicates success)
+	GvrsEventDecodeStart = 2,       // a compressed segment of a tile is about to be decoded
+	GvrsEventDecodeEnd = 3,         // the decoding of a segment is complete
+	GvrsEventEvict = 4,             // a tile was removed from the cache
+	GvrsEventWriteBack = 5,         // a modified tile was written to the file
+	GvrsEventFileSpaceAlloc = 6,    // file space was allocated for a tile record
+	GvrsEventFileSpaceDealloc = 7   // the file space for a tile record was released
+}GvrsEventType;
+
+/**
+* The number of event types.
+*/
+#define GVRS_EVENT_TYPE_COUNT 8
+
+/**
+* A mask that selects all event types.  Individual event types are selected
+* using (1u << eventType).
+*/
+#define GVRS_EVENT_MASK_ALL 0xffu
+
+/**
+* Describes a tile-lifecycle event.  Fields that do not apply to an event are set to -1
+* (or to a null for the codec name).
+*/
+typedef struct GvrsEventTag {
+	GvrsEventType eventType;
+	int64_t timeNS;          // the time of the event from GvrsTimeNS()
+	int64_t durationNS;      // for end events, write-backs, and file-space operations, the time required
+	int tileIndex;
+	int elementIndex;        // for decode events
+	int codecIndex;          // for decode events
+	const char* codecName;   // for decode events
+	int64_t nBytes;          // the size of the record or segment, if known
+	int64_t filePosition;    // the file position of the tile record, if known
+	int status;              // for end events and write-backs, zero if successful; otherwise an error code
+}GvrsEvent;
+
+/**
+* A function that receives tile-lifecycle events.  Events are reported from the thread
+* that is using the GVRS instance.  The function should return promptly and
+* must not access the GVRS instance.
+* @param gvrs the instance that reported the event.
+* @param event the event; the structure is valid only for the duration of the call.
+* @param appData the application data supplied when the callback was registered.
+*/
+typedef void (*GvrsEventCallback)(Gvrs* gvrs, const GvrsEvent* event, void* appData);
+
+/**
+* A function that is called when an event callback is replaced or cleared (including
+* when the GVRS instance is closed) so that the application can release the
+* resources associated with its application data.
+* @param appData the application data supplied when the callback was registered.
+*/
+typedef void (*GvrsEventDispose)(void* appData);
+
+/**
+* Registers a function to receive tile-lifecycle events from a GVRS instance.  An instance has
+* at most one callback, so registering a callback replaces the existing one.  Passing a null callback
+* clears the registration.  When no callback is registered, event reporting costs a single
+* pointer test at each point where an event could be reported.
+* @param gvrs a valid GVRS instance.
+* @param eventMask a bit mask selecting the event types to be reported (see GVRS_EVENT_MASK_ALL).
+* @param callback the function to receive events; or a null to clear the registration.
+* @param dispose an optional function to be called when the registration is replaced or cleared;
+* may be null.
+* @param appData application data to be passed to the callback; may be null.
+* @return if successful, zero; otherwise an error code.
+*/
+int GvrsSetEventCallback(Gvrs* gvrs, unsigned int eventMask, GvrsEventCallback callback, GvrsEventDispose dispose, void* appData);
+
+/**
+* Gets a name for an event type.
+* @param eventType a valid event type.
+* @return a static string.
+*/
+const char* GvrsGetEventName(GvrsEventType eventType);
+
+/**
+* Starts writing the tile-lifecycle events for a GVRS instance to a file in the
+* Chrome trace-event format (a JSON array that can be loaded in chrome://tracing or Perfetto).
+* Misses and decoding operations are written as duration events, write-backs and file-space
+* operations as complete events, and evictions as instant events.  The trace replaces any
+* event callback that is registered for the instance.  The trace is finished when the
+* callback is cleared or replaced, or when the instance is closed.
+* @param gvrs a valid GVRS instance.
+* @param path the path for the trace file.
+* @return if successful, zero; otherwise an error code.
+*/
+int GvrsStartChromeTrace(Gvrs* gvrs, const char* path);
+
+#ifdef __cplusplus
+}
+#endif
+
+
+#endif
@@ -0,0 +1,147 @@
+/* --------------------------------------------------------------------
+ *
+ * The MIT License
+ *
+ * Copyright (C) 2024  Gary W. Lucas.
+
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ * ---------------------------------------------------------------------
+ */
+
+
+#include "Gvrs.h"
+
+#ifndef GVRS_HANDLE_POOL_H
+#define GVRS_HANDLE_POOL_H
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/**
+* Maintains a set of open GVRS instances (handles) that can be reused by applications
+* that access a large number of files.  Opening a file requires reading its header and
+* allocating a tile cache.  When an application accesses the same files repeatedly,
+* the pool avoids that cost by keeping recently used handles open.
+* <p>
+* Handles are obtained using GvrsHandlePoolAcquire and returned using GvrsHandlePoolRelease.
+* While a handle is acquired, it is reserved for the exclusive use of the caller.  If
+* the same file is acquired by more than one caller at a time, the pool opens
+* an additional handle for the file.  Released handles remain open
+* until the pool needs to close them to honor its limit on the number of open handles
+* or its budget for tile-cache memory.  When a handle must be closed, the pool selects
+* the handle that has been idle for the longest time (least-recently used).
+* <p>
+* Before a released handle is reused, the pool checks whether the underlying file was
+* changed.  If the file-system modification time or size of the file differs from
+* the values recorded when the handle was opened, the pool reads the header of the file
+* and compares its UUID and modification time to those of the handle.
+* If they differ (or if the file is opened for writing by another process), the
+* handle is closed and the file is opened again.
+* <p>
+* All handles are opened for read-only access.  The functions of the pool
+* may be called from multiple threads.  Each handle may be used by only one thread at a time.
+* <p>
+* The configuration elements of the structure may be modified by the application
+* before the pool is used.  The remaining elements are maintained by the pool and are
+* provided for diagnostic purposes.
+*/
+typedef struct GvrsHandlePoolTag {
+	int maxOpenHandles;      // the maximum number of handles that may be open at once
+	int64_t tileCacheBudget; // the maximum bytes for the tile caches of all handles, zero for no limit
+	GvrsTileCacheSizeType tileCacheSize;  // the tile-cache size assigned to handles when they are opened
+	int64_t validationIntervalMS; // the minimum time between checks for file modification, zero to check on every acquisition
+
+	int nOpenHandles;        // the number of handles currently open
+	int nHandlesInUse;       // the number of handles currently acquired
+	int64_t tileCacheBytes;  // the total tile-cache size for the open handles
+
+	int64_t nAcquisitions;   // the number of calls to acquire a handle
+	int64_t nReuses;         // the number of acquisitions satisfied by an open handle
+	int64_t nOpens;          // the number of files opened
+	int64_t nStaleHandles;   // the number of handles discarded because the file was changed
+	int64_t nEvictions;      // the number of idle handles closed by the pool
+
+	void* mutex;
+	void* buckets;           // a hash table of handle entries, indexed by path
+	int nBuckets;
+	void* head;              // the most recently used entry
+	void* tail;              // the least recently used entry
+}GvrsHandlePool;
+
+
+/**
+* Allocates a handle pool.  The tile-cache size for the handles is initialized
+* to GvrsTileCacheSizeSmall and the validation interval is initialized to zero.
+* @param maxOpenHandles the maximum number of handles that may be open at once, a positive integer.
+* Each handle requires one file descriptor.
+* @param tileCacheBudget the maximum number of bytes to be used for the tile caches of all
+* handles combined, or zero for no limit.  The size of the tile cache for a handle is computed as
+* the maximum number of tiles in its cache multiplied by the number of bytes for a tile.
+* @param pool a pointer to a variable to receive the pool.
+* @return if successful, zero; otherwise an error code.
+*/
+int GvrsHandlePoolAlloc(int maxOpenHandles, int64_t tileCacheBudget, GvrsHandlePool** pool);
+
+/**
+* Gets an open GVRS instance for the specified path, reusing an idle handle if one is available.
+* The handle is reserved for the caller until it is released.  Applications must not
+* close the handle using GvrsClose.
+* <p>
+* If the pool has reached its limit of open handles, the least-recently used idle handle
+* is closed.  If all the handles are in use, the function returns GVRSERR_HANDLE_LIMIT.
+* @param pool a valid pool.
+* @param path the path to a GVRS file.  Handles are matched by an exact comparison of paths.
+* @param gvrs a pointer to a variable to receive the handle.
+* @return if successful, zero; otherwise an error code.
+*/
+int GvrsHandlePoolAcquire(GvrsHandlePool* pool, const char* path, Gvrs** gvrs);
+
+/**
+* Returns a handle to the pool so that it may be reused.  If the pool exceeds its
+* tile-cache budget, idle handles are closed in least-recently used order.
+* @param pool a valid pool.
+* @param gvrs a handle obtained from GvrsHandlePoolAcquire.
+* @return if successful, zero; otherwise an error code.
+*/
+int GvrsHandlePoolRelease(GvrsHandlePool* pool, Gvrs* gvrs);
+
+/**
+* Closes the handles that have not been used for the specified time.  Applications
+* may call this function periodically to release the resources of idle handles.
+* @param pool a valid pool.
+* @param idleTimeMS the idle time, in milliseconds; zero to close all idle handles.
+* @return if successful, the number of handles closed; otherwise, a negative error code.
+*/
+int GvrsHandlePoolCloseIdle(GvrsHandlePool* pool, int64_t idleTimeMS);
+
+/**
+* Closes all handles and frees the resources associated with the pool.
+* All handles must be released before the pool is freed.
+* @param pool a valid pool, or a null.
+* @return a null pointer.
+*/
+GvrsHandlePool* GvrsHandlePoolFree(GvrsHandlePool* pool);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
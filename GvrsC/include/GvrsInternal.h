@@ -87,6 +87,7 @@ static const long FILEPOS_OFFSET_TO_TILE_DIR = 80;
 		int referenceArrayIndex;
 
 		int writePending;
+		int pinCount;    // non-zero if the tile is pinned (see GvrsPinRegion)
 		int32_t fileRecordContentSize;
 		int64_t filePosition;  // zero if not written to file
 
@@ -106,6 +107,10 @@ static const long FILEPOS_OFFSET_TO_TILE_DIR = 80;
 		// compact references are used.  lOffsets for extended references.
 		uint32_t* iOffsets;
 		int64_t* lOffsets;
+		// the size of each tile record (including its header and checksum) in the
+		// same arrangement as the offsets.  A value of zero indicates that the size
+		// has not yet been obtained from the file.  The sizes are not stored in the file.
+		int32_t* recordSizes;
 	}GvrsTileDirectory;
 
 
@@ -173,8 +178,64 @@ static const long FILEPOS_OFFSET_TO_TILE_DIR = 80;
 
 		int nElementsInTupple;
 		GvrsTileOutputBlock* outputBlocks;
+
+		// Pinned tiles are allocated individually and are kept on a list of their own
+		// rather than the priority queue, so they are never evicted.
+		GvrsTile* pinnedTiles;
+		int32_t nPinnedTiles;
+
+		// Automatic sizing (see GvrsTileCacheSizeAutomatic).  The maxTileCacheSize gives
+		// the ceiling for the cache.  Tiles in excess of the current size are held on
+		// the reserve list.  Recently evicted tile indices are kept in a ring buffer
+		// (the ghost list) so that misses on tiles that a larger cache would have
+		// retained can be detected.
+		int32_t automaticSize;
+		int32_t currentTileCacheSize;
+		GvrsTile* reserveList;
+		int32_t* ghostIndices;
+		int64_t* ghostSerials;
+		int32_t nGhosts;
+		int32_t ghostNext;
+		int64_t nEvictions;
+		int32_t windowAccesses;
+		int32_t windowMisses;
+		int32_t windowGhostHits;
+		int32_t windowMaxDepth;
+		int32_t nSaturatedWindows;
+		int32_t shrinkDelay;
+
+		// Optional in-memory cell layout (see GvrsSetTileLayout).  When the index tables
+		// are set, the cell at (rowInTile, colInTile) is stored at the position
+		// cellRowIndex[rowInTile] + cellColIndex[colInTile].  Tile records in the file,
+		// the codecs, and the shared tile cache always use row-major order, so data is
+		// converted when tiles are read and written.  The layout buffer is used for the conversions.
+		GvrsTileLayout tileLayout;
+		int32_t* cellRowIndex;
+		int32_t* cellColIndex;
+		uint8_t* layoutBuffer;
+
+		// Read-ahead for tile records that are stored consecutively in the file
+		// (see GvrsSetReadAhead).  The buffer holds a block of the file starting at
+		// readAheadPosition.  The readAheadNext element gives the file position at
+		// which the record following the most recently read record would start.
+		uint8_t* readAheadBuffer;
+		int32_t readAheadCapacity;
+		int32_t readAheadLength;
+		int64_t readAheadPosition;
+		int64_t readAheadNext;
+		int64_t nReadAheadFills;
+		int64_t nReadAheadHits;
+
+		// a reusable buffer for tile records that are read individually
+		uint8_t* recordBuffer;
+		int32_t recordBufferCapacity;
 	}GvrsTileCache;
 
+	// Computes the position of a cell within the data for a tile.
+#define GVRS_CELL_INDEX(tc, rowInTile, colInTile) \
+	((tc)->cellRowIndex ? (tc)->cellRowIndex[rowInTile] + (tc)->cellColIndex[colInTile] \
+		: (rowInTile) * (tc)->nColsInTile + (colInTile))
+
 
 	typedef struct GvrsMetadataReferenceTag {
 		void* gvrs;
@@ -216,15 +277,122 @@ static const long FILEPOS_OFFSET_TO_TILE_DIR = 80;
 		int64_t nFinish;
 	}GvrsFileSpaceManager;
 
+	/**
+	* Holds the resources shared by a GVRS instance and its reader clones.  The
+	* resources belong to the instance from which the first clone was created
+	* and are freed when the last instance that refers to them is closed.
+	*/
+	typedef struct GvrsSharedStateTag {
+		GvrsMutex* mutex;
+		int referenceCount;
+		char* path;
+		char* productLabel;
+		GvrsTileDirectory* tileDirectory;
+		GvrsMetadataDirectory* metadataDirectory;
+		int nElementsInTupple;
+		GvrsElement** elements;  // element specifications, strings are shared with the clones' elements
+
+		// Writer clones share the file pointer and file-space manager of the writer.
+		// The write mutex serializes access to them.  The directory mutex guards the
+		// tile directory, which a writer may modify while other instances read it.
+		// When both are needed, the write mutex is acquired first.
+		GvrsMutex* writeMutex;
+		GvrsMutex* directoryMutex;
+		Gvrs* writer;
+		int nWriterClones;
+	}GvrsSharedState;
+
+	/**
+	* Determines whether the resources of an instance are shared with other
+	* instances (clones) that are currently open.  If not, the instance may modify
+	* them without locking because no other instance can refer to them.
+	* @param gvrs a valid instance.
+	* @return 1 if the resources are shared; otherwise, 0.
+	*/
+	int GvrsIsStateShared(Gvrs* gvrs);
+
+	/**
+	* Acquires the lock that serializes access to the file pointer and file-space
+	* manager that a writer shares with its writer clones.  If the instance was not
+	* opened for writing, or has no writer clones, no action is taken.  Reader clones
+	* have their own file pointers and never need the lock.
+	* @param gvrs a valid instance.
+	*/
+	void GvrsWriteLock(Gvrs* gvrs);
+
+	/**
+	* Releases the lock acquired by GvrsWriteLock.
+	* @param gvrs a valid instance.
+	*/
+	void GvrsWriteUnlock(Gvrs* gvrs);
+
+	/**
+	* Acquires the lock that guards the tile directory of an instance whose resources
+	* are shared with clones.  The lock should be held only for the directory access
+	* itself.  If the instance has no clones, no action is taken.
+	* @param gvrs a valid instance.
+	*/
+	void GvrsDirectoryLock(Gvrs* gvrs);
+
+	/**
+	* Releases the lock acquired by GvrsDirectoryLock.
+	* @param gvrs a valid instance.
+	*/
+	void GvrsDirectoryUnlock(Gvrs* gvrs);
+
 	const char* GvrsGetRecordTypeName(int index);
 	GvrsRecordType  GvrsGetRecordType(int index);
 	 
+	/**
+	* Ensures that the tile directory for a GVRS instance is loaded.  The tile directory
+	* is read from the file on first use rather than when the file is opened.
+	* @param gvrs a valid instance.
+	* @return if successful, zero; otherwise an error code.
+	*/
+	int GvrsLoadTileDirectory(Gvrs* gvrs);
+
+	/**
+	* Ensures that the metadata directory for a GVRS instance is loaded.  The metadata directory
+	* is read from the file on first use rather than when the file is opened.
+	* @param gvrs a valid instance.
+	* @return if successful, zero; otherwise an error code.
+	*/
+	int GvrsLoadMetadataDirectory(Gvrs* gvrs);
+
 	int GvrsTileDirectoryAllocEmpty(int nRowsOfTiles, int nColsOfTiles, GvrsTileDirectory** tileDirectoryReference);
 	int GvrsTileDirectoryRead(Gvrs* gvrs, int64_t fileOffset, GvrsTileDirectory** tileDirectoryReference);
 	int GvrsTileDirectoryWrite(Gvrs* gvrs, int64_t* tileDirectoryPos);
 	GvrsTileDirectory* GvrsTileDirectoryFree(GvrsTileDirectory* tileDirectory);
 	int64_t GvrsTileDirectoryGetFilePosition(GvrsTileDirectory* tileDir, int tileIndex);
 
+	/**
+	* Gets the size of the record for a tile, including the record header and checksum.
+	* @param tileDir a pointer to a valid tile directory structure
+	* @param tileIndex a positive integer
+	* @return if the size is known, a positive value; otherwise, zero.
+	*/
+	int32_t GvrsTileDirectoryGetRecordSize(GvrsTileDirectory* tileDir, int tileIndex);
+
+	/**
+	* Sets the size of the record for a tile that was obtained from its header.
+	* The tile must already be registered in the directory.  If the directory is shared
+	* with clones, the caller must hold the directory lock (see GvrsDirectoryLock).
+	* @param tileDir a pointer to a valid tile directory structure
+	* @param tileIndex a positive integer
+	* @param recordSize the size of the record, including the record header and checksum.
+	*/
+	void GvrsTileDirectorySetRecordSize(GvrsTileDirectory* tileDir, int tileIndex, int32_t recordSize);
+
+	/**
+	* Reads the record header for each populated tile for which the record size is not yet
+	* known and stores the size in the tile directory.  The headers are read in the
+	* order in which the records are stored in the file.  If the directory is shared
+	* with clones, the caller must hold the directory lock (see GvrsDirectoryLock).
+	* @param gvrs a valid instance with a loaded tile directory.
+	* @return if successful, zero; otherwise an error code.
+	*/
+	int GvrsTileDirectoryLoadRecordSizes(Gvrs* gvrs);
+
 
 	/**
 	* Sets the file position for a tile in the GVRS tile directory. The GVRS specification requires that
@@ -233,11 +401,32 @@ static const long FILEPOS_OFFSET_TO_TILE_DIR = 80;
 	* @param td a pointer to a valid tile directory structure
 	* @param tileIndex a positive integer
 	* @param filePosition the filePos in the file at which the tile is stored.
+	* @param recordSize the size of the record including its header and checksum, or zero if not known.
+	*/
+	int GvrsTileDirectoryRegisterFilePosition(GvrsTileDirectory* td, int32_t tileIndex, int64_t filePosition, int32_t recordSize);
+
+	/**
+	* Computes the position of a tile along the space-filling curve for the specified
+	* tile placement.  Tiles are written to the file in increasing order of their keys.
+	* For the sequential placement, the key is always zero.
+	* @param tilePlacement the placement
+	* @param nRowsOfTiles the number of rows of tiles in the raster
+	* @param nColsOfTiles the number of columns of tiles in the raster
+	* @param tileIndex the index of the tile
+	* @return a positive value or zero.
 	*/
-	int GvrsTileDirectoryRegisterFilePosition(GvrsTileDirectory* td, int32_t tileIndex, int64_t filePosition);
+	int64_t GvrsTilePlacementKey(GvrsTilePlacement tilePlacement, int nRowsOfTiles, int nColsOfTiles, int tileIndex);
 
 
 	int GvrsFileSpaceAlloc(GvrsFileSpaceManager* manager, GvrsRecordType recordType, int sizeOfContent, int64_t* filePos);
+
+	/**
+	* Computes the size of the record that GvrsFileSpaceAlloc allocates for the
+	* specified content, including the record header, padding, and checksum.
+	* @param sizeOfContent the size of the content in bytes
+	* @return a positive multiple of 8.
+	*/
+	int32_t GvrsFileSpaceRecordSize(int sizeOfContent);
 	int GvrsFileSpaceDealloc(GvrsFileSpaceManager* manager, int64_t contentPosition);
 	/**
 	* Computes the standard maximum capacity for a tile cache based on the number
@@ -279,6 +468,135 @@ static const long FILEPOS_OFFSET_TO_TILE_DIR = 80;
 	*/
 	GvrsTile* GvrsTileCacheStartNewTile(GvrsTileCache* tc,  int tileIndex, int* errCode);
 
+	/**
+	* Looks up a tile in the tile cache without accessing the file.  If the tile
+	* is found, it is moved to the head of the cache.
+	* @param tc a pointer to a valid tile cache instance.
+	* @param tileIndex the index for the tile of interest.
+	* @return if the tile is in the cache, a pointer to the tile; otherwise, a null.
+	*/
+	GvrsTile* GvrsTileCacheLookup(GvrsTileCache* tc, int tileIndex);
+
+	/**
+	* Installs a tile that was decoded outside the tile cache (for example, by a background loader).
+	* The tile takes ownership of the data and the memory that was previously used by the
+	* tile it replaces is returned through the data argument (it may be a null).  No file access
+	* is performed, so the cache must not contain tiles with pending writes.
+	* The data must be arranged in the cell layout of the tile cache.
+	* If the tile is already in the cache, no action is taken and the data is not transferred.
+	* @param tc a pointer to a valid tile cache instance.
+	* @param tileIndex the index for the tile.
+	* @param filePos the file position of the tile record.
+	* @param data a pointer to a variable giving the decoded data for the tile; on return
+	* it holds memory that is no longer used by the cache.
+	* @return a pointer to the tile.
+	*/
+	GvrsTile* GvrsTileCacheInstallTile(GvrsTileCache* tc, int tileIndex, int64_t filePos, uint8_t** data);
+
+	/**
+	* Installs the tiles that were decoded by the background loader (if any) into
+	* the tile cache of a GVRS instance.  This function must be called only by the thread
+	* that is using the GVRS instance.
+	* @param gvrs a valid instance.
+	* @param tileIndex the index of a tile of interest; or -1 if there is no tile of interest.
+	* @param errCode a pointer to a variable to receive the error code if the loader
+	* failed to load the tile of interest.
+	* @return if the tile of interest is in the cache after the installation, a pointer to the tile;
+	* otherwise, a null.
+	*/
+	GvrsTile* GvrsTileLoaderInstall(Gvrs* gvrs, int tileIndex, int* errCode);
+
+	/**
+	* Transfers the pinned tiles from one tile cache to another.  Used when the
+	* tile cache for a GVRS instance is replaced.
+	* @param source the tile cache that holds the pinned tiles.
+	* @param target a newly allocated tile cache for the same GVRS instance.
+	* @return if successful, zero; otherwise an error code.
+	*/
+	int GvrsTileCacheTransferPins(GvrsTileCache* source, GvrsTileCache* target);
+
+	/**
+	* Enables automatic sizing for a newly allocated tile cache.  The size of the
+	* cache is adjusted as tiles are accessed, up to the maximum size specified when
+	* the cache was allocated.
+	* @param tc a pointer to a valid tile cache instance that does not yet contain tiles.
+	* @param initialSize the initial number of tiles permitted in the cache.
+	* @return if successful, zero; otherwise an error code.
+	*/
+	int GvrsTileCacheEnableAutomaticSize(GvrsTileCache* tc, int initialSize);
+
+	/**
+	* Sets the in-memory cell layout for a tile cache.  Tiles with pending writes are
+	* written to the file and the data for the tiles that remain in memory (including
+	* pinned tiles) is rearranged.
+	* @param tc a pointer to a valid tile cache instance.
+	* @param tileLayout a valid layout; the Morton layout requires tile dimensions
+	* that are integral powers of two.
+	* @return if successful, zero; otherwise an error code.
+	*/
+	int GvrsTileCacheSetLayout(GvrsTileCache* tc, GvrsTileLayout tileLayout);
+
+	/**
+	* Rearranges the row-major data for a tile into the cell layout of a tile cache.
+	* The conversion exchanges the data with the layout buffer of the tile cache,
+	* so the data pointer may be replaced.  No action is taken for row-major layouts.
+	* @param tc a pointer to a valid tile cache instance.
+	* @param data a pointer to a variable giving the tile data.
+	*/
+	void GvrsTileCacheApplyLayout(GvrsTileCache* tc, uint8_t** data);
+
+	/**
+	* Records a tile access for an instance that has an access trace in progress.
+	* @param gvrs a valid instance with a non-null access trace.
+	* @param tileIndex the index of the tile that was accessed.
+	* @param recordSize if the tile was read from the file, the size of its record;
+	* otherwise, zero.
+	*/
+	void GvrsAccessTraceRecord(Gvrs* gvrs, int tileIndex, int32_t recordSize);
+
+	/**
+	* Adds the latency for a tile read to the timing statistics of an instance.
+	* @param gvrs a valid instance with timing enabled.
+	* @param ns the time required to read and decode the tile, in nanoseconds.
+	*/
+	void GvrsStatisticsRecordMiss(Gvrs* gvrs, int64_t ns);
+
+	/**
+	* Reports an event to the callback registered for an instance, if the event
+	* is enabled by its mask (see GvrsEvents.h).
+	* @param gvrs a valid instance with a non-null event-hook reference.
+	* @param eventType the type of event, a GvrsEventType value.
+	* @param tileIndex the index of the tile, or -1 if not applicable.
+	* @param elementIndex the index of the element, or -1 if not applicable.
+	* @param codecIndex the index of the codec, or -1 if not applicable.
+	* @param nBytes the number of bytes involved, or -1 if not applicable.
+	* @param filePosition the file position of the tile record, or -1 if not applicable.
+	* @param durationNS for end-of-operation events, the elapsed time in nanoseconds.
+	* @param status zero if the operation succeeded; otherwise, an error code.
+	*/
+	void GvrsEventReport(Gvrs* gvrs, int eventType, int tileIndex, int elementIndex, int codecIndex,
+		int64_t nBytes, int64_t filePosition, int64_t durationNS, int status);
+
+	/**
+	* Copies a decoded tile from the shared tile cache, if available.
+	* @param gvrs a valid instance with an attached shared tile cache.
+	* @param tileIndex the index of the tile.
+	* @param filePos the file position of the tile record.
+	* @param data the storage to receive the tile data.
+	* @return one if the tile was found; otherwise, zero.
+	*/
+	int GvrsSharedTileCacheGet(Gvrs* gvrs, int tileIndex, int64_t filePos, uint8_t* data);
+
+	/**
+	* Posts a decoded tile to the shared tile cache.  If the tile cannot be posted
+	* without waiting for another writer, it is not stored.
+	* @param gvrs a valid instance with an attached shared tile cache.
+	* @param tileIndex the index of the tile.
+	* @param filePos the file position of the tile record.
+	* @param data the tile data.
+	*/
+	void GvrsSharedTileCachePut(Gvrs* gvrs, int tileIndex, int64_t filePos, const uint8_t* data);
+
 	int GvrsMetadataDirectoryAllocEmpty(Gvrs* gvrs, GvrsMetadataDirectory** directory);
 	int GvrsMetadataDirectoryRead(FILE *fp, int64_t filePosMetadataDir, GvrsMetadataDirectory** directory);
 	int GvrsMetadataDirectoryWrite(void* gvrsReference, int64_t* filePosMetadataDirectory);
@@ -0,0 +1,192 @@
+/* --------------------------------------------------------------------
+ *
+ * The MIT License
+ *
+ * Copyright (C) 2024  Gary W. Lucas.
+
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ * ---------------------------------------------------------------------
+ */
+
+
+#include "Gvrs.h"
+#include "GvrsHandlePool.h"
+#include "GvrsInterpolation.h"
+
+#ifndef GVRS_MOSAIC_H
+#define GVRS_MOSAIC_H
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/**
+* Presents a set of GVRS files as a single virtual raster.  The member files must
+* share a common grid: they must use the same cell sizes and the same kind of coordinates
+* (geographic or model) and their grid points must be aligned with each other.
+* A typical example is a set of regional survey tiles produced using a common
+* specification.  The mosaic grid is the smallest grid that contains the grids of all
+* the members.  The mosaic does not support geographic coordinates that wrap
+* across the 180th meridian.
+* <p>
+* A mosaic provides access to a single element, specified by name, which must be
+* defined by all member files. Values are accessed as floating-point numbers.
+* Where member files overlap, they are searched in the order in which they were added to the mosaic.
+* The first member that supplies a value other than its fill value (or NaN) is used.
+* Cells that are not covered by any member, or for which no member supplies a value,
+* are reported as NaN.
+* <p>
+* Member files are opened through a handle pool only when they are first accessed,
+* so the number of open files and the total memory for tile caches are governed
+* by the pool. The mosaic retains a small number of recently-used handles between
+* calls.  A mosaic is not safe for concurrent use by multiple threads, but multiple
+* mosaics (one per thread) may share a single pool.
+*/
+typedef struct GvrsMosaicTag {
+	char elementName[GVRS_ELEMENT_NAME_SZ + 4];
+	GvrsHandlePool* pool;
+	int poolIsOwned;     // indicates that the pool was created by the mosaic
+
+	int geographicCoordinates;
+	double x0;           // the x coordinate of the first column of the mosaic grid
+	double y0;           // the y coordinate of the first row of the mosaic grid
+	double cellSizeX;
+	double cellSizeY;
+	int nRowsInMosaic;
+	int nColsInMosaic;
+	double unitsToMeters;  // taken from the element of the first member
+
+	// the grid of the first member is used as a reference for aligning the others.
+	// the extent of the members is tracked in reference-grid coordinates.
+	double xRef;
+	double yRef;
+	int refRow0;
+	int refCol0;
+	int refRow1;
+	int refCol1;
+
+	int nMembers;
+	int maxHeldHandles;  // the maximum number of member handles retained between calls
+	void* members;
+
+	// a spatial index of the member files, organized as a grid of bins
+	int indexIsValid;
+	int nRowsInBin;
+	int nColsInBin;
+	int nRowsOfBins;
+	int nColsOfBins;
+	void* bins;
+	int64_t useCounter;
+}GvrsMosaic;
+
+/**
+* Allocates a mosaic for the specified element.
+* @param pool the handle pool to be used for accessing member files; or a null,
+* in which case the mosaic creates a pool for its own use.
+* @param elementName the name of the element to be accessed.
+* @param mosaic a pointer to a variable to receive the mosaic.
+* @return if successful, zero; otherwise an error code.
+*/
+int GvrsMosaicAlloc(GvrsHandlePool* pool, const char* elementName, GvrsMosaic** mosaic);
+
+/**
+* Adds a GVRS file to the mosaic.  The header of the file is read to obtain its extent.
+* The file must define the element for the mosaic and its grid must be aligned
+* with the grids of the members that were previously added.
+* @param mosaic a valid mosaic.
+* @param path the path to a GVRS file.
+* @return if successful, zero; otherwise an error code.
+*/
+int GvrsMosaicAddFile(GvrsMosaic* mosaic, const char* path);
+
+/**
+* Maps a coordinate to the row and column of the mosaic grid.  For geographic coordinates,
+* x is the longitude and y is the latitude.
+* @param mosaic a valid mosaic.
+* @param x the x coordinate.
+* @param y the y coordinate.
+* @param row a pointer to a variable to receive the real-valued row.
+* @param column a pointer to a variable to receive the real-valued column.
+*/
+void GvrsMosaicMapToGrid(GvrsMosaic* mosaic, double x, double y, double* row, double* column);
+
+/**
+* Reads the value of the element at the specified cell of the mosaic grid.
+* @param mosaic a valid mosaic.
+* @param row the row of the cell in the mosaic grid.
+* @param column the column of the cell in the mosaic grid.
+* @param value a pointer to a variable to receive the value; NaN if no member provides a value.
+* @return if successful, zero; otherwise an error code. If the cell is outside the
+* mosaic grid, GVRSERR_COORDINATE_OUT_OF_BOUNDS.
+*/
+int GvrsMosaicReadGridFloat(GvrsMosaic* mosaic, int row, int column, float* value);
+
+/**
+* Reads the value of the element at the cell nearest to the specified coordinates.
+* For geographic coordinates, x is the longitude and y is the latitude.
+* @param mosaic a valid mosaic.
+* @param x the x coordinate.
+* @param y the y coordinate.
+* @param value a pointer to a variable to receive the value; NaN if no member provides a value.
+* @return if successful, zero; otherwise an error code.
+*/
+int GvrsMosaicReadFloat(GvrsMosaic* mosaic, double x, double y, float* value);
+
+/**
+* Reads a rectangular block of values from the mosaic grid.  The block may span any
+* number of member files and may extend beyond the mosaic grid. Cells that are not
+* covered by any member are populated with NaN.
+* @param mosaic a valid mosaic.
+* @param row0 the first row of the block.
+* @param col0 the first column of the block.
+* @param nRows the number of rows in the block.
+* @param nCols the number of columns in the block.
+* @param values an array of at least nRows*nCols values to receive the block in row-major order.
+* @return if successful, zero; otherwise an error code.
+*/
+int GvrsMosaicReadBlock(GvrsMosaic* mosaic, int row0, int col0, int nRows, int nCols, float* values);
+
+/**
+* Performs a B-spline interpolation over the mosaic.  The interpolation uses a
+* 4-by-4 neighborhood of cells that may span the seams between member files.
+* The derivatives are computed using the cell sizes of the mosaic grid (see GvrsInterpolateBspline).
+* @param mosaic a valid mosaic.
+* @param x the x coordinate (or longitude) of the interpolation point.
+* @param y the y coordinate (or latitude) of the interpolation point.
+* @param computeDerivatives an value of 0 (no derivatives), 1 (first derivative), or 2 (second derivative)
+* @param result a pointer to a structure to receive the computation results.
+* @return if successful, zero; otherwise an error code.  If the neighborhood
+* extends beyond the mosaic or includes cells without values, GVRSERR_COORDINATE_OUT_OF_BOUNDS.
+*/
+int GvrsMosaicInterpolateBspline(GvrsMosaic* mosaic, double x, double y, int computeDerivatives, GvrsInterpolationResult* result);
+
+/**
+* Releases the member handles retained by the mosaic and frees its resources.
+* If the mosaic created its own pool, the pool is also freed.
+* @param mosaic a valid mosaic, or a null.
+* @return a null pointer.
+*/
+GvrsMosaic* GvrsMosaicFree(GvrsMosaic* mosaic);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
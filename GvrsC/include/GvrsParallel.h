@@ -0,0 +1,225 @@
+/* --------------------------------------------------------------------
+ *
+ * The MIT License
+ *
+ * Copyright (C) 2024  Gary W. Lucas.
+
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ * ---------------------------------------------------------------------
+ */
+
+#include "Gvrs.h"
+
+#ifndef GVRS_PARALLEL_H
+#define GVRS_PARALLEL_H
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+
+/**
+* Defines a rectangular region of a raster.  The bounds are inclusive.
+*/
+typedef struct GvrsRegionTag {
+	int row0;
+	int col0;
+	int row1;
+	int col1;
+}GvrsRegion;
+
+
+/**
+* Provides the information for a single unit of work in a parallel operation.
+* Each unit of work corresponds to one tile that intersects the region of interest.
+*/
+typedef struct GvrsParallelTaskTag {
+	/**
+	* The GVRS instance assigned to the worker that is processing the tile.  Each worker
+	* has its own instance, with its own tile cache and file position,
+	* so that the element read functions can be used without synchronization.
+	* The instance must be treated as read-only and must not be closed by the application.
+	*/
+	Gvrs* gvrs;
+
+	/**
+	* The index of the worker, in the range 0 to the number of threads minus one.
+	*/
+	int workerIndex;
+
+	/**
+	* The index of the tile within the raster, and its row and column in the grid of tiles.
+	*/
+	int tileIndex;
+	int tileRow;
+	int tileCol;
+
+	/**
+	* The position of the tile in the row-major sequence of the tiles processed
+	* by the operation.  Results are written back in order of sequence.
+	*/
+	int sequence;
+
+	/**
+	* The portion of the region of interest that is covered by the tile, inclusive.
+	*/
+	int row0;
+	int col0;
+	int row1;
+	int col1;
+
+	/**
+	* The worker's accumulator for reduction operations, or a null if the
+	* options did not specify a worker data size.
+	*/
+	void* workerData;
+
+	/**
+	* An optional result for ordered write back.  The tile function may set this
+	* value to memory obtained from malloc.  The result is passed to the write-back function
+	* and then freed by the executor.
+	*/
+	void* result;
+}GvrsParallelTask;
+
+
+/**
+* The signature for a function that processes one tile in a parallel operation.
+* The function may be called concurrently by multiple threads.
+* @param task the description of the work to be performed.
+* @param userData the application-supplied pointer given to the executor.
+* @return zero if successful; otherwise, an error code that terminates the operation.
+*/
+typedef int (*GvrsParallelTileFunction)(GvrsParallelTask* task, void* userData);
+
+
+/**
+* Specifies the optional behaviors for a parallel operation.  Applications should use
+* GvrsParallelOptionsInit to populate the structure before modifying its settings.
+*/
+typedef struct GvrsParallelOptionsTag {
+	/**
+	* The number of worker threads.  If zero or negative, the number of processors is used.
+	*/
+	int nThreads;
+
+	/**
+	* Indicates that tiles that have not been written to the file are not to be processed.
+	*/
+	int skipUnpopulatedTiles;
+
+	/**
+	* The size of the tile cache for each worker.
+	*/
+	GvrsTileCacheSizeType tileCacheSize;
+
+	/**
+	* The number of bytes for the per-worker accumulator passed in the workerData
+	* field of the task.  The memory is initialized to zeroes.
+	*/
+	size_t workerDataSize;
+
+	/**
+	* An optional function called once for each worker before it processes any tiles.
+	*/
+	int (*initWorkerData)(int workerIndex, void* workerData, void* userData);
+
+	/**
+	* An optional function used to combine the per-worker accumulators.  After all
+	* tiles are processed, it is called on the calling thread once for each worker
+	* in order of worker index.
+	*/
+	int (*reduce)(int workerIndex, void* workerData, void* userData);
+
+	/**
+	* An optional function that receives the results of the tile function in order of
+	* tile sequence.  Calls are serialized, but may be made from any of the worker threads.
+	* The result field of the task may be null if the tile function did not set it.
+	* When a write-back function is specified, the tiles are handed out in order of sequence
+	* and a worker waits if it gets more than twice the number of threads ahead of
+	* the write back, so the number of results held in memory is limited.
+	*/
+	int (*writeBack)(GvrsParallelTask* task, void* userData);
+}GvrsParallelOptions;
+
+
+/**
+* Initializes a parallel-options structure with default settings.
+* @param gvrs a valid GVRS instance.
+* @param options a valid pointer to a structure to receive the settings.
+* @return if successful, zero; otherwise an error code.
+*/
+int GvrsParallelOptionsInit(Gvrs* gvrs, GvrsParallelOptions* options);
+
+/**
+* Applies a function to each tile that intersects a region using multiple threads.
+* <p>
+* The tiles are divided into contiguous runs in row-major order and each worker
+* is assigned a run so that it reads nearby tiles.  When a worker exhausts its
+* own run, it takes the latter half of the remaining run from another worker.
+* The calling thread serves as the first worker and uses the source GVRS instance
+* as its reader.  Additional workers are given reader clones of the source
+* (see GvrsOpenReaderClone).
+* If the source is opened for writing, any pending tiles are written to the file
+* before processing begins.
+* @param gvrs a valid GVRS instance.
+* @param region the region of interest, or a null to process the entire raster.
+* @param nThreads the number of threads; if zero or negative, the number of processors is used.
+* @param function the function to be applied to each tile.
+* @param userData an application-supplied pointer passed to the function.
+* @return if successful, zero; otherwise, the first error code encountered.
+*/
+int GvrsParallelForTiles(Gvrs* gvrs, const GvrsRegion* region, int nThreads, GvrsParallelTileFunction function, void* userData);
+
+/**
+* Applies a function to each tile that intersects a region using multiple threads,
+* with support for reductions and ordered write back.  See GvrsParallelForTiles.
+* If the options specify a write-back function, the tiles are not divided into
+* contiguous runs.  Instead, each worker takes the next tile in sequence (see
+* the writeBack member of GvrsParallelOptions).
+* @param gvrs a valid GVRS instance.
+* @param region the region of interest, or a null to process the entire raster.
+* @param options a valid options structure.
+* @param function the function to be applied to each tile.
+* @param userData an application-supplied pointer passed to the function.
+* @return if successful, zero; otherwise, the first error code encountered.
+*/
+int GvrsParallelForTilesWithOptions(Gvrs* gvrs, const GvrsRegion* region, const GvrsParallelOptions* options,
+	GvrsParallelTileFunction function, void* userData);
+
+/**
+* Reads the floating-point values for the portion of the region of interest
+* covered by a task, using the task's GVRS instance (which is specific to the worker).
+* The values are obtained by GvrsElementReadBlockFloat, so integer-coded-float
+* elements are converted in bulk.  Intended for use within a tile function.
+* @param task the task passed to the tile function.
+* @param elementIndex the index of the element within the tuple.
+* @param values an array of dimension (row1-row0+1)*(col1-col0+1) to accept
+* the values in row-major order.
+* @return if successful, zero; otherwise an error code.
+*/
+int GvrsParallelTaskReadBlockFloat(GvrsParallelTask* task, int elementIndex, float* values);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
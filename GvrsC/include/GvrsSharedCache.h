@@ -0,0 +1,115 @@
+/* --------------------------------------------------------------------
+ *
+ * The MIT License
+ *
+ * Copyright (C) 2024  Gary W. Lucas.
+
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ * ---------------------------------------------------------------------
+ */
+
+#include "Gvrs.h"
+
+#ifndef GVRS_SHARED_CACHE_H
+#define GVRS_SHARED_CACHE_H
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/**
+* Provides a cache of decoded tiles in a shared-memory segment that can be
+* used by multiple GVRS instances in multiple processes.  Tiles are identified
+* by the UUID and modification time of the file (or a hash of the file path if the
+* UUID is not populated) and the tile index and file position of the tile.
+* So a single segment may serve any number of files.
+* <p>
+* The shared cache supplements, but does not replace, the tile cache of each GVRS instance.
+* When a tile is not found in the instance's tile cache, it is copied from the shared
+* cache if available.  Otherwise, it is read from the file, decoded, and
+* posted to the shared cache for use by other instances.  Applications that use a shared
+* cache will usually set a small tile-cache size for their GVRS instances.
+* <p>
+* The counts of hits, misses, and stores are local to the calling process and are
+* maintained for diagnostic purposes.
+*/
+typedef struct GvrsSharedTileCacheTag {
+	char name[64];
+	int nSlots;
+	int slotDataSize;
+	int64_t segmentSize;
+
+	volatile int64_t nHits;
+	volatile int64_t nMisses;
+	volatile int64_t nStores;
+
+	void* segment;     // the address of the mapped segment
+	void* handle;      // platform-specific information for the mapping
+}GvrsSharedTileCache;
+
+
+/**
+* Opens a shared tile cache, creating the underlying shared-memory segment if it
+* does not already exist.  If the segment exists, the number of slots and slot size are taken
+* from the segment and the specified values are ignored.
+* <p>
+* On POSIX systems the segment is created with shm_open and persists until it
+* is removed using GvrsSharedTileCacheRemove (or the system is restarted).
+* On Windows, the segment is a named file mapping that persists only while
+* at least one process has it open.
+* @param name the name of the segment, a string of up to 60 characters that does not include a slash.
+* @param nSlots the number of tiles that can be stored in the cache; rounded up to a multiple of four.
+* @param slotDataSize the maximum number of bytes of decoded data for a tile (see the nBytesForTileData
+* element of the Gvrs structure).
+* @param cache a pointer to a variable to receive the cache.
+* @return if successful, zero; otherwise an error code.
+*/
+int GvrsSharedTileCacheOpen(const char* name, int nSlots, int slotDataSize, GvrsSharedTileCache** cache);
+
+/**
+* Closes the process's connection to a shared tile cache.  Any GVRS instances that
+* use the cache must be closed (or detached from it) before it is closed.
+* @param cache a valid shared cache, or a null.
+* @return a null pointer.
+*/
+GvrsSharedTileCache* GvrsSharedTileCacheClose(GvrsSharedTileCache* cache);
+
+/**
+* Removes the name of a shared-memory segment from the system.  Processes that
+* have the segment open may continue to use it.
+* @param name the name of the segment.
+* @return if successful, zero; otherwise an error code.
+*/
+int GvrsSharedTileCacheRemove(const char* name);
+
+/**
+* Attaches a shared tile cache to a GVRS instance opened for read-only access.
+* Any reader clones created afterwards also use the shared cache.
+* @param gvrs a valid GVRS instance.
+* @param cache a valid shared cache, or a null to detach the instance from a cache.
+* @return if successful, zero; otherwise an error code.
+*/
+int GvrsSetSharedTileCache(Gvrs* gvrs, GvrsSharedTileCache* cache);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,220 @@
+/* --------------------------------------------------------------------
+ *
+ * The MIT License
+ *
+ * Copyright (C) 2024  Gary W. Lucas.
+
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ * ---------------------------------------------------------------------
+ */
+
+
+#include "Gvrs.h"
+#include "GvrsHandlePool.h"
+
+#ifndef GVRS_STACK_H
+#define GVRS_STACK_H
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/**
+* Specifies the organization of the output from GvrsStackTranscode.
+*/
+typedef enum {
+	// each member of the stack is stored as a separate element in the output.
+	// all the values for a grid cell are stored in the same tile.
+	GvrsStackLayoutTimeAsElements = 1,
+	// the output has a single element. each tile of the stack is stored as
+	// a sequence of tiles, one per member, that are consecutive in the file.
+	GvrsStackLayoutInterleavedPlanes = 2
+} GvrsStackLayout;
+
+/**
+* Presents a set of GVRS files with identical grids as a three-dimensional raster.
+* The files are treated as a sequence (typically, a time series) in the
+* order in which they were added to the stack.  A typical example is a
+* set of daily outputs from a model.  All member files must define the element
+* for the stack with the same data type and must have the same number of rows and columns
+* and the same tile size.
+* <p>
+* The values for a range of members are read using a single call.  The reads are distributed
+* over multiple threads, each of which fetches the tiles for a subset of
+* the members.  Member files are accessed through a handle pool,
+* so files that are accessed repeatedly remain open with their tile caches intact.
+* A pool created by the stack is enlarged as members are added so that it can hold
+* a handle for every member.  An application that supplies its own pool
+* should permit at least as many open handles as there are members.  Otherwise,
+* each read that covers all members reopens every file because the members are
+* visited in order and the least-recently used handle is the next one needed.
+* <p>
+* Because each member is stored in a separate file, reading the series of values for a
+* single grid cell requires reading one tile from each member. Applications that
+* perform many such reads may use GvrsStackTranscode to create a single
+* file organized so that the series for a grid cell can be obtained from
+* one tile (or from a set of tiles stored contiguously in the file).
+* <p>
+* A stack is not safe for concurrent use by multiple threads, but multiple
+* stacks (one per thread) may share a single pool.
+*/
+typedef struct GvrsStackTag {
+	char elementName[GVRS_ELEMENT_NAME_SZ + 4];
+	GvrsHandlePool* pool;
+	int poolIsOwned;     // indicates that the pool was created by the stack
+	int nThreads;        // the maximum number of threads for read operations, zero to use the processor count
+
+	// the grid and element definitions, taken from the first member
+	int nRowsInRaster;
+	int nColsInRaster;
+	int nRowsInTile;
+	int nColsInTile;
+	GvrsElementType elementType;
+
+	int nMembers;
+	int nMembersAllocated;
+	char** members;      // the paths of the member files
+}GvrsStack;
+
+/**
+* Describes the organization of a file that was produced using GvrsStackTranscode.
+* The structure is populated using GvrsStackReadLayout.
+*/
+typedef struct GvrsStackLayoutSpecTag {
+	GvrsStackLayout layout;
+	int nTimes;          // the number of members in the stack
+	int nRowsInRaster;   // the number of rows in the grid of the stack
+	int nColsInRaster;   // the number of columns in the grid of the stack
+	int nRowsInTile;
+	int nColsInTile;
+}GvrsStackLayoutSpec;
+
+/**
+* Allocates a stack for the specified element.
+* @param pool the handle pool to be used for accessing member files; or a null,
+* in which case the stack creates a pool for its own use.  The pool created by the stack
+* keeps one handle (and one file descriptor) open for each member.
+* @param elementName the name of the element to be accessed.
+* @param stack a pointer to a variable to receive the stack.
+* @return if successful, zero; otherwise an error code.
+*/
+int GvrsStackAlloc(GvrsHandlePool* pool, const char* elementName, GvrsStack** stack);
+
+/**
+* Adds a GVRS file to the end of the stack.  The file must define the element for the stack
+* and its grid and tile dimensions must match those of the members that were previously added.
+* @param stack a valid stack.
+* @param path the path to a GVRS file.
+* @return if successful, zero; otherwise an error code.
+*/
+int GvrsStackAddFile(GvrsStack* stack, const char* path);
+
+/**
+* Reads the values of the element at the specified grid cell for a range of members.
+* Values are obtained as described for GvrsElementReadFloat.  Cells that are not populated
+* in a member are given the fill value for the element.
+* @param stack a valid stack.
+* @param row the row of the grid cell.
+* @param column the column of the grid cell.
+* @param t0 the index of the first member to be read.
+* @param nTimes the number of members to be read.
+* @param values an array of at least nTimes values to receive the results.
+* @return if successful, zero; otherwise an error code.
+*/
+int GvrsStackReadSeries(GvrsStack* stack, int row, int column, int t0, int nTimes, float* values);
+
+/**
+* Reads the values of the element for a rectangular block of grid cells and a range of members.
+* The results are stored so that the series for each grid cell is contiguous:
+* the value for member t0+t at block row r and column c is stored at
+* values[(r*nCols + c)*nTimes + t].
+* @param stack a valid stack.
+* @param row0 the first row of the block.
+* @param col0 the first column of the block.
+* @param nRows the number of rows in the block.
+* @param nCols the number of columns in the block.
+* @param t0 the index of the first member to be read.
+* @param nTimes the number of members to be read.
+* @param values an array of at least nRows*nCols*nTimes values to receive the results.
+* @return if successful, zero; otherwise an error code.
+*/
+int GvrsStackReadBlock(GvrsStack* stack, int row0, int col0, int nRows, int nCols, int t0, int nTimes, float* values);
+
+/**
+* Creates a new GVRS file containing the content of all the members of the stack
+* organized so that the series of values for a grid cell may be read efficiently.
+* The output records its layout in a metadata record named "GvrsStackLayout"
+* and the paths of the members in records named "GvrsStackMember" (the record ID
+* gives the index of the member).
+* <p>
+* For the time-as-elements layout, the output has the same grid and coordinate
+* system as the members.  The element for member t is named "t" followed by
+* the index of the member as a four-digit number (t0000, t0001, etc.).
+* For the interleaved-planes layout, the output has a single element with the name of the
+* stack element. Each row of tiles from the stack is
+* expanded into nTimes rows of tiles in the output, so that the grid of the output
+* does not correspond to the coordinate system of the members.
+* Applications should use GvrsStackReadTranscodedSeries to access its values.
+* In both layouts, tiles that contain only fill values are not stored.
+* @param stack a valid stack.
+* @param path the path for the output file; must not be the path of one of the members.
+* @param layout the organization for the output.
+* @param compress zero to store the output without data compression; non-zero
+* to use the standard data compression codecs.
+* @return if successful, zero; otherwise an error code.
+*/
+int GvrsStackTranscode(GvrsStack* stack, const char* path, GvrsStackLayout layout, int compress);
+
+/**
+* Reads the layout of a file that was created using GvrsStackTranscode.
+* @param gvrs a valid GVRS instance.
+* @param spec a pointer to a structure to receive the layout.
+* @return if successful, zero; if the file was not created by GvrsStackTranscode,
+* GVRSERR_INVALID_PARAMETER; otherwise an error code.
+*/
+int GvrsStackReadLayout(Gvrs* gvrs, GvrsStackLayoutSpec* spec);
+
+/**
+* Reads the values for a grid cell from a range of members stored
+* in a file that was created using GvrsStackTranscode.
+* @param gvrs a valid GVRS instance.
+* @param spec the layout of the file, obtained using GvrsStackReadLayout.
+* @param row the row of the grid cell (in the grid of the stack).
+* @param column the column of the grid cell (in the grid of the stack).
+* @param t0 the index of the first member to be read.
+* @param nTimes the number of members to be read.
+* @param values an array of at least nTimes values to receive the results.
+* @return if successful, zero; otherwise an error code.
+*/
+int GvrsStackReadTranscodedSeries(Gvrs* gvrs, GvrsStackLayoutSpec* spec, int row, int column, int t0, int nTimes, float* values);
+
+/**
+* Frees the resources associated with the stack.
+* If the stack created its own pool, the pool is also freed.
+* @param stack a valid stack, or a null.
+* @return a null pointer.
+*/
+GvrsStack* GvrsStackFree(GvrsStack* stack);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,131 @@
+/* --------------------------------------------------------------------
+ *
+ * The MIT License
+ *
+ * Copyright (C) 2024  Gary W. Lucas.
+
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ * ---------------------------------------------------------------------
+ */
+
+#include "Gvrs.h"
+
+#ifndef GVRS_STATISTICS_H
+#define GVRS_STATISTICS_H
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/**
+* The maximum number of codecs for which statistics are reported.
+*/
+#define GVRS_STATISTICS_MAX_CODECS 16
+
+/**
+* The number of bins in the histogram of tile-miss latencies.  Bin zero counts misses
+* that were resolved in less than one microsecond.  Bin k, for k greater than zero,
+* counts misses that took at least 2^(k-1) microseconds, but less than 2^k.
+* The last bin also counts all misses that took longer.
+*/
+#define GVRS_STATISTICS_LATENCY_BINS 32
+
+/**
+* Provides statistics for the use of a data-compression codec.  Times are given
+* in nanoseconds.
+*/
+typedef struct GvrsCodecStatisticsTag {
+	char identification[GVRS_CODEC_IDENTIFICATION_MAXLEN + 1];
+	int64_t nDecoded;        // the number of segments decoded
+	int64_t nsDecoding;      // the time spent decoding
+	int64_t nEncodeAttempts; // the number of segments the codec was asked to encode
+	int64_t nsEncoding;      // the time spent encoding (including attempts that were not used)
+	int64_t nTimesEncoded;   // the number of segments stored using the codec
+	int64_t nBytesEncoded;   // the number of bytes stored using the codec
+}GvrsCodecStatistics;
+
+/**
+* Provides statistics for the access operations performed by a GVRS instance.
+* The counters are always maintained.  The timing values are collected only while timing is enabled
+* (see GvrsSetTimingEnabled). All times are given in nanoseconds.
+*/
+typedef struct GvrsStatisticsTag {
+	int timingEnabled;
+
+	int64_t nRasterReads;
+	int64_t nRasterWrites;
+	int64_t nCacheSearches;
+	int64_t nNotFound;
+	int64_t nTileReads;
+	int64_t nTileWrites;
+	int64_t nReadAheadFills; // the number of blocks read when tile records were accessed sequentially
+	int64_t nReadAheadHits;  // the number of tile records decoded from a block that was read ahead
+
+	int64_t nsFileRead;      // time reading tile records, excluding decompression
+	int64_t nBytesRead;
+	int64_t nsFileWrite;     // time writing tile records, excluding file-space allocation
+	int64_t nBytesWritten;
+	int64_t nsAllocation;    // time allocating and releasing file space for tile records
+	int64_t nAllocations;
+	int64_t nsChecksum;      // time computing checksums when the file is closed
+
+	int nCodecs;
+	GvrsCodecStatistics codecs[GVRS_STATISTICS_MAX_CODECS];
+
+	int64_t nMisses;         // the number of tiles read into the cache while timing was enabled
+	int64_t nsMissTotal;     // the time to read and decode those tiles
+	int64_t nsMissMax;
+	int64_t missLatency[GVRS_STATISTICS_LATENCY_BINS];
+}GvrsStatistics;
+
+/**
+* Enables or disables the collection of timing statistics for a GVRS instance.
+* Timing adds a small overhead to each file access and to each data compression operation, but
+* not to access operations that are satisfied from the tile cache. Enabling timing
+* clears the timing values collected previously. Reader and writer clones
+* collect statistics of their own.
+* @param gvrs a valid GVRS instance.
+* @param enabled non-zero to enable timing; zero to disable it.
+* @return if successful, zero; otherwise an error code.
+*/
+int GvrsSetTimingEnabled(Gvrs* gvrs, int enabled);
+
+/**
+* Gets the access statistics for a GVRS instance.
+* @param gvrs a valid GVRS instance.
+* @param statistics a pointer to a structure to receive the statistics.
+* @return if successful, zero; otherwise an error code.
+*/
+int GvrsGetStatistics(Gvrs* gvrs, GvrsStatistics* statistics);
+
+/**
+* Writes the access statistics for a GVRS instance as a JSON object.
+* @param gvrs a valid GVRS instance.
+* @param fp a valid output stream (file, standard output, etc).
+* @return if successful, zero; otherwise an error code.
+*/
+int GvrsWriteStatisticsJSON(Gvrs* gvrs, FILE* fp);
+
+#ifdef __cplusplus
+}
+#endif
+
+
+#endif
@@ -0,0 +1,128 @@
+/* --------------------------------------------------------------------
+ *
+ * The MIT License
+ *
+ * Copyright (C) 2024  Gary W. Lucas.
+
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ * ---------------------------------------------------------------------
+ */
+
+
+#include "Gvrs.h"
+
+#ifndef GVRS_TILE_LOADER_H
+#define GVRS_TILE_LOADER_H
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/**
+* Provides non-blocking access to the data in a GVRS file for applications that cannot
+* wait for file access and decompression, such as real-time control loops.
+* When a tile is not in the tile cache, the "try read" functions do not read it.
+* Instead, they queue the tile for a background loader and report GVRS_NOT_CACHED.
+* The loader reads and decodes the tile using a reader clone of the GVRS instance
+* and posts it for installation.  Decoded tiles are installed into the tile cache by the
+* thread that uses the GVRS instance the next time it accesses a tile that is not in the cache.
+* <p>
+* The work performed by the try-read functions is bounded: they never access the file
+* and the lock that they share with the loader is never held while the loader
+* is performing file access or decompression.
+* The loader may be used only with instances that are opened for read-only access.
+*/
+
+/**
+* A function to be called when all the tiles queued by a region preload have been
+* read and decoded.  At that point, the tiles are held by the loader rather than
+* the tile cache.  Because only the thread that uses the GVRS instance may
+* modify its tile cache, the decoded tiles are installed when that thread next
+* accesses a tile that is not in the cache, which includes the first access
+* to any of the preloaded tiles.  Installation does not require file access or decoding.
+* <p>
+* The function is called from the loader thread (or from the calling thread if
+* there are no tiles to be loaded) and should return promptly.  It must not
+* access the GVRS instance.
+* @param gvrs the GVRS instance for which the preload was requested.
+* @param status zero if all the queued tiles were decoded; otherwise an error code.
+* @param appData the application data supplied with the preload request.
+*/
+typedef void (*GvrsPreloadCallback)(Gvrs* gvrs, int status, void* appData);
+
+/**
+* Starts the background loader for a GVRS instance.  The loader is started
+* automatically when it is first needed, but applications with strict latency
+* requirements should start it in advance since doing so requires opening
+* the file and loading its tile directory.
+* The loader is stopped when the instance is closed.
+* @param gvrs a valid GVRS instance opened for read-only access.
+* @return if successful, zero; otherwise an error code.
+*/
+int GvrsTileLoaderStart(Gvrs* gvrs);
+
+/**
+* Stops the background loader for a GVRS instance and frees its resources.
+* Tiles that were queued but not loaded are discarded.  The callbacks for incomplete
+* preload requests are not invoked.  If no loader is running, no action is taken.
+* @param gvrs a valid GVRS instance.
+* @return if successful, zero; otherwise an error code.
+*/
+int GvrsTileLoaderStop(Gvrs* gvrs);
+
+/**
+* Reads the value of an element as a floating-point number if it can be done without
+* accessing the file.  If the tile containing the grid cell is not in the tile cache,
+* it is queued for the background loader and GVRS_NOT_CACHED is returned.  The number of
+* queued tiles is limited to the size of the tile cache. When the limit is reached,
+* GVRS_NOT_CACHED is returned without queuing the tile.
+* Grid cells that are not populated are reported using the fill value for the element.
+* @param element a valid element.
+* @param row the row of the grid cell.
+* @param column the column of the grid cell.
+* @param value a pointer to a variable to receive the value.
+* @return zero if the value was obtained; GVRS_NOT_CACHED if the tile is not yet
+* available; otherwise an error code.
+*/
+int GvrsElementTryReadFloat(GvrsElement* element, int row, int column, float* value);
+
+/**
+* Queues the tiles for a region for loading in the background.  Tiles that are
+* already in the tile cache or that are not populated are not queued.
+* Because tiles beyond the capacity of the tile cache would displace one another
+* when installed, the number of tiles queued is limited to the size of the tile cache.
+* If the region requires more tiles, only the first ones, in row-major order
+* starting from the first row and column of the region, are queued.
+* @param gvrs a valid GVRS instance opened for read-only access.
+* @param row0 the first row of the region, inclusive.
+* @param col0 the first column of the region, inclusive.
+* @param row1 the last row of the region, inclusive.
+* @param col1 the last column of the region, inclusive.
+* @param callback a function to be called when all the queued tiles are decoded; or a null.
+* @param appData application data to be passed to the callback; may be a null.
+* @return if the request was queued, zero; otherwise an error code.
+*/
+int GvrsPreloadRegion(Gvrs* gvrs, int row0, int col0, int row1, int col1, GvrsPreloadCallback callback, void* appData);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
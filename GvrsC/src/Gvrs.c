@@ -30,9 +30,17 @@
 #include "GvrsPrimaryIo.h"
 #include "Gvrs.h"
 #include "GvrsInternal.h"
+#include "GvrsTileLoader.h"
+#include "GvrsAccessTrace.h"
+#include "GvrsStatistics.h"
+#include "GvrsEvents.h"
+#include "GvrsSimd.h"
 #include "GvrsError.h"
 #include <math.h>
 
+// The number of bytes read when the header is parsed.  This value is large enough
+// to hold the header of most GVRS files.  Larger headers are read using a second operation.
+#define GVRS_HEADER_READ_SIZE 2048
 
 
 
@@ -64,6 +72,8 @@ static GvrsCodec* destroyCodecPlaceholder(GvrsCodec* codec) {
 	return 0;
 }
 
+static GvrsCodec* allocateCodecPlaceholder(GvrsCodec* codec);
+
 static GvrsCodec* createCodecPlaceholder(const char *identification) {
 	GvrsCodec* codec = calloc(1, sizeof(GvrsCodec));
 	if (!codec) {
@@ -72,9 +82,18 @@ static GvrsCodec* createCodecPlaceholder(const char *identification) {
 	GvrsStrncpy(codec->identification, sizeof(codec->identification), identification);
 	codec->description = GVRS_STRDUP("Unimplemented compressor");
 	codec->destroyCodec = destroyCodecPlaceholder;
+	codec->allocateNewCodec = allocateCodecPlaceholder;
 	return codec;
 }
 
+// A placeholder cannot decode or encode data, but it can be copied so that
+// a file transcribed from the source retains the original codec identification
+// (and any compressed segments that were copied verbatim remain readable by
+// applications that do implement the codec).
+static GvrsCodec* allocateCodecPlaceholder(GvrsCodec* codec) {
+	return createCodecPlaceholder(codec->identification);
+}
+
 
 static int fail(Gvrs *gvrs, FILE *fp, int errorCode) {
 	if (gvrs) {
@@ -88,21 +107,131 @@ static int fail(Gvrs *gvrs, FILE *fp, int errorCode) {
 	return errorCode;
 }
 
-static void skipToMultipleOf4(FILE* fp) {
-	int64_t pos = GvrsGetFilePosition(fp);
-	int k = (int)(pos & 0x3);
+// The header is read from the file in a single operation and then parsed
+// from memory.  The following functions extract values from the buffer.
+// The GVRS file is written in the byte-order of the host, so the values are
+// simply copied.  If the buffer is exhausted, the status is set to GVRSERR_EOF
+// and all subsequent extractions produce zero values.
+typedef struct GvrsHeaderBufferTag {
+	uint8_t* data;
+	int32_t  nBytes;
+	int32_t  pos;    // the position in the buffer, equal to the file position
+	int      status;
+}GvrsHeaderBuffer;
+
+static void hbRead(GvrsHeaderBuffer* hb, int n, void* value) {
+	if (hb->status || hb->pos + n > hb->nBytes) {
+		hb->status = GVRSERR_EOF;
+		memset(value, 0, (size_t)n);
+		return;
+	}
+	memcpy(value, hb->data + hb->pos, (size_t)n);
+	hb->pos += n;
+}
+
+static void hbSkip(GvrsHeaderBuffer* hb, int n) {
+	if (hb->status || hb->pos + n > hb->nBytes) {
+		hb->status = GVRSERR_EOF;
+		return;
+	}
+	hb->pos += n;
+}
+
+static void hbSkipToMultipleOf4(GvrsHeaderBuffer* hb) {
+	int k = hb->pos & 0x3;
 	if (k > 0) {
-		GvrsSkipBytes(fp, 4 - k);
+		hbSkip(hb, 4 - k);
 	}
 }
 
-static void readAffineTransform(FILE *fp, GvrsAffineTransform *transform) {
-	GvrsReadDouble(fp, &transform->a00);
-	GvrsReadDouble(fp, &transform->a01);
-	GvrsReadDouble(fp, &transform->a02);
-	GvrsReadDouble(fp, &transform->a10);
-	GvrsReadDouble(fp, &transform->a11);
-	GvrsReadDouble(fp, &transform->a12);
+static uint8_t hbByte(GvrsHeaderBuffer* hb) {
+	uint8_t v;
+	hbRead(hb, 1, &v);
+	return v;
+}
+
+static int16_t hbShort(GvrsHeaderBuffer* hb) {
+	int16_t v;
+	hbRead(hb, 2, &v);
+	return v;
+}
+
+static int32_t hbInt(GvrsHeaderBuffer* hb) {
+	int32_t v;
+	hbRead(hb, 4, &v);
+	return v;
+}
+
+static int64_t hbLong(GvrsHeaderBuffer* hb) {
+	int64_t v;
+	hbRead(hb, 8, &v);
+	return v;
+}
+
+static float hbFloat(GvrsHeaderBuffer* hb) {
+	float v;
+	hbRead(hb, 4, &v);
+	return v;
+}
+
+static double hbDouble(GvrsHeaderBuffer* hb) {
+	double v;
+	hbRead(hb, 8, &v);
+	return v;
+}
+
+// Strings are stored as an unsigned short length followed by the text (no null terminator).
+// Returns zero if the buffer is exhausted or memory cannot be allocated.
+static char* hbString(GvrsHeaderBuffer* hb) {
+	uint16_t len;
+	hbRead(hb, 2, &len);
+	if (hb->status || hb->pos + len > hb->nBytes) {
+		hb->status = GVRSERR_EOF;
+		return 0;
+	}
+	char* string = malloc((size_t)len + 1);
+	if (!string) {
+		hb->status = GVRSERR_NOMEM;
+		return 0;
+	}
+	memcpy(string, hb->data + hb->pos, len);
+	string[len] = 0;
+	hb->pos += len;
+	return string;
+}
+
+static void hbIdentifier(GvrsHeaderBuffer* hb, size_t bufferSize, char* buffer) {
+	uint16_t len;
+	buffer[0] = 0;
+	hbRead(hb, 2, &len);
+	if (!hb->status && bufferSize < (size_t)len + 1) {
+		hb->status = GVRSERR_FILE_ERROR;
+	}
+	if (hb->status || hb->pos + len > hb->nBytes) {
+		hb->status = hb->status ? hb->status : GVRSERR_EOF;
+		return;
+	}
+	memcpy(buffer, hb->data + hb->pos, len);
+	buffer[len] = 0;
+	hb->pos += len;
+}
+
+// Dispose of a partially parsed header, releasing the buffer if it was allocated
+static int headerFail(GvrsHeaderBuffer* hb, uint8_t* headerBlock, Gvrs* gvrs, FILE* fp, int errorCode) {
+	if (hb->data != headerBlock) {
+		free(hb->data);
+	}
+	hb->data = 0;
+	return fail(gvrs, fp, errorCode);
+}
+
+static void readAffineTransform(GvrsHeaderBuffer* hb, GvrsAffineTransform *transform) {
+	transform->a00 = hbDouble(hb);
+	transform->a01 = hbDouble(hb);
+	transform->a02 = hbDouble(hb);
+	transform->a10 = hbDouble(hb);
+	transform->a11 = hbDouble(hb);
+	transform->a12 = hbDouble(hb);
 }
 
 static char* freeString(char* s) {
@@ -129,25 +258,24 @@ static GvrsElement* freeElement(GvrsElement* element) {
 	return 0;
 }
 
-static GvrsElement* readElement(Gvrs* gvrs, int iElement, int nCellsInTile, int offsetWithinTileData, int *status) {
-	FILE* fp = gvrs->fp;
+static GvrsElement* readElement(Gvrs* gvrs, GvrsHeaderBuffer* hb, int iElement, int nCellsInTile, int offsetWithinTileData) {
 	GvrsElement* element = calloc(1, sizeof(GvrsElement));
 	if (!element) {
+		hb->status = GVRSERR_NOMEM;
 		return (GvrsElement*)0;
 	}
 	element->elementIndex = iElement;
 	element->dataOffset = offsetWithinTileData;
 
-	uint8_t eType;
-	*status = GvrsReadByte(fp, &eType);
-	if (*status || eType < 0 || eType>3) {
+	uint8_t eType = hbByte(hb);
+	if (hb->status || eType>3) {
 		free(element);
 		return (GvrsElement*)0;
 	}
-	GvrsReadBoolean(fp, &element->continuous);
-	GvrsSkipBytes(fp, 6); // reserved for future use
-	*status = GvrsReadIdentifier(fp, sizeof(element->name), element->name);
-	skipToMultipleOf4(fp); // needed because the name often breaks byte-alignment
+	element->continuous = hbByte(hb) != 0;
+	hbSkip(hb, 6); // reserved for future use
+	hbIdentifier(hb, sizeof(element->name), element->name);
+	hbSkipToMultipleOf4(hb); // needed because the name often breaks byte-alignment
 	// TO DO:  in the following, most of the types aren't completely implemented.
 	//         the code skips the appropriate bytes.
 	switch ((GvrsElementType)eType) {
@@ -155,9 +283,9 @@ static GvrsElement* readElement(Gvrs* gvrs, int iElement, int nCellsInTile, int
 		element->elementType = GvrsElementTypeInt;
 		element->typeSize = 4;
 		GvrsElementSpecInt* intSpec = &(element->elementSpec.intSpec);
-		GvrsReadInt(fp, &intSpec->minValue);
-		GvrsReadInt(fp, &intSpec->maxValue);
-		GvrsReadInt(fp, &intSpec->fillValue);
+		intSpec->minValue = hbInt(hb);
+		intSpec->maxValue = hbInt(hb);
+		intSpec->fillValue = hbInt(hb);
 		element->fillValueInt = intSpec->fillValue;
 		element->fillValueFloat = (float)intSpec->fillValue;
 		break;
@@ -165,14 +293,15 @@ static GvrsElement* readElement(Gvrs* gvrs, int iElement, int nCellsInTile, int
 		element->elementType = GvrsElementTypeIntCodedFloat;
 		element->typeSize = 4;
 		GvrsElementSpecIntCodedFloat* icfSpec = &(element->elementSpec.intFloatSpec);
-		GvrsReadFloat(fp, &icfSpec->minValue);
-		GvrsReadFloat(fp, &icfSpec->maxValue);
-		GvrsReadFloat(fp, &icfSpec->fillValue);
-		GvrsReadFloat(fp, &icfSpec->scale);
-		GvrsReadFloat(fp, &icfSpec->offset);
-		GvrsReadInt(fp, &icfSpec->iMinValue);
-		GvrsReadInt(fp, &icfSpec->iMaxValue);
-		GvrsReadInt(fp, &icfSpec->iFillValue);
+		icfSpec->minValue = hbFloat(hb);
+		icfSpec->maxValue = hbFloat(hb);
+		icfSpec->fillValue = hbFloat(hb);
+		icfSpec->scale = hbFloat(hb);
+		icfSpec->offset = hbFloat(hb);
+		icfSpec->iMinValue = hbInt(hb);
+		icfSpec->iMaxValue = hbInt(hb);
+		icfSpec->iFillValue = hbInt(hb);
+		element->icfInverseScale = 1.0f / icfSpec->scale;
 		element->fillValueInt = icfSpec->iFillValue;
 		element->fillValueFloat = icfSpec->fillValue;
 		break;
@@ -180,9 +309,9 @@ static GvrsElement* readElement(Gvrs* gvrs, int iElement, int nCellsInTile, int
 		element->elementType = GvrsElementTypeFloat;
 		element->typeSize = 4;
 		GvrsElementSpecFloat* floatSpec = &(element->elementSpec.floatSpec);
-		GvrsReadFloat(fp, &floatSpec->minValue);
-		GvrsReadFloat(fp, &floatSpec->maxValue);
-		GvrsReadFloat(fp, &floatSpec->fillValue);
+		floatSpec->minValue = hbFloat(hb);
+		floatSpec->maxValue = hbFloat(hb);
+		floatSpec->fillValue = hbFloat(hb);
 		element->fillValueInt = (int)floatSpec->fillValue;
 		element->fillValueFloat = floatSpec->fillValue;
 		break;
@@ -190,9 +319,9 @@ static GvrsElement* readElement(Gvrs* gvrs, int iElement, int nCellsInTile, int
 		element->elementType = GvrsElementTypeShort;
 		element->typeSize = 2;
 		GvrsElementSpecShort* shortSpec = &(element->elementSpec.shortSpec);
-		GvrsReadShort(fp, &shortSpec->minValue);
-		GvrsReadShort(fp, &shortSpec->maxValue);
-		GvrsReadShort(fp, &shortSpec->fillValue);
+		shortSpec->minValue = hbShort(hb);
+		shortSpec->maxValue = hbShort(hb);
+		shortSpec->fillValue = hbShort(hb);
 		element->fillValueInt = shortSpec->fillValue;
 		element->fillValueFloat = shortSpec->fillValue;
 		break;
@@ -200,10 +329,14 @@ static GvrsElement* readElement(Gvrs* gvrs, int iElement, int nCellsInTile, int
 		break; // no action required
 	}
 
-	GvrsReadString(fp, &(element->label));
-	GvrsReadString(fp, &(element->description));
-	GvrsReadString(fp, &(element->unitOfMeasure));
-	skipToMultipleOf4(fp);
+	element->label = hbString(hb);
+	element->description = hbString(hb);
+	element->unitOfMeasure = hbString(hb);
+	hbSkipToMultipleOf4(hb);
+	if (hb->status) {
+		freeElement(element);
+		return (GvrsElement*)0;
+	}
 
 	// compute number of bytes needed for tile.  Note that this size
 	// is adjusted to be a multiple of 4, if necessary.  This action
@@ -260,36 +393,117 @@ static GvrsElement* readElement(Gvrs* gvrs, int iElement, int nCellsInTile, int
 int GvrsSetTileCacheSize(Gvrs* gvrs, GvrsTileCacheSizeType cacheSize) {
 	int i, n;
 	int status = 0;
-	if (cacheSize < 0 || cacheSize>3) {
+	if (cacheSize < 0 || cacheSize>4) {
 		// improper specification from application code.
 		cacheSize = GvrsTileCacheSizeMedium;
 	}
 	gvrs->tileCacheSize = cacheSize;
 	n = GvrsTileCacheComputeStandardSize(gvrs->nRowsOfTiles, gvrs->nColsOfTiles, cacheSize);
+	int automatic = cacheSize == GvrsTileCacheSizeAutomatic;
+	if (automatic && gvrs->tileCacheCeiling > 0) {
+		n = gvrs->tileCacheCeiling;
+	}
 
 	GvrsTileCache* tileCache = (GvrsTileCache *)gvrs->tileCache;
+	if (tileCache && tileCache->maxTileCacheSize == n && tileCache->automaticSize == automatic) {
+		return 0;
+	}
 	gvrs->tileCache = 0;
 	if (tileCache) {
-		if (tileCache->maxTileCacheSize == n) {
-			return 0;
-		}
 		int status = GvrsTileCacheWritePendingTiles(tileCache);
 		if (status) {
 			return status;
 		}
-		GvrsTileCacheFree(tileCache);
 	}
+	GvrsTileCache* oldCache = tileCache;
 	status = GvrsTileCacheAlloc(gvrs, n, &tileCache);
-	if (tileCache) {
-		gvrs->tileCache = tileCache;
-		for (i = 0; i < gvrs->nElementsInTupple; i++) {
-			gvrs->elements[i]->tileCache = tileCache;
+	if (tileCache && automatic) {
+		// start with the medium size and let the cache adjust to the access pattern
+		int initialSize = GvrsTileCacheComputeStandardSize(gvrs->nRowsOfTiles, gvrs->nColsOfTiles, GvrsTileCacheSizeMedium);
+		status = GvrsTileCacheEnableAutomaticSize(tileCache, initialSize < n ? initialSize : n);
+		if (status) {
+			tileCache = GvrsTileCacheFree(tileCache);
 		}
-		return 0;
 	}
+	if (!tileCache) {
+		// the existing cache is retained
+		gvrs->tileCache = oldCache;
+		return status;
+	}
+	if (oldCache) {
+		status = GvrsTileCacheTransferPins(oldCache, tileCache);
+		GvrsTileCacheFree(oldCache);
+	}
+	gvrs->tileCache = tileCache;
+	for (i = 0; i < gvrs->nElementsInTupple; i++) {
+		gvrs->elements[i]->tileCache = tileCache;
+	}
+	return status;
+}
+
+int GvrsSetTileLayout(Gvrs* gvrs, GvrsTileLayout tileLayout) {
+	if (!gvrs) {
+		return GVRSERR_NULL_ARGUMENT;
+	}
+	if (gvrs->tileLoader) {
+		// the background loader's clone decodes tiles in the current layout
+		return GVRSERR_INVALID_PARAMETER;
+	}
+	int status = GvrsTileCacheSetLayout(gvrs->tileCache, tileLayout);
+	if (!status) {
+		gvrs->tileLayout = tileLayout;
+	}
+	return status;
+}
+
+int GvrsSetReadAhead(Gvrs* gvrs, int nBytes) {
+	if (!gvrs) {
+		return GVRSERR_NULL_ARGUMENT;
+	}
+	if (nBytes < 0) {
+		return GVRSERR_INVALID_PARAMETER;
+	}
+	gvrs->readAheadSize = nBytes;
+	GvrsTileCache* tc = gvrs->tileCache;
+	if (tc) {
+		// the buffer is re-allocated with the new size when it is next needed
+		free(tc->readAheadBuffer);
+		tc->readAheadBuffer = 0;
+		tc->readAheadCapacity = 0;
+		tc->readAheadLength = 0;
+	}
+	return 0;
+}
+
+int GvrsLoadTileRecordSizes(Gvrs* gvrs) {
+	if (!gvrs) {
+		return GVRSERR_NULL_ARGUMENT;
+	}
+	int status = GvrsLoadTileDirectory(gvrs);
+	if (status) {
+		return status;
+	}
+	// The sizes are published through the directory lock, so clones may be open.
+	// A writer's file pointer may be shared with its writer clones.
+	GvrsWriteLock(gvrs);
+	GvrsDirectoryLock(gvrs);
+	status = GvrsTileDirectoryLoadRecordSizes(gvrs);
+	GvrsDirectoryUnlock(gvrs);
+	GvrsWriteUnlock(gvrs);
 	return status;
 }
 
+int GvrsSetTileCacheCeiling(Gvrs* gvrs, int maxTiles) {
+	if (!gvrs) {
+		return GVRSERR_NULL_ARGUMENT;
+	}
+	gvrs->tileCacheCeiling = maxTiles > 0 ? maxTiles : 0;
+	if (gvrs->tileCacheSize == GvrsTileCacheSizeAutomatic) {
+		return GvrsSetTileCacheSize(gvrs, GvrsTileCacheSizeAutomatic);
+	}
+	return 0;
+}
+
  
 
 int GvrsOpen(Gvrs **gvrsReference, const char* path, const char* accessMode) {
@@ -300,6 +514,7 @@ int GvrsOpen(Gvrs **gvrsReference, const char* path, const char* accessMode) {
 	int status = 0;  // start off optimistic
 	int iElement;
 	Gvrs* gvrs = 0;
+	GvrsSimdInit();  // select the kernels for the host processor
 	errno = 0;
 	FILE* fp = fopen(path, "rb+");
 
@@ -324,88 +539,119 @@ int GvrsOpen(Gvrs **gvrsReference, const char* path, const char* accessMode) {
 	}
  
 
-	// As this function is reading the file, it checks the return status
-	// from read functions only at critical points in the code.  It does not check
-	// the status for every read operation because that would clutter the code
-	// and reduce its readability without significantly improving the functionality.
-
-	char buffer[64];
-	int istat = GvrsReadASCII(fp, 12, sizeof(buffer), buffer);
-	if (istat!=0 || strcmp(buffer, "gvrs raster")) {
+	// The header is read using a single read operation into a buffer that
+	// is large enough for most files (a GVRS file with many elements may
+	// require a second read).  The content is then parsed from memory.
+	// As this function parses the header, it checks the status only at
+	// critical points in the code.  If the buffer is exhausted, the parsing
+	// functions set an error status and all subsequent values are zero.
+	uint8_t headerBlock[GVRS_HEADER_READ_SIZE];
+	GvrsHeaderBuffer hbStruct;
+	GvrsHeaderBuffer* hb = &hbStruct;
+	memset(hb, 0, sizeof(GvrsHeaderBuffer));
+	hb->data = headerBlock;
+	hb->nBytes = (int32_t)fread(headerBlock, 1, sizeof(headerBlock), fp);
+
+	char buffer[16];
+	hbRead(hb, 12, buffer);
+	buffer[11] = 0;
+	if (hb->status || strcmp(buffer, "gvrs raster")) {
 		return fail(gvrs, fp, GVRSERR_INVALID_FILE);
 	}
 
 	unsigned  char v1, v2;
-	GvrsReadByte(fp, &v1);
-	GvrsReadByte(fp, &v2);
+	v1 = hbByte(hb);
+	v2 = hbByte(hb);
 	if (v1 != 1 && v2 < 4) {
 		return fail(gvrs, fp, GVRSERR_VERSION_NOT_SUPPORTED);
 	}
 
+	hbSkip(hb, 2);
+	int32_t sizeOfHeaderInBytes = hbInt(hb);
+	if (hb->status || sizeOfHeaderInBytes <= 0) {
+		return fail(gvrs, fp, GVRSERR_INVALID_FILE);
+	}
+	int32_t nBytesInHeader = (int32_t)FILEPOS_OFFSET_TO_HEADER_RECORD + sizeOfHeaderInBytes;
+	if (nBytesInHeader > hb->nBytes) {
+		// the header is larger than the initial read.  Read the remainder.
+		if (hb->nBytes < (int32_t)sizeof(headerBlock)) {
+			return fail(gvrs, fp, GVRSERR_EOF);
+		}
+		hb->data = malloc((size_t)nBytesInHeader);
+		if (!hb->data) {
+			return fail(gvrs, fp, GVRSERR_NOMEM);
+		}
+		memcpy(hb->data, headerBlock, (size_t)hb->nBytes);
+		size_t nRemainder = (size_t)(nBytesInHeader - hb->nBytes);
+		if (fread(hb->data + hb->nBytes, 1, nRemainder, fp) < nRemainder) {
+			free(hb->data);
+			return fail(gvrs, fp, GVRSERR_EOF);
+		}
+		hb->nBytes = nBytesInHeader;
+	}
+
 	gvrs = calloc(1, sizeof(Gvrs));
 	if (!gvrs) {
-		return fail(gvrs, fp, GVRSERR_NOMEM);
+		return headerFail(hb, headerBlock, gvrs, fp, GVRSERR_NOMEM);
 	}
 
 	gvrs->fp = fp;
 	gvrs->path = GVRS_STRDUP(path);
-	if (!path) {
-		return fail(gvrs, fp, GVRSERR_NOMEM);
+	if (!gvrs->path) {
+		return headerFail(hb, headerBlock, gvrs, fp, GVRSERR_NOMEM);
 	}
+	gvrs->readAheadSize = GVRS_READ_AHEAD_DEFAULT_SIZE;
 
-	GvrsSkipBytes(fp, 2);
-	int32_t sizeOfHeaderInBytes;
-	GvrsReadInt(fp, &sizeOfHeaderInBytes);
 	gvrs->offsetToContent = sizeOfHeaderInBytes;
-	GvrsSkipBytes(fp, 4);
+	hbSkip(hb, 4);
 	
-	GvrsReadLong(fp, &gvrs->uuidLow);
-	GvrsReadLong(fp, &gvrs->uuidHigh);
+	gvrs->uuidLow = hbLong(hb);
+	gvrs->uuidHigh = hbLong(hb);
  
-	GvrsReadLong(fp, &gvrs->modTimeMS);
+	gvrs->modTimeMS = hbLong(hb);
 	gvrs->modTimeSec = gvrs->modTimeMS / 1000LL;
 
-	GvrsReadLong(fp, &gvrs->timeOpenedForWritingMS);
+	gvrs->timeOpenedForWritingMS = hbLong(hb);
 	if (gvrs->timeOpenedForWritingMS) {
-		return fail(gvrs, fp, GVRSERR_EXCLUSIVE_OPEN);
+		return headerFail(hb, headerBlock, gvrs, fp, GVRSERR_EXCLUSIVE_OPEN);
 	}
 
  
-	GvrsReadLong(fp, &gvrs->filePosFileSpaceDirectory);
-	GvrsReadLong(fp, &gvrs->filePosMetadataDirectory);
+	gvrs->filePosFileSpaceDirectory = hbLong(hb);
+	gvrs->filePosMetadataDirectory = hbLong(hb);
 
-	int16_t nLevels = 0;
-	GvrsReadShort(fp, &nLevels);
+	int16_t nLevels = hbShort(hb);
+	(void)nLevels;
 
-	GvrsSkipBytes(fp, 6);
+	hbSkip(hb, 6);
 
-	GvrsReadLong(fp, &gvrs->filePosTileDirectory);
+	gvrs->filePosTileDirectory = hbLong(hb);
 
-	GvrsSkipBytes(fp, 16);
+	hbSkip(hb, 16);
 
-	GvrsReadInt(fp, &gvrs->nRowsInRaster);
-	GvrsReadInt(fp, &gvrs->nColsInRaster);
-	GvrsReadInt(fp, &gvrs->nRowsInTile);
-	GvrsReadInt(fp, &gvrs->nColsInTile);
+	gvrs->nRowsInRaster = hbInt(hb);
+	gvrs->nColsInRaster = hbInt(hb);
+	gvrs->nRowsInTile = hbInt(hb);
+	gvrs->nColsInTile = hbInt(hb);
+	if (hb->status || gvrs->nRowsInTile <= 0 || gvrs->nColsInTile <= 0) {
+		return headerFail(hb, headerBlock, gvrs, fp, GVRSERR_INVALID_FILE);
+	}
 	gvrs->nRowsOfTiles = (gvrs->nRowsInRaster + gvrs->nRowsInTile - 1) / gvrs->nRowsInTile;
 	gvrs->nColsOfTiles = (gvrs->nColsInRaster + gvrs->nColsInTile - 1) / gvrs->nColsInTile;
 	gvrs->nCellsInTile = gvrs->nRowsInTile * gvrs->nColsInTile;
 
-	GvrsSkipBytes(fp, 8);
-	uint8_t scratch;
-	GvrsReadBoolean(fp, &gvrs->checksumEnabled);
-	GvrsReadByte(fp, &scratch);
-	gvrs->rasterSpaceCode = scratch;
-	GvrsReadByte(fp, &scratch);
-	gvrs->geographicCoordinates = (scratch == 2);
-	GvrsSkipBytes(fp, 5);
-
-	GvrsReadDouble(fp, &gvrs->x0);
-	GvrsReadDouble(fp, &gvrs->y0);
-	GvrsReadDouble(fp, &gvrs->x1);
-	GvrsReadDouble(fp, &gvrs->y1);
-	GvrsReadDouble(fp, &gvrs->cellSizeX);
-	GvrsReadDouble(fp, &gvrs->cellSizeY);
+	hbSkip(hb, 8);
+	gvrs->checksumEnabled = hbByte(hb) != 0;
+	gvrs->rasterSpaceCode = hbByte(hb);
+	gvrs->geographicCoordinates = (hbByte(hb) == 2);
+	hbSkip(hb, 5);
+
+	gvrs->x0 = hbDouble(hb);
+	gvrs->y0 = hbDouble(hb);
+	gvrs->x1 = hbDouble(hb);
+	gvrs->y1 = hbDouble(hb);
+	gvrs->cellSizeX = hbDouble(hb);
+	gvrs->cellSizeY = hbDouble(hb);
 	// The "x-center" parameters are intended to support geographic coordinate
 	// transformations, but may be applied to other purposes as needed.
 	gvrs->xCenterGrid = (gvrs->nColsInRaster - 1) / 2.0;
@@ -434,17 +680,20 @@ int GvrsOpen(Gvrs **gvrsReference, const char* path, const char* accessMode) {
 	}
 
 
-	readAffineTransform(fp, &gvrs->m2r);
-	readAffineTransform(fp, &gvrs->r2m);
+	readAffineTransform(hb, &gvrs->m2r);
+	readAffineTransform(hb, &gvrs->r2m);
 
-	istat = GvrsReadInt(fp, &gvrs->nElementsInTupple);
-	if (istat != 0) {
-		return fail(gvrs, fp, GVRSERR_EOF);
+	gvrs->nElementsInTupple = hbInt(hb);
+	if (hb->status) {
+		return headerFail(hb, headerBlock, gvrs, fp, GVRSERR_EOF);
+	}
+	if (gvrs->nElementsInTupple <= 0) {
+		return headerFail(hb, headerBlock, gvrs, fp, GVRSERR_INVALID_FILE);
 	}
 
 	gvrs->elements = calloc((size_t)(gvrs->nElementsInTupple+1), sizeof(GvrsElement*));
 	if (!gvrs->elements) {
-		return fail(gvrs, fp, GVRSERR_NOMEM);
+		return headerFail(hb, headerBlock, gvrs, fp, GVRSERR_NOMEM);
 	}
 
 	// The format for data within the file is a set of the following
@@ -458,94 +707,92 @@ int GvrsOpen(Gvrs **gvrsReference, const char* path, const char* accessMode) {
 	gvrs->nBytesForTileData = 0;
 	int nCellsInTile = gvrs->nRowsInTile * gvrs->nColsInTile;
 	for (iElement = 0; iElement < gvrs->nElementsInTupple; iElement++) {
-		GvrsElement *element =   readElement(gvrs, iElement, nCellsInTile, gvrs->nBytesForTileData, &status);
+		GvrsElement *element =   readElement(gvrs, hb, iElement, nCellsInTile, gvrs->nBytesForTileData);
 		if (!element) {
-			return fail(gvrs, fp, GVRSERR_FILE_ACCESS);
+			return headerFail(hb, headerBlock, gvrs, fp, GVRSERR_FILE_ACCESS);
 		}
 		gvrs->elements[iElement] = element;
 		gvrs->nBytesForTileData += element->dataSize;
 	}
 
-	GvrsReadInt(fp, &gvrs->nDataCompressionCodecs);
-	if (gvrs->nDataCompressionCodecs > 0) {
+	int nCodecs = hbInt(hb);
+	if (hb->status || nCodecs < 0) {
+		return headerFail(hb, headerBlock, gvrs, fp, GVRSERR_INVALID_FILE);
+	}
+	if (nCodecs > 0) {
 		int iCompress;
-		gvrs->dataCompressionCodecs = calloc(gvrs->nDataCompressionCodecs, sizeof(GvrsCodec*));
+		gvrs->dataCompressionCodecs = calloc(nCodecs, sizeof(GvrsCodec*));
 		if (!gvrs->dataCompressionCodecs) {
-			return fail(gvrs, fp, GVRSERR_NOMEM);
+			return headerFail(hb, headerBlock, gvrs, fp, GVRSERR_NOMEM);
 		}
+		gvrs->nDataCompressionCodecs = nCodecs;
 
-#ifdef GVRS_ZLIB
-		for (iCompress = 0; iCompress < gvrs->nDataCompressionCodecs; iCompress++) {
-			char* sp = "";
-			status = GvrsReadString(fp, &sp);
-			if (status) {
-				return fail(gvrs, fp, status);
+		for (iCompress = 0; iCompress < nCodecs; iCompress++) {
+			char* sp = hbString(hb);
+			if (!sp) {
+				return headerFail(hb, headerBlock, gvrs, fp, hb->status);
 			}
 			if (strcmp("GvrsHuffman", sp) == 0) {
 				gvrs->dataCompressionCodecs[iCompress] = GvrsCodecHuffmanAlloc();
 			}
+#ifdef GVRS_ZLIB
 			else if (strcmp("GvrsDeflate", sp) == 0) {
 				gvrs->dataCompressionCodecs[iCompress] = GvrsCodecDeflateAlloc();
 			}
 			else if (strcmp("float", sp) == 0) {
 				gvrs->dataCompressionCodecs[iCompress] = GvrsCodecFloatAlloc();
-	}
+			}
+			else if (strcmp("GvrsFloat", sp) == 0) {
+				// Files written by the Java implementation identify the float codec
+				// as GvrsFloat.  The codec retains that name so that it matches the file
+				// when the data is copied or transcribed.
+				GvrsCodec* codec = GvrsCodecFloatAlloc();
+				if (codec) {
+					GvrsStrncpy(codec->identification, sizeof(codec->identification), sp);
+				}
+				gvrs->dataCompressionCodecs[iCompress] = codec;
+			}
 			else if (strcmp("LSOP12", sp)==0) {
 				gvrs->dataCompressionCodecs[iCompress] = GvrsCodecLsopAlloc();
 			}
+#endif
 			else {
 				gvrs->dataCompressionCodecs[iCompress] = createCodecPlaceholder(sp);
 			}
-			if (!gvrs->dataCompressionCodecs[iCompress]) {
-				return fail(gvrs, fp, GVRSERR_BAD_COMPRESSION_FORMAT);
-			}
 			free(sp);
-		}
-#else
-		for (iCompress = 0; iCompress < gvrs->nDataCompressionCodecs; iCompress++) {
-			unsigned char* sp = "";
-			*status = GvrsReadString(fp, &sp);
-			if (*status) {
-				return fail(gvrs, fp, status);
-			}
-	        if (strcmp("GvrsHuffman", sp) == 0) {
-				gvrs->dataCompressionCodecs[iCompress] = GvrsCodecHuffmanAlloc();
-			}
-			else {
-				gvrs->dataCompressionCodecs[iCompress] = createCodecPlaceholder(sp);
-			}
 			if (!gvrs->dataCompressionCodecs[iCompress]) {
-				return fail(gvrs, fp, GVRSERR_BAD_COMPRESSION_FORMAT);
+				return headerFail(hb, headerBlock, gvrs, fp, GVRSERR_BAD_COMPRESSION_FORMAT);
 			}
-			free(sp);
 		}
-#endif
-
 	}
 
-	status = GvrsReadString(fp, &(gvrs->productLabel));
-	if (status) {
-		return fail(gvrs, fp, status);
+	gvrs->productLabel = hbString(hb);
+	if (hb->status) {
+		return headerFail(hb, headerBlock, gvrs, fp, hb->status);
 	}
-
-	GvrsTileDirectory* tileDirectory = 0;
-	status = GvrsTileDirectoryRead(gvrs, gvrs->filePosTileDirectory, &tileDirectory);
-	if (status) {
-		return fail(gvrs, fp, status);
+	if (hb->data != headerBlock) {
+		free(hb->data);
 	}
-	gvrs->tileDirectory = tileDirectory;
-	
 
-	GvrsMetadataDirectory* metadataDirectory;
-	status =  GvrsMetadataDirectoryRead(fp, gvrs->filePosMetadataDirectory, &metadataDirectory);
-	if (status) {
-		return fail(gvrs, fp, status);
+	// The tile directory and metadata directory are loaded on first use.
+	// Applications that open a file only to inspect its header or to read a
+	// few values do not pay the cost of reading them.  If the file is opened
+	// for writing, both directories are loaded now because the file space
+	// they occupy may be reused once the file-space manager is in operation.
+	if (openedForWriting) {
+		status = GvrsLoadTileDirectory(gvrs);
+		if (status) {
+			return fail(gvrs, fp, status);
+		}
+		status = GvrsLoadMetadataDirectory(gvrs);
+		if (status) {
+			return fail(gvrs, fp, status);
+		}
 	}
-	gvrs->metadataDirectory = metadataDirectory;
 
 	status = GvrsSetTileCacheSize(gvrs, GvrsTileCacheSizeMedium);
 	if (status) {
-		fail(gvrs, fp, status);
+		return fail(gvrs, fp, status);
 	}
 
 	for (iElement = 0; iElement < gvrs->nElementsInTupple; iElement++) {
@@ -592,6 +839,37 @@ int GvrsOpen(Gvrs **gvrsReference, const char* path, const char* accessMode) {
 
 
 
+int GvrsLoadTileDirectory(Gvrs* gvrs) {
+	if (gvrs->tileDirectory) {
+		return 0;
+	}
+	GvrsTileDirectory* tileDirectory = 0;
+	int status = GvrsTileDirectoryRead(gvrs, gvrs->filePosTileDirectory, &tileDirectory);
+	if (status) {
+		return status;
+	}
+	gvrs->tileDirectory = tileDirectory;
+	if (gvrs->tileCache) {
+		((GvrsTileCache*)gvrs->tileCache)->tileDirectory = tileDirectory;
+	}
+	return 0;
+}
+
+
+int GvrsLoadMetadataDirectory(Gvrs* gvrs) {
+	if (gvrs->metadataDirectory) {
+		return 0;
+	}
+	GvrsMetadataDirectory* metadataDirectory = 0;
+	int status = GvrsMetadataDirectoryRead(gvrs->fp, gvrs->filePosMetadataDirectory, &metadataDirectory);
+	if (status) {
+		return status;
+	}
+	gvrs->metadataDirectory = metadataDirectory;
+	return 0;
+}
+
+
 GvrsElement* GvrsGetElementByName(Gvrs* gvrs, const char *name) {
 	int i;
 	if (!gvrs || !name || !gvrs->elements) {
@@ -841,7 +1119,12 @@ static int writeClosingElements(Gvrs* gvrs, FILE* fp) {
 		return status;
 	}
 
+	GvrsStatistics* statistics = gvrs->statistics;
+	int64_t time0 = statistics ? GvrsTimeNS() : 0;
  	status = writeChecksums(gvrs);
+	if (statistics) {
+		statistics->nsChecksum += GvrsTimeNS() - time0;
+	}
 	if (status) {
 		return status;
 	}
@@ -849,12 +1132,47 @@ static int writeClosingElements(Gvrs* gvrs, FILE* fp) {
 }
 
 
+static int isWriterClone(Gvrs* gvrs) {
+	GvrsSharedState* shared = gvrs->sharedState;
+	return shared && shared->writer && shared->writer != gvrs && gvrs->timeOpenedForWritingMS;
+}
+
+
 int GvrsClose(Gvrs* gvrs) {
 	if (!gvrs) {
 		return GVRSERR_NULL_ARGUMENT;
 	}
 
+	// the background loader uses a reader clone that must be closed first
+	GvrsTileLoaderStop(gvrs);
+	GvrsAccessTraceStop(gvrs);
+
 	int status = 0;
+	GvrsSharedState* shared = gvrs->sharedState;
+	if (isWriterClone(gvrs)) {
+		// A writer clone writes its pending tiles but does not perform the
+		// completion operations.  Those are performed when the source is closed.
+		status = GvrsTileCacheWritePendingTiles(gvrs->tileCache);
+		GvrsMutexLock(shared->mutex);
+		shared->nWriterClones--;
+		GvrsMutexUnlock(shared->mutex);
+		gvrs->fp = 0;
+		gvrs->fileSpaceManager = 0;
+		gvrs->timeOpenedForWritingMS = 0;
+		GvrsDisposeOfResources(gvrs);
+		return status;
+	}
+	if (shared && shared->writer == gvrs) {
+		GvrsMutexLock(shared->mutex);
+		int nWriterClones = shared->nWriterClones;
+		GvrsMutexUnlock(shared->mutex);
+		if (nWriterClones > 0) {
+			// The writer clones must be closed first so that their
+			// pending tiles are written before the file is completed.
+			return GVRSERR_INVALID_PARAMETER;
+		}
+		shared->writer = 0;
+	}
 	if (gvrs->fp && gvrs->timeOpenedForWritingMS) {
 		if (gvrs->deleteOnClose) {
 			// because the file is going to be deleted, there
@@ -880,31 +1198,314 @@ int GvrsClose(Gvrs* gvrs) {
 	return status;
 }
 
+static int createSharedState(Gvrs* gvrs) {
+	GvrsSharedState* shared = calloc(1, sizeof(GvrsSharedState));
+	if (!shared) {
+		return GVRSERR_NOMEM;
+	}
+	int status = GvrsMutexInit(&shared->mutex);
+	if (!status) {
+		status = GvrsMutexInit(&shared->directoryMutex);
+		if (status) {
+			shared->mutex = GvrsMutexFree(shared->mutex);
+		}
+	}
+	if (status) {
+		free(shared);
+		return status;
+	}
+	shared->referenceCount = 1;
+	shared->path = gvrs->path;
+	shared->productLabel = gvrs->productLabel;
+	shared->tileDirectory = gvrs->tileDirectory;
+	shared->metadataDirectory = gvrs->metadataDirectory;
+	shared->nElementsInTupple = gvrs->nElementsInTupple;
+	shared->elements = gvrs->elements;
+	gvrs->sharedState = shared;
+	return 0;
+}
+
+
+static int openClone(Gvrs* gvrs, int forWriting, Gvrs** cloneReference) {
+	*cloneReference = 0;
+	int status;
+	int i;
+
+	if (gvrs->timeOpenedForWritingMS && gvrs->tileCache) {
+		// the clone reads tiles from the file, so it must reflect any changes
+		// made through the source
+		status = GvrsTileCacheWritePendingTiles(gvrs->tileCache);
+		if (status) {
+			return status;
+		}
+		fflush(gvrs->fp);
+	}
+
+	if (!gvrs->sharedState) {
+		// the directories are shared by the clones, so they must be loaded before the state is shared
+		status = GvrsLoadTileDirectory(gvrs);
+		if (status) {
+			return status;
+		}
+		status = GvrsLoadMetadataDirectory(gvrs);
+		if (status) {
+			return status;
+		}
+		status = createSharedState(gvrs);
+		if (status) {
+			return status;
+		}
+	}
+	GvrsSharedState* shared = gvrs->sharedState;
+	if (forWriting && !shared->writeMutex) {
+		status = GvrsMutexInit(&shared->writeMutex);
+		if (status) {
+			return status;
+		}
+		shared->writer = gvrs;
+	}
+
+	Gvrs* clone = calloc(1, sizeof(Gvrs));
+	if (!clone) {
+		return GVRSERR_NOMEM;
+	}
+	// The clone begins as a copy of the source.  The references to resources that
+	// belong to the source alone are cleared and replaced with resources of its own.
+	memcpy(clone, gvrs, sizeof(Gvrs));
+	clone->fp = 0;
+	clone->timeOpenedForWritingMS = 0;
+	clone->deleteOnClose = 0;
+	clone->elements = 0;
+	clone->nDataCompressionCodecs = 0;
+	clone->dataCompressionCodecs = 0;
+	clone->tileCache = 0;
+	clone->fileSpaceManager = 0;
+	clone->tileLoader = 0;
+	clone->accessTrace = 0;
+	clone->statistics = 0;
+	clone->eventHooks = 0;
+
+	GvrsMutexLock(shared->mutex);
+	shared->referenceCount++;
+	GvrsMutexUnlock(shared->mutex);
+
+	if (!forWriting) {
+		clone->fp = fopen(shared->path, "rb");
+		if (!clone->fp) {
+			return fail(clone, 0, GVRSERR_FILE_ACCESS);
+		}
+	}
+
+	clone->elements = calloc((size_t)(gvrs->nElementsInTupple + 1), sizeof(GvrsElement*));
+	if (!clone->elements) {
+		return fail(clone, 0, GVRSERR_NOMEM);
+	}
+	for (i = 0; i < gvrs->nElementsInTupple; i++) {
+		GvrsElement* e = calloc(1, sizeof(GvrsElement));
+		if (!e) {
+			return fail(clone, 0, GVRSERR_NOMEM);
+		}
+		memcpy(e, shared->elements[i], sizeof(GvrsElement));
+		e->gvrs = clone;
+		e->tileCache = 0;
+		clone->elements[i] = e;
+	}
+
+	if (gvrs->nDataCompressionCodecs > 0) {
+		clone->dataCompressionCodecs = calloc((size_t)gvrs->nDataCompressionCodecs, sizeof(GvrsCodec*));
+		if (!clone->dataCompressionCodecs) {
+			return fail(clone, 0, GVRSERR_NOMEM);
+		}
+		for (i = 0; i < gvrs->nDataCompressionCodecs; i++) {
+			GvrsCodec* codec = gvrs->dataCompressionCodecs[i];
+			if (!codec->allocateNewCodec) {
+				return fail(clone, 0, GVRSERR_COMPRESSION_NOT_IMPLEMENTED);
+			}
+			clone->dataCompressionCodecs[i] = codec->allocateNewCodec(codec);
+			if (!clone->dataCompressionCodecs[i]) {
+				return fail(clone, 0, GVRSERR_NOMEM);
+			}
+			clone->nDataCompressionCodecs++;
+		}
+	}
+
+	status = GvrsSetTileCacheSize(clone, gvrs->tileCacheSize);
+	if (status) {
+		return fail(clone, 0, status);
+	}
+
+	if (forWriting) {
+		// A writer clone uses the file pointer and file-space manager of the source.
+		// These are attached only after all other resources are allocated so that
+		// a failure does not dispose of them.  Access is serialized by the write mutex.
+		clone->fp = gvrs->fp;
+		clone->fileSpaceManager = gvrs->fileSpaceManager;
+		clone->timeOpenedForWritingMS = gvrs->timeOpenedForWritingMS;
+		GvrsMutexLock(shared->mutex);
+		shared->nWriterClones++;
+		GvrsMutexUnlock(shared->mutex);
+	}
+
+	*cloneReference = clone;
+	return 0;
+}
+
+
+int GvrsOpenReaderClone(Gvrs* gvrs, Gvrs** cloneReference) {
+	if (!gvrs || !cloneReference) {
+		return GVRSERR_NULL_ARGUMENT;
+	}
+	return openClone(gvrs, 0, cloneReference);
+}
+
+
+int GvrsOpenWriterClone(Gvrs* gvrs, Gvrs** cloneReference) {
+	if (!gvrs || !cloneReference) {
+		return GVRSERR_NULL_ARGUMENT;
+	}
+	*cloneReference = 0;
+	if (!gvrs->timeOpenedForWritingMS) {
+		return GVRSERR_NOT_OPENED_FOR_WRITING;
+	}
+	GvrsSharedState* shared = gvrs->sharedState;
+	if (shared && shared->writer && shared->writer != gvrs) {
+		// writer clones must be created from the instance that opened the file
+		return GVRSERR_INVALID_PARAMETER;
+	}
+	return openClone(gvrs, 1, cloneReference);
+}
+
+
+int GvrsIsStateShared(Gvrs* gvrs) {
+	GvrsSharedState* shared = gvrs->sharedState;
+	if (!shared) {
+		return 0;
+	}
+	// Only an instance that holds a reference can open a new clone.  So if the
+	// calling instance holds the only reference, no other instance can obtain one.
+	GvrsMutexLock(shared->mutex);
+	int referenceCount = shared->referenceCount;
+	GvrsMutexUnlock(shared->mutex);
+	return referenceCount > 1;
+}
+
+
+void GvrsWriteLock(Gvrs* gvrs) {
+	// Only the writer and its writer clones share a file pointer.  The test on
+	// timeOpenedForWritingMS comes first so that reader clones never examine
+	// the write mutex, which may be created while they are running.
+	GvrsSharedState* shared = gvrs->sharedState;
+	if (gvrs->timeOpenedForWritingMS && shared && shared->writeMutex) {
+		GvrsMutexLock(shared->writeMutex);
+	}
+}
+
+
+void GvrsWriteUnlock(Gvrs* gvrs) {
+	GvrsSharedState* shared = gvrs->sharedState;
+	if (gvrs->timeOpenedForWritingMS && shared && shared->writeMutex) {
+		GvrsMutexUnlock(shared->writeMutex);
+	}
+}
+
+
+void GvrsDirectoryLock(Gvrs* gvrs) {
+	GvrsSharedState* shared = gvrs->sharedState;
+	if (shared) {
+		GvrsMutexLock(shared->directoryMutex);
+	}
+}
+
+
+void GvrsDirectoryUnlock(Gvrs* gvrs) {
+	GvrsSharedState* shared = gvrs->sharedState;
+	if (shared) {
+		GvrsMutexUnlock(shared->directoryMutex);
+	}
+}
+
+
 void GvrsSetDeleteOnClose(Gvrs* gvrs, int deleteOnClose) {
 	if (gvrs) {
 		gvrs->deleteOnClose = deleteOnClose;
 	}
 }
 
+static void releaseSharedState(GvrsSharedState* shared) {
+	GvrsMutexLock(shared->mutex);
+	int referenceCount = --shared->referenceCount;
+	GvrsMutexUnlock(shared->mutex);
+	if (referenceCount > 0) {
+		return;
+	}
+	int i;
+	shared->path = freeString(shared->path);
+	shared->productLabel = freeString(shared->productLabel);
+	for (i = 0; i < shared->nElementsInTupple; i++) {
+		shared->elements[i] = freeElement(shared->elements[i]);
+	}
+	free(shared->elements);
+	shared->tileDirectory = GvrsTileDirectoryFree(shared->tileDirectory);
+	shared->metadataDirectory = GvrsMetadataDirectoryFree(shared->metadataDirectory);
+	shared->mutex = GvrsMutexFree(shared->mutex);
+	shared->writeMutex = GvrsMutexFree(shared->writeMutex);
+	shared->directoryMutex = GvrsMutexFree(shared->directoryMutex);
+	memset(shared, 0, sizeof(GvrsSharedState));
+	free(shared);
+}
+
 Gvrs* GvrsDisposeOfResources(Gvrs* gvrs) {
 	if (gvrs) {
+		// Release the event callback so that its disposal function runs
+		// (and finishes any trace file) after the last write is reported.
+		GvrsSetEventCallback(gvrs, 0, 0, 0, 0);
 		if (gvrs->fp) {
 			fclose(gvrs->fp);
 			gvrs->fp = 0;
 		}
 
 		// Free resources ------------------------
-
-		gvrs->path = freeString(gvrs->path);
-		gvrs->productLabel = freeString(gvrs->productLabel);
 		int i;
-		for (i = 0; i < gvrs->nElementsInTupple; i++) {
-			gvrs->elements[i] = freeElement(gvrs->elements[i]);
+		GvrsSharedState* shared = gvrs->sharedState;
+		if (shared) {
+			// The instance is either the source of a reader clone or a clone.
+			// The shared resources are freed when the last instance that refers to them
+			// is closed. The elements of a clone are shallow copies of the shared elements,
+			// so the clone frees only the element structures.
+			if (gvrs->elements == shared->elements) {
+				for (i = 0; i < gvrs->nElementsInTupple; i++) {
+					gvrs->elements[i]->tileCache = 0;
+					gvrs->elements[i]->gvrs = 0;
+				}
+			}
+			else if (gvrs->elements) {
+				for (i = 0; i < gvrs->nElementsInTupple; i++) {
+					if (gvrs->elements[i]) {
+						memset(gvrs->elements[i], 0, sizeof(GvrsElement));
+						free(gvrs->elements[i]);
+					}
+				}
+				free(gvrs->elements);
+			}
+			gvrs->elements = 0;
+			gvrs->path = 0;
+			gvrs->productLabel = 0;
+			gvrs->tileDirectory = 0;
+			gvrs->metadataDirectory = 0;
+			gvrs->sharedState = 0;
+			releaseSharedState(shared);
+		}
+		else {
+			gvrs->path = freeString(gvrs->path);
+			gvrs->productLabel = freeString(gvrs->productLabel);
+			for (i = 0; i < gvrs->nElementsInTupple; i++) {
+				gvrs->elements[i] = freeElement(gvrs->elements[i]);
+			}
+			free(gvrs->elements);
+			gvrs->tileDirectory = GvrsTileDirectoryFree(gvrs->tileDirectory);
+			gvrs->metadataDirectory = GvrsMetadataDirectoryFree(gvrs->metadataDirectory);
 		}
-		free(gvrs->elements);
 		gvrs->tileCache = GvrsTileCacheFree(gvrs->tileCache);
-		gvrs->tileDirectory = GvrsTileDirectoryFree(gvrs->tileDirectory);
-		gvrs->metadataDirectory = GvrsMetadataDirectoryFree(gvrs->metadataDirectory);
 
 		if (gvrs->dataCompressionCodecs) {
 			for (i = 0; i < gvrs->nDataCompressionCodecs; i++) {
@@ -918,6 +1519,8 @@ Gvrs* GvrsDisposeOfResources(Gvrs* gvrs) {
 		}
 
 		gvrs->fileSpaceManager = GvrsFileSpaceManagerFree(gvrs->fileSpaceManager);
+		free(gvrs->statistics);
+		gvrs->statistics = 0;
 
 		// we zero out the content of the GVRS structure as a diagnostic to help detect
 		// cases where any external code attempts to access it after the close.  
@@ -0,0 +1,262 @@
+/* --------------------------------------------------------------------
+ *
+ * The MIT License
+ *
+ * Copyright (C) 2024  Gary W. Lucas.
+
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ * ---------------------------------------------------------------------
+ */
+
+// Development Note:
+//    The recorder is called from GvrsTileCacheFetchTile, so it must not perform
+// file access for each tile request.  Records are encoded into a memory buffer
+// that is written to the file when it is full.  Each record is a variable-length
+// unsigned integer (7 bits per byte, low-order bits first) given by
+//      (zigzag(tileIndex - priorTileIndex) << 1) | hasRecordSize
+// followed, when hasRecordSize is set, by the record size as a second
+// variable-length integer.  For the access patterns that are typical of raster
+// processing, most records require a single byte.
+//    Write failures are retained and reported when the trace is stopped.
+
+#include "GvrsFramework.h"
+
+#include "GvrsPrimaryIo.h"
+#include "Gvrs.h"
+#include "GvrsInternal.h"
+#include "GvrsAccessTrace.h"
+#include "GvrsError.h"
+
+#define TRACE_IDENTIFIER "GvrsAccessTrace"
+#define TRACE_VERSION 1
+#define TRACE_BUFFER_SIZE 65536
+
+typedef struct GvrsTraceRecorderTag {
+	FILE* fp;
+	int status;
+	int32_t priorTileIndex;
+	int nBytesInBuffer;
+	uint8_t buffer[TRACE_BUFFER_SIZE];
+}GvrsTraceRecorder;
+
+int GvrsAccessTraceStart(Gvrs* gvrs, const char* path) {
+	if (!gvrs || !path) {
+		return GVRSERR_NULL_ARGUMENT;
+	}
+	int status = GvrsAccessTraceStop(gvrs);
+	if (status) {
+		return status;
+	}
+	GvrsTraceRecorder* recorder = calloc(1, sizeof(GvrsTraceRecorder));
+	if (!recorder) {
+		return GVRSERR_NOMEM;
+	}
+	recorder->fp = fopen(path, "wb");
+	if (!recorder->fp) {
+		free(recorder);
+		return GVRSERR_FILE_ACCESS;
+	}
+	GvrsTileCache* tc = gvrs->tileCache;
+	FILE* fp = recorder->fp;
+	status = GvrsWriteString(fp, TRACE_IDENTIFIER);
+	status |= GvrsWriteInt(fp, TRACE_VERSION);
+	status |= GvrsWriteInt(fp, gvrs->nRowsOfTiles);
+	status |= GvrsWriteInt(fp, gvrs->nColsOfTiles);
+	status |= GvrsWriteInt(fp, gvrs->nBytesForTileData);
+	status |= GvrsWriteInt(fp, tc ? tc->maxTileCacheSize : 0);
+	if (status) {
+		fclose(fp);
+		free(recorder);
+		return GVRSERR_FILE_ERROR;
+	}
+	gvrs->accessTrace = recorder;
+	return 0;
+}
+
+static void flushBuffer(GvrsTraceRecorder* recorder) {
+	if (recorder->nBytesInBuffer > 0 && !recorder->status) {
+		if (GvrsWriteByteArray(recorder->fp, recorder->nBytesInBuffer, recorder->buffer)) {
+			recorder->status = GVRSERR_FILE_ERROR;
+		}
+	}
+	recorder->nBytesInBuffer = 0;
+}
+
+static void putVarint(GvrsTraceRecorder* recorder, uint64_t value) {
+	uint8_t* b = recorder->buffer + recorder->nBytesInBuffer;
+	while (value >= 0x80) {
+		*b++ = (uint8_t)(value | 0x80);
+		value >>= 7;
+	}
+	*b++ = (uint8_t)value;
+	recorder->nBytesInBuffer = (int)(b - recorder->buffer);
+}
+
+void GvrsAccessTraceRecord(Gvrs* gvrs, int tileIndex, int32_t recordSize) {
+	GvrsTraceRecorder* recorder = gvrs->accessTrace;
+	// a record requires at most 10 bytes for the index and 5 for the size
+	if (recorder->nBytesInBuffer > TRACE_BUFFER_SIZE - 16) {
+		flushBuffer(recorder);
+	}
+	int64_t delta = (int64_t)tileIndex - (int64_t)recorder->priorTileIndex;
+	uint64_t zigzag = delta < 0 ? ((uint64_t)(-delta) << 1) - 1 : (uint64_t)delta << 1;
+	putVarint(recorder, (zigzag << 1) | (recordSize > 0 ? 1 : 0));
+	if (recordSize > 0) {
+		putVarint(recorder, (uint64_t)recordSize);
+	}
+	recorder->priorTileIndex = tileIndex;
+}
+
+int GvrsAccessTraceStop(Gvrs* gvrs) {
+	if (!gvrs) {
+		return GVRSERR_NULL_ARGUMENT;
+	}
+	GvrsTraceRecorder* recorder = gvrs->accessTrace;
+	if (!recorder) {
+		return 0;
+	}
+	gvrs->accessTrace = 0;
+	flushBuffer(recorder);
+	int status = recorder->status;
+	if (fclose(recorder->fp) && !status) {
+		status = GVRSERR_FILE_ERROR;
+	}
+	free(recorder);
+	return status;
+}
+
+GvrsAccessTrace* GvrsAccessTraceFree(GvrsAccessTrace* trace) {
+	if (trace) {
+		free(trace->tileIndices);
+		free(trace->recordSizes);
+		free(trace);
+	}
+	return 0;
+}
+
+static int getVarint(const uint8_t* b, int64_t n, int64_t* offset, uint64_t* value) {
+	uint64_t v = 0;
+	int shift = 0;
+	while (*offset < n && shift < 64) {
+		uint8_t c = b[(*offset)++];
+		v |= (uint64_t)(c & 0x7f) << shift;
+		if (!(c & 0x80)) {
+			*value = v;
+			return 0;
+		}
+		shift += 7;
+	}
+	return GVRSERR_INVALID_FILE;
+}
+
+int GvrsAccessTraceRead(const char* path, GvrsAccessTrace** traceReference) {
+	if (!path || !traceReference) {
+		return GVRSERR_NULL_ARGUMENT;
+	}
+	*traceReference = 0;
+	FILE* fp = fopen(path, "rb");
+	if (!fp) {
+		return GVRSERR_FILENOTFOUND;
+	}
+	GvrsAccessTrace* trace = calloc(1, sizeof(GvrsAccessTrace));
+	if (!trace) {
+		fclose(fp);
+		return GVRSERR_NOMEM;
+	}
+	char identifier[32];
+	int32_t version = 0;
+	int status = GvrsReadIdentifier(fp, sizeof(identifier), identifier);
+	if (!status && strcmp(identifier, TRACE_IDENTIFIER)) {
+		status = GVRSERR_INVALID_FILE;
+	}
+	if (!status) {
+		GvrsReadInt(fp, &version);
+		GvrsReadInt(fp, &trace->nRowsOfTiles);
+		GvrsReadInt(fp, &trace->nColsOfTiles);
+		GvrsReadInt(fp, &trace->nBytesForTileData);
+		status = GvrsReadInt(fp, &trace->maxTileCacheSize);
+	}
+	if (!status && version != TRACE_VERSION) {
+		status = GVRSERR_VERSION_NOT_SUPPORTED;
+	}
+	int64_t nTiles = (int64_t)trace->nRowsOfTiles * (int64_t)trace->nColsOfTiles;
+	if (!status && (trace->nRowsOfTiles <= 0 || trace->nColsOfTiles <= 0 || nTiles > INT32_MAX)) {
+		status = GVRSERR_INVALID_FILE;
+	}
+
+	// read the remainder of the file into memory
+	uint8_t* content = 0;
+	int64_t nBytes = 0;
+	if (!status) {
+		int64_t filePos = GvrsGetFilePosition(fp);
+		fseek(fp, 0, SEEK_END);
+		nBytes = GvrsGetFilePosition(fp) - filePos;
+		status = GvrsSetFilePosition(fp, filePos);
+		if (!status && nBytes > 0) {
+			content = malloc((size_t)nBytes);
+			if (!content) {
+				status = GVRSERR_NOMEM;
+			}
+			else if (fread(content, 1, (size_t)nBytes, fp) != (size_t)nBytes) {
+				status = GVRSERR_FILE_ERROR;
+			}
+		}
+	}
+	fclose(fp);
+
+	// each access requires at least one byte, so the content size
+	// gives an upper bound for the number of accesses
+	if (!status) {
+		trace->tileIndices = malloc((size_t)(nBytes + 1) * sizeof(int32_t));
+		trace->recordSizes = calloc((size_t)nTiles, sizeof(int32_t));
+		if (!trace->tileIndices || !trace->recordSizes) {
+			status = GVRSERR_NOMEM;
+		}
+	}
+	int64_t offset = 0;
+	int64_t tileIndex = 0;
+	while (!status && offset < nBytes) {
+		uint64_t value, recordSize = 0;
+		status = getVarint(content, nBytes, &offset, &value);
+		if (!status && (value & 1)) {
+			status = getVarint(content, nBytes, &offset, &recordSize);
+		}
+		if (status) {
+			break;
+		}
+		uint64_t zigzag = value >> 1;
+		int64_t delta = (zigzag & 1) ? -(int64_t)((zigzag + 1) >> 1) : (int64_t)(zigzag >> 1);
+		tileIndex += delta;
+		if (tileIndex < 0 || tileIndex >= nTiles || recordSize > INT32_MAX) {
+			status = GVRSERR_INVALID_FILE;
+			break;
+		}
+		trace->tileIndices[trace->nAccesses++] = (int32_t)tileIndex;
+		if (recordSize) {
+			trace->recordSizes[tileIndex] = (int32_t)recordSize;
+		}
+	}
+	free(content);
+	if (status) {
+		GvrsAccessTraceFree(trace);
+		return status;
+	}
+	*traceReference = trace;
+	return 0;
+}
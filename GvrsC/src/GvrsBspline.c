@@ -363,12 +363,10 @@ GvrsInterpolateBspline(GvrsElement* e,
             }
             xCol = col - col0;
         }
-        int k = 0;
-        for (int iRow = 0; iRow < 4; iRow++) {
-            for (int iCol = 0; iCol < 4; iCol++) {
-                GvrsElementReadFloat(e, iRow + row0, iCol + col0, grid + k);
-                k++;
-            }
+        // the block read fetches each tile once and is aware of the in-memory tile layout
+        int status = GvrsElementReadBlockFloat(e, row0, col0, 4, 4, grid);
+        if (status) {
+            return status;
         }
     }
          
@@ -26,6 +26,7 @@
 
 
 #include "GvrsBuilder.h"
+#include "GvrsSimd.h"
 #include "GvrsError.h"
 
 #include <math.h>
@@ -559,6 +560,61 @@ GvrsBuilderAddElementIntCodedFloat(GvrsBuilder* builder,
 	return 0;
 }
 
+int
+GvrsBuilderAddElementCopy(GvrsBuilder* builder, const char* name, GvrsElement* source, GvrsElementSpec** specReference) {
+	if (!builder || !source) {
+		return GVRSERR_NULL_ARGUMENT;
+	}
+	if (!name) {
+		name = source->name;
+	}
+
+	int status;
+	GvrsElementSpec* spec;
+	switch (source->elementType) {
+	case GvrsElementTypeInt:
+		status = GvrsBuilderAddElementInt(builder, name, &spec);
+		break;
+	case GvrsElementTypeIntCodedFloat:
+		status = GvrsBuilderAddElementIntCodedFloat(builder, name,
+			source->elementSpec.intFloatSpec.scale, source->elementSpec.intFloatSpec.offset, &spec);
+		break;
+	case GvrsElementTypeFloat:
+		status = GvrsBuilderAddElementFloat(builder, name, &spec);
+		break;
+	case GvrsElementTypeShort:
+		status = GvrsBuilderAddElementShort(builder, name, &spec);
+		break;
+	default:
+		return recordStatus(builder, GVRSERR_BAD_ELEMENT_SPEC);
+	}
+	if (status) {
+		return status;
+	}
+
+	// The source specification was validated when the source was created,
+	// so the range and fill values can be transferred directly.
+	memcpy(&spec->elementSpec, &source->elementSpec, sizeof(spec->elementSpec));
+	spec->continuous = source->continuous;
+	spec->fillValueInt = source->fillValueInt;
+	spec->fillValueFloat = source->fillValueFloat;
+	spec->unitsToMeters = source->unitsToMeters;
+	status = GvrsElementSpecSetLabel(spec, source->label);
+	if (!status) {
+		status = GvrsElementSpecSetDescription(spec, source->description);
+	}
+	if (!status) {
+		status = GvrsElementSpecSetUnitOfMeasure(spec, source->unitOfMeasure);
+	}
+	if (status) {
+		return status;
+	}
+	if (specReference) {
+		*specReference = spec;
+	}
+	return 0;
+}
+
 int
 GvrsElementSpecSetRangeInt(GvrsElementSpec* eSpec, int32_t iMin, int32_t iMax) {
 	if (!eSpec || !eSpec->builder) {
@@ -619,7 +675,7 @@ GvrsElementSpecSetDescription(GvrsElementSpec* eSpec, char *description) {
 		return 0;
 	}
 
-	int status;
+	int status = 0;
 	eSpec->description = optstrdup(description, &status);
 	return status;
 }
@@ -636,7 +692,7 @@ GvrsElementSpecSetLabel(GvrsElementSpec* eSpec, char* label) {
 		return 0;
 	}
 
-	int status;
+	int status = 0;
 	eSpec->label = optstrdup(label, &status);
 	return status;
 }
@@ -653,7 +709,7 @@ GvrsElementSpecSetUnitOfMeasure(GvrsElementSpec* eSpec, char* unitOfMeasure) {
 		return 0;
 	}
 
-	int status;
+	int status = 0;
 	eSpec->unitOfMeasure = optstrdup(unitOfMeasure, &status);
 	return status;
 }
@@ -661,6 +717,26 @@ GvrsElementSpecSetUnitOfMeasure(GvrsElementSpec* eSpec, char* unitOfMeasure) {
 
 static int writeHeader(Gvrs *gvrs);
 
+static uint64_t splitMix(uint64_t* state) {
+	uint64_t x = (*state += 0x9e3779b97f4a7c15ULL);
+	x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+	x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+	return x ^ (x >> 31);
+}
+
+// Assigns a random (version 4) UUID to a new file so that the handle pool,
+// the shared tile cache, and cache manifests can distinguish it from other files.
+// There is no portable source of random numbers in C, so the bits are obtained
+// by mixing the clock, the address of the instance, and a counter.
+static void assignUuid(Gvrs* gvrs) {
+	static uint64_t nAssigned;
+	uint64_t state = (uint64_t)GvrsTimeNS() ^ ((uint64_t)(uintptr_t)gvrs << 16) ^ (++nAssigned << 48);
+	uint64_t high = splitMix(&state);
+	uint64_t low = splitMix(&state);
+	gvrs->uuidHigh = (int64_t)((high & ~0xf000ULL) | 0x4000ULL);
+	gvrs->uuidLow = (int64_t)((low & 0x3fffffffffffffffULL) | 0x8000000000000000ULL);
+}
+
 int
 GvrsBuilderOpenNewGvrs(GvrsBuilder* builder, const char* path, Gvrs** gvrsReference) {
 	int i;
@@ -668,6 +744,7 @@ GvrsBuilderOpenNewGvrs(GvrsBuilder* builder, const char* path, Gvrs** gvrsRefere
 		return GVRSERR_NULL_ARGUMENT;
 	}
 	*gvrsReference = 0;
+	GvrsSimdInit();  // select the kernels for the host processor
 
 	if (builder->errorCode) {
 		// there was an error recorded while building the specification.
@@ -792,7 +869,9 @@ GvrsBuilderOpenNewGvrs(GvrsBuilder* builder, const char* path, Gvrs** gvrsRefere
 		e->gvrs = gvrs;
 		GvrsStrncpy(e->name, sizeof(e->name), eSpec->name);
 		e->elementType = eSpec->elementType;
+		e->continuous = eSpec->continuous;
 		e->elementIndex = i;
+		e->typeSize = eSpec->typeSize;
 		e->dataOffset = offsetWithinTileData;
 		int n = eSpec->typeSize * builder->nCellsInTile;
 		e->dataSize = (n + 2) & 0xfffffffc; // round up to nearest multiple of 4 (sometimes needed for short) 
@@ -811,6 +890,7 @@ GvrsBuilderOpenNewGvrs(GvrsBuilder* builder, const char* path, Gvrs** gvrsRefere
 		case GvrsElementTypeIntCodedFloat:
 			e->fillValueInt = eSpec->elementSpec.intFloatSpec.iFillValue;
 			e->fillValueFloat = eSpec->elementSpec.intFloatSpec.fillValue;
+			e->icfInverseScale = 1.0f / eSpec->elementSpec.intFloatSpec.scale;
 			break;
 		case GvrsElementTypeFloat:
 			e->fillValueFloat = eSpec->elementSpec.floatSpec.fillValue;
@@ -843,6 +923,7 @@ GvrsBuilderOpenNewGvrs(GvrsBuilder* builder, const char* path, Gvrs** gvrsRefere
 		}
 	}
 
+	assignUuid(gvrs);
 	status = writeHeader(gvrs);
 	if (status == 0) {
 		GvrsTileDirectory* tileDirectoryReference;
@@ -1278,7 +1359,7 @@ GvrsElementSpecSetFillValueFloat(GvrsElementSpec* spec, float fillValue) {
 			spec->elementSpec.intFloatSpec.iFillValue = INT32_MIN;
 		}
 		else {
-			spec->elementSpec.intFloatSpec.fillValue = (fillValue - offset) * scale; ;
+			spec->elementSpec.intFloatSpec.iFillValue = (int32_t)floorf((fillValue - offset) * scale + 0.5f);
 		}
 	}
 	return 0;
@@ -211,6 +211,7 @@ static int pack(int codecIndex, int predictorIndex, int seed, GvrsM32* m32, int*
 	strm.next_out = packing+10;
 	status = deflate(&strm, Z_FINISH);
 	if (status == Z_STREAM_ERROR) {
+		deflateEnd(&strm);
 		free(packing);
 		return GVRSERR_COMPRESSION_FAILURE;
 	}
@@ -219,6 +220,7 @@ static int pack(int codecIndex, int predictorIndex, int seed, GvrsM32* m32, int*
 		// The packing wasn't large enough to store the full compression
 		// or this compressed format was larger than the input.
 		// This would happen if the data was essentially non-compressible.
+		deflateEnd(&strm);
 		free(packing);
 		return GVRSERR_COMPRESSION_FAILURE;
 	}
@@ -29,6 +29,7 @@
 #include "GvrsCrossPlatform.h"
 #include "GvrsError.h"
 #include "GvrsCodec.h"
+#include "GvrsSimd.h"
 #include "zlib.h"
 
 // case-sensitive name of codec
@@ -49,7 +50,12 @@ static GvrsCodec* destroyCodecFloat(struct GvrsCodecTag* codec) {
 }
 
 static GvrsCodec* allocateCodecFloat(struct GvrsCodecTag* codec) {
-	return GvrsCodecFloatAlloc();
+	GvrsCodec* c = GvrsCodecFloatAlloc();
+	if (c && codec) {
+		// preserve an alternate identification (e.g. "GvrsFloat")
+		GvrsStrncpy(c->identification, sizeof(c->identification), codec->identification);
+	}
+	return c;
 }
 
 static int32_t unpackInteger(uint8_t input[], int offset) {
@@ -131,68 +137,35 @@ static int decodeFloat(int nRow, int nColumn, int packingLength, uint8_t* packin
 		return errCode;
 	}
 	for (i = 0; i < nCellsInTile; i++) {
-		rawInt[i] = GvrsBitInputGetBit(bitInput) << 31;
+		rawInt[i] = (uint32_t)GvrsBitInputGetBit(bitInput) << 31;
 	}
 	free(signBytes);
 	bitInput = GvrsBitInputFree(bitInput);
 
-	int lengthExponentPacking = unpackInteger(packing, offset);
-	offset += 4;
-	uint8_t* exponentBytes = doInflate(packing + offset, lengthExponentPacking, nCellsInTile, &errCode);
-	if (!exponentBytes) {
-		return errCode;
-	}
-	offset += lengthExponentPacking;
-	for (i = 0; i < nCellsInTile; i++) {
-		rawInt[i] |= (exponentBytes[i] & 0xff) << 23;   // TO DO: is the & 0xff actually needed?
-	}
-	free(exponentBytes);
-	exponentBytes = 0;
-
-	int lengthMan0Packing = unpackInteger(packing, offset);
-	offset += 4;
-	uint8_t* man0Bytes = doInflate(packing + offset, lengthMan0Packing, nCellsInTile, &errCode);
-	if (!man0Bytes) {
-		return errCode;
-	}
-	offset += lengthMan0Packing;
-	decodeDeltas(man0Bytes, nRow, nColumn);
-	for (i = 0; i < nCellsInTile; i++) {
-		rawInt[i] |= (man0Bytes[i] & 0x7f) << 16;   // TO DO: is the & 0x7f actually needed?
-	}
-	free(man0Bytes);
-	man0Bytes = 0;
-
-
-
-	int lengthMan1Packing = unpackInteger(packing, offset);
-	offset += 4;
-	uint8_t* man1Bytes = doInflate(packing + offset, lengthMan1Packing, nCellsInTile, &errCode);
-	if (!man1Bytes) {
-		return errCode;
+	// Inflate the exponent and the three mantissa byte planes, then
+	// combine them with the sign bits in a single pass.
+	uint8_t* planes[4] = { 0, 0, 0, 0 };
+	for (int iPlane = 0; iPlane < 4; iPlane++) {
+		int lengthPlanePacking = unpackInteger(packing, offset);
+		offset += 4;
+		planes[iPlane] = doInflate(packing + offset, lengthPlanePacking, nCellsInTile, &errCode);
+		if (!planes[iPlane]) {
+			for (int k = 0; k < iPlane; k++) {
+				free(planes[k]);
+			}
+			return errCode;
+		}
+		offset += lengthPlanePacking;
+		if (iPlane > 0) {
+			// the mantissa fragments are stored using a differencing format
+			decodeDeltas(planes[iPlane], nRow, nColumn);
+		}
 	}
-	offset += lengthMan1Packing;
-	decodeDeltas(man1Bytes, nRow, nColumn);
-	for (i = 0; i < nCellsInTile; i++) {
-		rawInt[i] |= (man1Bytes[i] & 0xff) << 8; 
+	GvrsSimdGetKernels()->mergeFloatBytes(nCellsInTile, planes[0], planes[1], planes[2], planes[3], rawInt);
+	for (int iPlane = 0; iPlane < 4; iPlane++) {
+		free(planes[iPlane]);
 	}
-	free(man1Bytes);
-	man1Bytes = 0;
-
 
-	int lengthMan2Packing = unpackInteger(packing, offset);
-	offset += 4;
-	uint8_t* man2Bytes = doInflate(packing + offset, lengthMan2Packing, nCellsInTile, &errCode);
-	if (!man2Bytes) {
-		return errCode;
-	}
-	offset += lengthMan2Packing;
-	decodeDeltas(man2Bytes, nRow, nColumn);
-	for (i = 0; i < nCellsInTile; i++) {
-		rawInt[i] |= (man2Bytes[i] & 0xff);
-	}
-	free(man2Bytes);
- 
 	return 0;
 }
 
@@ -234,12 +207,14 @@ static int doDeflate(int nBytesAvailable, uint8_t* output, int inputLength, uint
 	strm.next_out = output+4;
 	status = deflate(&strm, Z_FINISH);
 	if (status == Z_STREAM_ERROR) {
+		deflateEnd(&strm);
 		return  GVRSERR_COMPRESSION_FAILURE;
 	}
 	if (status != Z_STREAM_END || (int)strm.total_out >= inputLength) {
 		// Compression did not reduce the input to a size less than the source.
 		// This would happen if the data was essentially non-compressible.
 		// For example, random data is non-compressible
+		deflateEnd(&strm);
 		return GVRSERR_COMPRESSION_FAILURE;
 	}
 
@@ -308,11 +283,8 @@ static int encodeFloat(int nRow, int nColumn, float* data, int index, int* packi
 	for (i = 0; i < nCellsInTile; i++) {
 		unsigned int bits = BitsFromF(data, i);
 		GvrsBitOutputPutBit(bitOutput, bits >> 31);
-		sEx[i] = (uint8_t)((bits >> 23) & 0xff);
-		sM1[i] = (uint8_t)((bits >> 16) & 0x7f);
-		sM2[i] = (uint8_t)((bits >> 8) & 0xff);
-		sM3[i] = (uint8_t)(bits & 0xff);
 	}
+	GvrsSimdGetKernels()->splitFloatBytes(nCellsInTile, data, sEx, sM1, sM2, sM3);
 
 	int sBitLength;
 	uint8_t* sBits;
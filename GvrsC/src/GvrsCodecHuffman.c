@@ -236,6 +236,7 @@ int GvrsHuffmanDecodeText(GvrsBitInput* input, int nNodesInIndex, int* nodeIndex
 		for (i = 0; i < nSymbolsInOutput; i++) {
 			output[i] = nodeIndex[0];
 		}
+		return 0;
 	}
 
 	for (i = 0; i < nSymbolsInOutput; i++) {
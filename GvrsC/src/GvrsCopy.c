@@ -0,0 +1,971 @@
+/* --------------------------------------------------------------------
+ *
+ * The MIT License
+ *
+ * Copyright (C) 2024  Gary W. Lucas.
+
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ * ---------------------------------------------------------------------
+ */
+
+// Development Note:
+//    The functions in this module copy content from a source GVRS file
+// to a new file.  There are two ways of transferring a tile:
+//
+//    1. Raw transfer.  If the output uses the same tile size as the source,
+//       and it supports the codecs that were used to compress the tile,
+//       the tile record is read from the source file as a block of bytes and
+//       written to the output without being decompressed.  Because the codec
+//       index stored in the first byte of each compressed segment refers to the
+//       position of the codec in the file's codec list, it is remapped
+//       when the output lists the codecs in a different order.
+//    2. Transcoding.  Tiles are decoded using a tile cache for the source,
+//       copied into tiles in the output, and compressed by the output
+//       tile cache when they are written.
+//
+// Raw transfers are performed in order of file position so that the reads
+// from the source file proceed sequentially.  The tiles that cannot be transferred
+// are transcoded afterwards by the parallel executor (see GvrsParallel.c), which
+// visits the source tiles in the region.  Each output tile is assigned to the
+// source tile that contains its first cell.  The worker that processes the source
+// tile populates the output tiles assigned to it, reading any neighboring source
+// tiles they overlap through a private tile cache.  The completed output tiles
+// are stored in the output tile cache by the ordered write-back function,
+// so the content of the output does not depend on the scheduling of the workers.
+//
+// When a tile placement is specified, the tiles are processed sequentially in
+// the order of the space-filling curve instead and each tile is written as soon
+// as it is populated, so the tile records in the output follow the curve.
+// Because the output has no free space,
+// a copy also serves as a compaction pass for files that have been modified.
+//
+// When a subset of the source is extracted, raw transfers are possible only
+// if the subset starts on a tile boundary.  Tiles along the far edges of
+// the subset that extend beyond it are re-tiled so that the output does
+// not carry data from outside the subset.
+
+#include "GvrsFramework.h"
+
+#include "GvrsPrimaryIo.h"
+#include "Gvrs.h"
+#include "GvrsInternal.h"
+#include "GvrsBuilder.h"
+#include "GvrsParallel.h"
+#include "GvrsError.h"
+
+typedef struct GvrsCopyTileRefTag {
+	int tileIndex;
+	int64_t filePos;
+}GvrsCopyTileRef;
+
+typedef struct GvrsCopyContextTag {
+	Gvrs* source;
+	Gvrs* output;
+	GvrsCopyOptions* options;
+
+	// the region of the source to be copied
+	int row0;
+	int col0;
+	int nRows;
+	int nCols;
+
+	// codecMap[i] gives the index of the output codec with the same identification
+	// as source codec i, or -1 if the output does not have one.
+	int* codecMap;
+	int rawSegmentsAllowed;
+
+	uint8_t* buffer;
+	int bufferSize;
+
+	// the source cache and tile buffer used when tiles are transcoded sequentially
+	GvrsTileCache* sourceCache;
+	uint8_t* tileBuffer;
+
+	// transcode[i] is non-zero if output tile i is to be transcoded by the
+	// parallel pass.  If a null, all output tiles are transcoded.
+	uint8_t* transcode;
+
+	// the private source caches for the workers in the parallel pass, indexed by worker
+	int nWorkerCaches;
+	GvrsTileCache** workerCaches;
+}GvrsCopyContext;
+
+// The result posted by a worker for the output tiles assigned to a source tile.
+// The structure is followed by nTiles records, each consisting of
+// the output tile index (padded to 8 bytes) and the tile data.
+typedef struct GvrsCopyResultTag {
+	int nTiles;
+	int recordSize;
+}GvrsCopyResult;
+
+
+static int compareTileRefs(const void* p1, const void* p2) {
+	const GvrsCopyTileRef* a = (const GvrsCopyTileRef*)p1;
+	const GvrsCopyTileRef* b = (const GvrsCopyTileRef*)p2;
+	if (a->filePos < b->filePos) {
+		return -1;
+	}
+	else if (a->filePos > b->filePos) {
+		return 1;
+	}
+	return 0;
+}
+
+
+int GvrsCopyOptionsInit(Gvrs* source, GvrsCopyOptions* options) {
+	if (!source || !options) {
+		return GVRSERR_NULL_ARGUMENT;
+	}
+	memset(options, 0, sizeof(GvrsCopyOptions));
+	options->nRowsInTile = source->nRowsInTile;
+	options->nColsInTile = source->nColsInTile;
+	options->compression = GvrsCopyCompressionSource;
+	options->checksumEnabled = source->checksumEnabled;
+	options->copyMetadata = 1;
+	options->tilePlacement = GvrsTilePlacementSequential;
+	return 0;
+}
+
+static int addElementSpecs(Gvrs* source, GvrsBuilder* builder) {
+	int i;
+	for (i = 0; i < source->nElementsInTupple; i++) {
+		int status = GvrsBuilderAddElementCopy(builder, 0, source->elements[i], 0);
+		if (status) {
+			return status;
+		}
+	}
+	return 0;
+}
+
+static int registerCodecs(Gvrs* source, GvrsCopyOptions* options, GvrsBuilder* builder) {
+	int i;
+	switch (options->compression) {
+	case GvrsCopyCompressionNone:
+		return 0;
+	case GvrsCopyCompressionStandard:
+		return GvrsBuilderRegisterStandardDataCompressionCodecs(builder);
+	case GvrsCopyCompressionSource:
+		for (i = 0; i < source->nDataCompressionCodecs; i++) {
+			GvrsCodec* codec = source->dataCompressionCodecs[i];
+			if (!codec || !codec->allocateNewCodec) {
+				return GVRSERR_COMPRESSION_NOT_IMPLEMENTED;
+			}
+			GvrsCodec* c = codec->allocateNewCodec(codec);
+			if (!c) {
+				return GVRSERR_NOMEM;
+			}
+			int status = GvrsBuilderRegisterDataCompressionCodec(builder, c);
+			if (status) {
+				c->destroyCodec(c);
+				return status;
+			}
+		}
+		return 0;
+	default:
+		return GVRSERR_INVALID_PARAMETER;
+	}
+}
+
+
+static int openOutput(GvrsCopyContext* ctx, const char* path) {
+	Gvrs* source = ctx->source;
+	GvrsCopyOptions* options = ctx->options;
+	GvrsBuilder* builder;
+	int status = GvrsBuilderInit(&builder, ctx->nRows, ctx->nCols);
+	if (status) {
+		return status;
+	}
+
+	int nRowsInTile = options->nRowsInTile > 0 ? options->nRowsInTile : source->nRowsInTile;
+	int nColsInTile = options->nColsInTile > 0 ? options->nColsInTile : source->nColsInTile;
+	status = GvrsBuilderSetTileSize(builder, nRowsInTile, nColsInTile);
+	if (status) {
+		GvrsBuilderFree(builder);
+		return status;
+	}
+	GvrsBuilderSetChecksumEnabled(builder, options->checksumEnabled);
+
+	// Transfer the coordinate system.  The row and column offsets are applied
+	// to the model coordinates so that each cell in the output retains
+	// the coordinates it had in the source.
+	builder->rasterSpaceCode = source->rasterSpaceCode;
+	builder->geographicCoordinates = source->geographicCoordinates;
+	builder->cellSizeX = source->cellSizeX;
+	builder->cellSizeY = source->cellSizeY;
+	builder->x0 = source->x0 + ctx->col0 * source->cellSizeX;
+	builder->y0 = source->y0 + ctx->row0 * source->cellSizeY;
+	builder->x1 = source->x1 - (source->nColsInRaster - ctx->col0 - ctx->nCols) * source->cellSizeX;
+	builder->y1 = source->y1 - (source->nRowsInRaster - ctx->row0 - ctx->nRows) * source->cellSizeY;
+	builder->m2r = source->m2r;
+	builder->m2r.a02 -= ctx->col0;
+	builder->m2r.a12 -= ctx->row0;
+	builder->r2m = source->r2m;
+	builder->r2m.a02 += ctx->col0 * source->r2m.a00 + ctx->row0 * source->r2m.a01;
+	builder->r2m.a12 += ctx->col0 * source->r2m.a10 + ctx->row0 * source->r2m.a11;
+
+	status = addElementSpecs(source, builder);
+	if (!status) {
+		status = registerCodecs(source, options, builder);
+	}
+	if (!status) {
+		status = GvrsBuilderOpenNewGvrs(builder, path, &ctx->output);
+	}
+	GvrsBuilderFree(builder);
+	return status;
+}
+
+
+// Establish the mapping between the codecs in the source and the output
+// and determine whether segments that were stored without compression
+// may be transferred as is.  An uncompressed segment is acceptable if the
+// output does not use compression at all, or if every codec in the output
+// was also available to the source (in which case, the source
+// must have determined that none of them was effective for the segment).
+static int mapCodecs(GvrsCopyContext* ctx) {
+	Gvrs* source = ctx->source;
+	Gvrs* output = ctx->output;
+	int i, j;
+	if (source->nDataCompressionCodecs > 0) {
+		ctx->codecMap = calloc((size_t)source->nDataCompressionCodecs, sizeof(int));
+		if (!ctx->codecMap) {
+			return GVRSERR_NOMEM;
+		}
+	}
+	for (i = 0; i < source->nDataCompressionCodecs; i++) {
+		ctx->codecMap[i] = -1;
+		for (j = 0; j < output->nDataCompressionCodecs; j++) {
+			if (strcmp(source->dataCompressionCodecs[i]->identification,
+				output->dataCompressionCodecs[j]->identification) == 0) {
+				ctx->codecMap[i] = j;
+				break;
+			}
+		}
+	}
+
+	ctx->rawSegmentsAllowed = 1;
+	for (j = 0; j < output->nDataCompressionCodecs; j++) {
+		if (!GvrsGetCodecByName(source, output->dataCompressionCodecs[j]->identification)) {
+			ctx->rawSegmentsAllowed = 0;
+			break;
+		}
+	}
+	return 0;
+}
+
+
+// Attempts to transfer a tile record from the source to the output without
+// decoding it.  If the record is not eligible for a raw transfer,
+// the copied flag is set to zero and no output is written.
+static int copyTileRecord(GvrsCopyContext* ctx, int64_t filePos, int outputTileIndex, int* copied) {
+	Gvrs* source = ctx->source;
+	Gvrs* output = ctx->output;
+	FILE* fp = source->fp;
+	int status;
+	int i;
+
+	*copied = 0;
+
+	int32_t blockSize;
+	status = GvrsSetFilePosition(fp, filePos - 8);
+	if (status) {
+		return status;
+	}
+	status = GvrsReadInt(fp, &blockSize);
+	if (status) {
+		return status;
+	}
+	// the block size includes the record header and checksum (12 bytes total)
+	int nBytesInRecord = blockSize - 12;
+	if (nBytesInRecord < 4 + 4 * source->nElementsInTupple) {
+		return GVRSERR_INVALID_FILE;
+	}
+	if (nBytesInRecord > ctx->bufferSize) {
+		uint8_t* b = realloc(ctx->buffer, (size_t)nBytesInRecord);
+		if (!b) {
+			return GVRSERR_NOMEM;
+		}
+		ctx->buffer = b;
+		ctx->bufferSize = nBytesInRecord;
+	}
+	uint8_t* buffer = ctx->buffer;
+	status = GvrsSetFilePosition(fp, filePos);
+	if (!status) {
+		status = GvrsReadByteArray(fp, nBytesInRecord, buffer);
+	}
+	if (status) {
+		return status;
+	}
+
+	// Scan the element segments to verify that they can be transferred
+	// and to establish the exact size of the content.  The records use the
+	// same byte order as the GvrsPrimaryIo functions.
+	int pos = 4; // skip the tile index
+	for (i = 0; i < source->nElementsInTupple; i++) {
+		int32_t n;
+		if (pos + 4 > nBytesInRecord) {
+			return GVRSERR_INVALID_FILE;
+		}
+		memcpy(&n, buffer + pos, 4);
+		pos += 4;
+		if (n <= 0 || pos + n > nBytesInRecord) {
+			return GVRSERR_INVALID_FILE;
+		}
+		if (n < source->elements[i]->dataSize) {
+			int codecIndex = (int)buffer[pos];
+			if (codecIndex >= source->nDataCompressionCodecs || ctx->codecMap[codecIndex] < 0) {
+				return 0;
+			}
+		}
+		else if (!ctx->rawSegmentsAllowed) {
+			return 0;
+		}
+		pos += n;
+	}
+	int nBytesForContent = pos;
+
+	// The tile is eligible for transfer.  Remap codec indices and the tile index.
+	int32_t tileIndex = outputTileIndex;
+	memcpy(buffer, &tileIndex, 4);
+	pos = 4;
+	for (i = 0; i < source->nElementsInTupple; i++) {
+		int32_t n;
+		memcpy(&n, buffer + pos, 4);
+		pos += 4;
+		if (n < source->elements[i]->dataSize) {
+			buffer[pos] = (uint8_t)ctx->codecMap[buffer[pos]];
+		}
+		pos += n;
+	}
+
+	int64_t outputPos;
+	status = GvrsFileSpaceAlloc(output->fileSpaceManager, GvrsRecordTypeTile, nBytesForContent, &outputPos);
+	if (outputPos == 0) {
+		return status ? status : GVRSERR_FILE_ERROR;
+	}
+	status = GvrsWriteByteArray(output->fp, nBytesForContent, buffer);
+	if (status) {
+		return status;
+	}
+	status = GvrsFileSpaceFinish(output->fileSpaceManager, outputPos);
+	if (status) {
+		return status;
+	}
+	status = GvrsTileDirectoryRegisterFilePosition(output->tileDirectory, outputTileIndex, outputPos, GvrsFileSpaceRecordSize(nBytesForContent));
+	if (status) {
+		return status;
+	}
+	*copied = 1;
+	return 0;
+}
+
+
+// Populates the data for the specified output tile with values from the source.
+// The output tile may overlap multiple source tiles, which are read using the
+// specified source cache.  If none of the overlapped source tiles are populated,
+// the populated flag is set to zero and the output tile is not to be created.
+static int fillOutputTile(GvrsCopyContext* ctx, GvrsTileCache* sourceCache, int outputTileIndex, uint8_t* data, int* populated) {
+	Gvrs* source = ctx->source;
+	Gvrs* output = ctx->output;
+	int errCode = 0;
+	int i, iRow;
+
+	*populated = 0;
+	for (i = 0; i < output->nElementsInTupple; i++) {
+		GvrsElement* oe = output->elements[i];
+		GvrsElementFillData(oe, data + oe->dataOffset, output->nCellsInTile);
+	}
+
+	int tileRow = outputTileIndex / output->nColsOfTiles;
+	int tileCol = outputTileIndex - tileRow * output->nColsOfTiles;
+
+	// the range of rows and columns covered by the tile in output coordinates
+	int oRow0 = tileRow * output->nRowsInTile;
+	int oCol0 = tileCol * output->nColsInTile;
+	int oRow1 = oRow0 + output->nRowsInTile;
+	int oCol1 = oCol0 + output->nColsInTile;
+	if (oRow1 > output->nRowsInRaster) {
+		oRow1 = output->nRowsInRaster;
+	}
+	if (oCol1 > output->nColsInRaster) {
+		oCol1 = output->nColsInRaster;
+	}
+
+	// the same range in source coordinates
+	int sRow0 = oRow0 + ctx->row0;
+	int sCol0 = oCol0 + ctx->col0;
+	int sRow1 = oRow1 + ctx->row0;
+	int sCol1 = oCol1 + ctx->col0;
+
+	int sNRowsInTile = source->nRowsInTile;
+	int sNColsInTile = source->nColsInTile;
+	int sTileRow0 = sRow0 / sNRowsInTile;
+	int sTileRow1 = (sRow1 - 1) / sNRowsInTile;
+	int sTileCol0 = sCol0 / sNColsInTile;
+	int sTileCol1 = (sCol1 - 1) / sNColsInTile;
+
+	int sTileRow, sTileCol;
+	for (sTileRow = sTileRow0; sTileRow <= sTileRow1; sTileRow++) {
+		for (sTileCol = sTileCol0; sTileCol <= sTileCol1; sTileCol++) {
+			int sTileIndex = sTileRow * source->nColsOfTiles + sTileCol;
+			GvrsTile* sTile = GvrsTileCacheFetchTile(sourceCache, sTileIndex, &errCode);
+			if (!sTile) {
+				if (errCode) {
+					return errCode;
+				}
+				continue;
+			}
+			*populated = 1;
+
+			// the intersection of the source tile and the output tile, in source coordinates
+			int rA = sTileRow * sNRowsInTile;
+			int rB = rA + sNRowsInTile;
+			int cA = sTileCol * sNColsInTile;
+			int cB = cA + sNColsInTile;
+			int sTileRowStart = rA;
+			int sTileColStart = cA;
+			if (rA < sRow0) {
+				rA = sRow0;
+			}
+			if (rB > sRow1) {
+				rB = sRow1;
+			}
+			if (cA < sCol0) {
+				cA = sCol0;
+			}
+			if (cB > sCol1) {
+				cB = sCol1;
+			}
+			int nColsInSegment = cB - cA;
+			for (i = 0; i < source->nElementsInTupple; i++) {
+				GvrsElement* se = source->elements[i];
+				GvrsElement* oe = output->elements[i];
+				int typeSize = se->typeSize;
+				uint8_t* sData = sTile->data + se->dataOffset;
+				uint8_t* oData = data + oe->dataOffset;
+				for (iRow = rA; iRow < rB; iRow++) {
+					int sIndex = (iRow - sTileRowStart) * sNColsInTile + (cA - sTileColStart);
+					int oIndex = (iRow - ctx->row0 - oRow0) * output->nColsInTile + (cA - ctx->col0 - oCol0);
+					memcpy(oData + (size_t)oIndex * typeSize, sData + (size_t)sIndex * typeSize, (size_t)nColsInSegment * typeSize);
+				}
+			}
+		}
+	}
+
+	return 0;
+}
+
+
+// Stores the data for a transcoded tile in the output tile cache.  The cache
+// will compress the tile when it is written.
+static int storeOutputTile(GvrsCopyContext* ctx, int outputTileIndex, const uint8_t* data) {
+	Gvrs* output = ctx->output;
+	int errCode = 0;
+	GvrsTile* oTile = GvrsTileCacheStartNewTile(output->tileCache, outputTileIndex, &errCode);
+	if (!oTile) {
+		return errCode ? errCode : GVRSERR_INTERNAL_ERROR;
+	}
+	memcpy(oTile->data, data, (size_t)output->nBytesForTileData);
+	oTile->writePending = 1;
+	ctx->options->nTilesTranscoded++;
+	return 0;
+}
+
+
+// Transcodes a single output tile using the sequential source cache.
+static int transcodeTile(GvrsCopyContext* ctx, int outputTileIndex) {
+	int populated;
+	int status = fillOutputTile(ctx, ctx->sourceCache, outputTileIndex, ctx->tileBuffer, &populated);
+	if (status || !populated) {
+		return status;
+	}
+	return storeOutputTile(ctx, outputTileIndex, ctx->tileBuffer);
+}
+
+
+static int allocSourceCache(GvrsCopyContext* ctx) {
+	// The source cache must be large enough to hold all the source tiles
+	// that overlap one row of output tiles so that each source tile is read only once
+	// when the output tiles are processed in row-major order.
+	Gvrs* source = ctx->source;
+	Gvrs* output = ctx->output;
+	int sTileCol0 = ctx->col0 / source->nColsInTile;
+	int sTileCol1 = (ctx->col0 + ctx->nCols - 1) / source->nColsInTile;
+	int nRowsOfTilesInRow = (output->nRowsInTile + source->nRowsInTile - 2) / source->nRowsInTile + 1;
+	int n = (sTileCol1 - sTileCol0 + 1) * nRowsOfTilesInRow;
+	int status = GvrsTileCacheAlloc(source, n, &ctx->sourceCache);
+	if (status) {
+		return status;
+	}
+	ctx->tileBuffer = malloc((size_t)output->nBytesForTileData);
+	if (!ctx->tileBuffer) {
+		return GVRSERR_NOMEM;
+	}
+	// the tile data is copied row by row, so the source cache uses row-major order
+	// regardless of the layout selected for the source instance.
+	return GvrsTileCacheSetLayout(ctx->sourceCache, GvrsTileLayoutRowMajor);
+}
+
+
+// Indicates whether the source tile corresponding to an output tile extends
+// beyond the region being copied (applies only when the tiles are aligned).
+static int isEdgeTile(GvrsCopyContext* ctx, int outputTileIndex) {
+	Gvrs* source = ctx->source;
+	Gvrs* output = ctx->output;
+	int tileRow = outputTileIndex / output->nColsOfTiles;
+	int tileCol = outputTileIndex - tileRow * output->nColsOfTiles;
+	int sTileRow = tileRow + ctx->row0 / source->nRowsInTile;
+	int sTileCol = tileCol + ctx->col0 / source->nColsInTile;
+	int sRowEnd = (sTileRow + 1) * source->nRowsInTile;
+	int sColEnd = (sTileCol + 1) * source->nColsInTile;
+	if (sRowEnd > source->nRowsInRaster) {
+		sRowEnd = source->nRowsInRaster;
+	}
+	if (sColEnd > source->nColsInRaster) {
+		sColEnd = source->nColsInRaster;
+	}
+	return sRowEnd > ctx->row0 + ctx->nRows || sColEnd > ctx->col0 + ctx->nCols;
+}
+
+static int sourceTileIndex(GvrsCopyContext* ctx, int outputTileIndex) {
+	Gvrs* source = ctx->source;
+	Gvrs* output = ctx->output;
+	int tileRow = outputTileIndex / output->nColsOfTiles;
+	int tileCol = outputTileIndex - tileRow * output->nColsOfTiles;
+	int sTileRow = tileRow + ctx->row0 / source->nRowsInTile;
+	int sTileCol = tileCol + ctx->col0 / source->nColsInTile;
+	return sTileRow * source->nColsOfTiles + sTileCol;
+}
+
+
+// Processes all output tiles in the order given by the tile placement.
+// Transcoded tiles are written immediately so that they take their place
+// in the sequence of records in the output file.
+static int copyTilesInPlacementOrder(GvrsCopyContext* ctx, int aligned) {
+	Gvrs* source = ctx->source;
+	Gvrs* output = ctx->output;
+	GvrsCopyOptions* options = ctx->options;
+	int status = 0;
+	int i;
+
+	int nTiles = output->nRowsOfTiles * output->nColsOfTiles;
+	GvrsCopyTileRef* refs = calloc((size_t)(nTiles > 0 ? nTiles : 1), sizeof(GvrsCopyTileRef));
+	if (!refs) {
+		return GVRSERR_NOMEM;
+	}
+	// the filePos member of the reference is used for the sort key
+	for (i = 0; i < nTiles; i++) {
+		refs[i].tileIndex = i;
+		refs[i].filePos = GvrsTilePlacementKey(options->tilePlacement,
+			output->nRowsOfTiles, output->nColsOfTiles, i);
+	}
+	qsort(refs, (size_t)nTiles, sizeof(GvrsCopyTileRef), compareTileRefs);
+
+	for (i = 0; i < nTiles; i++) {
+		int tileIndex = refs[i].tileIndex;
+		if (aligned && !isEdgeTile(ctx, tileIndex)) {
+			int64_t filePos = GvrsTileDirectoryGetFilePosition(source->tileDirectory, sourceTileIndex(ctx, tileIndex));
+			if (!filePos) {
+				continue;
+			}
+			int copied;
+			status = copyTileRecord(ctx, filePos, tileIndex, &copied);
+			if (status) {
+				break;
+			}
+			if (copied) {
+				options->nTilesCopiedRaw++;
+				continue;
+			}
+		}
+		status = transcodeTile(ctx, tileIndex);
+		if (!status) {
+			status = GvrsTileCacheWritePendingTiles(output->tileCache);
+		}
+		if (status) {
+			break;
+		}
+	}
+
+	free(refs);
+	return status;
+}
+
+
+// Allocates the private source cache for a worker in the parallel pass.  The cache
+// must hold the source tiles that overlap an output tile along with
+// the next column of source tiles, which the worker is likely to need
+// for the output tiles assigned to the next source tile in its run.
+static int allocWorkerCache(GvrsCopyContext* ctx, Gvrs* gvrs, GvrsTileCache** cache) {
+	Gvrs* source = ctx->source;
+	Gvrs* output = ctx->output;
+	int nRowsOfTilesSpanned = (output->nRowsInTile + source->nRowsInTile - 2) / source->nRowsInTile + 1;
+	int nColsOfTilesSpanned = (output->nColsInTile + source->nColsInTile - 2) / source->nColsInTile + 1;
+	int status = GvrsTileCacheAlloc(gvrs, nRowsOfTilesSpanned * (nColsOfTilesSpanned + 1), cache);
+	if (status) {
+		return status;
+	}
+	return GvrsTileCacheSetLayout(*cache, GvrsTileLayoutRowMajor);
+}
+
+
+// Computes the range of output tile rows (or columns) assigned to a source
+// tile row (or column).  An output tile is assigned to the source tile that
+// contains its first cell.  The range is empty if first is greater than last.
+static void assignedRange(int sIndex, int sN, int offset, int oN, int nOfTiles, int* first, int* last) {
+	int a = sIndex * sN - offset;
+	int b = (sIndex + 1) * sN - 1 - offset;
+	if (a < 0) {
+		a = 0;
+	}
+	*first = (a + oN - 1) / oN;
+	*last = b / oN;
+	if (*last > nOfTiles - 1) {
+		*last = nOfTiles - 1;
+	}
+}
+
+
+// The tile function for the parallel pass.  Populates the output tiles
+// assigned to a source tile and posts them as the task result.
+static int transcodeTask(GvrsParallelTask* task, void* userData) {
+	GvrsCopyContext* ctx = (GvrsCopyContext*)userData;
+	Gvrs* source = ctx->source;
+	Gvrs* output = ctx->output;
+	int status;
+	int oTileRow, oTileCol;
+
+	int oTileRow0, oTileRow1, oTileCol0, oTileCol1;
+	assignedRange(task->tileRow, source->nRowsInTile, ctx->row0, output->nRowsInTile, output->nRowsOfTiles, &oTileRow0, &oTileRow1);
+	assignedRange(task->tileCol, source->nColsInTile, ctx->col0, output->nColsInTile, output->nColsOfTiles, &oTileCol0, &oTileCol1);
+	int nAssigned = 0;
+	for (oTileRow = oTileRow0; oTileRow <= oTileRow1; oTileRow++) {
+		for (oTileCol = oTileCol0; oTileCol <= oTileCol1; oTileCol++) {
+			int oTileIndex = oTileRow * output->nColsOfTiles + oTileCol;
+			if (!ctx->transcode || ctx->transcode[oTileIndex]) {
+				nAssigned++;
+			}
+		}
+	}
+	if (nAssigned == 0) {
+		return 0;
+	}
+
+	GvrsTileCache** cache = ctx->workerCaches + task->workerIndex;
+	if (!*cache) {
+		status = allocWorkerCache(ctx, task->gvrs, cache);
+		if (status) {
+			return status;
+		}
+	}
+
+	int recordSize = 8 + output->nBytesForTileData;
+	GvrsCopyResult* result = malloc(sizeof(GvrsCopyResult) + (size_t)nAssigned * recordSize);
+	if (!result) {
+		return GVRSERR_NOMEM;
+	}
+	result->nTiles = 0;
+	result->recordSize = recordSize;
+	task->result = result;
+	uint8_t* record = (uint8_t*)(result + 1);
+	for (oTileRow = oTileRow0; oTileRow <= oTileRow1; oTileRow++) {
+		for (oTileCol = oTileCol0; oTileCol <= oTileCol1; oTileCol++) {
+			int oTileIndex = oTileRow * output->nColsOfTiles + oTileCol;
+			if (ctx->transcode && !ctx->transcode[oTileIndex]) {
+				continue;
+			}
+			int populated;
+			status = fillOutputTile(ctx, *cache, oTileIndex, record + 8, &populated);
+			if (status) {
+				return status;
+			}
+			if (populated) {
+				memcpy(record, &oTileIndex, sizeof(int));
+				record += recordSize;
+				result->nTiles++;
+			}
+		}
+	}
+	return 0;
+}
+
+
+// The write-back function for the parallel pass.  Calls are made in order
+// of the source tile sequence, so the output tiles are stored in the same order
+// regardless of which worker populated them.
+static int transcodeWriteBack(GvrsParallelTask* task, void* userData) {
+	GvrsCopyContext* ctx = (GvrsCopyContext*)userData;
+	GvrsCopyResult* result = (GvrsCopyResult*)task->result;
+	if (!result) {
+		return 0;
+	}
+	uint8_t* record = (uint8_t*)(result + 1);
+	int i;
+	for (i = 0; i < result->nTiles; i++) {
+		int oTileIndex;
+		memcpy(&oTileIndex, record, sizeof(int));
+		int status = storeOutputTile(ctx, oTileIndex, record + 8);
+		if (status) {
+			return status;
+		}
+		record += result->recordSize;
+	}
+	return 0;
+}
+
+
+// Transcodes the output tiles indicated by the transcode array (or all output tiles
+// if the array is a null) using multiple threads.
+static int transcodeTilesInParallel(GvrsCopyContext* ctx) {
+	Gvrs* source = ctx->source;
+	GvrsParallelOptions parallelOptions;
+	int status = GvrsParallelOptionsInit(source, &parallelOptions);
+	if (status) {
+		return status;
+	}
+	// The workers read the source through their private caches, so the
+	// caches for their GVRS instances are kept small.
+	parallelOptions.nThreads = ctx->options->nThreads;
+	parallelOptions.tileCacheSize = GvrsTileCacheSizeSmall;
+	parallelOptions.writeBack = transcodeWriteBack;
+
+	ctx->nWorkerCaches = ctx->options->nThreads > 0 ? ctx->options->nThreads : GvrsGetProcessorCount();
+	if (ctx->nWorkerCaches < 1) {
+		ctx->nWorkerCaches = 1;
+	}
+	ctx->workerCaches = calloc((size_t)ctx->nWorkerCaches, sizeof(GvrsTileCache*));
+	if (!ctx->workerCaches) {
+		return GVRSERR_NOMEM;
+	}
+
+	GvrsRegion region;
+	region.row0 = ctx->row0;
+	region.col0 = ctx->col0;
+	region.row1 = ctx->row0 + ctx->nRows - 1;
+	region.col1 = ctx->col0 + ctx->nCols - 1;
+	status = GvrsParallelForTilesWithOptions(source, &region, &parallelOptions, transcodeTask, ctx);
+
+	// The reader clones used by the workers have been closed by the executor.
+	// The worker caches are read-only and freeing them does not access the
+	// GVRS instances that were used to allocate them.
+	int i;
+	for (i = 0; i < ctx->nWorkerCaches; i++) {
+		GvrsTileCacheFree(ctx->workerCaches[i]);
+	}
+	free(ctx->workerCaches);
+	ctx->workerCaches = 0;
+	ctx->nWorkerCaches = 0;
+	return status;
+}
+
+
+static int copyTiles(GvrsCopyContext* ctx) {
+	Gvrs* source = ctx->source;
+	Gvrs* output = ctx->output;
+	GvrsCopyOptions* options = ctx->options;
+	int status;
+	int i;
+
+	status = GvrsLoadTileDirectory(source);
+	if (status) {
+		return status;
+	}
+
+	int nTiles = output->nRowsOfTiles * output->nColsOfTiles;
+	int aligned = source->nRowsInTile == output->nRowsInTile
+		&& source->nColsInTile == output->nColsInTile
+		&& (ctx->row0 % source->nRowsInTile) == 0
+		&& (ctx->col0 % source->nColsInTile) == 0;
+
+	if (options->tilePlacement != GvrsTilePlacementSequential) {
+		// Each tile must be written as soon as it is populated, so the tiles
+		// are transcoded sequentially.
+		status = allocSourceCache(ctx);
+		if (status) {
+			return status;
+		}
+		return copyTilesInPlacementOrder(ctx, aligned);
+	}
+
+	if (!aligned) {
+		// The tile geometry differs.  All output tiles are transcoded.
+		return transcodeTilesInParallel(ctx);
+	}
+
+	// Each output tile corresponds to exactly one source tile.  A source tile
+	// may be transferred as is if all of its cells that lie inside the source raster
+	// also lie inside the region being copied.  The remaining tiles along the
+	// edges of the region are re-tiled.  Collect the candidates for transfer and
+	// process them in the order in which they are stored in the source file.
+	// Tiles that are not eligible for transfer are marked for transcoding.
+	// Output tiles whose source tile is not populated are not created.
+	GvrsCopyTileRef* refs = calloc((size_t)(nTiles > 0 ? nTiles : 1), sizeof(GvrsCopyTileRef));
+	ctx->transcode = calloc((size_t)(nTiles > 0 ? nTiles : 1), sizeof(uint8_t));
+	if (!refs || !ctx->transcode) {
+		free(refs);
+		return GVRSERR_NOMEM;
+	}
+	int nRefs = 0;
+	int nToTranscode = 0;
+	for (i = 0; i < nTiles; i++) {
+		int64_t filePos = GvrsTileDirectoryGetFilePosition(source->tileDirectory, sourceTileIndex(ctx, i));
+		if (!filePos) {
+			continue;
+		}
+		if (isEdgeTile(ctx, i)) {
+			ctx->transcode[i] = 1;
+			nToTranscode++;
+		}
+		else {
+			refs[nRefs].tileIndex = i;
+			refs[nRefs].filePos = filePos;
+			nRefs++;
+		}
+	}
+	qsort(refs, (size_t)nRefs, sizeof(GvrsCopyTileRef), compareTileRefs);
+
+	for (i = 0; i < nRefs; i++) {
+		int copied;
+		status = copyTileRecord(ctx, refs[i].filePos, refs[i].tileIndex, &copied);
+		if (status) {
+			break;
+		}
+		if (copied) {
+			options->nTilesCopiedRaw++;
+		}
+		else {
+			ctx->transcode[refs[i].tileIndex] = 1;
+			nToTranscode++;
+		}
+	}
+	free(refs);
+	if (status || nToTranscode == 0) {
+		// the parallel pass is not needed if every tile was transferred as stored
+		return status;
+	}
+
+	return transcodeTilesInParallel(ctx);
+}
+
+
+static int copyMetadata(Gvrs* source, Gvrs* output) {
+	GvrsMetadataResultSet* resultSet;
+	int status = GvrsReadMetadataByName(source, "*", &resultSet);
+	if (status) {
+		// the result set was disposed of by the read function
+		return status;
+	}
+	int i;
+	for (i = 0; i < resultSet->nRecords; i++) {
+		status = GvrsMetadataWrite(output, resultSet->records[i]);
+		if (status) {
+			break;
+		}
+	}
+	GvrsMetadataResultSetFree(resultSet);
+	return status;
+}
+
+
+static int copyRegion(Gvrs* source, int row0, int col0, int nRows, int nCols, const char* path, GvrsCopyOptions* options) {
+	if (!source || !path || !*path) {
+		return GVRSERR_NULL_ARGUMENT;
+	}
+	if (source->path && strcmp(source->path, path) == 0) {
+		// the builder would delete the source file
+		return GVRSERR_INVALID_PARAMETER;
+	}
+
+	GvrsCopyOptions defaultOptions;
+	if (!options) {
+		GvrsCopyOptionsInit(source, &defaultOptions);
+		options = &defaultOptions;
+	}
+	options->nTilesCopiedRaw = 0;
+	options->nTilesTranscoded = 0;
+	if (options->tilePlacement != GvrsTilePlacementSequential
+		&& options->tilePlacement != GvrsTilePlacementMorton
+		&& options->tilePlacement != GvrsTilePlacementHilbert) {
+		return GVRSERR_INVALID_PARAMETER;
+	}
+
+	int status;
+	if (source->timeOpenedForWritingMS && source->tileCache) {
+		// ensure that the file reflects any changes made by the application
+		status = GvrsTileCacheWritePendingTiles(source->tileCache);
+		if (status) {
+			return status;
+		}
+		fflush(source->fp);
+	}
+
+	GvrsCopyContext ctx;
+	memset(&ctx, 0, sizeof(ctx));
+	ctx.source = source;
+	ctx.options = options;
+	ctx.row0 = row0;
+	ctx.col0 = col0;
+	ctx.nRows = nRows;
+	ctx.nCols = nCols;
+
+	status = openOutput(&ctx, path);
+	if (status) {
+		return status;
+	}
+
+	status = mapCodecs(&ctx);
+	if (!status) {
+		status = copyTiles(&ctx);
+	}
+	if (!status && options->copyMetadata) {
+		status = copyMetadata(source, ctx.output);
+	}
+
+	ctx.sourceCache = GvrsTileCacheFree(ctx.sourceCache);
+	free(ctx.tileBuffer);
+	free(ctx.transcode);
+	free(ctx.codecMap);
+	free(ctx.buffer);
+
+	if (status) {
+		GvrsSetDeleteOnClose(ctx.output, 1);
+		GvrsClose(ctx.output);
+		return status;
+	}
+	return GvrsClose(ctx.output);
+}
+
+
+int GvrsCopy(Gvrs* source, const char* path, GvrsCopyOptions* options) {
+	if (!source) {
+		return GVRSERR_NULL_ARGUMENT;
+	}
+	return copyRegion(source, 0, 0, source->nRowsInRaster, source->nColsInRaster, path, options);
+}
+
+
+int GvrsExtractSubset(Gvrs* source, int row0, int col0, int row1, int col1, const char* path, GvrsCopyOptions* options) {
+	if (!source) {
+		return GVRSERR_NULL_ARGUMENT;
+	}
+	if (row0 < 0 || col0 < 0 || row1 < row0 || col1 < col0
+		|| row1 >= source->nRowsInRaster || col1 >= source->nColsInRaster) {
+		return GVRSERR_COORDINATE_OUT_OF_BOUNDS;
+	}
+	return copyRegion(source, row0, col0, row1 - row0 + 1, col1 - col0 + 1, path, options);
+}
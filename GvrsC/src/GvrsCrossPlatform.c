@@ -28,9 +28,15 @@
 #include <string.h>
 #if defined(_WIN32) || defined(_WIN64)
 #include <sys/timeb.h>
+#include <windows.h>
+#else
+#include <pthread.h>
+#include <unistd.h>
+#include <fcntl.h>
 #endif
 
 #include "Gvrs.h"
+#include "GvrsError.h"
 
 int64_t GvrsTimeMS() {
 #if defined(_WIN32) || defined(_WIN64)
@@ -45,6 +51,19 @@ int64_t GvrsTimeMS() {
 
 }
 
+int64_t GvrsTimeNS() {
+#if defined(_WIN32) || defined(_WIN64)
+	LARGE_INTEGER frequency, counter;
+	QueryPerformanceFrequency(&frequency);
+	QueryPerformanceCounter(&counter);
+	return (int64_t)((double)counter.QuadPart * 1.0e+9 / (double)frequency.QuadPart);
+#else
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (int64_t)ts.tv_sec * 1000000000LL + (int64_t)ts.tv_nsec;
+#endif
+}
+
 
 int
 GvrsStrncpy(char* destination, size_t destinationSize, const char* source) {
@@ -61,3 +80,264 @@ GvrsStrncpy(char* destination, size_t destinationSize, const char* source) {
 		destination[i] = '\0';
 	return 0;
  }
+
+
+
+// Threading:
+//   The GVRS library uses only a small subset of the threading capabilities
+// of the host platform: mutexes, condition variables, and threads that can be joined.  The
+// wrappers below allow the rest of the library to be written without regard
+// to whether POSIX threads or the Windows API is used.
+
+#if defined(_WIN32) || defined(_WIN64)
+
+struct GvrsMutexTag {
+	CRITICAL_SECTION criticalSection;
+};
+
+struct GvrsConditionTag {
+	CONDITION_VARIABLE conditionVariable;
+};
+
+struct GvrsThreadTag {
+	HANDLE handle;
+	int (*function)(void*);
+	void* argument;
+	int result;
+};
+
+static DWORD WINAPI threadEntry(LPVOID parameter) {
+	GvrsThread* thread = (GvrsThread*)parameter;
+	thread->result = thread->function(thread->argument);
+	return 0;
+}
+
+int GvrsMutexInit(GvrsMutex** mutex) {
+	if (!mutex) {
+		return GVRSERR_NULL_ARGUMENT;
+	}
+	*mutex = calloc(1, sizeof(GvrsMutex));
+	if (!*mutex) {
+		return GVRSERR_NOMEM;
+	}
+	InitializeCriticalSection(&(*mutex)->criticalSection);
+	return 0;
+}
+
+void GvrsMutexLock(GvrsMutex* mutex) {
+	EnterCriticalSection(&mutex->criticalSection);
+}
+
+void GvrsMutexUnlock(GvrsMutex* mutex) {
+	LeaveCriticalSection(&mutex->criticalSection);
+}
+
+GvrsMutex* GvrsMutexFree(GvrsMutex* mutex) {
+	if (mutex) {
+		DeleteCriticalSection(&mutex->criticalSection);
+		free(mutex);
+	}
+	return 0;
+}
+
+int GvrsConditionInit(GvrsCondition** condition) {
+	if (!condition) {
+		return GVRSERR_NULL_ARGUMENT;
+	}
+	*condition = calloc(1, sizeof(GvrsCondition));
+	if (!*condition) {
+		return GVRSERR_NOMEM;
+	}
+	InitializeConditionVariable(&(*condition)->conditionVariable);
+	return 0;
+}
+
+void GvrsConditionWait(GvrsCondition* condition, GvrsMutex* mutex) {
+	SleepConditionVariableCS(&condition->conditionVariable, &mutex->criticalSection, INFINITE);
+}
+
+void GvrsConditionSignal(GvrsCondition* condition) {
+	WakeAllConditionVariable(&condition->conditionVariable);
+}
+
+GvrsCondition* GvrsConditionFree(GvrsCondition* condition) {
+	// Windows condition variables do not need to be deleted
+	free(condition);
+	return 0;
+}
+
+int GvrsThreadStart(GvrsThread** thread, int (*function)(void*), void* argument) {
+	if (!thread || !function) {
+		return GVRSERR_NULL_ARGUMENT;
+	}
+	*thread = 0;
+	GvrsThread* t = calloc(1, sizeof(GvrsThread));
+	if (!t) {
+		return GVRSERR_NOMEM;
+	}
+	t->function = function;
+	t->argument = argument;
+	t->handle = CreateThread(NULL, 0, threadEntry, t, 0, NULL);
+	if (!t->handle) {
+		free(t);
+		return GVRSERR_THREAD_FAILURE;
+	}
+	*thread = t;
+	return 0;
+}
+
+int GvrsThreadJoin(GvrsThread* thread) {
+	if (!thread) {
+		return GVRSERR_NULL_ARGUMENT;
+	}
+	int status = GVRSERR_THREAD_FAILURE;
+	if (WaitForSingleObject(thread->handle, INFINITE) == WAIT_OBJECT_0) {
+		status = thread->result;
+	}
+	CloseHandle(thread->handle);
+	free(thread);
+	return status;
+}
+
+int GvrsGetProcessorCount() {
+	SYSTEM_INFO info;
+	GetSystemInfo(&info);
+	return info.dwNumberOfProcessors > 0 ? (int)info.dwNumberOfProcessors : 1;
+}
+
+#else
+
+struct GvrsMutexTag {
+	pthread_mutex_t mutex;
+};
+
+struct GvrsConditionTag {
+	pthread_cond_t cond;
+};
+
+struct GvrsThreadTag {
+	pthread_t thread;
+	int (*function)(void*);
+	void* argument;
+	int result;
+};
+
+static void* threadEntry(void* parameter) {
+	GvrsThread* thread = (GvrsThread*)parameter;
+	thread->result = thread->function(thread->argument);
+	return 0;
+}
+
+int GvrsMutexInit(GvrsMutex** mutex) {
+	if (!mutex) {
+		return GVRSERR_NULL_ARGUMENT;
+	}
+	*mutex = calloc(1, sizeof(GvrsMutex));
+	if (!*mutex) {
+		return GVRSERR_NOMEM;
+	}
+	if (pthread_mutex_init(&(*mutex)->mutex, NULL)) {
+		free(*mutex);
+		*mutex = 0;
+		return GVRSERR_THREAD_FAILURE;
+	}
+	return 0;
+}
+
+void GvrsMutexLock(GvrsMutex* mutex) {
+	pthread_mutex_lock(&mutex->mutex);
+}
+
+void GvrsMutexUnlock(GvrsMutex* mutex) {
+	pthread_mutex_unlock(&mutex->mutex);
+}
+
+GvrsMutex* GvrsMutexFree(GvrsMutex* mutex) {
+	if (mutex) {
+		pthread_mutex_destroy(&mutex->mutex);
+		free(mutex);
+	}
+	return 0;
+}
+
+int GvrsConditionInit(GvrsCondition** condition) {
+	if (!condition) {
+		return GVRSERR_NULL_ARGUMENT;
+	}
+	*condition = calloc(1, sizeof(GvrsCondition));
+	if (!*condition) {
+		return GVRSERR_NOMEM;
+	}
+	if (pthread_cond_init(&(*condition)->cond, NULL)) {
+		free(*condition);
+		*condition = 0;
+		return GVRSERR_THREAD_FAILURE;
+	}
+	return 0;
+}
+
+void GvrsConditionWait(GvrsCondition* condition, GvrsMutex* mutex) {
+	pthread_cond_wait(&condition->cond, &mutex->mutex);
+}
+
+void GvrsConditionSignal(GvrsCondition* condition) {
+	pthread_cond_broadcast(&condition->cond);
+}
+
+GvrsCondition* GvrsConditionFree(GvrsCondition* condition) {
+	if (condition) {
+		pthread_cond_destroy(&condition->cond);
+		free(condition);
+	}
+	return 0;
+}
+
+int GvrsThreadStart(GvrsThread** thread, int (*function)(void*), void* argument) {
+	if (!thread || !function) {
+		return GVRSERR_NULL_ARGUMENT;
+	}
+	*thread = 0;
+	GvrsThread* t = calloc(1, sizeof(GvrsThread));
+	if (!t) {
+		return GVRSERR_NOMEM;
+	}
+	t->function = function;
+	t->argument = argument;
+	if (pthread_create(&t->thread, NULL, threadEntry, t)) {
+		free(t);
+		return GVRSERR_THREAD_FAILURE;
+	}
+	*thread = t;
+	return 0;
+}
+
+int GvrsThreadJoin(GvrsThread* thread) {
+	if (!thread) {
+		return GVRSERR_NULL_ARGUMENT;
+	}
+	int status = GVRSERR_THREAD_FAILURE;
+	if (pthread_join(thread->thread, NULL) == 0) {
+		status = thread->result;
+	}
+	free(thread);
+	return status;
+}
+
+int GvrsGetProcessorCount() {
+	long n = sysconf(_SC_NPROCESSORS_ONLN);
+	return n > 0 ? (int)n : 1;
+}
+
+#endif
+
+void GvrsAdviseWillNeed(FILE* fp, int64_t offset, int64_t length) {
+#if !(defined(_WIN32) || defined(_WIN64)) && defined(POSIX_FADV_WILLNEED)
+	if (fp && offset >= 0 && length > 0) {
+		posix_fadvise(fileno(fp), (off_t)offset, (off_t)length, POSIX_FADV_WILLNEED);
+	}
+#else
+	(void)fp;
+	(void)offset;
+	(void)length;
+#endif
+}
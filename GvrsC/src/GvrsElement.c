@@ -52,8 +52,38 @@
 #include "GvrsPrimaryIo.h"
 #include "Gvrs.h"
 #include "GvrsInternal.h"
+#include "GvrsSimd.h"
 #include "GvrsError.h"
 #include <math.h>
+
+// Converts a floating-point value to an integer for storage.  A conversion
+// of a NaN or of a value outside the range of the integer type is undefined
+// in C, so NaN is mapped to the fill value and other values are clamped.
+static int32_t floatToInt32(float value, int32_t fillValue) {
+	if (isnan(value)) {
+		return fillValue;
+	}
+	if (value <= -2147483648.0f) {
+		return INT32_MIN;
+	}
+	if (value >= 2147483648.0f) {
+		return INT32_MAX;
+	}
+	return (int32_t)value;
+}
+
+static int16_t floatToInt16(float value, int16_t fillValue) {
+	if (isnan(value)) {
+		return fillValue;
+	}
+	if (value <= -32768.0f) {
+		return INT16_MIN;
+	}
+	if (value >= 32767.0f) {
+		return INT16_MAX;
+	}
+	return (int16_t)value;
+}
  
 
  
@@ -77,7 +107,7 @@ int GvrsElementReadInt(GvrsElement* element, int gridRow, int gridColumn, int32_
 	int tileIndex = tileRow * nColsOfTiles + tileCol;
 	int rowInTile = gridRow - tileRow * nRowsInTile;
 	int colInTile = gridColumn - tileCol * nColsInTile;
-	int indexInTile = rowInTile * nColsInTile + colInTile;
+	int indexInTile = GVRS_CELL_INDEX(tc, rowInTile, colInTile);
 
 	int errCode;
 	GvrsTile* tile;
@@ -138,7 +168,7 @@ int  GvrsElementReadFloat(GvrsElement* element, int gridRow, int gridColumn, flo
 	int tileIndex = tileRow * nColsOfTiles + tileCol;
 	int rowInTile = gridRow - tileRow * nRowsInTile;
 	int colInTile = gridColumn - tileCol * nColsInTile;
-	int indexInTile = rowInTile * nColsInTile + colInTile;
+	int indexInTile = GVRS_CELL_INDEX(tc, rowInTile, colInTile);
 
 	int errCode;
 	GvrsTile* tile;
@@ -172,7 +202,7 @@ int  GvrsElementReadFloat(GvrsElement* element, int gridRow, int gridColumn, flo
 			*value = s.fillValue;
 		}
 		else {
-			*value = i / s.scale + s.offset;
+			*value = (float)i * element->icfInverseScale + s.offset;
 		}
 	}
 	return 0;
@@ -216,40 +246,25 @@ int GvrsElementIsIntegral(GvrsElement * element) {
 void
 GvrsElementFillData(GvrsElement* element, uint8_t* data, int nCells) {
 	//uint8_t* data = tile->data + element->dataOffset;
-	int i;
+	const GvrsSimdKernels* simd = GvrsSimdGetKernels();
 	switch (element->elementType) {
-	case GvrsElementTypeInt: {
-		int iFillValue = element->elementSpec.intSpec.fillValue;
-		int* iData = (int*)data;
-		for (i = 0; i < nCells; i++) {
-			iData[i] = iFillValue;
-		}
+	case GvrsElementTypeInt:
+		simd->fillInt32((int32_t*)data, nCells, element->elementSpec.intSpec.fillValue);
 		return;
-	}
-	case GvrsElementTypeIntCodedFloat: {
-		int iFillValue = element->elementSpec.intFloatSpec.iFillValue;
-		int* iData = (int*)data;
-		for (i = 0; i < nCells; i++) {
-			iData[i] = iFillValue;
-		}
+	case GvrsElementTypeIntCodedFloat:
+		simd->fillInt32((int32_t*)data, nCells, element->elementSpec.intFloatSpec.iFillValue);
 		return;
-	}
 	case GvrsElementTypeFloat: {
+		// fill using the bit pattern of the value (which may be a NaN)
 		float fFillValue = element->elementSpec.floatSpec.fillValue;
-		float* fData = (float*)data;
-		for (i = 0; i < nCells; i++) {
-			fData[i] = fFillValue;
-		}
+		int32_t iFillBits;
+		memcpy(&iFillBits, &fFillValue, sizeof(iFillBits));
+		simd->fillInt32((int32_t*)data, nCells, iFillBits);
 		return;
 	}
-	case GvrsElementTypeShort: {
-		short sFillValue = element->elementSpec.shortSpec.fillValue;
-		short* sData = (short*)data;
-		for (i = 0; i < nCells; i++) {
-			sData[i] = sFillValue;
-		}
+	case GvrsElementTypeShort:
+		simd->fillInt16((int16_t*)data, nCells, element->elementSpec.shortSpec.fillValue);
 		return;
-	}
 	default:
 		return; // we should never get here!
 	}
@@ -287,7 +302,7 @@ int GvrsElementWriteInt(GvrsElement* element, int gridRow, int gridColumn, int32
 	int tileIndex = tileRow * nColsOfTiles + tileCol;
 	int rowInTile = gridRow - tileRow * nRowsInTile;
 	int colInTile = gridColumn - tileCol * nColsInTile;
-	int indexInTile = rowInTile * nColsInTile + colInTile;
+	int indexInTile = GVRS_CELL_INDEX(tc, rowInTile, colInTile);
 
 	int errCode;
 	GvrsTile* tile;
@@ -369,7 +384,7 @@ int GvrsElementWriteFloat(GvrsElement* element, int gridRow, int gridColumn, flo
 	int tileIndex = tileRow * nColsOfTiles + tileCol;
 	int rowInTile = gridRow - tileRow * nRowsInTile;
 	int colInTile = gridColumn - tileCol * nColsInTile;
-	int indexInTile = rowInTile * nColsInTile + colInTile;
+	int indexInTile = GVRS_CELL_INDEX(tc, rowInTile, colInTile);
 
 	int errCode;
 	GvrsTile* tile;
@@ -400,17 +415,25 @@ int GvrsElementWriteFloat(GvrsElement* element, int gridRow, int gridColumn, flo
 	uint8_t* data = tile->data + element->dataOffset;
 	switch (element->elementType) {
 	case GvrsElementTypeInt:
-		((int*)data)[indexInTile] = (int)value;
+		((int*)data)[indexInTile] = floatToInt32(value, element->elementSpec.intSpec.fillValue);
 		return 0;
 	case GvrsElementTypeIntCodedFloat:
 	{
 		int i;
 		GvrsElementSpecIntCodedFloat s = element->elementSpec.intFloatSpec;
-		if (isnan(value) && isnan(s.fillValue)) {
+		if (isnan(value) || value == s.fillValue) {
 			i = s.iFillValue;
 		}
 		else {
-			i = (int)(value * s.scale - s.offset);
+			// the same computation as the floatToIcf kernels, see GvrsSimd.h
+			float t = floorf((value - s.offset) * s.scale + 0.5f);
+			if (t < GVRS_SIMD_ICF_MIN) {
+				t = GVRS_SIMD_ICF_MIN;
+			}
+			else if (t > GVRS_SIMD_ICF_MAX) {
+				t = GVRS_SIMD_ICF_MAX;
+			}
+			i = (int)t;
 		}
 		((int*)data)[indexInTile] = i;
 		return 0;
@@ -419,13 +442,281 @@ int GvrsElementWriteFloat(GvrsElement* element, int gridRow, int gridColumn, flo
 		((float*)data)[indexInTile] = value;
 		return 0;
 	case GvrsElementTypeShort:
-		((short*)data)[indexInTile] = (short)value;
+		((short*)data)[indexInTile] = floatToInt16(value, element->elementSpec.shortSpec.fillValue);
 		return 0;
 	default:
 		return GVRSERR_FILE_ERROR;
 	}
 }
 
+
+// Checks the arguments for the block read and write functions.
+static int checkBlock(GvrsElement* element, int row0, int col0, int nRows, int nCols, const void* values) {
+	if (!element || !values) {
+		return GVRSERR_NULL_ARGUMENT;
+	}
+	if (nRows < 1 || nCols < 1) {
+		return GVRSERR_INVALID_PARAMETER;
+	}
+	GvrsTileCache* tc = (GvrsTileCache*)element->tileCache;
+	if (row0 < 0 || col0 < 0
+		|| (unsigned int)row0 + (unsigned int)nRows > tc->nRowsInRaster
+		|| (unsigned int)col0 + (unsigned int)nCols > tc->nColsInRaster) {
+		return GVRSERR_COORDINATE_OUT_OF_BOUNDS;
+	}
+	return 0;
+}
+
+// Gets a pointer to the data for the cells in a row segment within a tile.
+// For the row-major layout, the pointer is into the tile data.  For other
+// layouts, the values are gathered into the buffer.
+static uint8_t* getRowSegment(GvrsTileCache* tc, uint8_t* data, int typeSize,
+	int rowInTile, int colInTile, int n, uint8_t* buffer) {
+	int col;
+	if (!tc->cellRowIndex) {
+		return data + (size_t)(rowInTile * tc->nColsInTile + colInTile) * typeSize;
+	}
+	const int32_t* colIndex = tc->cellColIndex + colInTile;
+	int32_t rowIndex = tc->cellRowIndex[rowInTile];
+	if (typeSize == 2) {
+		for (col = 0; col < n; col++) {
+			((int16_t*)buffer)[col] = ((int16_t*)data)[rowIndex + colIndex[col]];
+		}
+	}
+	else {
+		for (col = 0; col < n; col++) {
+			((int32_t*)buffer)[col] = ((int32_t*)data)[rowIndex + colIndex[col]];
+		}
+	}
+	return buffer;
+}
+
+// Stores the values for a row segment from the buffer into the tile data
+// (no action is needed for the row-major layout).
+static void putRowSegment(GvrsTileCache* tc, uint8_t* data, int typeSize,
+	int rowInTile, int colInTile, int n, const uint8_t* buffer) {
+	int col;
+	if (!tc->cellRowIndex) {
+		return;
+	}
+	const int32_t* colIndex = tc->cellColIndex + colInTile;
+	int32_t rowIndex = tc->cellRowIndex[rowInTile];
+	if (typeSize == 2) {
+		for (col = 0; col < n; col++) {
+			((int16_t*)data)[rowIndex + colIndex[col]] = ((const int16_t*)buffer)[col];
+		}
+	}
+	else {
+		for (col = 0; col < n; col++) {
+			((int32_t*)data)[rowIndex + colIndex[col]] = ((const int32_t*)buffer)[col];
+		}
+	}
+}
+
+int GvrsElementReadBlockFloat(GvrsElement* element, int row0, int col0, int nRows, int nCols, float* values) {
+	int status = checkBlock(element, row0, col0, nRows, nCols, values);
+	if (status) {
+		return status;
+	}
+
+	GvrsTileCache* tc = (GvrsTileCache*)element->tileCache;
+	const GvrsSimdKernels* simd = GvrsSimdGetKernels();
+	GvrsElementSpecIntCodedFloat s = element->elementSpec.intFloatSpec;
+	int nRowsInTile = tc->nRowsInTile;
+	int nColsInTile = tc->nColsInTile;
+	int row1 = row0 + nRows;
+	int col1 = col0 + nCols;
+	tc->nRasterReads += (int64_t)nRows * nCols;
+	uint8_t* buffer = 0;
+	if (tc->cellRowIndex) {
+		buffer = malloc((size_t)nColsInTile * sizeof(int32_t));
+		if (!buffer) {
+			return GVRSERR_NOMEM;
+		}
+	}
+
+	// process the block one tile at a time so that each tile is fetched only once
+	// and each row segment within a tile is converted with a single kernel call.
+	int tileRow, tileCol, row, col;
+	for (tileRow = row0 / nRowsInTile; tileRow <= (row1 - 1) / nRowsInTile; tileRow++) {
+		int r0 = tileRow * nRowsInTile;
+		int r1 = r0 + nRowsInTile;
+		int tileRowStart = r0;
+		if (r0 < row0) {
+			r0 = row0;
+		}
+		if (r1 > row1) {
+			r1 = row1;
+		}
+		for (tileCol = col0 / nColsInTile; tileCol <= (col1 - 1) / nColsInTile; tileCol++) {
+			int c0 = tileCol * nColsInTile;
+			int c1 = c0 + nColsInTile;
+			int tileColStart = c0;
+			if (c0 < col0) {
+				c0 = col0;
+			}
+			if (c1 > col1) {
+				c1 = col1;
+			}
+			int n = c1 - c0;
+			int tileIndex = tileRow * tc->nColsOfTiles + tileCol;
+			int errCode = 0;
+			GvrsTile* tile;
+			if (tc->firstTileIndex == tileIndex) {
+				tile = tc->firstTile;
+			}
+			else {
+				tile = GvrsTileCacheFetchTile(tc, tileIndex, &errCode);
+				if (errCode) {
+					free(buffer);
+					return errCode;
+				}
+			}
+			for (row = r0; row < r1; row++) {
+				float* v = values + (int64_t)(row - row0) * nCols + (c0 - col0);
+				if (!tile) {
+					// the tile is not populated
+					for (col = 0; col < n; col++) {
+						v[col] = element->fillValueFloat;
+					}
+					continue;
+				}
+				uint8_t* data = getRowSegment(tc, tile->data + element->dataOffset, element->typeSize,
+					row - tileRowStart, c0 - tileColStart, n, buffer);
+				switch (element->elementType) {
+				case GvrsElementTypeInt:
+					for (col = 0; col < n; col++) {
+						v[col] = (float)(((int32_t*)data)[col]);
+					}
+					break;
+				case GvrsElementTypeIntCodedFloat:
+					simd->icfToFloat(n, (int32_t*)data, element->icfInverseScale, s.offset, s.iFillValue, s.fillValue, v);
+					break;
+				case GvrsElementTypeFloat:
+					memcpy(v, data, (size_t)n * sizeof(float));
+					break;
+				case GvrsElementTypeShort:
+					for (col = 0; col < n; col++) {
+						v[col] = (float)(((int16_t*)data)[col]);
+					}
+					break;
+				default:
+					free(buffer);
+					return GVRSERR_FILE_ERROR;
+				}
+			}
+		}
+	}
+	free(buffer);
+	return 0;
+}
+
+
+int GvrsElementWriteBlockFloat(GvrsElement* element, int row0, int col0, int nRows, int nCols, const float* values) {
+	int status = checkBlock(element, row0, col0, nRows, nCols, values);
+	if (status) {
+		return status;
+	}
+	Gvrs* gvrs = element->gvrs;
+	if (!gvrs) {
+		return GVRSERR_NULL_ARGUMENT;
+	}
+	if (!gvrs->timeOpenedForWritingMS) {
+		return GVRSERR_NOT_OPENED_FOR_WRITING;
+	}
+
+	GvrsTileCache* tc = (GvrsTileCache*)element->tileCache;
+	const GvrsSimdKernels* simd = GvrsSimdGetKernels();
+	GvrsElementSpecIntCodedFloat s = element->elementSpec.intFloatSpec;
+	int nRowsInTile = tc->nRowsInTile;
+	int nColsInTile = tc->nColsInTile;
+	int row1 = row0 + nRows;
+	int col1 = col0 + nCols;
+	tc->nRasterWrites += (int64_t)nRows * nCols;
+	uint8_t* buffer = 0;
+	if (tc->cellRowIndex) {
+		buffer = malloc((size_t)nColsInTile * sizeof(int32_t));
+		if (!buffer) {
+			return GVRSERR_NOMEM;
+		}
+	}
+
+	int tileRow, tileCol, row, col;
+	for (tileRow = row0 / nRowsInTile; tileRow <= (row1 - 1) / nRowsInTile; tileRow++) {
+		int r0 = tileRow * nRowsInTile;
+		int r1 = r0 + nRowsInTile;
+		int tileRowStart = r0;
+		if (r0 < row0) {
+			r0 = row0;
+		}
+		if (r1 > row1) {
+			r1 = row1;
+		}
+		for (tileCol = col0 / nColsInTile; tileCol <= (col1 - 1) / nColsInTile; tileCol++) {
+			int c0 = tileCol * nColsInTile;
+			int c1 = c0 + nColsInTile;
+			int tileColStart = c0;
+			if (c0 < col0) {
+				c0 = col0;
+			}
+			if (c1 > col1) {
+				c1 = col1;
+			}
+			int n = c1 - c0;
+			int tileIndex = tileRow * tc->nColsOfTiles + tileCol;
+			int errCode = 0;
+			GvrsTile* tile;
+			if (tc->firstTileIndex == tileIndex) {
+				tile = tc->firstTile;
+			}
+			else {
+				tile = GvrsTileCacheFetchTile(tc, tileIndex, &errCode);
+				if (!tile) {
+					if (!errCode) {
+						tile = GvrsTileCacheStartNewTile(tc, tileIndex, &errCode);
+					}
+					if (errCode) {
+						free(buffer);
+						return errCode;
+					}
+				}
+			}
+			tile->writePending = 1;
+			uint8_t* tileData = tile->data + element->dataOffset;
+			for (row = r0; row < r1; row++) {
+				const float* v = values + (int64_t)(row - row0) * nCols + (c0 - col0);
+				// for layouts other than row-major, the values are assembled in the buffer and then stored
+				uint8_t* data = buffer ? buffer
+					: tileData + (size_t)((row - tileRowStart) * nColsInTile + (c0 - tileColStart)) * element->typeSize;
+				switch (element->elementType) {
+				case GvrsElementTypeInt:
+					for (col = 0; col < n; col++) {
+						((int32_t*)data)[col] = floatToInt32(v[col], element->elementSpec.intSpec.fillValue);
+					}
+					break;
+				case GvrsElementTypeIntCodedFloat:
+					simd->floatToIcf(n, v, s.scale, s.offset, s.iFillValue, s.fillValue, (int32_t*)data);
+					break;
+				case GvrsElementTypeFloat:
+					memcpy(data, v, (size_t)n * sizeof(float));
+					break;
+				case GvrsElementTypeShort:
+					for (col = 0; col < n; col++) {
+						((int16_t*)data)[col] = floatToInt16(v[col], element->elementSpec.shortSpec.fillValue);
+					}
+					break;
+				default:
+					free(buffer);
+					return GVRSERR_FILE_ERROR;
+				}
+				putRowSegment(tc, tileData, element->typeSize, row - tileRowStart, c0 - tileColStart, n, buffer);
+			}
+		}
+	}
+	free(buffer);
+	return 0;
+}
+
  
 
 
@@ -461,7 +752,7 @@ int GvrsElementCount(GvrsElement* element, int gridRow, int gridColumn, int32_t*
 	int tileIndex = tileRow * nColsOfTiles + tileCol;
 	int rowInTile = gridRow - tileRow * nRowsInTile;
 	int colInTile = gridColumn - tileCol * nColsInTile;
-	int indexInTile = rowInTile * nColsInTile + colInTile;
+	int indexInTile = GVRS_CELL_INDEX(tc, rowInTile, colInTile);
 
 	int tileIsNew = 0;
 	int errCode;
@@ -0,0 +1,201 @@
+/* --------------------------------------------------------------------
+ *
+ * The MIT License
+ *
+ * Copyright (C) 2024  Gary W. Lucas.
+
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ * ---------------------------------------------------------------------
+ */
+
+// Development Note:
+//    The instrumented code tests the eventHooks pointer before calling
+// GvrsEventReport, so the mask and clock are consulted only when an application
+// has registered a callback.
+//    The Chrome trace adapter is an ordinary client of the callback API.  Its file
+// is finished by its dispose function, which is invoked when the callback is
+// cleared (GvrsClose clears it).
+
+#include "GvrsFramework.h"
+
+#include "GvrsPrimaryIo.h"
+#include "Gvrs.h"
+#include "GvrsInternal.h"
+#include "GvrsEvents.h"
+#include "GvrsError.h"
+
+typedef struct GvrsEventHooksTag {
+	unsigned int eventMask;
+	GvrsEventCallback callback;
+	GvrsEventDispose dispose;
+	void* appData;
+}GvrsEventHooks;
+
+static const char* eventNames[] = {
+	"miss", "miss", "decode", "decode", "evict", "write-back", "file-space-alloc", "file-space-dealloc"
+};
+
+const char* GvrsGetEventName(GvrsEventType eventType) {
+	if ((int)eventType < 0 || (int)eventType >= GVRS_EVENT_TYPE_COUNT) {
+		return "unknown";
+	}
+	return eventNames[eventType];
+}
+
+int GvrsSetEventCallback(Gvrs* gvrs, unsigned int eventMask, GvrsEventCallback callback, GvrsEventDispose dispose, void* appData) {
+	if (!gvrs) {
+		return GVRSERR_NULL_ARGUMENT;
+	}
+	GvrsEventHooks* hooks = gvrs->eventHooks;
+	gvrs->eventHooks = 0;
+	if (hooks) {
+		if (hooks->dispose) {
+			hooks->dispose(hooks->appData);
+		}
+		free(hooks);
+	}
+	if (!callback) {
+		return 0;
+	}
+	hooks = calloc(1, sizeof(GvrsEventHooks));
+	if (!hooks) {
+		return GVRSERR_NOMEM;
+	}
+	hooks->eventMask = eventMask;
+	hooks->callback = callback;
+	hooks->dispose = dispose;
+	hooks->appData = appData;
+	gvrs->eventHooks = hooks;
+	return 0;
+}
+
+void GvrsEventReport(Gvrs* gvrs, int eventType, int tileIndex, int elementIndex, int codecIndex,
+	int64_t nBytes, int64_t filePosition, int64_t durationNS, int status) {
+	GvrsEventHooks* hooks = gvrs->eventHooks;
+	if (!(hooks->eventMask & (1u << eventType))) {
+		return;
+	}
+	GvrsEvent event;
+	event.eventType = (GvrsEventType)eventType;
+	event.timeNS = GvrsTimeNS();
+	event.durationNS = durationNS;
+	event.tileIndex = tileIndex;
+	event.elementIndex = elementIndex;
+	event.codecIndex = codecIndex;
+	event.codecName = 0;
+	if (codecIndex >= 0 && codecIndex < gvrs->nDataCompressionCodecs && gvrs->dataCompressionCodecs[codecIndex]) {
+		event.codecName = gvrs->dataCompressionCodecs[codecIndex]->identification;
+	}
+	event.nBytes = nBytes;
+	event.filePosition = filePosition;
+	event.status = status;
+	hooks->callback(gvrs, &event, hooks->appData);
+}
+
+
+
+// Chrome trace adapter ---------------------------------------------------
+
+typedef struct GvrsChromeTraceTag {
+	FILE* fp;
+	int64_t time0;
+	int nEvents;
+}GvrsChromeTrace;
+
+static void writeChromeEvent(Gvrs* gvrs, const GvrsEvent* event, void* appData) {
+	GvrsChromeTrace* trace = appData;
+	FILE* fp = trace->fp;
+	const char* phase;
+	int64_t timeNS = event->timeNS;
+	switch (event->eventType) {
+	case GvrsEventMissStart:
+	case GvrsEventDecodeStart:
+		phase = "B";
+		break;
+	case GvrsEventMissEnd:
+	case GvrsEventDecodeEnd:
+		phase = "E";
+		break;
+	case GvrsEventEvict:
+		phase = "i";
+		break;
+	default:
+		// operations that report a duration when they are complete
+		phase = "X";
+		timeNS -= event->durationNS;
+		break;
+	}
+	fprintf(fp, "%s\n{\"name\":\"%s\",\"cat\":\"gvrs\",\"ph\":\"%s\",\"ts\":%.3f,\"pid\":1,\"tid\":1",
+		trace->nEvents ? "," : "",
+		GvrsGetEventName(event->eventType), phase,
+		(double)(timeNS - trace->time0) / 1000.0);
+	if (phase[0] == 'X') {
+		fprintf(fp, ",\"dur\":%.3f", (double)event->durationNS / 1000.0);
+	}
+	else if (phase[0] == 'i') {
+		fprintf(fp, ",\"s\":\"t\"");
+	}
+	fprintf(fp, ",\"args\":{\"tile\":%d", event->tileIndex);
+	if (event->elementIndex >= 0) {
+		fprintf(fp, ",\"element\":\"%s\"", gvrs->elements[event->elementIndex]->name);
+	}
+	if (event->codecName) {
+		fprintf(fp, ",\"codec\":\"%s\"", event->codecName);
+	}
+	if (event->nBytes >= 0) {
+		fprintf(fp, ",\"bytes\":%lld", (long long)event->nBytes);
+	}
+	if (event->filePosition >= 0) {
+		fprintf(fp, ",\"filePos\":%lld", (long long)event->filePosition);
+	}
+	if (event->status) {
+		fprintf(fp, ",\"status\":%d", event->status);
+	}
+	fprintf(fp, "}}");
+	trace->nEvents++;
+}
+
+static void finishChromeTrace(void* appData) {
+	GvrsChromeTrace* trace = appData;
+	fprintf(trace->fp, "\n]\n");
+	fclose(trace->fp);
+	free(trace);
+}
+
+int GvrsStartChromeTrace(Gvrs* gvrs, const char* path) {
+	if (!gvrs || !path) {
+		return GVRSERR_NULL_ARGUMENT;
+	}
+	GvrsChromeTrace* trace = calloc(1, sizeof(GvrsChromeTrace));
+	if (!trace) {
+		return GVRSERR_NOMEM;
+	}
+	trace->fp = fopen(path, "w");
+	if (!trace->fp) {
+		free(trace);
+		return GVRSERR_FILE_ACCESS;
+	}
+	trace->time0 = GvrsTimeNS();
+	fprintf(trace->fp, "[");
+	int status = GvrsSetEventCallback(gvrs, GVRS_EVENT_MASK_ALL, writeChromeEvent, finishChromeTrace, trace);
+	if (status) {
+		finishChromeTrace(trace);
+	}
+	return status;
+}
@@ -67,6 +67,10 @@ static int multipleOf8(int value) {
 	return (value + 7) & 0x7ffffff8;
 }
 
+int32_t GvrsFileSpaceRecordSize(int sizeOfContent) {
+	return multipleOf8(sizeOfContent + RECORD_OVERHEAD_SIZE);
+}
+
 
 int
 GvrsFileSpaceAlloc(GvrsFileSpaceManager* manager, GvrsRecordType recordType, int sizeOfContent, int64_t* filePos) {
@@ -498,7 +502,8 @@ int GvrsFileSpaceDirectoryWrite(Gvrs* gvrs, int64_t* filePosition) {
 
 int
 GvrsFileSpaceDirectoryRead(Gvrs* gvrs, int64_t fileSpaceDirectoryPosition, GvrsFileSpaceManager** managerRef) {
-	if (!gvrs || !managerRef || fileSpaceDirectoryPosition <= 0) {
+	// a file position of zero indicates that the file has no free space
+	if (!gvrs || !managerRef || fileSpaceDirectoryPosition < 0) {
 		return GVRSERR_NULL_ARGUMENT;
 	}
 	*managerRef = 0;
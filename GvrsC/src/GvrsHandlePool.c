@@ -0,0 +1,470 @@
+/* --------------------------------------------------------------------
+ *
+ * The MIT License
+ *
+ * Copyright (C) 2024  Gary W. Lucas.
+
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ * ---------------------------------------------------------------------
+ */
+
+// Development Note:
+//    Each open handle is represented by an entry.  The entries are stored
+// in a hash table keyed by path and are also linked into a doubly-linked
+// list in order of use.  The head of the list is the most recently used entry
+// and the tail is the least recently used. When the pool needs to close a handle,
+// it searches from the tail for an entry that is not in use.
+//    A path may have more than one entry when the same file is acquired
+// concurrently by more than one caller.
+//    The check for file modification uses the file-system status (stat) as
+// a fast test. The header is read only when the status changes, so a
+// file that is touched but not rewritten does not force a reopen.
+//    The pool mutex is not held while a file is checked or opened, so callers
+// acquiring other files are not delayed by the file-system operations.
+// Instead, an existing entry is reserved by marking it as in use, and a new
+// entry is reserved by counting it as an open handle before it is opened.
+// The mutex is then re-acquired to publish the new entry or to roll back
+// the reservation.
+
+#include "GvrsFramework.h"
+
+#include "GvrsPrimaryIo.h"
+#include "Gvrs.h"
+#include "GvrsInternal.h"
+#include "GvrsCrossPlatform.h"
+#include "GvrsHandlePool.h"
+#include "GvrsError.h"
+
+#include <sys/stat.h>
+
+typedef struct GvrsPoolEntryTag {
+	char* path;
+	uint32_t hash;
+	Gvrs* gvrs;
+	int inUse;
+	int64_t lastUsedMS;
+	int64_t validatedMS;
+	int64_t tileCacheBytes;
+
+	// file-system status when the handle was opened (or last validated)
+	int64_t statTime;
+	int64_t statSize;
+	int64_t statInode;
+
+	struct GvrsPoolEntryTag* hashNext;
+	struct GvrsPoolEntryTag* prior;
+	struct GvrsPoolEntryTag* next;
+}GvrsPoolEntry;
+
+
+static uint32_t hashPath(const char* path) {
+	// FNV-1a
+	uint32_t h = 2166136261u;
+	const unsigned char* p = (const unsigned char*)path;
+	while (*p) {
+		h ^= *p++;
+		h *= 16777619u;
+	}
+	return h;
+}
+
+static int readFileStatus(const char* path, int64_t* statTime, int64_t* statSize, int64_t* statInode) {
+#if defined(_WIN32) || defined(_WIN64)
+	struct _stat64 s;
+	if (_stat64(path, &s)) {
+		return GVRSERR_FILENOTFOUND;
+	}
+	*statTime = (int64_t)s.st_mtime;
+	*statInode = 0;
+#else
+	struct stat s;
+	if (stat(path, &s)) {
+		return GVRSERR_FILENOTFOUND;
+	}
+#if defined(__linux__)
+	*statTime = (int64_t)s.st_mtim.tv_sec * 1000000000LL + (int64_t)s.st_mtim.tv_nsec;
+#else
+	*statTime = (int64_t)s.st_mtime;
+#endif
+	*statInode = (int64_t)s.st_ino;
+#endif
+	*statSize = (int64_t)s.st_size;
+	return 0;
+}
+
+// Compare the identification values in the header of the file to those of the handle.
+// Returns 1 if they match; 0 if the file was changed or is opened for writing.
+static int headerMatches(GvrsPoolEntry* entry) {
+	Gvrs* gvrs = entry->gvrs;
+	FILE* fp = fopen(entry->path, "rb");
+	if (!fp) {
+		return 0;
+	}
+	int64_t uuidLow = 0, uuidHigh = 0, modTimeMS = 0, timeOpenedForWritingMS = 0;
+	// the UUID occupies the 16 bytes that precede the modification time
+	int status = GvrsSetFilePosition(fp, FILEPOS_MODIFICATION_TIME - 16);
+	if (!status) {
+		GvrsReadLong(fp, &uuidLow);
+		GvrsReadLong(fp, &uuidHigh);
+		GvrsReadLong(fp, &modTimeMS);
+		status = GvrsReadLong(fp, &timeOpenedForWritingMS);
+	}
+	fclose(fp);
+	return !status
+		&& uuidLow == gvrs->uuidLow
+		&& uuidHigh == gvrs->uuidHigh
+		&& modTimeMS == gvrs->modTimeMS
+		&& timeOpenedForWritingMS == 0;
+}
+
+// Called without holding the pool mutex.  The entry is reserved by the caller.
+static int isCurrent(GvrsPoolEntry* entry, int64_t validationIntervalMS, int64_t timeMS) {
+	if (validationIntervalMS > 0 && timeMS - entry->validatedMS < validationIntervalMS) {
+		return 1;
+	}
+	int64_t statTime, statSize, statInode;
+	if (readFileStatus(entry->path, &statTime, &statSize, &statInode)) {
+		return 0;
+	}
+	if (statTime != entry->statTime || statSize != entry->statSize || statInode != entry->statInode) {
+		if (!headerMatches(entry)) {
+			return 0;
+		}
+		entry->statTime = statTime;
+		entry->statSize = statSize;
+		entry->statInode = statInode;
+	}
+	entry->validatedMS = timeMS;
+	return 1;
+}
+
+static int64_t computeTileCacheBytes(Gvrs* gvrs) {
+	GvrsTileCache* tc = (GvrsTileCache*)gvrs->tileCache;
+	if (!tc) {
+		return 0;
+	}
+	return (int64_t)tc->maxTileCacheSize * (int64_t)gvrs->nBytesForTileData;
+}
+
+static void unlinkFromList(GvrsHandlePool* pool, GvrsPoolEntry* entry) {
+	if (entry->prior) {
+		entry->prior->next = entry->next;
+	}
+	else {
+		pool->head = entry->next;
+	}
+	if (entry->next) {
+		entry->next->prior = entry->prior;
+	}
+	else {
+		pool->tail = entry->prior;
+	}
+	entry->prior = 0;
+	entry->next = 0;
+}
+
+static void linkAtHead(GvrsHandlePool* pool, GvrsPoolEntry* entry) {
+	GvrsPoolEntry* head = (GvrsPoolEntry*)pool->head;
+	entry->prior = 0;
+	entry->next = head;
+	if (head) {
+		head->prior = entry;
+	}
+	else {
+		pool->tail = entry;
+	}
+	pool->head = entry;
+}
+
+// Remove the entry from the pool, close its handle, and free it.
+static void closeEntry(GvrsHandlePool* pool, GvrsPoolEntry* entry) {
+	GvrsPoolEntry** buckets = (GvrsPoolEntry**)pool->buckets;
+	GvrsPoolEntry** p = &buckets[entry->hash & (uint32_t)(pool->nBuckets - 1)];
+	while (*p) {
+		if (*p == entry) {
+			*p = entry->hashNext;
+			break;
+		}
+		p = &(*p)->hashNext;
+	}
+	unlinkFromList(pool, entry);
+	if (entry->inUse) {
+		pool->nHandlesInUse--;
+	}
+	pool->nOpenHandles--;
+	pool->tileCacheBytes -= entry->tileCacheBytes;
+	GvrsClose(entry->gvrs);
+	free(entry->path);
+	free(entry);
+}
+
+// Close the least-recently used idle handle.  Returns 1 if a handle was closed, 0 if all are in use.
+static int evictOne(GvrsHandlePool* pool) {
+	GvrsPoolEntry* entry = (GvrsPoolEntry*)pool->tail;
+	while (entry) {
+		if (!entry->inUse) {
+			closeEntry(pool, entry);
+			pool->nEvictions++;
+			return 1;
+		}
+		entry = entry->prior;
+	}
+	return 0;
+}
+
+static void enforceBudget(GvrsHandlePool* pool) {
+	if (pool->tileCacheBudget > 0) {
+		while (pool->tileCacheBytes > pool->tileCacheBudget && evictOne(pool)) {
+			// no additional action required
+		}
+	}
+}
+
+// Opens the handle for a new entry.  Called without holding the pool mutex.
+// The slot for the handle is reserved by the caller.
+static int openEntry(const char* path, uint32_t hash, GvrsTileCacheSizeType tileCacheSize, GvrsPoolEntry** entryReference) {
+	*entryReference = 0;
+	GvrsPoolEntry* entry = calloc(1, sizeof(GvrsPoolEntry));
+	if (!entry) {
+		return GVRSERR_NOMEM;
+	}
+	entry->path = GVRS_STRDUP(path);
+	if (!entry->path) {
+		free(entry);
+		return GVRSERR_NOMEM;
+	}
+	// the file status is obtained before the file is opened so that a modification
+	// made while the file is being opened is detected on the next acquisition.
+	int status = readFileStatus(path, &entry->statTime, &entry->statSize, &entry->statInode);
+	if (!status) {
+		status = GvrsOpen(&entry->gvrs, path, "r");
+	}
+	if (!status && tileCacheSize != GvrsTileCacheSizeMedium) {
+		status = GvrsSetTileCacheSize(entry->gvrs, tileCacheSize);
+	}
+	if (status) {
+		if (entry->gvrs) {
+			GvrsClose(entry->gvrs);
+		}
+		free(entry->path);
+		free(entry);
+		return status;
+	}
+	entry->hash = hash;
+	entry->tileCacheBytes = computeTileCacheBytes(entry->gvrs);
+	*entryReference = entry;
+	return 0;
+}
+
+// Adds a newly opened entry to the hash table and the list.  The handle
+// was already counted when its slot was reserved.
+static void publishEntry(GvrsHandlePool* pool, GvrsPoolEntry* entry) {
+	pool->nOpens++;
+	GvrsPoolEntry** buckets = (GvrsPoolEntry**)pool->buckets;
+	int iBucket = (int)(entry->hash & (uint32_t)(pool->nBuckets - 1));
+	entry->hashNext = buckets[iBucket];
+	buckets[iBucket] = entry;
+	linkAtHead(pool, entry);
+	pool->tileCacheBytes += entry->tileCacheBytes;
+}
+
+static GvrsPoolEntry* findIdleEntry(GvrsHandlePool* pool, const char* path, uint32_t hash) {
+	GvrsPoolEntry** buckets = (GvrsPoolEntry**)pool->buckets;
+	GvrsPoolEntry* entry = buckets[hash & (uint32_t)(pool->nBuckets - 1)];
+	while (entry) {
+		if (entry->hash == hash && !entry->inUse && strcmp(entry->path, path) == 0) {
+			return entry;
+		}
+		entry = entry->hashNext;
+	}
+	return 0;
+}
+
+
+int GvrsHandlePoolAlloc(int maxOpenHandles, int64_t tileCacheBudget, GvrsHandlePool** poolReference) {
+	if (!poolReference) {
+		return GVRSERR_NULL_ARGUMENT;
+	}
+	*poolReference = 0;
+	if (maxOpenHandles < 1 || tileCacheBudget < 0) {
+		return GVRSERR_INVALID_PARAMETER;
+	}
+	GvrsHandlePool* pool = calloc(1, sizeof(GvrsHandlePool));
+	if (!pool) {
+		return GVRSERR_NOMEM;
+	}
+	pool->maxOpenHandles = maxOpenHandles;
+	pool->tileCacheBudget = tileCacheBudget;
+	pool->tileCacheSize = GvrsTileCacheSizeSmall;
+
+	// the number of buckets is a power of two at least twice the number of handles
+	int nBuckets = 64;
+	while (nBuckets < 2 * maxOpenHandles && nBuckets < (1 << 24)) {
+		nBuckets *= 2;
+	}
+	pool->nBuckets = nBuckets;
+	pool->buckets = calloc((size_t)nBuckets, sizeof(GvrsPoolEntry*));
+	if (!pool->buckets) {
+		free(pool);
+		return GVRSERR_NOMEM;
+	}
+	GvrsMutex* mutex;
+	int status = GvrsMutexInit(&mutex);
+	if (status) {
+		free(pool->buckets);
+		free(pool);
+		return status;
+	}
+	pool->mutex = mutex;
+	*poolReference = pool;
+	return 0;
+}
+
+
+int GvrsHandlePoolAcquire(GvrsHandlePool* pool, const char* path, Gvrs** gvrsReference) {
+	if (!pool || !path || !gvrsReference) {
+		return GVRSERR_NULL_ARGUMENT;
+	}
+	*gvrsReference = 0;
+	uint32_t hash = hashPath(path);
+	int64_t timeMS = GvrsTimeMS();
+
+	GvrsMutexLock(pool->mutex);
+	pool->nAcquisitions++;
+	GvrsPoolEntry* found = 0;
+	GvrsPoolEntry* entry;
+	while ((entry = findIdleEntry(pool, path, hash)) != 0) {
+		// reserve the entry while its file is checked
+		entry->inUse = 1;
+		pool->nHandlesInUse++;
+		int64_t validationIntervalMS = pool->validationIntervalMS;
+		GvrsMutexUnlock(pool->mutex);
+		int current = isCurrent(entry, validationIntervalMS, timeMS);
+		GvrsMutexLock(pool->mutex);
+		if (current) {
+			found = entry;
+			pool->nReuses++;
+			break;
+		}
+		// the file was modified, so the handle cannot be used.
+		closeEntry(pool, entry);
+		pool->nStaleHandles++;
+	}
+
+	if (!found) {
+		if (pool->nOpenHandles >= pool->maxOpenHandles && !evictOne(pool)) {
+			GvrsMutexUnlock(pool->mutex);
+			return GVRSERR_HANDLE_LIMIT;
+		}
+		// reserve the slot for the new handle
+		pool->nOpenHandles++;
+		pool->nHandlesInUse++;
+		GvrsTileCacheSizeType tileCacheSize = pool->tileCacheSize;
+		GvrsMutexUnlock(pool->mutex);
+		int status = openEntry(path, hash, tileCacheSize, &found);
+		GvrsMutexLock(pool->mutex);
+		if (status) {
+			pool->nOpenHandles--;
+			pool->nHandlesInUse--;
+			GvrsMutexUnlock(pool->mutex);
+			return status;
+		}
+		found->inUse = 1;
+		publishEntry(pool, found);
+	}
+
+	found->lastUsedMS = timeMS;
+	if (!found->validatedMS) {
+		found->validatedMS = timeMS;
+	}
+	unlinkFromList(pool, found);
+	linkAtHead(pool, found);
+	enforceBudget(pool);
+	*gvrsReference = found->gvrs;
+	GvrsMutexUnlock(pool->mutex);
+	return 0;
+}
+
+
+int GvrsHandlePoolRelease(GvrsHandlePool* pool, Gvrs* gvrs) {
+	if (!pool || !gvrs) {
+		return GVRSERR_NULL_ARGUMENT;
+	}
+	uint32_t hash = hashPath(gvrs->path);
+	GvrsMutexLock(pool->mutex);
+	GvrsPoolEntry** buckets = (GvrsPoolEntry**)pool->buckets;
+	GvrsPoolEntry* entry = buckets[hash & (uint32_t)(pool->nBuckets - 1)];
+	while (entry && entry->gvrs != gvrs) {
+		entry = entry->hashNext;
+	}
+	if (!entry || !entry->inUse) {
+		GvrsMutexUnlock(pool->mutex);
+		return GVRSERR_INVALID_PARAMETER;
+	}
+	entry->inUse = 0;
+	entry->lastUsedMS = GvrsTimeMS();
+	pool->nHandlesInUse--;
+
+	// the application may have changed the tile-cache size while it held the handle
+	int64_t tileCacheBytes = computeTileCacheBytes(gvrs);
+	pool->tileCacheBytes += tileCacheBytes - entry->tileCacheBytes;
+	entry->tileCacheBytes = tileCacheBytes;
+
+	unlinkFromList(pool, entry);
+	linkAtHead(pool, entry);
+	enforceBudget(pool);
+	GvrsMutexUnlock(pool->mutex);
+	return 0;
+}
+
+
+int GvrsHandlePoolCloseIdle(GvrsHandlePool* pool, int64_t idleTimeMS) {
+	if (!pool) {
+		return GVRSERR_NULL_ARGUMENT;
+	}
+	int nClosed = 0;
+	int64_t timeMS = GvrsTimeMS();
+	GvrsMutexLock(pool->mutex);
+	GvrsPoolEntry* entry = (GvrsPoolEntry*)pool->tail;
+	while (entry) {
+		GvrsPoolEntry* prior = entry->prior;
+		if (!entry->inUse && timeMS - entry->lastUsedMS >= idleTimeMS) {
+			closeEntry(pool, entry);
+			pool->nEvictions++;
+			nClosed++;
+		}
+		entry = prior;
+	}
+	GvrsMutexUnlock(pool->mutex);
+	return nClosed;
+}
+
+
+GvrsHandlePool* GvrsHandlePoolFree(GvrsHandlePool* pool) {
+	if (pool) {
+		while (pool->head) {
+			closeEntry(pool, (GvrsPoolEntry*)pool->head);
+		}
+		free(pool->buckets);
+		pool->buckets = 0;
+		pool->mutex = GvrsMutexFree(pool->mutex);
+		free(pool);
+	}
+	return 0;
+}
@@ -263,6 +263,10 @@ int  GvrsReadMetadataByNameAndID(Gvrs* gvrs, const char* name, int recordID, Gvr
 	if (!gvrs || !gvrs->fp) {
 		return GVRSERR_NULL_ARGUMENT;
 	}
+	int status = GvrsLoadMetadataDirectory(gvrs);
+	if (status) {
+		return status;
+	}
 	GvrsMetadataResultSet *rs = calloc(1, sizeof(GvrsMetadataResultSet));
 	if (rs) {
 		*resultSet = rs;
@@ -288,7 +292,7 @@ int  GvrsReadMetadataByNameAndID(Gvrs* gvrs, const char* name, int recordID, Gvr
 	for (i = 0; i < dir->nMetadataReferences; i++) {
 		GvrsMetadataReference r = dir->references[i];
 		if ((*name == '*' || strcmp(name, r.name) == 0) && recordID == r.recordID) {
-			int status = GvrsSetFilePosition(fp, r.filePos);
+			status = GvrsSetFilePosition(fp, r.filePos);
 			if (status) {
 				// non-zero status indicates an error
 				GvrsMetadataResultSetFree(rs);
@@ -316,6 +320,10 @@ int  GvrsReadMetadataByName(Gvrs* gvrs, const char* name, GvrsMetadataResultSet*
 	if (!gvrs || !gvrs->fp) {
 		return GVRSERR_NULL_ARGUMENT;
 	}
+	int status = GvrsLoadMetadataDirectory(gvrs);
+	if (status) {
+		return status;
+	}
 	GvrsMetadataResultSet* rs = calloc(1, sizeof(GvrsMetadataResultSet));
 	if (rs) {
 		*resultSet = rs;
@@ -342,7 +350,7 @@ int  GvrsReadMetadataByName(Gvrs* gvrs, const char* name, GvrsMetadataResultSet*
 	for (i = 0; i < dir->nMetadataReferences; i++) {
 		GvrsMetadataReference r = dir->references[i];
 		if (*name == '*' || strcmp(name, r.name) == 0) {
-			int status = GvrsSetFilePosition(fp, r.filePos);
+			status = GvrsSetFilePosition(fp, r.filePos);
 			if (status) {
 				// non-zero status indicates an error
 				GvrsMetadataResultSetFree(rs);
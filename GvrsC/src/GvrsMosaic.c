@@ -0,0 +1,597 @@
+/* --------------------------------------------------------------------
+ *
+ * The MIT License
+ *
+ * Copyright (C) 2024  Gary W. Lucas.
+
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ * ---------------------------------------------------------------------
+ */
+
+// Development Note:
+//    Each member is assigned a position in the mosaic grid when it is added.
+// The spatial index is a grid of bins, each of which lists the members that
+// overlap it in the order the members were added.  The bin size is taken from
+// the dimensions of the first member since, in typical applications, the members
+// are of similar size.  The index is rebuilt on the first read after a member is added.
+//    Member handles are acquired from the pool when they are first needed
+// and are retained by the mosaic until more than maxHeldHandles are in use.
+// At that point, the least-recently used handle is returned to the pool.
+
+#define _USE_MATH_DEFINES
+#include <math.h>
+
+#include "GvrsFramework.h"
+
+#include "GvrsPrimaryIo.h"
+#include "Gvrs.h"
+#include "GvrsInternal.h"
+#include "GvrsHandlePool.h"
+#include "GvrsMosaic.h"
+#include "GvrsError.h"
+
+#define MOSAIC_DEFAULT_HELD_HANDLES 8
+#define MOSAIC_DEFAULT_POOL_SIZE 64
+
+typedef struct GvrsMosaicMemberTag {
+	char* path;
+	int refRow0;   // the position of the member within the reference grid
+	int refCol0;
+	int row0;      // the position of the member within the mosaic grid
+	int col0;
+	int nRows;
+	int nCols;
+	float fillValue;
+
+	Gvrs* gvrs;    // the handle, if currently held
+	GvrsElement* element;
+	int64_t lastUsed;
+	int64_t stamp; // used to mark the member as visited in a search
+}GvrsMosaicMember;
+
+typedef struct GvrsMosaicBinTag {
+	int nMembers;
+	int nAllocated;
+	int* members;
+}GvrsMosaicBin;
+
+static const double degreesToMetersScale = (6371007.2 * M_PI / 180.0);
+
+
+static void freeBins(GvrsMosaic* mosaic) {
+	GvrsMosaicBin* bins = (GvrsMosaicBin*)mosaic->bins;
+	if (bins) {
+		int i;
+		int nBins = mosaic->nRowsOfBins * mosaic->nColsOfBins;
+		for (i = 0; i < nBins; i++) {
+			free(bins[i].members);
+		}
+		free(bins);
+	}
+	mosaic->bins = 0;
+	mosaic->indexIsValid = 0;
+}
+
+static int addToBin(GvrsMosaicBin* bin, int iMember) {
+	if (bin->nMembers == bin->nAllocated) {
+		int n = bin->nAllocated ? bin->nAllocated * 2 : 4;
+		int* p = realloc(bin->members, (size_t)n * sizeof(int));
+		if (!p) {
+			return GVRSERR_NOMEM;
+		}
+		bin->members = p;
+		bin->nAllocated = n;
+	}
+	bin->members[bin->nMembers++] = iMember;
+	return 0;
+}
+
+static int buildIndex(GvrsMosaic* mosaic) {
+	freeBins(mosaic);
+	if (mosaic->nMembers == 0) {
+		return 0;
+	}
+	GvrsMosaicMember* members = (GvrsMosaicMember*)mosaic->members;
+	int i;
+	for (i = 0; i < mosaic->nMembers; i++) {
+		members[i].row0 = members[i].refRow0 - mosaic->refRow0;
+		members[i].col0 = members[i].refCol0 - mosaic->refCol0;
+	}
+	mosaic->nRowsInBin = members[0].nRows;
+	mosaic->nColsInBin = members[0].nCols;
+	mosaic->nRowsOfBins = (mosaic->nRowsInMosaic + mosaic->nRowsInBin - 1) / mosaic->nRowsInBin;
+	mosaic->nColsOfBins = (mosaic->nColsInMosaic + mosaic->nColsInBin - 1) / mosaic->nColsInBin;
+	GvrsMosaicBin* bins = calloc((size_t)mosaic->nRowsOfBins * (size_t)mosaic->nColsOfBins, sizeof(GvrsMosaicBin));
+	if (!bins) {
+		return GVRSERR_NOMEM;
+	}
+	mosaic->bins = bins;
+	for (i = 0; i < mosaic->nMembers; i++) {
+		GvrsMosaicMember* m = members + i;
+		int binRow0 = m->row0 / mosaic->nRowsInBin;
+		int binCol0 = m->col0 / mosaic->nColsInBin;
+		int binRow1 = (m->row0 + m->nRows - 1) / mosaic->nRowsInBin;
+		int binCol1 = (m->col0 + m->nCols - 1) / mosaic->nColsInBin;
+		int binRow, binCol;
+		for (binRow = binRow0; binRow <= binRow1; binRow++) {
+			for (binCol = binCol0; binCol <= binCol1; binCol++) {
+				int status = addToBin(bins + binRow * mosaic->nColsOfBins + binCol, i);
+				if (status) {
+					freeBins(mosaic);
+					return status;
+				}
+			}
+		}
+	}
+	mosaic->indexIsValid = 1;
+	return 0;
+}
+
+static int checkIndex(GvrsMosaic* mosaic) {
+	if (mosaic->indexIsValid) {
+		return 0;
+	}
+	return buildIndex(mosaic);
+}
+
+static void releaseMember(GvrsMosaic* mosaic, GvrsMosaicMember* m) {
+	if (m->gvrs) {
+		GvrsHandlePoolRelease(mosaic->pool, m->gvrs);
+		m->gvrs = 0;
+		m->element = 0;
+	}
+}
+
+// Gets the element for the member, acquiring a handle from the pool if necessary.
+static GvrsElement* getMemberElement(GvrsMosaic* mosaic, GvrsMosaicMember* m, int* status) {
+	*status = 0;
+	m->lastUsed = ++mosaic->useCounter;
+	if (m->element) {
+		return m->element;
+	}
+
+	// if the mosaic is holding the maximum number of handles, release the least-recently used
+	GvrsMosaicMember* members = (GvrsMosaicMember*)mosaic->members;
+	GvrsMosaicMember* oldest = 0;
+	int nHeld = 0;
+	int i;
+	for (i = 0; i < mosaic->nMembers; i++) {
+		if (members[i].gvrs) {
+			nHeld++;
+			if (!oldest || members[i].lastUsed < oldest->lastUsed) {
+				oldest = members + i;
+			}
+		}
+	}
+	if (oldest && nHeld >= mosaic->maxHeldHandles) {
+		releaseMember(mosaic, oldest);
+	}
+
+	Gvrs* gvrs;
+	*status = GvrsHandlePoolAcquire(mosaic->pool, m->path, &gvrs);
+	if (*status == GVRSERR_HANDLE_LIMIT) {
+		// The pool is exhausted, perhaps by other mosaics that share it.
+		// Return all the handles held by this mosaic and try again.
+		for (i = 0; i < mosaic->nMembers; i++) {
+			releaseMember(mosaic, members + i);
+		}
+		*status = GvrsHandlePoolAcquire(mosaic->pool, m->path, &gvrs);
+	}
+	if (*status) {
+		return 0;
+	}
+	GvrsElement* element = GvrsGetElementByName(gvrs, mosaic->elementName);
+	if (!element) {
+		GvrsHandlePoolRelease(mosaic->pool, gvrs);
+		*status = GVRSERR_ELEMENT_NOT_FOUND;
+		return 0;
+	}
+	m->gvrs = gvrs;
+	m->element = element;
+	return element;
+}
+
+static int isMissing(GvrsMosaicMember* m, float v) {
+	return v != v || v == m->fillValue;
+}
+
+static int readCell(GvrsMosaic* mosaic, int row, int column, float* value) {
+	*value = NAN;
+	GvrsMosaicBin* bin = (GvrsMosaicBin*)mosaic->bins
+		+ (row / mosaic->nRowsInBin) * mosaic->nColsOfBins + column / mosaic->nColsInBin;
+	GvrsMosaicMember* members = (GvrsMosaicMember*)mosaic->members;
+	int i, status;
+	for (i = 0; i < bin->nMembers; i++) {
+		GvrsMosaicMember* m = members + bin->members[i];
+		int r = row - m->row0;
+		int c = column - m->col0;
+		if (r < 0 || c < 0 || r >= m->nRows || c >= m->nCols) {
+			continue;
+		}
+		GvrsElement* e = getMemberElement(mosaic, m, &status);
+		if (!e) {
+			return status;
+		}
+		float v;
+		status = GvrsElementReadFloat(e, r, c, &v);
+		if (status) {
+			return status;
+		}
+		if (!isMissing(m, v)) {
+			*value = v;
+			return 0;
+		}
+	}
+	return 0;
+}
+
+static int compareInt(const void* a, const void* b) {
+	int ia = *(const int*)a;
+	int ib = *(const int*)b;
+	return (ia > ib) - (ia < ib);
+}
+
+
+int GvrsMosaicAlloc(GvrsHandlePool* pool, const char* elementName, GvrsMosaic** mosaicReference) {
+	if (!elementName || !mosaicReference) {
+		return GVRSERR_NULL_ARGUMENT;
+	}
+	*mosaicReference = 0;
+	if (!elementName[0] || strlen(elementName) > GVRS_ELEMENT_NAME_SZ) {
+		return GVRSERR_BAD_NAME_SPECIFICATION;
+	}
+	GvrsMosaic* mosaic = calloc(1, sizeof(GvrsMosaic));
+	if (!mosaic) {
+		return GVRSERR_NOMEM;
+	}
+	GvrsStrncpy(mosaic->elementName, sizeof(mosaic->elementName), elementName);
+	mosaic->maxHeldHandles = MOSAIC_DEFAULT_HELD_HANDLES;
+	mosaic->unitsToMeters = 1.0;
+	if (pool) {
+		mosaic->pool = pool;
+	}
+	else {
+		int status = GvrsHandlePoolAlloc(MOSAIC_DEFAULT_POOL_SIZE, 0, &mosaic->pool);
+		if (status) {
+			free(mosaic);
+			return status;
+		}
+		mosaic->poolIsOwned = 1;
+	}
+	*mosaicReference = mosaic;
+	return 0;
+}
+
+
+int GvrsMosaicAddFile(GvrsMosaic* mosaic, const char* path) {
+	if (!mosaic || !path) {
+		return GVRSERR_NULL_ARGUMENT;
+	}
+	Gvrs* gvrs;
+	int status = GvrsHandlePoolAcquire(mosaic->pool, path, &gvrs);
+	if (status) {
+		return status;
+	}
+	GvrsElement* element = GvrsGetElementByName(gvrs, mosaic->elementName);
+	if (!element) {
+		GvrsHandlePoolRelease(mosaic->pool, gvrs);
+		return GVRSERR_ELEMENT_NOT_FOUND;
+	}
+
+	int refRow0 = 0;
+	int refCol0 = 0;
+	if (mosaic->nMembers == 0) {
+		mosaic->geographicCoordinates = gvrs->geographicCoordinates;
+		mosaic->cellSizeX = gvrs->cellSizeX;
+		mosaic->cellSizeY = gvrs->cellSizeY;
+		mosaic->xRef = gvrs->x0;
+		mosaic->yRef = gvrs->y0;
+		mosaic->unitsToMeters = element->unitsToMeters;
+	}
+	else {
+		// verify that the grid of the file is aligned with the reference grid
+		double tx = 1.0e-9 * fabs(mosaic->cellSizeX);
+		double ty = 1.0e-9 * fabs(mosaic->cellSizeY);
+		double fCol = (gvrs->x0 - mosaic->xRef) / mosaic->cellSizeX;
+		double fRow = (gvrs->y0 - mosaic->yRef) / mosaic->cellSizeY;
+		refCol0 = (int)floor(fCol + 0.5);
+		refRow0 = (int)floor(fRow + 0.5);
+		if (gvrs->geographicCoordinates != mosaic->geographicCoordinates
+			|| fabs(gvrs->cellSizeX - mosaic->cellSizeX) > tx
+			|| fabs(gvrs->cellSizeY - mosaic->cellSizeY) > ty
+			|| fabs(fCol - refCol0) > 1.0e-6
+			|| fabs(fRow - refRow0) > 1.0e-6) {
+			GvrsHandlePoolRelease(mosaic->pool, gvrs);
+			return GVRSERR_BAD_RASTER_SPECIFICATION;
+		}
+	}
+
+	GvrsMosaicMember* members = realloc(mosaic->members, (size_t)(mosaic->nMembers + 1) * sizeof(GvrsMosaicMember));
+	if (!members) {
+		GvrsHandlePoolRelease(mosaic->pool, gvrs);
+		return GVRSERR_NOMEM;
+	}
+	mosaic->members = members;
+	GvrsMosaicMember* m = members + mosaic->nMembers;
+	memset(m, 0, sizeof(GvrsMosaicMember));
+	m->path = GVRS_STRDUP(path);
+	if (!m->path) {
+		GvrsHandlePoolRelease(mosaic->pool, gvrs);
+		return GVRSERR_NOMEM;
+	}
+	m->refRow0 = refRow0;
+	m->refCol0 = refCol0;
+	m->nRows = gvrs->nRowsInRaster;
+	m->nCols = gvrs->nColsInRaster;
+	m->fillValue = element->fillValueFloat;
+	GvrsHandlePoolRelease(mosaic->pool, gvrs);
+
+	int refRow1 = refRow0 + m->nRows - 1;
+	int refCol1 = refCol0 + m->nCols - 1;
+	if (mosaic->nMembers == 0) {
+		mosaic->refRow0 = refRow0;
+		mosaic->refCol0 = refCol0;
+		mosaic->refRow1 = refRow1;
+		mosaic->refCol1 = refCol1;
+	}
+	else {
+		if (refRow0 < mosaic->refRow0) {
+			mosaic->refRow0 = refRow0;
+		}
+		if (refCol0 < mosaic->refCol0) {
+			mosaic->refCol0 = refCol0;
+		}
+		if (refRow1 > mosaic->refRow1) {
+			mosaic->refRow1 = refRow1;
+		}
+		if (refCol1 > mosaic->refCol1) {
+			mosaic->refCol1 = refCol1;
+		}
+	}
+	mosaic->nMembers++;
+	mosaic->nRowsInMosaic = mosaic->refRow1 - mosaic->refRow0 + 1;
+	mosaic->nColsInMosaic = mosaic->refCol1 - mosaic->refCol0 + 1;
+	mosaic->x0 = mosaic->xRef + mosaic->refCol0 * mosaic->cellSizeX;
+	mosaic->y0 = mosaic->yRef + mosaic->refRow0 * mosaic->cellSizeY;
+	mosaic->indexIsValid = 0;
+	return 0;
+}
+
+
+void GvrsMosaicMapToGrid(GvrsMosaic* mosaic, double x, double y, double* row, double* column) {
+	*column = (x - mosaic->x0) / mosaic->cellSizeX;
+	*row = (y - mosaic->y0) / mosaic->cellSizeY;
+}
+
+
+int GvrsMosaicReadGridFloat(GvrsMosaic* mosaic, int row, int column, float* value) {
+	if (!mosaic || !value) {
+		return GVRSERR_NULL_ARGUMENT;
+	}
+	*value = NAN;
+	if (row < 0 || column < 0 || row >= mosaic->nRowsInMosaic || column >= mosaic->nColsInMosaic) {
+		return GVRSERR_COORDINATE_OUT_OF_BOUNDS;
+	}
+	int status = checkIndex(mosaic);
+	if (status) {
+		return status;
+	}
+	return readCell(mosaic, row, column, value);
+}
+
+
+int GvrsMosaicReadFloat(GvrsMosaic* mosaic, double x, double y, float* value) {
+	if (!mosaic || !value) {
+		return GVRSERR_NULL_ARGUMENT;
+	}
+	double row, column;
+	GvrsMosaicMapToGrid(mosaic, x, y, &row, &column);
+	return GvrsMosaicReadGridFloat(mosaic, (int)floor(row + 0.5), (int)floor(column + 0.5), value);
+}
+
+
+int GvrsMosaicReadBlock(GvrsMosaic* mosaic, int row0, int col0, int nRows, int nCols, float* values) {
+	if (!mosaic || !values) {
+		return GVRSERR_NULL_ARGUMENT;
+	}
+	if (nRows < 1 || nCols < 1) {
+		return GVRSERR_INVALID_PARAMETER;
+	}
+	int i, k, status;
+	int nValues = nRows * nCols;
+	for (i = 0; i < nValues; i++) {
+		values[i] = NAN;
+	}
+	status = checkIndex(mosaic);
+	if (status) {
+		return status;
+	}
+
+	// clip the block to the mosaic grid
+	int r0 = row0 < 0 ? 0 : row0;
+	int c0 = col0 < 0 ? 0 : col0;
+	int r1 = row0 + nRows - 1;
+	int c1 = col0 + nCols - 1;
+	if (r1 >= mosaic->nRowsInMosaic) {
+		r1 = mosaic->nRowsInMosaic - 1;
+	}
+	if (c1 >= mosaic->nColsInMosaic) {
+		c1 = mosaic->nColsInMosaic - 1;
+	}
+	if (r0 > r1 || c0 > c1) {
+		return 0;
+	}
+
+	// collect the members that overlap the block.  A member may be listed in more than
+	// one bin, so a stamp is used to avoid duplicates.
+	GvrsMosaicMember* members = (GvrsMosaicMember*)mosaic->members;
+	GvrsMosaicBin* bins = (GvrsMosaicBin*)mosaic->bins;
+	int64_t stamp = ++mosaic->useCounter;
+	int nCandidates = 0;
+	int* candidates = 0;
+	int nAllocated = 0;
+	int binRow, binCol;
+	for (binRow = r0 / mosaic->nRowsInBin; binRow <= r1 / mosaic->nRowsInBin; binRow++) {
+		for (binCol = c0 / mosaic->nColsInBin; binCol <= c1 / mosaic->nColsInBin; binCol++) {
+			GvrsMosaicBin* bin = bins + binRow * mosaic->nColsOfBins + binCol;
+			for (i = 0; i < bin->nMembers; i++) {
+				GvrsMosaicMember* m = members + bin->members[i];
+				if (m->stamp == stamp) {
+					continue;
+				}
+				m->stamp = stamp;
+				if (m->row0 > r1 || m->col0 > c1 || m->row0 + m->nRows <= r0 || m->col0 + m->nCols <= c0) {
+					continue;
+				}
+				if (nCandidates == nAllocated) {
+					nAllocated = nAllocated ? nAllocated * 2 : 16;
+					int* p = realloc(candidates, (size_t)nAllocated * sizeof(int));
+					if (!p) {
+						free(candidates);
+						return GVRSERR_NOMEM;
+					}
+					candidates = p;
+				}
+				candidates[nCandidates++] = bin->members[i];
+			}
+		}
+	}
+
+	// process the members in the order they were added so that the overlap rule is honored.
+	// Each member's portion of the block is read in bulk into a scratch buffer
+	// and then merged into the cells that are not yet populated.
+	qsort(candidates, (size_t)nCandidates, sizeof(int), compareInt);
+	float* scratch = 0;
+	if (nCandidates > 0) {
+		scratch = malloc((size_t)(r1 - r0 + 1) * (size_t)(c1 - c0 + 1) * sizeof(float));
+		if (!scratch) {
+			free(candidates);
+			return GVRSERR_NOMEM;
+		}
+	}
+	status = 0;
+	for (k = 0; k < nCandidates && !status; k++) {
+		GvrsMosaicMember* m = members + candidates[k];
+		GvrsElement* e = getMemberElement(mosaic, m, &status);
+		if (!e) {
+			break;
+		}
+		int mr0 = m->row0 > r0 ? m->row0 : r0;
+		int mc0 = m->col0 > c0 ? m->col0 : c0;
+		int mr1 = m->row0 + m->nRows - 1 < r1 ? m->row0 + m->nRows - 1 : r1;
+		int mc1 = m->col0 + m->nCols - 1 < c1 ? m->col0 + m->nCols - 1 : c1;
+		int mNCols = mc1 - mc0 + 1;
+		status = GvrsElementReadBlockFloat(e, mr0 - m->row0, mc0 - m->col0, mr1 - mr0 + 1, mNCols, scratch);
+		if (status) {
+			break;
+		}
+		int row, col;
+		for (row = mr0; row <= mr1; row++) {
+			float* p = values + (row - row0) * nCols - col0;
+			const float* s = scratch + (row - mr0) * mNCols - mc0;
+			for (col = mc0; col <= mc1; col++) {
+				if (p[col] == p[col]) {
+					continue; // already populated by an earlier member
+				}
+				if (!isMissing(m, s[col])) {
+					p[col] = s[col];
+				}
+			}
+		}
+	}
+	free(scratch);
+	free(candidates);
+	return status;
+}
+
+
+int GvrsMosaicInterpolateBspline(GvrsMosaic* mosaic, double x, double y, int computeDerivatives, GvrsInterpolationResult* result) {
+	if (!mosaic || !result) {
+		return GVRSERR_NULL_ARGUMENT;
+	}
+	double row, col;
+	double rowSpacing, colSpacing;
+	GvrsMosaicMapToGrid(mosaic, x, y, &row, &col);
+	if (mosaic->geographicCoordinates) {
+		double phi = y * M_PI / 180.0;  // latitude in radians
+		rowSpacing = mosaic->cellSizeY * degreesToMetersScale * mosaic->unitsToMeters;
+		colSpacing = mosaic->cellSizeX * degreesToMetersScale * cos(phi) * mosaic->unitsToMeters;
+	}
+	else {
+		rowSpacing = mosaic->cellSizeY;
+		colSpacing = mosaic->cellSizeX;
+	}
+
+	// The neighborhood is a 4-by-4 block positioned so that the interpolation point
+	// lies in its central cell.  Points within half a cell of the edge of the mosaic
+	// use the block at the edge, following the conventions of GvrsInterpolateBspline.
+	if (mosaic->nRowsInMosaic < 4 || mosaic->nColsInMosaic < 4
+		|| row < -0.5 || row > mosaic->nRowsInMosaic - 0.5
+		|| col < -0.5 || col > mosaic->nColsInMosaic - 0.5) {
+		return GVRSERR_COORDINATE_OUT_OF_BOUNDS;
+	}
+	int row0 = (int)floor(row) - 1;
+	int col0 = (int)floor(col) - 1;
+	if (row0 < 0) {
+		row0 = 0;
+	}
+	else if (row0 > mosaic->nRowsInMosaic - 4) {
+		row0 = mosaic->nRowsInMosaic - 4;
+	}
+	if (col0 < 0) {
+		col0 = 0;
+	}
+	else if (col0 > mosaic->nColsInMosaic - 4) {
+		col0 = mosaic->nColsInMosaic - 4;
+	}
+
+	float grid[16];
+	int status = GvrsMosaicReadBlock(mosaic, row0, col0, 4, 4, grid);
+	if (status) {
+		return status;
+	}
+	int i;
+	for (i = 0; i < 16; i++) {
+		if (grid[i] != grid[i]) {
+			return GVRSERR_COORDINATE_OUT_OF_BOUNDS;
+		}
+	}
+	return GvrsGeneralBspline(row - row0, col - col0, 4, 4, grid, computeDerivatives, rowSpacing, colSpacing, result);
+}
+
+
+GvrsMosaic* GvrsMosaicFree(GvrsMosaic* mosaic) {
+	if (mosaic) {
+		GvrsMosaicMember* members = (GvrsMosaicMember*)mosaic->members;
+		int i;
+		for (i = 0; i < mosaic->nMembers; i++) {
+			releaseMember(mosaic, members + i);
+			free(members[i].path);
+		}
+		free(members);
+		mosaic->members = 0;
+		freeBins(mosaic);
+		if (mosaic->poolIsOwned) {
+			GvrsHandlePoolFree(mosaic->pool);
+		}
+		mosaic->pool = 0;
+		free(mosaic);
+	}
+	return 0;
+}
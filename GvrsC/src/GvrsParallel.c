@@ -0,0 +1,543 @@
+/* --------------------------------------------------------------------
+ *
+ * The MIT License
+ *
+ * Copyright (C) 2024  Gary W. Lucas.
+
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ * ---------------------------------------------------------------------
+ */
+
+// Development Note:
+//    The parallel executor assigns each worker a contiguous run of tiles taken
+// from the row-major sequence of tiles in the region of interest.  Because
+// adjacent tiles are often stored near each other in the file and are often
+// needed together by interpolation and filtering operations, the contiguous
+// assignment tends to preserve locality.  When a worker exhausts its own run,
+// it "steals" the latter half of the run of another worker.  Stealing from
+// the far end of a run leaves the victim to continue with the tiles that are
+// adjacent to the ones it has already processed.
+//
+//    The GVRS data structures are not thread safe.  So each worker has its own
+// GVRS instance (and, hence, its own tile cache and file position).
+// The calling thread serves as worker zero and uses the source instance.
+//
+//    Write back of results is serialized and performed in order of sequence.  When a
+// worker completes a tile, it posts its result. Then, if the result for the next
+// tile in sequence is available and no other worker is writing, the worker takes
+// it and any completed results that follow it and writes them.  The job mutex
+// is released while the results are written so that the other workers are
+// not blocked by the (potentially slow) write-back function.
+//
+//    With contiguous runs, the results from all but the first worker would be
+// held in memory until the first worker completed its run.  So when a write-back
+// function is specified, the tiles are handed out one at a time in order of sequence
+// instead.  A worker that gets more than a fixed window of tiles ahead of the write back
+// waits until the write back catches up, which limits the number of pending results.
+
+#include "GvrsFramework.h"
+
+#include "GvrsPrimaryIo.h"
+#include "Gvrs.h"
+#include "GvrsInternal.h"
+#include "GvrsParallel.h"
+#include "GvrsError.h"
+
+struct GvrsParallelJobTag;
+
+typedef struct GvrsParallelWorkerTag {
+	struct GvrsParallelJobTag* job;
+	int workerIndex;
+	Gvrs* gvrs;
+	void* workerData;
+	GvrsThread* thread;
+	int started;
+
+	// the run of sequence values assigned to the worker.  The worker takes
+	// values from next.  Other workers steal values from end.
+	GvrsMutex* mutex;
+	int next;
+	int end;
+}GvrsParallelWorker;
+
+typedef struct GvrsParallelJobTag {
+	Gvrs* source;
+	GvrsRegion region;
+	const GvrsParallelOptions* options;
+	GvrsParallelTileFunction function;
+	void* userData;
+
+	int nTiles;
+	int* tiles;  // tile indices in order of sequence
+
+	int nWorkers;
+	GvrsParallelWorker* workers;
+
+	// the job mutex protects the status and the write-back elements
+	GvrsMutex* mutex;
+	int status;
+	void** results;
+	uint8_t* completed;
+	int nextToWrite;
+
+	// For ordered write back, the next sequence value to be handed out,
+	// the number of tiles a worker may be ahead of the write back,
+	// and an indication that a worker is writing results.  Workers that are
+	// too far ahead wait on the condition.
+	int nextToTake;
+	int window;
+	int writerActive;
+	GvrsCondition* condition;
+}GvrsParallelJob;
+
+
+int GvrsParallelOptionsInit(Gvrs* gvrs, GvrsParallelOptions* options) {
+	if (!gvrs || !options) {
+		return GVRSERR_NULL_ARGUMENT;
+	}
+	memset(options, 0, sizeof(GvrsParallelOptions));
+	options->tileCacheSize = gvrs->tileCacheSize;
+	return 0;
+}
+
+
+static int getJobStatus(GvrsParallelJob* job) {
+	GvrsMutexLock(job->mutex);
+	int status = job->status;
+	GvrsMutexUnlock(job->mutex);
+	return status;
+}
+
+static void setJobStatus(GvrsParallelJob* job, int status) {
+	GvrsMutexLock(job->mutex);
+	if (!job->status) {
+		job->status = status;
+	}
+	if (job->condition) {
+		// release any workers that are waiting for the write back
+		GvrsConditionSignal(job->condition);
+	}
+	GvrsMutexUnlock(job->mutex);
+}
+
+
+static int takeFromOwnRun(GvrsParallelWorker* worker, int* sequence) {
+	int found = 0;
+	GvrsMutexLock(worker->mutex);
+	if (worker->next < worker->end) {
+		*sequence = worker->next++;
+		found = 1;
+	}
+	GvrsMutexUnlock(worker->mutex);
+	return found;
+}
+
+static int stealFromOtherRun(GvrsParallelWorker* worker, int* sequence) {
+	GvrsParallelJob* job = worker->job;
+	int i;
+	for (i = 1; i < job->nWorkers; i++) {
+		GvrsParallelWorker* victim = job->workers + (worker->workerIndex + i) % job->nWorkers;
+		int start = 0;
+		int end = 0;
+		GvrsMutexLock(victim->mutex);
+		int nRemaining = victim->end - victim->next;
+		if (nRemaining > 0) {
+			end = victim->end;
+			start = end - (nRemaining + 1) / 2;
+			victim->end = start;
+		}
+		GvrsMutexUnlock(victim->mutex);
+		if (end > start) {
+			GvrsMutexLock(worker->mutex);
+			worker->next = start + 1;
+			worker->end = end;
+			GvrsMutexUnlock(worker->mutex);
+			*sequence = start;
+			return 1;
+		}
+	}
+	return 0;
+}
+
+
+// Takes the next tile in sequence for a job with ordered write back.  If the tile
+// is too far ahead of the write back, waits until the write back catches up.
+// The tile for nextToWrite is always held by a worker that is not waiting,
+// so the wait cannot stall the job.
+static int takeInSequence(GvrsParallelWorker* worker, int* sequence) {
+	GvrsParallelJob* job = worker->job;
+	int found = 0;
+	GvrsMutexLock(job->mutex);
+	if (!job->status && job->nextToTake < job->nTiles) {
+		int k = job->nextToTake++;
+		while (!job->status && k >= job->nextToWrite + job->window) {
+			GvrsConditionWait(job->condition, job->mutex);
+		}
+		if (!job->status) {
+			*sequence = k;
+			found = 1;
+		}
+	}
+	GvrsMutexUnlock(job->mutex);
+	return found;
+}
+
+
+static int writeBackResults(GvrsParallelWorker* worker, int sequence, void* result) {
+	GvrsParallelJob* job = worker->job;
+	const GvrsParallelOptions* options = job->options;
+	int status = 0;
+	int k;
+	GvrsMutexLock(job->mutex);
+	job->results[sequence] = result;
+	job->completed[sequence] = 1;
+	if (job->writerActive) {
+		// the worker that is writing will pick up the result
+		GvrsMutexUnlock(job->mutex);
+		return 0;
+	}
+	job->writerActive = 1;
+	while (!job->status && job->nextToWrite < job->nTiles && job->completed[job->nextToWrite]) {
+		// take the run of completed results that starts at nextToWrite
+		int first = job->nextToWrite;
+		int last = first;
+		while (last < job->nTiles && job->completed[last]) {
+			last++;
+		}
+		job->nextToWrite = last;
+		GvrsConditionSignal(job->condition);
+		GvrsMutexUnlock(job->mutex);
+
+		for (k = first; k < last; k++) {
+			if (!status) {
+				GvrsParallelTask task;
+				memset(&task, 0, sizeof(task));
+				task.gvrs = worker->gvrs;
+				task.workerIndex = worker->workerIndex;
+				task.tileIndex = job->tiles[k];
+				task.tileRow = task.tileIndex / job->source->nColsOfTiles;
+				task.tileCol = task.tileIndex - task.tileRow * job->source->nColsOfTiles;
+				task.sequence = k;
+				task.result = job->results[k];
+				status = options->writeBack(&task, job->userData);
+			}
+			free(job->results[k]);
+			job->results[k] = 0;
+		}
+
+		GvrsMutexLock(job->mutex);
+		if (status && !job->status) {
+			job->status = status;
+			GvrsConditionSignal(job->condition);
+		}
+	}
+	job->writerActive = 0;
+	GvrsMutexUnlock(job->mutex);
+	return status;
+}
+
+
+static int processTile(GvrsParallelWorker* worker, int sequence) {
+	GvrsParallelJob* job = worker->job;
+	Gvrs* gvrs = job->source;
+	GvrsParallelTask task;
+	memset(&task, 0, sizeof(task));
+	task.gvrs = worker->gvrs;
+	task.workerIndex = worker->workerIndex;
+	task.tileIndex = job->tiles[sequence];
+	task.tileRow = task.tileIndex / gvrs->nColsOfTiles;
+	task.tileCol = task.tileIndex - task.tileRow * gvrs->nColsOfTiles;
+	task.sequence = sequence;
+	task.workerData = worker->workerData;
+
+	// the intersection of the tile and the region of interest
+	task.row0 = task.tileRow * gvrs->nRowsInTile;
+	task.col0 = task.tileCol * gvrs->nColsInTile;
+	task.row1 = task.row0 + gvrs->nRowsInTile - 1;
+	task.col1 = task.col0 + gvrs->nColsInTile - 1;
+	if (task.row0 < job->region.row0) {
+		task.row0 = job->region.row0;
+	}
+	if (task.col0 < job->region.col0) {
+		task.col0 = job->region.col0;
+	}
+	if (task.row1 > job->region.row1) {
+		task.row1 = job->region.row1;
+	}
+	if (task.col1 > job->region.col1) {
+		task.col1 = job->region.col1;
+	}
+
+	int status = job->function(&task, job->userData);
+	if (job->options->writeBack) {
+		if (status) {
+			free(task.result);
+			return status;
+		}
+		return writeBackResults(worker, sequence, task.result);
+	}
+	free(task.result);
+	return status;
+}
+
+
+static int runWorker(void* argument) {
+	GvrsParallelWorker* worker = (GvrsParallelWorker*)argument;
+	GvrsParallelJob* job = worker->job;
+	const GvrsParallelOptions* options = job->options;
+	int status = 0;
+
+	worker->started = 1;
+	if (worker->gvrs != job->source) {
+		status = GvrsSetTileCacheSize(worker->gvrs, options->tileCacheSize);
+	}
+	if (!status && options->workerDataSize > 0) {
+		worker->workerData = calloc(1, options->workerDataSize);
+		if (!worker->workerData) {
+			status = GVRSERR_NOMEM;
+		}
+	}
+	if (!status && options->initWorkerData) {
+		status = options->initWorkerData(worker->workerIndex, worker->workerData, job->userData);
+	}
+	if (status) {
+		setJobStatus(job, status);
+		return status;
+	}
+
+	int sequence;
+	while (!getJobStatus(job)) {
+		if (options->writeBack) {
+			if (!takeInSequence(worker, &sequence)) {
+				break;
+			}
+		}
+		else if (!takeFromOwnRun(worker, &sequence) && !stealFromOtherRun(worker, &sequence)) {
+			break;
+		}
+		status = processTile(worker, sequence);
+		if (status) {
+			setJobStatus(job, status);
+			break;
+		}
+	}
+	return status;
+}
+
+
+static int collectTiles(GvrsParallelJob* job) {
+	Gvrs* gvrs = job->source;
+	int tileRow0 = job->region.row0 / gvrs->nRowsInTile;
+	int tileRow1 = job->region.row1 / gvrs->nRowsInTile;
+	int tileCol0 = job->region.col0 / gvrs->nColsInTile;
+	int tileCol1 = job->region.col1 / gvrs->nColsInTile;
+	int n = (tileRow1 - tileRow0 + 1) * (tileCol1 - tileCol0 + 1);
+	int status = GvrsLoadTileDirectory(gvrs);
+	if (status) {
+		return status;
+	}
+	job->tiles = calloc((size_t)n, sizeof(int));
+	if (!job->tiles) {
+		return GVRSERR_NOMEM;
+	}
+	int tileRow, tileCol;
+	for (tileRow = tileRow0; tileRow <= tileRow1; tileRow++) {
+		for (tileCol = tileCol0; tileCol <= tileCol1; tileCol++) {
+			int tileIndex = tileRow * gvrs->nColsOfTiles + tileCol;
+			if (job->options->skipUnpopulatedTiles
+				&& !GvrsTileDirectoryGetFilePosition(gvrs->tileDirectory, tileIndex)) {
+				continue;
+			}
+			job->tiles[job->nTiles++] = tileIndex;
+		}
+	}
+	return 0;
+}
+
+
+static void freeJob(GvrsParallelJob* job) {
+	int i;
+	if (job->workers) {
+		for (i = 0; i < job->nWorkers; i++) {
+			GvrsParallelWorker* worker = job->workers + i;
+			if (worker->gvrs && worker->gvrs != job->source) {
+				GvrsClose(worker->gvrs);
+			}
+			free(worker->workerData);
+			GvrsMutexFree(worker->mutex);
+		}
+		free(job->workers);
+	}
+	if (job->results) {
+		for (i = 0; i < job->nTiles; i++) {
+			free(job->results[i]);
+		}
+		free(job->results);
+	}
+	free(job->completed);
+	free(job->tiles);
+	GvrsConditionFree(job->condition);
+	GvrsMutexFree(job->mutex);
+}
+
+
+int GvrsParallelForTilesWithOptions(Gvrs* gvrs, const GvrsRegion* region, const GvrsParallelOptions* options,
+	GvrsParallelTileFunction function, void* userData) {
+	if (!gvrs || !options || !function) {
+		return GVRSERR_NULL_ARGUMENT;
+	}
+
+	GvrsParallelJob job;
+	memset(&job, 0, sizeof(job));
+	job.source = gvrs;
+	job.options = options;
+	job.function = function;
+	job.userData = userData;
+	if (region) {
+		job.region = *region;
+		if (job.region.row0 < 0 || job.region.col0 < 0
+			|| job.region.row1 < job.region.row0 || job.region.col1 < job.region.col0
+			|| job.region.row1 >= gvrs->nRowsInRaster || job.region.col1 >= gvrs->nColsInRaster) {
+			return GVRSERR_COORDINATE_OUT_OF_BOUNDS;
+		}
+	}
+	else {
+		job.region.row1 = gvrs->nRowsInRaster - 1;
+		job.region.col1 = gvrs->nColsInRaster - 1;
+	}
+
+	int status;
+	int nThreads = options->nThreads > 0 ? options->nThreads : GvrsGetProcessorCount();
+	if (gvrs->timeOpenedForWritingMS) {
+		// ensure that the file (and the tile directory) reflect any changes made by the application
+		status = GvrsTileCacheWritePendingTiles(gvrs->tileCache);
+		if (status) {
+			return status;
+		}
+		fflush(gvrs->fp);
+	}
+
+	status = GvrsMutexInit(&job.mutex);
+	if (!status) {
+		status = collectTiles(&job);
+	}
+	if (status || job.nTiles == 0) {
+		freeJob(&job);
+		return status;
+	}
+	if (nThreads > job.nTiles) {
+		nThreads = job.nTiles;
+	}
+
+	if (options->writeBack) {
+		job.results = calloc((size_t)job.nTiles, sizeof(void*));
+		job.completed = calloc((size_t)job.nTiles, sizeof(uint8_t));
+		if (!job.results || !job.completed) {
+			freeJob(&job);
+			return GVRSERR_NOMEM;
+		}
+		status = GvrsConditionInit(&job.condition);
+		if (status) {
+			freeJob(&job);
+			return status;
+		}
+		job.window = 2 * nThreads;
+	}
+
+	job.workers = calloc((size_t)nThreads, sizeof(GvrsParallelWorker));
+	if (!job.workers) {
+		freeJob(&job);
+		return GVRSERR_NOMEM;
+	}
+	job.nWorkers = nThreads;
+	int i;
+	for (i = 0; i < nThreads; i++) {
+		GvrsParallelWorker* worker = job.workers + i;
+		worker->job = &job;
+		worker->workerIndex = i;
+		worker->next = (int)((int64_t)job.nTiles * i / nThreads);
+		worker->end = (int)((int64_t)job.nTiles * (i + 1) / nThreads);
+		status = GvrsMutexInit(&worker->mutex);
+		if (status) {
+			freeJob(&job);
+			return status;
+		}
+	}
+	job.workers[0].gvrs = gvrs;
+	for (i = 1; i < nThreads; i++) {
+		status = GvrsOpenReaderClone(gvrs, &job.workers[i].gvrs);
+		if (status) {
+			freeJob(&job);
+			return status;
+		}
+	}
+
+	for (i = 1; i < nThreads; i++) {
+		if (GvrsThreadStart(&job.workers[i].thread, runWorker, job.workers + i)) {
+			// The system could not supply another thread.  The runs that were
+			// assigned to the workers that did not start will be stolen by the others.
+			break;
+		}
+	}
+	runWorker(job.workers);
+	for (i = 1; i < nThreads; i++) {
+		if (job.workers[i].thread) {
+			GvrsThreadJoin(job.workers[i].thread);
+		}
+	}
+
+	status = job.status;
+	if (!status && options->reduce) {
+		for (i = 0; i < nThreads; i++) {
+			if (!job.workers[i].started) {
+				continue;
+			}
+			status = options->reduce(i, job.workers[i].workerData, userData);
+			if (status) {
+				break;
+			}
+		}
+	}
+	freeJob(&job);
+	return status;
+}
+
+
+int GvrsParallelForTiles(Gvrs* gvrs, const GvrsRegion* region, int nThreads, GvrsParallelTileFunction function, void* userData) {
+	GvrsParallelOptions options;
+	int status = GvrsParallelOptionsInit(gvrs, &options);
+	if (status) {
+		return status;
+	}
+	options.nThreads = nThreads;
+	return GvrsParallelForTilesWithOptions(gvrs, region, &options, function, userData);
+}
+
+
+int GvrsParallelTaskReadBlockFloat(GvrsParallelTask* task, int elementIndex, float* values) {
+	if (!task || !task->gvrs || !values) {
+		return GVRSERR_NULL_ARGUMENT;
+	}
+	Gvrs* gvrs = task->gvrs;
+	if (elementIndex < 0 || elementIndex >= gvrs->nElementsInTupple) {
+		return GVRSERR_ELEMENT_NOT_FOUND;
+	}
+	return GvrsElementReadBlockFloat(gvrs->elements[elementIndex],
+		task->row0, task->col0, task->row1 - task->row0 + 1, task->col1 - task->col0 + 1, values);
+}
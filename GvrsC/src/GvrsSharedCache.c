@@ -0,0 +1,524 @@
+/* --------------------------------------------------------------------
+ *
+ * The MIT License
+ *
+ * Copyright (C) 2024  Gary W. Lucas.
+
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ * ---------------------------------------------------------------------
+ */
+
+// Development Note:
+//    The shared cache is organized as a set-associative table of fixed-size
+// slots.  Each tile key maps to a set of four slots.  Because the segment may
+// be accessed by multiple processes, it cannot contain pointers and cannot
+// use process-local locks.  Instead, each slot is protected by a sequence lock
+// (a "seqlock"). The sequence value is odd while a writer is modifying the slot
+// and is advanced to the next even value when the modification is complete.
+//
+//    A reader copies the slot content without taking a lock and then confirms
+// that the sequence did not change while it was copying.  If it did, the copy
+// may be inconsistent and is treated as a cache miss.  A writer claims a slot
+// by using an atomic compare-and-swap to change the sequence from even to odd.
+// If the claim fails, another writer is busy with the slot and the tile is
+// simply not stored.  Thus neither readers nor writers ever wait.
+//
+//    The cache is an optimization. A process that terminates while
+// writing a slot leaves that slot permanently claimed, but the other slots
+// in its set remain available.
+
+#include "GvrsFramework.h"
+
+#include "GvrsPrimaryIo.h"
+#include "Gvrs.h"
+#include "GvrsInternal.h"
+#include "GvrsSharedCache.h"
+#include "GvrsError.h"
+
+#if defined(_WIN32) || defined(_WIN64)
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <errno.h>
+#endif
+
+#define SHARED_CACHE_IDENTIFICATION "gvrs tile cache"
+#define SHARED_CACHE_VERSION 1
+#define SHARED_CACHE_WAYS    4
+#define SHARED_CACHE_ALIGN   64
+
+typedef struct GvrsSharedHeaderTag {
+	char identification[16];
+	int32_t version;
+	int32_t nSlots;
+	int32_t slotDataSize;
+	int32_t slotStride;
+	volatile uint64_t useCounter;
+	volatile uint32_t ready;
+}GvrsSharedHeader;
+
+typedef struct GvrsSharedSlotTag {
+	volatile uint32_t sequence;
+	int32_t tileIndex;
+	int64_t key0;
+	int64_t key1;
+	int64_t key2;
+	int64_t filePos;
+	volatile uint64_t lastUse;
+	int32_t nBytes;    // zero if the slot is unused
+	int32_t pad;
+}GvrsSharedSlot;
+
+
+#if defined(_WIN32) || defined(_WIN64)
+
+static uint32_t loadAcquire(volatile uint32_t* p) {
+	uint32_t v = *p;
+	MemoryBarrier();
+	return v;
+}
+
+static void storeRelease(volatile uint32_t* p, uint32_t v) {
+	MemoryBarrier();
+	*p = v;
+}
+
+static int compareAndSwap(volatile uint32_t* p, uint32_t expected, uint32_t desired) {
+	return InterlockedCompareExchange((volatile LONG*)p, (LONG)desired, (LONG)expected) == (LONG)expected;
+}
+
+static void fence() {
+	MemoryBarrier();
+}
+
+static uint64_t fetchAndIncrement(volatile uint64_t* p) {
+	return (uint64_t)InterlockedIncrement64((volatile LONG64*)p);
+}
+
+static void increment(volatile int64_t* p) {
+	InterlockedIncrement64((volatile LONG64*)p);
+}
+
+#else
+
+static uint32_t loadAcquire(volatile uint32_t* p) {
+	return __atomic_load_n(p, __ATOMIC_ACQUIRE);
+}
+
+static void storeRelease(volatile uint32_t* p, uint32_t v) {
+	__atomic_store_n(p, v, __ATOMIC_RELEASE);
+}
+
+static int compareAndSwap(volatile uint32_t* p, uint32_t expected, uint32_t desired) {
+	return __atomic_compare_exchange_n(p, &expected, desired, 0, __ATOMIC_ACQ_REL, __ATOMIC_RELAXED);
+}
+
+static void fence() {
+	__atomic_thread_fence(__ATOMIC_SEQ_CST);
+}
+
+static uint64_t fetchAndIncrement(volatile uint64_t* p) {
+	return __atomic_add_fetch(p, 1, __ATOMIC_RELAXED);
+}
+
+static void increment(volatile int64_t* p) {
+	__atomic_add_fetch(p, 1, __ATOMIC_RELAXED);
+}
+
+#endif
+
+
+static int roundUp(int value, int alignment) {
+	return (value + alignment - 1) / alignment * alignment;
+}
+
+static GvrsSharedSlot* getSlot(GvrsSharedHeader* header, int index) {
+	uint8_t* base = (uint8_t*)header + SHARED_CACHE_ALIGN;
+	return (GvrsSharedSlot*)(base + (size_t)index * (size_t)header->slotStride);
+}
+
+static uint8_t* getSlotData(GvrsSharedSlot* slot) {
+	return (uint8_t*)slot + SHARED_CACHE_ALIGN;
+}
+
+static uint64_t mix(uint64_t x) {
+	// the finalization step from the SplitMix64 generator
+	x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+	x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+	return x ^ (x >> 31);
+}
+
+static void computeKey(Gvrs* gvrs, int64_t key[3]) {
+	key[0] = gvrs->uuidLow;
+	key[1] = gvrs->uuidHigh;
+	key[2] = gvrs->modTimeMS;
+	if (key[0] == 0 && key[1] == 0 && gvrs->path) {
+		// The UUID was not populated when the file was created.  Use an FNV-1a hash
+		// of the path instead.  Processes that specify the same file using different
+		// paths will not share tiles, but they will still get correct results.
+		uint64_t h = 0xcbf29ce484222325ULL;
+		const unsigned char* p = (const unsigned char*)gvrs->path;
+		while (*p) {
+			h ^= *p++;
+			h *= 0x100000001b3ULL;
+		}
+		key[0] = (int64_t)h;
+		key[1] = (int64_t)mix(h);
+	}
+}
+
+static int getFirstSlotInSet(GvrsSharedHeader* header, const int64_t key[3], int tileIndex, int64_t filePos) {
+	uint64_t h = mix((uint64_t)key[0] ^ mix((uint64_t)key[1] ^ mix((uint64_t)key[2] ^ mix((uint64_t)filePos + (uint64_t)tileIndex))));
+	int nSets = header->nSlots / SHARED_CACHE_WAYS;
+	return (int)(h % (uint64_t)nSets) * SHARED_CACHE_WAYS;
+}
+
+static int slotMatches(GvrsSharedSlot* slot, const int64_t key[3], int tileIndex, int64_t filePos) {
+	return slot->nBytes > 0
+		&& slot->tileIndex == tileIndex
+		&& slot->filePos == filePos
+		&& slot->key0 == key[0]
+		&& slot->key1 == key[1]
+		&& slot->key2 == key[2];
+}
+
+
+int GvrsSharedTileCacheGet(Gvrs* gvrs, int tileIndex, int64_t filePos, uint8_t* data) {
+	GvrsSharedTileCache* cache = gvrs->sharedTileCache;
+	GvrsSharedHeader* header = cache->segment;
+	int64_t key[3];
+	computeKey(gvrs, key);
+	int nBytes = gvrs->nBytesForTileData;
+	int iFirst = getFirstSlotInSet(header, key, tileIndex, filePos);
+	int i;
+	for (i = 0; i < SHARED_CACHE_WAYS; i++) {
+		GvrsSharedSlot* slot = getSlot(header, iFirst + i);
+		uint32_t s0 = loadAcquire(&slot->sequence);
+		if ((s0 & 1) || !slotMatches(slot, key, tileIndex, filePos) || slot->nBytes != nBytes) {
+			continue;
+		}
+		memcpy(data, getSlotData(slot), (size_t)nBytes);
+		fence();
+		if (loadAcquire(&slot->sequence) != s0) {
+			// a writer modified the slot while it was being copied
+			break;
+		}
+		slot->lastUse = fetchAndIncrement(&header->useCounter);
+		increment(&cache->nHits);
+		return 1;
+	}
+	increment(&cache->nMisses);
+	return 0;
+}
+
+
+void GvrsSharedTileCachePut(Gvrs* gvrs, int tileIndex, int64_t filePos, const uint8_t* data) {
+	GvrsSharedTileCache* cache = gvrs->sharedTileCache;
+	GvrsSharedHeader* header = cache->segment;
+	int64_t key[3];
+	computeKey(gvrs, key);
+	int nBytes = gvrs->nBytesForTileData;
+	int iFirst = getFirstSlotInSet(header, key, tileIndex, filePos);
+	int i;
+
+	// Select an unused slot if possible, otherwise the least-recently used slot.
+	// If another process has already posted the tile, there is nothing to do.
+	GvrsSharedSlot* target = 0;
+	for (i = 0; i < SHARED_CACHE_WAYS; i++) {
+		GvrsSharedSlot* slot = getSlot(header, iFirst + i);
+		uint32_t s0 = loadAcquire(&slot->sequence);
+		if (s0 & 1) {
+			continue;
+		}
+		if (slotMatches(slot, key, tileIndex, filePos)) {
+			return;
+		}
+		if (!target || (target->nBytes > 0 && (slot->nBytes == 0 || slot->lastUse < target->lastUse))) {
+			target = slot;
+		}
+	}
+	if (!target) {
+		return;
+	}
+
+	uint32_t s0 = loadAcquire(&target->sequence);
+	if ((s0 & 1) || !compareAndSwap(&target->sequence, s0, s0 + 1)) {
+		return;
+	}
+	fence();
+	target->nBytes = nBytes;
+	target->tileIndex = tileIndex;
+	target->filePos = filePos;
+	target->key0 = key[0];
+	target->key1 = key[1];
+	target->key2 = key[2];
+	memcpy(getSlotData(target), data, (size_t)nBytes);
+	target->lastUse = fetchAndIncrement(&header->useCounter);
+	storeRelease(&target->sequence, s0 + 2);
+	increment(&cache->nStores);
+}
+
+
+static int checkName(const char* name) {
+	if (!name || !*name) {
+		return GVRSERR_NULL_ARGUMENT;
+	}
+	if (strlen(name) > 60 || strchr(name, '/') || strchr(name, '\\')) {
+		return GVRSERR_INVALID_PARAMETER;
+	}
+	return 0;
+}
+
+static void initializeHeader(GvrsSharedHeader* header, int nSlots, int slotDataSize, int slotStride) {
+	GvrsStrncpy(header->identification, sizeof(header->identification), SHARED_CACHE_IDENTIFICATION);
+	header->version = SHARED_CACHE_VERSION;
+	header->nSlots = nSlots;
+	header->slotDataSize = slotDataSize;
+	header->slotStride = slotStride;
+	storeRelease(&header->ready, 1);
+}
+
+static int checkHeader(GvrsSharedHeader* header) {
+	if (strcmp(header->identification, SHARED_CACHE_IDENTIFICATION) || header->version != SHARED_CACHE_VERSION) {
+		return GVRSERR_INVALID_FILE;
+	}
+	return 0;
+}
+
+#if defined(_WIN32) || defined(_WIN64)
+
+int GvrsSharedTileCacheOpen(const char* name, int nSlots, int slotDataSize, GvrsSharedTileCache** cacheReference) {
+	if (!cacheReference) {
+		return GVRSERR_NULL_ARGUMENT;
+	}
+	*cacheReference = 0;
+	int status = checkName(name);
+	if (status) {
+		return status;
+	}
+	if (nSlots <= 0 || slotDataSize <= 0) {
+		return GVRSERR_INVALID_PARAMETER;
+	}
+	nSlots = roundUp(nSlots, SHARED_CACHE_WAYS);
+	int slotStride = SHARED_CACHE_ALIGN + roundUp(slotDataSize, SHARED_CACHE_ALIGN);
+	int64_t segmentSize = SHARED_CACHE_ALIGN + (int64_t)nSlots * slotStride;
+
+	char mappingName[80];
+	snprintf(mappingName, sizeof(mappingName), "Local\\%s", name);
+	HANDLE h = CreateFileMappingA(INVALID_HANDLE_VALUE, NULL, PAGE_READWRITE,
+		(DWORD)(segmentSize >> 32), (DWORD)(segmentSize & 0xffffffff), mappingName);
+	if (!h) {
+		return GVRSERR_FILE_ERROR;
+	}
+	int created = GetLastError() != ERROR_ALREADY_EXISTS;
+	GvrsSharedHeader* header = MapViewOfFile(h, FILE_MAP_ALL_ACCESS, 0, 0, 0);
+	if (!header) {
+		CloseHandle(h);
+		return GVRSERR_FILE_ERROR;
+	}
+	if (created) {
+		initializeHeader(header, nSlots, slotDataSize, slotStride);
+	}
+	else {
+		int i;
+		for (i = 0; i < 1000 && !loadAcquire(&header->ready); i++) {
+			Sleep(1);
+		}
+		status = header->ready ? checkHeader(header) : GVRSERR_FILE_ERROR;
+		if (status) {
+			UnmapViewOfFile(header);
+			CloseHandle(h);
+			return status;
+		}
+		segmentSize = SHARED_CACHE_ALIGN + (int64_t)header->nSlots * header->slotStride;
+	}
+
+	GvrsSharedTileCache* cache = calloc(1, sizeof(GvrsSharedTileCache));
+	if (!cache) {
+		UnmapViewOfFile(header);
+		CloseHandle(h);
+		return GVRSERR_NOMEM;
+	}
+	GvrsStrncpy(cache->name, sizeof(cache->name), name);
+	cache->nSlots = header->nSlots;
+	cache->slotDataSize = header->slotDataSize;
+	cache->segmentSize = segmentSize;
+	cache->segment = header;
+	cache->handle = h;
+	*cacheReference = cache;
+	return 0;
+}
+
+GvrsSharedTileCache* GvrsSharedTileCacheClose(GvrsSharedTileCache* cache) {
+	if (cache) {
+		UnmapViewOfFile(cache->segment);
+		CloseHandle((HANDLE)cache->handle);
+		memset(cache, 0, sizeof(GvrsSharedTileCache));
+		free(cache);
+	}
+	return 0;
+}
+
+int GvrsSharedTileCacheRemove(const char* name) {
+	// a Windows file mapping is removed when the last handle to it is closed
+	return checkName(name);
+}
+
+#else
+
+int GvrsSharedTileCacheOpen(const char* name, int nSlots, int slotDataSize, GvrsSharedTileCache** cacheReference) {
+	if (!cacheReference) {
+		return GVRSERR_NULL_ARGUMENT;
+	}
+	*cacheReference = 0;
+	int status = checkName(name);
+	if (status) {
+		return status;
+	}
+	if (nSlots <= 0 || slotDataSize <= 0) {
+		return GVRSERR_INVALID_PARAMETER;
+	}
+	nSlots = roundUp(nSlots, SHARED_CACHE_WAYS);
+	int slotStride = SHARED_CACHE_ALIGN + roundUp(slotDataSize, SHARED_CACHE_ALIGN);
+	int64_t segmentSize = SHARED_CACHE_ALIGN + (int64_t)nSlots * slotStride;
+
+	char shmName[80];
+	snprintf(shmName, sizeof(shmName), "/%s", name);
+
+	// The process that succeeds in creating the segment is responsible for
+	// initializing it.  Other processes wait for the initialization to complete.
+	// A newly created segment is filled with zeroes, so all slots are initially unused.
+	int created = 1;
+	int fd = shm_open(shmName, O_RDWR | O_CREAT | O_EXCL, 0666);
+	if (fd < 0 && errno == EEXIST) {
+		created = 0;
+		fd = shm_open(shmName, O_RDWR, 0);
+	}
+	if (fd < 0) {
+		return errno == EACCES ? GVRSERR_FILE_ACCESS : GVRSERR_FILE_ERROR;
+	}
+
+	int i;
+	if (created) {
+		if (ftruncate(fd, (off_t)segmentSize)) {
+			close(fd);
+			shm_unlink(shmName);
+			return GVRSERR_FILE_ERROR;
+		}
+	}
+	else {
+		struct stat sb;
+		segmentSize = 0;
+		for (i = 0; i < 1000; i++) {
+			if (fstat(fd, &sb) == 0 && sb.st_size > 0) {
+				segmentSize = (int64_t)sb.st_size;
+				break;
+			}
+			usleep(1000);
+		}
+		if (segmentSize < SHARED_CACHE_ALIGN) {
+			close(fd);
+			return GVRSERR_FILE_ERROR;
+		}
+	}
+
+	GvrsSharedHeader* header = mmap(NULL, (size_t)segmentSize, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	close(fd);
+	if (header == MAP_FAILED) {
+		if (created) {
+			shm_unlink(shmName);
+		}
+		return GVRSERR_FILE_ERROR;
+	}
+
+	if (created) {
+		initializeHeader(header, nSlots, slotDataSize, slotStride);
+	}
+	else {
+		for (i = 0; i < 1000 && !loadAcquire(&header->ready); i++) {
+			usleep(1000);
+		}
+		status = header->ready ? checkHeader(header) : GVRSERR_FILE_ERROR;
+		if (!status && segmentSize < SHARED_CACHE_ALIGN + (int64_t)header->nSlots * header->slotStride) {
+			status = GVRSERR_INVALID_FILE;
+		}
+		if (status) {
+			munmap(header, (size_t)segmentSize);
+			return status;
+		}
+	}
+
+	GvrsSharedTileCache* cache = calloc(1, sizeof(GvrsSharedTileCache));
+	if (!cache) {
+		munmap(header, (size_t)segmentSize);
+		return GVRSERR_NOMEM;
+	}
+	GvrsStrncpy(cache->name, sizeof(cache->name), name);
+	cache->nSlots = header->nSlots;
+	cache->slotDataSize = header->slotDataSize;
+	cache->segmentSize = segmentSize;
+	cache->segment = header;
+	*cacheReference = cache;
+	return 0;
+}
+
+GvrsSharedTileCache* GvrsSharedTileCacheClose(GvrsSharedTileCache* cache) {
+	if (cache) {
+		munmap(cache->segment, (size_t)cache->segmentSize);
+		memset(cache, 0, sizeof(GvrsSharedTileCache));
+		free(cache);
+	}
+	return 0;
+}
+
+int GvrsSharedTileCacheRemove(const char* name) {
+	int status = checkName(name);
+	if (status) {
+		return status;
+	}
+	char shmName[80];
+	snprintf(shmName, sizeof(shmName), "/%s", name);
+	if (shm_unlink(shmName)) {
+		return errno == ENOENT ? GVRSERR_FILENOTFOUND : GVRSERR_FILE_ERROR;
+	}
+	return 0;
+}
+
+#endif
+
+
+int GvrsSetSharedTileCache(Gvrs* gvrs, GvrsSharedTileCache* cache) {
+	if (!gvrs) {
+		return GVRSERR_NULL_ARGUMENT;
+	}
+	if (cache) {
+		if (gvrs->timeOpenedForWritingMS) {
+			// the content of the tiles may change, so they cannot be shared
+			return GVRSERR_INVALID_PARAMETER;
+		}
+		if (cache->slotDataSize < gvrs->nBytesForTileData) {
+			return GVRSERR_INVALID_PARAMETER;
+		}
+	}
+	gvrs->sharedTileCache = cache;
+	return 0;
+}
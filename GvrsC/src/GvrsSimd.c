@@ -0,0 +1,136 @@
+/* --------------------------------------------------------------------
+ *
+ * The MIT License
+ *
+ * Copyright (C) 2024  Gary W. Lucas.
+
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ * ---------------------------------------------------------------------
+ */
+
+// Development Note:
+//    The kernel variant is chosen once per process.  The selection is stored
+// with atomic operations where the compiler provides them so that concurrent
+// first calls (for example, from several threads opening files) are well defined.
+// Every thread computes the same answer, so there is no need for a lock.
+
+#include "GvrsFramework.h"
+
+#include "Gvrs.h"
+#include "GvrsSimd.h"
+#include "GvrsError.h"
+
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <intrin.h>
+#endif
+
+static const GvrsSimdKernels* selectedKernels;
+
+static const GvrsSimdKernels* loadSelected(void) {
+#if defined(__GNUC__) || defined(__clang__)
+	return __atomic_load_n(&selectedKernels, __ATOMIC_ACQUIRE);
+#else
+	return *(const GvrsSimdKernels* volatile*)&selectedKernels;
+#endif
+}
+
+static void storeSelected(const GvrsSimdKernels* kernels) {
+#if defined(__GNUC__) || defined(__clang__)
+	__atomic_store_n(&selectedKernels, kernels, __ATOMIC_RELEASE);
+#else
+	*(const GvrsSimdKernels* volatile*)&selectedKernels = kernels;
+#endif
+}
+
+static GvrsSimdLevel detectProcessorLevel(void) {
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+	__builtin_cpu_init();
+	if (__builtin_cpu_supports("avx2")) {
+		return GvrsSimdLevelAvx2;
+	}
+	if (__builtin_cpu_supports("sse4.1")) {
+		return GvrsSimdLevelSse41;
+	}
+	return GvrsSimdLevelScalar;
+#elif defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+	int info[4];
+	__cpuid(info, 0);
+	int nIds = info[0];
+	__cpuid(info, 1);
+	int sse41 = (info[2] & (1 << 19)) != 0;
+	int osxsave = (info[2] & (1 << 27)) != 0;
+	int avx = (info[2] & (1 << 28)) != 0;
+	if (nIds >= 7 && osxsave && avx && (_xgetbv(0) & 6) == 6) {
+		// the operating system saves the YMM registers
+		__cpuidex(info, 7, 0);
+		if (info[1] & (1 << 5)) {
+			return GvrsSimdLevelAvx2;
+		}
+	}
+	return sse41 ? GvrsSimdLevelSse41 : GvrsSimdLevelScalar;
+#else
+	return GvrsSimdLevelScalar;
+#endif
+}
+
+static const GvrsSimdKernels* getVariant(GvrsSimdLevel level) {
+	switch (level) {
+	case GvrsSimdLevelAvx2:
+		return GvrsSimdKernelsAvx2();
+	case GvrsSimdLevelSse41:
+		return GvrsSimdKernelsSse41();
+	default:
+		return GvrsSimdKernelsScalar();
+	}
+}
+
+GvrsSimdLevel GvrsSimdGetSupportedLevel(void) {
+	int level = (int)detectProcessorLevel();
+	while (level > GvrsSimdLevelScalar && !getVariant((GvrsSimdLevel)level)) {
+		level--;
+	}
+	return (GvrsSimdLevel)level;
+}
+
+void GvrsSimdInit(void) {
+	if (!loadSelected()) {
+		storeSelected(getVariant(GvrsSimdGetSupportedLevel()));
+	}
+}
+
+const GvrsSimdKernels* GvrsSimdGetKernels(void) {
+	const GvrsSimdKernels* kernels = loadSelected();
+	if (!kernels) {
+		GvrsSimdInit();
+		kernels = loadSelected();
+	}
+	return kernels;
+}
+
+int GvrsSimdSetLevel(GvrsSimdLevel level) {
+	if ((int)level < GvrsSimdLevelScalar || level > GvrsSimdGetSupportedLevel()) {
+		return GVRSERR_INVALID_PARAMETER;
+	}
+	const GvrsSimdKernels* kernels = getVariant(level);
+	if (!kernels) {
+		return GVRSERR_INVALID_PARAMETER;
+	}
+	storeSelected(kernels);
+	return 0;
+}
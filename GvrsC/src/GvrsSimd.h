@@ -0,0 +1,152 @@
+/* --------------------------------------------------------------------
+ *
+ * The MIT License
+ *
+ * Copyright (C) 2024  Gary W. Lucas.
+
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ * ---------------------------------------------------------------------
+ */
+
+#include "GvrsFramework.h"
+
+#ifndef GVRS_SIMD_H
+#define GVRS_SIMD_H
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+// Internal header for the kernels that are compiled for specific instruction sets.
+// Each variant is implemented in its own translation unit (GvrsSimdScalar.c,
+// GvrsSimdSse41.c, GvrsSimdAvx2.c) so that only that file is built with the
+// corresponding compiler options.  The best variant supported by the host
+// processor is selected at run time.
+
+// The range used to clamp ICF codes before they are converted to integers.
+// The upper bound is the largest float that is less than 2^31.
+#define GVRS_SIMD_ICF_MIN (-2147483648.0f)
+#define GVRS_SIMD_ICF_MAX 2147483520.0f
+
+/**
+* Identifies the instruction-set variants of the kernels.
+*/
+typedef enum {
+	GvrsSimdLevelScalar = 0,
+	GvrsSimdLevelSse41 = 1,
+	GvrsSimdLevelAvx2 = 2
+} GvrsSimdLevel;
+
+/**
+* A table of kernel functions for one instruction-set variant.  All functions
+* accept arbitrary counts and unaligned arrays.
+*/
+typedef struct GvrsSimdKernelsTag {
+	GvrsSimdLevel level;
+	const char* name;
+
+	/**
+	* Sets every value in an array of 32-bit integers (or, by bit pattern, floats).
+	*/
+	void (*fillInt32)(int32_t* data, int nValues, int32_t value);
+
+	/**
+	* Sets every value in an array of 16-bit integers.
+	*/
+	void (*fillInt16)(int16_t* data, int nValues, int16_t value);
+
+	/**
+	* Splits the bit patterns of floating-point values into byte planes: the 8 bits
+	* of the exponent, the high 7 bits of the mantissa, the middle 8 bits, and the low 8 bits.
+	* The sign bits are not included.
+	*/
+	void (*splitFloatBytes)(int nValues, const float* data,
+		uint8_t* sEx, uint8_t* sM1, uint8_t* sM2, uint8_t* sM3);
+
+	/**
+	* Combines byte planes produced by splitFloatBytes into floating-point bit patterns.
+	* The result is combined with the existing content of the output array using a
+	* bitwise OR, so that the output may be pre-populated with the sign bits.
+	*/
+	void (*mergeFloatBytes)(int nValues,
+		const uint8_t* sEx, const uint8_t* sM1, const uint8_t* sM2, const uint8_t* sM3,
+		uint32_t* rawInt);
+
+	/**
+	* Converts integer codes from an integer-coded-float (ICF) element to floating-point
+	* values using value = code * inverseScale + offset.  Codes equal to the integer
+	* fill value are mapped to the floating-point fill value (usually a NaN).
+	*/
+	void (*icfToFloat)(int nValues, const int32_t* codes, float inverseScale, float offset,
+		int32_t iFillValue, float fillValue, float* values);
+
+	/**
+	* Converts floating-point values to the integer codes for an ICF element using
+	* code = floor((value - offset) * scale + 0.5).  NaNs and values equal to the
+	* floating-point fill value are mapped to the integer fill value.  Results that
+	* are outside the range of a 32-bit integer are clamped.
+	*/
+	void (*floatToIcf)(int nValues, const float* values, float scale, float offset,
+		int32_t iFillValue, float fillValue, int32_t* codes);
+} GvrsSimdKernels;
+
+/**
+* Detects the instruction sets supported by the host processor and selects
+* the kernel variant.  Called by GvrsOpen and the builder; it is safe to call
+* more than once.
+*/
+void GvrsSimdInit(void);
+
+/**
+* Gets the kernel table selected for the host processor, performing the
+* detection if necessary.
+* @return a valid reference.
+*/
+const GvrsSimdKernels* GvrsSimdGetKernels(void);
+
+/**
+* Gets the highest kernel variant that is both compiled into the library and
+* supported by the host processor.
+* @return a valid level.
+*/
+GvrsSimdLevel GvrsSimdGetSupportedLevel(void);
+
+/**
+* Selects a specific kernel variant.  Intended for testing and benchmarking.
+* @param level the kernel variant.
+* @return zero if successful; GVRSERR_INVALID_PARAMETER if the variant is
+* not available on the host processor.
+*/
+int GvrsSimdSetLevel(GvrsSimdLevel level);
+
+/**
+* Gets the kernel table for a specific variant.  These functions are implemented
+* in the per-instruction-set translation units.
+* @return a valid reference; or a null if the variant was not compiled.
+*/
+const GvrsSimdKernels* GvrsSimdKernelsScalar(void);
+const GvrsSimdKernels* GvrsSimdKernelsSse41(void);
+const GvrsSimdKernels* GvrsSimdKernelsAvx2(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
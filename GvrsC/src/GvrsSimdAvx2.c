@@ -0,0 +1,172 @@
+/* --------------------------------------------------------------------
+ *
+ * The MIT License
+ *
+ * Copyright (C) 2024  Gary W. Lucas.
+
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ * ---------------------------------------------------------------------
+ */
+
+// Development Note:
+//    This file is compiled with AVX2 enabled (see CMakeLists.txt).  Its
+// functions must only be called after the dispatch logic in GvrsSimd.c has
+// confirmed that the processor and operating system support AVX2.
+// When the compiler does not target AVX2, the file provides no kernels.
+
+#include "GvrsFramework.h"
+
+#include "GvrsSimd.h"
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+
+static void fillInt32(int32_t* data, int nValues, int32_t value) {
+	__m256i v = _mm256_set1_epi32(value);
+	int i = 0;
+	for (; i + 8 <= nValues; i += 8) {
+		_mm256_storeu_si256((__m256i*)(data + i), v);
+	}
+	for (; i < nValues; i++) {
+		data[i] = value;
+	}
+}
+
+static void fillInt16(int16_t* data, int nValues, int16_t value) {
+	__m256i v = _mm256_set1_epi16(value);
+	int i = 0;
+	for (; i + 16 <= nValues; i += 16) {
+		_mm256_storeu_si256((__m256i*)(data + i), v);
+	}
+	for (; i < nValues; i++) {
+		data[i] = value;
+	}
+}
+
+// Extracts one byte plane from 32 bit patterns.  The AVX2 pack instructions
+// operate within 128-bit lanes, so the result is reordered by 32-bit groups.
+static __m256i plane32(__m256i a, __m256i b, __m256i c, __m256i d, int shift, __m256i mask, __m256i order) {
+	a = _mm256_and_si256(_mm256_srli_epi32(a, shift), mask);
+	b = _mm256_and_si256(_mm256_srli_epi32(b, shift), mask);
+	c = _mm256_and_si256(_mm256_srli_epi32(c, shift), mask);
+	d = _mm256_and_si256(_mm256_srli_epi32(d, shift), mask);
+	__m256i p = _mm256_packus_epi16(_mm256_packs_epi32(a, b), _mm256_packs_epi32(c, d));
+	return _mm256_permutevar8x32_epi32(p, order);
+}
+
+static void splitFloatBytes(int nValues, const float* data,
+	uint8_t* sEx, uint8_t* sM1, uint8_t* sM2, uint8_t* sM3) {
+	const uint32_t* bits = (const uint32_t*)data;
+	__m256i m8 = _mm256_set1_epi32(0xff);
+	__m256i m7 = _mm256_set1_epi32(0x7f);
+	__m256i order = _mm256_setr_epi32(0, 4, 1, 5, 2, 6, 3, 7);
+	int i = 0;
+	for (; i + 32 <= nValues; i += 32) {
+		__m256i a = _mm256_loadu_si256((const __m256i*)(bits + i));
+		__m256i b = _mm256_loadu_si256((const __m256i*)(bits + i + 8));
+		__m256i c = _mm256_loadu_si256((const __m256i*)(bits + i + 16));
+		__m256i d = _mm256_loadu_si256((const __m256i*)(bits + i + 24));
+		_mm256_storeu_si256((__m256i*)(sEx + i), plane32(a, b, c, d, 23, m8, order));
+		_mm256_storeu_si256((__m256i*)(sM1 + i), plane32(a, b, c, d, 16, m7, order));
+		_mm256_storeu_si256((__m256i*)(sM2 + i), plane32(a, b, c, d, 8, m8, order));
+		_mm256_storeu_si256((__m256i*)(sM3 + i), plane32(a, b, c, d, 0, m8, order));
+	}
+	GvrsSimdKernelsScalar()->splitFloatBytes(nValues - i, data + i, sEx + i, sM1 + i, sM2 + i, sM3 + i);
+}
+
+static __m256i loadBytesAsInt32(const uint8_t* p) {
+	return _mm256_cvtepu8_epi32(_mm_loadl_epi64((const __m128i*)p));
+}
+
+static void mergeFloatBytes(int nValues,
+	const uint8_t* sEx, const uint8_t* sM1, const uint8_t* sM2, const uint8_t* sM3,
+	uint32_t* rawInt) {
+	__m256i m7 = _mm256_set1_epi32(0x7f);
+	int i = 0;
+	for (; i + 8 <= nValues; i += 8) {
+		__m256i ex = _mm256_slli_epi32(loadBytesAsInt32(sEx + i), 23);
+		__m256i m1 = _mm256_slli_epi32(_mm256_and_si256(loadBytesAsInt32(sM1 + i), m7), 16);
+		__m256i m2 = _mm256_slli_epi32(loadBytesAsInt32(sM2 + i), 8);
+		__m256i m3 = loadBytesAsInt32(sM3 + i);
+		__m256i r = _mm256_loadu_si256((const __m256i*)(rawInt + i));
+		r = _mm256_or_si256(r, _mm256_or_si256(_mm256_or_si256(ex, m1), _mm256_or_si256(m2, m3)));
+		_mm256_storeu_si256((__m256i*)(rawInt + i), r);
+	}
+	GvrsSimdKernelsScalar()->mergeFloatBytes(nValues - i, sEx + i, sM1 + i, sM2 + i, sM3 + i, rawInt + i);
+}
+
+static void icfToFloat(int nValues, const int32_t* codes, float inverseScale, float offset,
+	int32_t iFillValue, float fillValue, float* values) {
+	__m256 vScale = _mm256_set1_ps(inverseScale);
+	__m256 vOffset = _mm256_set1_ps(offset);
+	__m256 vFill = _mm256_set1_ps(fillValue);
+	__m256i vIFill = _mm256_set1_epi32(iFillValue);
+	int i = 0;
+	for (; i + 8 <= nValues; i += 8) {
+		__m256i c = _mm256_loadu_si256((const __m256i*)(codes + i));
+		__m256 f = _mm256_add_ps(_mm256_mul_ps(_mm256_cvtepi32_ps(c), vScale), vOffset);
+		__m256 isFill = _mm256_castsi256_ps(_mm256_cmpeq_epi32(c, vIFill));
+		_mm256_storeu_ps(values + i, _mm256_blendv_ps(f, vFill, isFill));
+	}
+	GvrsSimdKernelsScalar()->icfToFloat(nValues - i, codes + i, inverseScale, offset, iFillValue, fillValue, values + i);
+}
+
+static void floatToIcf(int nValues, const float* values, float scale, float offset,
+	int32_t iFillValue, float fillValue, int32_t* codes) {
+	__m256 vScale = _mm256_set1_ps(scale);
+	__m256 vOffset = _mm256_set1_ps(offset);
+	__m256 vHalf = _mm256_set1_ps(0.5f);
+	__m256 vMin = _mm256_set1_ps(GVRS_SIMD_ICF_MIN);
+	__m256 vMax = _mm256_set1_ps(GVRS_SIMD_ICF_MAX);
+	__m256 vFill = _mm256_set1_ps(fillValue);
+	__m256i vIFill = _mm256_set1_epi32(iFillValue);
+	int i = 0;
+	for (; i + 8 <= nValues; i += 8) {
+		__m256 v = _mm256_loadu_ps(values + i);
+		__m256 t = _mm256_floor_ps(_mm256_add_ps(_mm256_mul_ps(_mm256_sub_ps(v, vOffset), vScale), vHalf));
+		t = _mm256_min_ps(_mm256_max_ps(t, vMin), vMax);
+		__m256 isFill = _mm256_or_ps(_mm256_cmp_ps(v, v, _CMP_UNORD_Q), _mm256_cmp_ps(v, vFill, _CMP_EQ_OQ));
+		__m256i c = _mm256_blendv_epi8(_mm256_cvttps_epi32(t), vIFill, _mm256_castps_si256(isFill));
+		_mm256_storeu_si256((__m256i*)(codes + i), c);
+	}
+	GvrsSimdKernelsScalar()->floatToIcf(nValues - i, values + i, scale, offset, iFillValue, fillValue, codes + i);
+}
+
+static const GvrsSimdKernels kernels = {
+	GvrsSimdLevelAvx2,
+	"avx2",
+	fillInt32,
+	fillInt16,
+	splitFloatBytes,
+	mergeFloatBytes,
+	icfToFloat,
+	floatToIcf
+};
+
+const GvrsSimdKernels* GvrsSimdKernelsAvx2(void) {
+	return &kernels;
+}
+
+#else
+
+const GvrsSimdKernels* GvrsSimdKernelsAvx2(void) {
+	return 0;
+}
+
+#endif
@@ -0,0 +1,117 @@
+/* --------------------------------------------------------------------
+ *
+ * The MIT License
+ *
+ * Copyright (C) 2024  Gary W. Lucas.
+
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ * ---------------------------------------------------------------------
+ */
+
+// Development Note:
+//    The scalar kernels are the reference implementations.  They are used on
+// processors (or compilers) for which no other variant is available and
+// they process the remainders of arrays for the vector variants.
+
+#include "GvrsFramework.h"
+#include <math.h>
+
+#include "GvrsSimd.h"
+
+static void fillInt32(int32_t* data, int nValues, int32_t value) {
+	for (int i = 0; i < nValues; i++) {
+		data[i] = value;
+	}
+}
+
+static void fillInt16(int16_t* data, int nValues, int16_t value) {
+	for (int i = 0; i < nValues; i++) {
+		data[i] = value;
+	}
+}
+
+static void splitFloatBytes(int nValues, const float* data,
+	uint8_t* sEx, uint8_t* sM1, uint8_t* sM2, uint8_t* sM3) {
+	const uint32_t* bits = (const uint32_t*)data;
+	for (int i = 0; i < nValues; i++) {
+		uint32_t b = bits[i];
+		sEx[i] = (uint8_t)((b >> 23) & 0xff);
+		sM1[i] = (uint8_t)((b >> 16) & 0x7f);
+		sM2[i] = (uint8_t)((b >> 8) & 0xff);
+		sM3[i] = (uint8_t)(b & 0xff);
+	}
+}
+
+static void mergeFloatBytes(int nValues,
+	const uint8_t* sEx, const uint8_t* sM1, const uint8_t* sM2, const uint8_t* sM3,
+	uint32_t* rawInt) {
+	for (int i = 0; i < nValues; i++) {
+		rawInt[i] |= ((uint32_t)sEx[i] << 23)
+			| ((uint32_t)(sM1[i] & 0x7f) << 16)
+			| ((uint32_t)sM2[i] << 8)
+			| (uint32_t)sM3[i];
+	}
+}
+
+static void icfToFloat(int nValues, const int32_t* codes, float inverseScale, float offset,
+	int32_t iFillValue, float fillValue, float* values) {
+	for (int i = 0; i < nValues; i++) {
+		int32_t code = codes[i];
+		if (code == iFillValue) {
+			values[i] = fillValue;
+		}
+		else {
+			values[i] = (float)code * inverseScale + offset;
+		}
+	}
+}
+
+static void floatToIcf(int nValues, const float* values, float scale, float offset,
+	int32_t iFillValue, float fillValue, int32_t* codes) {
+	for (int i = 0; i < nValues; i++) {
+		float v = values[i];
+		if (isnan(v) || v == fillValue) {
+			codes[i] = iFillValue;
+			continue;
+		}
+		float t = floorf((v - offset) * scale + 0.5f);
+		if (t < GVRS_SIMD_ICF_MIN) {
+			t = GVRS_SIMD_ICF_MIN;
+		}
+		else if (t > GVRS_SIMD_ICF_MAX) {
+			t = GVRS_SIMD_ICF_MAX;
+		}
+		codes[i] = (int32_t)t;
+	}
+}
+
+static const GvrsSimdKernels kernels = {
+	GvrsSimdLevelScalar,
+	"scalar",
+	fillInt32,
+	fillInt16,
+	splitFloatBytes,
+	mergeFloatBytes,
+	icfToFloat,
+	floatToIcf
+};
+
+const GvrsSimdKernels* GvrsSimdKernelsScalar(void) {
+	return &kernels;
+}
@@ -0,0 +1,173 @@
+/* --------------------------------------------------------------------
+ *
+ * The MIT License
+ *
+ * Copyright (C) 2024  Gary W. Lucas.
+
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ * ---------------------------------------------------------------------
+ */
+
+// Development Note:
+//    This file is compiled with SSE4.1 enabled (see CMakeLists.txt).  Its
+// functions must only be called after the dispatch logic in GvrsSimd.c has
+// confirmed that the processor supports SSE4.1. When the compiler does not
+// target x86 processors, the file provides no kernels.
+
+#include "GvrsFramework.h"
+
+#include "GvrsSimd.h"
+
+#if defined(__SSE4_1__) || (defined(_MSC_VER) && (defined(_M_X64) || defined(_M_AMD64)))
+#include <smmintrin.h>
+
+static void fillInt32(int32_t* data, int nValues, int32_t value) {
+	__m128i v = _mm_set1_epi32(value);
+	int i = 0;
+	for (; i + 4 <= nValues; i += 4) {
+		_mm_storeu_si128((__m128i*)(data + i), v);
+	}
+	for (; i < nValues; i++) {
+		data[i] = value;
+	}
+}
+
+static void fillInt16(int16_t* data, int nValues, int16_t value) {
+	__m128i v = _mm_set1_epi16(value);
+	int i = 0;
+	for (; i + 8 <= nValues; i += 8) {
+		_mm_storeu_si128((__m128i*)(data + i), v);
+	}
+	for (; i < nValues; i++) {
+		data[i] = value;
+	}
+}
+
+// Extracts one byte plane from 16 bit patterns, shifting and masking
+// each 32-bit value and then narrowing to bytes.  The values are at most 255,
+// so the signed 32-to-16 pack does not saturate.
+static __m128i plane16(__m128i a, __m128i b, __m128i c, __m128i d, int shift, __m128i mask) {
+	a = _mm_and_si128(_mm_srli_epi32(a, shift), mask);
+	b = _mm_and_si128(_mm_srli_epi32(b, shift), mask);
+	c = _mm_and_si128(_mm_srli_epi32(c, shift), mask);
+	d = _mm_and_si128(_mm_srli_epi32(d, shift), mask);
+	return _mm_packus_epi16(_mm_packs_epi32(a, b), _mm_packs_epi32(c, d));
+}
+
+static void splitFloatBytes(int nValues, const float* data,
+	uint8_t* sEx, uint8_t* sM1, uint8_t* sM2, uint8_t* sM3) {
+	const uint32_t* bits = (const uint32_t*)data;
+	__m128i m8 = _mm_set1_epi32(0xff);
+	__m128i m7 = _mm_set1_epi32(0x7f);
+	int i = 0;
+	for (; i + 16 <= nValues; i += 16) {
+		__m128i a = _mm_loadu_si128((const __m128i*)(bits + i));
+		__m128i b = _mm_loadu_si128((const __m128i*)(bits + i + 4));
+		__m128i c = _mm_loadu_si128((const __m128i*)(bits + i + 8));
+		__m128i d = _mm_loadu_si128((const __m128i*)(bits + i + 12));
+		_mm_storeu_si128((__m128i*)(sEx + i), plane16(a, b, c, d, 23, m8));
+		_mm_storeu_si128((__m128i*)(sM1 + i), plane16(a, b, c, d, 16, m7));
+		_mm_storeu_si128((__m128i*)(sM2 + i), plane16(a, b, c, d, 8, m8));
+		_mm_storeu_si128((__m128i*)(sM3 + i), plane16(a, b, c, d, 0, m8));
+	}
+	GvrsSimdKernelsScalar()->splitFloatBytes(nValues - i, data + i, sEx + i, sM1 + i, sM2 + i, sM3 + i);
+}
+
+static __m128i loadBytesAsInt32(const uint8_t* p) {
+	int32_t v;
+	memcpy(&v, p, 4);
+	return _mm_cvtepu8_epi32(_mm_cvtsi32_si128(v));
+}
+
+static void mergeFloatBytes(int nValues,
+	const uint8_t* sEx, const uint8_t* sM1, const uint8_t* sM2, const uint8_t* sM3,
+	uint32_t* rawInt) {
+	__m128i m7 = _mm_set1_epi32(0x7f);
+	int i = 0;
+	for (; i + 4 <= nValues; i += 4) {
+		__m128i ex = _mm_slli_epi32(loadBytesAsInt32(sEx + i), 23);
+		__m128i m1 = _mm_slli_epi32(_mm_and_si128(loadBytesAsInt32(sM1 + i), m7), 16);
+		__m128i m2 = _mm_slli_epi32(loadBytesAsInt32(sM2 + i), 8);
+		__m128i m3 = loadBytesAsInt32(sM3 + i);
+		__m128i r = _mm_loadu_si128((const __m128i*)(rawInt + i));
+		r = _mm_or_si128(r, _mm_or_si128(_mm_or_si128(ex, m1), _mm_or_si128(m2, m3)));
+		_mm_storeu_si128((__m128i*)(rawInt + i), r);
+	}
+	GvrsSimdKernelsScalar()->mergeFloatBytes(nValues - i, sEx + i, sM1 + i, sM2 + i, sM3 + i, rawInt + i);
+}
+
+static void icfToFloat(int nValues, const int32_t* codes, float inverseScale, float offset,
+	int32_t iFillValue, float fillValue, float* values) {
+	__m128 vScale = _mm_set1_ps(inverseScale);
+	__m128 vOffset = _mm_set1_ps(offset);
+	__m128 vFill = _mm_set1_ps(fillValue);
+	__m128i vIFill = _mm_set1_epi32(iFillValue);
+	int i = 0;
+	for (; i + 4 <= nValues; i += 4) {
+		__m128i c = _mm_loadu_si128((const __m128i*)(codes + i));
+		__m128 f = _mm_add_ps(_mm_mul_ps(_mm_cvtepi32_ps(c), vScale), vOffset);
+		__m128 isFill = _mm_castsi128_ps(_mm_cmpeq_epi32(c, vIFill));
+		_mm_storeu_ps(values + i, _mm_blendv_ps(f, vFill, isFill));
+	}
+	GvrsSimdKernelsScalar()->icfToFloat(nValues - i, codes + i, inverseScale, offset, iFillValue, fillValue, values + i);
+}
+
+static void floatToIcf(int nValues, const float* values, float scale, float offset,
+	int32_t iFillValue, float fillValue, int32_t* codes) {
+	__m128 vScale = _mm_set1_ps(scale);
+	__m128 vOffset = _mm_set1_ps(offset);
+	__m128 vHalf = _mm_set1_ps(0.5f);
+	__m128 vMin = _mm_set1_ps(GVRS_SIMD_ICF_MIN);
+	__m128 vMax = _mm_set1_ps(GVRS_SIMD_ICF_MAX);
+	__m128 vFill = _mm_set1_ps(fillValue);
+	__m128i vIFill = _mm_set1_epi32(iFillValue);
+	int i = 0;
+	for (; i + 4 <= nValues; i += 4) {
+		__m128 v = _mm_loadu_ps(values + i);
+		__m128 t = _mm_floor_ps(_mm_add_ps(_mm_mul_ps(_mm_sub_ps(v, vOffset), vScale), vHalf));
+		t = _mm_min_ps(_mm_max_ps(t, vMin), vMax);
+		__m128 isFill = _mm_or_ps(_mm_cmpunord_ps(v, v), _mm_cmpeq_ps(v, vFill));
+		__m128i c = _mm_blendv_epi8(_mm_cvttps_epi32(t), vIFill, _mm_castps_si128(isFill));
+		_mm_storeu_si128((__m128i*)(codes + i), c);
+	}
+	GvrsSimdKernelsScalar()->floatToIcf(nValues - i, values + i, scale, offset, iFillValue, fillValue, codes + i);
+}
+
+static const GvrsSimdKernels kernels = {
+	GvrsSimdLevelSse41,
+	"sse4.1",
+	fillInt32,
+	fillInt16,
+	splitFloatBytes,
+	mergeFloatBytes,
+	icfToFloat,
+	floatToIcf
+};
+
+const GvrsSimdKernels* GvrsSimdKernelsSse41(void) {
+	return &kernels;
+}
+
+#else
+
+const GvrsSimdKernels* GvrsSimdKernelsSse41(void) {
+	return 0;
+}
+
+#endif
@@ -0,0 +1,737 @@
+/* --------------------------------------------------------------------
+ *
+ * The MIT License
+ *
+ * Copyright (C) 2024  Gary W. Lucas.
+
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ * ---------------------------------------------------------------------
+ */
+
+// Development Note:
+//    Read operations are performed by a set of workers, each of which takes
+// members from a shared counter.  A worker acquires a handle for a member from
+// the pool, reads the cells of interest tile-by-tile, and releases the handle
+// before taking the next member.  The calling thread serves as worker zero.
+// Because each worker holds at most one handle at a time, the number of workers is
+// limited to the maximum number of handles permitted by the pool.
+//    The transcode operation processes the stack one row of tiles at a time.
+// If the row of tiles is too large to be buffered for all members, it is
+// processed in runs of tile columns.  The runs are read using the worker
+// mechanism described above (with the results stored in time-major order)
+// and then written to the output one tile at a time, so that the tiles
+// for a stack position are written to the output consecutively.
+
+#include "GvrsFramework.h"
+
+#include "GvrsPrimaryIo.h"
+#include "Gvrs.h"
+#include "GvrsInternal.h"
+#include "GvrsBuilder.h"
+#include "GvrsHandlePool.h"
+#include "GvrsStack.h"
+#include "GvrsError.h"
+
+#define STACK_DEFAULT_POOL_SIZE 256
+#define STACK_MEMBERS_PER_WORKER 16
+#define STACK_TRANSCODE_BUFFER_SIZE (64*1024*1024)
+#define STACK_LAYOUT_RECORD "GvrsStackLayout"
+#define STACK_MEMBER_RECORD "GvrsStackMember"
+
+typedef struct GvrsStackReadJobTag {
+	GvrsStack* stack;
+	int row0;
+	int col0;
+	int nRows;
+	int nCols;
+	int t0;
+	int nTimes;
+
+	// the results for member t0+t at block row r and column c are stored
+	// at values[r*rowStride + c*colStride + t*timeStride].  Integral elements
+	// may be read as integers, in which case the values are int32_t.
+	int readInt;
+	void* values;
+	int64_t rowStride;
+	int64_t colStride;
+	int64_t timeStride;
+
+	GvrsMutex* mutex;
+	int nextMember;
+	int status;
+}GvrsStackReadJob;
+
+
+static int takeMember(GvrsStackReadJob* job, int* t) {
+	int found = 0;
+	GvrsMutexLock(job->mutex);
+	if (!job->status && job->nextMember < job->nTimes) {
+		*t = job->nextMember++;
+		found = 1;
+	}
+	GvrsMutexUnlock(job->mutex);
+	return found;
+}
+
+static void setJobStatus(GvrsStackReadJob* job, int status) {
+	GvrsMutexLock(job->mutex);
+	if (!job->status) {
+		job->status = status;
+	}
+	GvrsMutexUnlock(job->mutex);
+}
+
+static int readMember(GvrsStackReadJob* job, GvrsElement* e, int t) {
+	GvrsStack* stack = job->stack;
+	int row1 = job->row0 + job->nRows;
+	int col1 = job->col0 + job->nCols;
+	int status;
+
+	// process the block one tile at a time so that each tile is fetched only once
+	int tileRow0 = job->row0 / stack->nRowsInTile;
+	int tileRow1 = (row1 - 1) / stack->nRowsInTile;
+	int tileCol0 = job->col0 / stack->nColsInTile;
+	int tileCol1 = (col1 - 1) / stack->nColsInTile;
+	int tileRow, tileCol;
+
+	// floating-point values are read in bulk, one tile at a time, into a scratch
+	// buffer and then scattered to the output using the job's strides.
+	float* scratch = 0;
+	if (!job->readInt) {
+		scratch = malloc((size_t)stack->nRowsInTile * (size_t)stack->nColsInTile * sizeof(float));
+		if (!scratch) {
+			return GVRSERR_NOMEM;
+		}
+	}
+	for (tileRow = tileRow0; tileRow <= tileRow1; tileRow++) {
+		int r0 = tileRow * stack->nRowsInTile;
+		int r1 = r0 + stack->nRowsInTile;
+		if (r0 < job->row0) {
+			r0 = job->row0;
+		}
+		if (r1 > row1) {
+			r1 = row1;
+		}
+		for (tileCol = tileCol0; tileCol <= tileCol1; tileCol++) {
+			int c0 = tileCol * stack->nColsInTile;
+			int c1 = c0 + stack->nColsInTile;
+			if (c0 < job->col0) {
+				c0 = job->col0;
+			}
+			if (c1 > col1) {
+				c1 = col1;
+			}
+			int row, col;
+			if (scratch) {
+				status = GvrsElementReadBlockFloat(e, r0, c0, r1 - r0, c1 - c0, scratch);
+				if (status) {
+					free(scratch);
+					return status;
+				}
+				const float* v = scratch;
+				for (row = r0; row < r1; row++) {
+					float* p = (float*)job->values + (row - job->row0) * job->rowStride + t * job->timeStride;
+					for (col = c0; col < c1; col++) {
+						p[(col - job->col0) * job->colStride] = *v++;
+					}
+				}
+				continue;
+			}
+			for (row = r0; row < r1; row++) {
+				int64_t index = (row - job->row0) * job->rowStride + t * job->timeStride;
+				for (col = c0; col < c1; col++) {
+					int64_t k = index + (col - job->col0) * job->colStride;
+					status = GvrsElementReadInt(e, row, col, (int32_t*)job->values + k);
+					if (status) {
+						return status;
+					}
+				}
+			}
+		}
+	}
+	free(scratch);
+	return 0;
+}
+
+static int runWorker(void* argument) {
+	GvrsStackReadJob* job = (GvrsStackReadJob*)argument;
+	GvrsStack* stack = job->stack;
+	int t;
+	while (takeMember(job, &t)) {
+		Gvrs* gvrs;
+		int status = GvrsHandlePoolAcquire(stack->pool, stack->members[job->t0 + t], &gvrs);
+		if (!status) {
+			GvrsElement* e = GvrsGetElementByName(gvrs, stack->elementName);
+			if (e) {
+				status = readMember(job, e, t);
+			}
+			else {
+				status = GVRSERR_ELEMENT_NOT_FOUND;
+			}
+			GvrsHandlePoolRelease(stack->pool, gvrs);
+		}
+		if (status) {
+			setJobStatus(job, status);
+			return status;
+		}
+	}
+	return 0;
+}
+
+static int runJob(GvrsStackReadJob* job) {
+	GvrsStack* stack = job->stack;
+	int nWorkers = stack->nThreads > 0 ? stack->nThreads : GvrsGetProcessorCount();
+	int nNeeded = (job->nTimes + STACK_MEMBERS_PER_WORKER - 1) / STACK_MEMBERS_PER_WORKER;
+	if (nWorkers > nNeeded) {
+		nWorkers = nNeeded;
+	}
+	if (nWorkers > stack->pool->maxOpenHandles) {
+		nWorkers = stack->pool->maxOpenHandles;
+	}
+	if (nWorkers < 1) {
+		nWorkers = 1;
+	}
+
+	job->nextMember = 0;
+	job->status = 0;
+	int status = GvrsMutexInit(&job->mutex);
+	if (status) {
+		return status;
+	}
+	GvrsThread** threads = 0;
+	if (nWorkers > 1) {
+		threads = calloc((size_t)nWorkers, sizeof(GvrsThread*));
+		if (!threads) {
+			GvrsMutexFree(job->mutex);
+			return GVRSERR_NOMEM;
+		}
+	}
+
+	int i;
+	for (i = 1; i < nWorkers; i++) {
+		if (GvrsThreadStart(threads + i, runWorker, job)) {
+			// the members will be processed by the workers that did start
+			break;
+		}
+	}
+	runWorker(job);
+	for (i = 1; i < nWorkers; i++) {
+		if (threads[i]) {
+			GvrsThreadJoin(threads[i]);
+		}
+	}
+	free(threads);
+	GvrsMutexFree(job->mutex);
+	job->mutex = 0;
+	return job->status;
+}
+
+static int checkRange(GvrsStack* stack, int row0, int col0, int nRows, int nCols, int t0, int nTimes) {
+	if (nRows < 1 || nCols < 1 || nTimes < 1) {
+		return GVRSERR_INVALID_PARAMETER;
+	}
+	if (row0 < 0 || col0 < 0 || t0 < 0
+		|| row0 > stack->nRowsInRaster - nRows
+		|| col0 > stack->nColsInRaster - nCols
+		|| t0 > stack->nMembers - nTimes) {
+		return GVRSERR_COORDINATE_OUT_OF_BOUNDS;
+	}
+	return 0;
+}
+
+
+int GvrsStackAlloc(GvrsHandlePool* pool, const char* elementName, GvrsStack** stackReference) {
+	if (!elementName || !stackReference) {
+		return GVRSERR_NULL_ARGUMENT;
+	}
+	*stackReference = 0;
+	if (!elementName[0] || strlen(elementName) > GVRS_ELEMENT_NAME_SZ) {
+		return GVRSERR_BAD_NAME_SPECIFICATION;
+	}
+	GvrsStack* stack = calloc(1, sizeof(GvrsStack));
+	if (!stack) {
+		return GVRSERR_NOMEM;
+	}
+	GvrsStrncpy(stack->elementName, sizeof(stack->elementName), elementName);
+	if (pool) {
+		stack->pool = pool;
+	}
+	else {
+		int status = GvrsHandlePoolAlloc(STACK_DEFAULT_POOL_SIZE, 0, &stack->pool);
+		if (status) {
+			free(stack);
+			return status;
+		}
+		stack->poolIsOwned = 1;
+	}
+	*stackReference = stack;
+	return 0;
+}
+
+
+int GvrsStackAddFile(GvrsStack* stack, const char* path) {
+	if (!stack || !path) {
+		return GVRSERR_NULL_ARGUMENT;
+	}
+
+	// Each read visits the members in order.  If the pool cannot hold a handle for
+	// every member, the least-recently used handle is always the next one needed,
+	// so a repeated scan over all members would reopen every file.
+	if (stack->poolIsOwned && stack->pool->maxOpenHandles <= stack->nMembers) {
+		stack->pool->maxOpenHandles = stack->nMembers + 1;
+	}
+	Gvrs* gvrs;
+	int status = GvrsHandlePoolAcquire(stack->pool, path, &gvrs);
+	if (status) {
+		return status;
+	}
+	GvrsElement* element = GvrsGetElementByName(gvrs, stack->elementName);
+	if (!element) {
+		GvrsHandlePoolRelease(stack->pool, gvrs);
+		return GVRSERR_ELEMENT_NOT_FOUND;
+	}
+	if (stack->nMembers == 0) {
+		stack->nRowsInRaster = gvrs->nRowsInRaster;
+		stack->nColsInRaster = gvrs->nColsInRaster;
+		stack->nRowsInTile = gvrs->nRowsInTile;
+		stack->nColsInTile = gvrs->nColsInTile;
+		stack->elementType = element->elementType;
+	}
+	else if (gvrs->nRowsInRaster != stack->nRowsInRaster
+		|| gvrs->nColsInRaster != stack->nColsInRaster
+		|| gvrs->nRowsInTile != stack->nRowsInTile
+		|| gvrs->nColsInTile != stack->nColsInTile) {
+		GvrsHandlePoolRelease(stack->pool, gvrs);
+		return GVRSERR_BAD_RASTER_SPECIFICATION;
+	}
+	else if (element->elementType != stack->elementType) {
+		GvrsHandlePoolRelease(stack->pool, gvrs);
+		return GVRSERR_BAD_ELEMENT_SPEC;
+	}
+	GvrsHandlePoolRelease(stack->pool, gvrs);
+
+	if (stack->nMembers == stack->nMembersAllocated) {
+		int n = stack->nMembersAllocated ? stack->nMembersAllocated * 2 : 16;
+		char** p = realloc(stack->members, (size_t)n * sizeof(char*));
+		if (!p) {
+			return GVRSERR_NOMEM;
+		}
+		stack->members = p;
+		stack->nMembersAllocated = n;
+	}
+	size_t n = strlen(path) + 1;
+	char* s = malloc(n);
+	if (!s) {
+		return GVRSERR_NOMEM;
+	}
+	memcpy(s, path, n);
+	stack->members[stack->nMembers++] = s;
+	return 0;
+}
+
+
+int GvrsStackReadSeries(GvrsStack* stack, int row, int column, int t0, int nTimes, float* values) {
+	return GvrsStackReadBlock(stack, row, column, 1, 1, t0, nTimes, values);
+}
+
+
+int GvrsStackReadBlock(GvrsStack* stack, int row0, int col0, int nRows, int nCols, int t0, int nTimes, float* values) {
+	if (!stack || !values) {
+		return GVRSERR_NULL_ARGUMENT;
+	}
+	int status = checkRange(stack, row0, col0, nRows, nCols, t0, nTimes);
+	if (status) {
+		return status;
+	}
+	GvrsStackReadJob job;
+	memset(&job, 0, sizeof(job));
+	job.stack = stack;
+	job.row0 = row0;
+	job.col0 = col0;
+	job.nRows = nRows;
+	job.nCols = nCols;
+	job.t0 = t0;
+	job.nTimes = nTimes;
+	job.values = values;
+	job.timeStride = 1;
+	job.colStride = nTimes;
+	job.rowStride = (int64_t)nCols * nTimes;
+	return runJob(&job);
+}
+
+
+static void copyCoordinateSystem(Gvrs* source, GvrsBuilder* builder) {
+	builder->rasterSpaceCode = source->rasterSpaceCode;
+	builder->geographicCoordinates = source->geographicCoordinates;
+	builder->cellSizeX = source->cellSizeX;
+	builder->cellSizeY = source->cellSizeY;
+	builder->x0 = source->x0;
+	builder->y0 = source->y0;
+	builder->x1 = source->x1;
+	builder->y1 = source->y1;
+	builder->m2r = source->m2r;
+	builder->r2m = source->r2m;
+}
+
+static int openOutput(GvrsStack* stack, const char* path, GvrsStackLayout layout, int compress, Gvrs** output) {
+	*output = 0;
+	int nRowsOfTiles = (stack->nRowsInRaster + stack->nRowsInTile - 1) / stack->nRowsInTile;
+	int64_t nRows = stack->nRowsInRaster;
+	if (layout == GvrsStackLayoutInterleavedPlanes) {
+		nRows = (int64_t)nRowsOfTiles * stack->nMembers * stack->nRowsInTile;
+		if (nRows > INT32_MAX) {
+			return GVRSERR_BAD_RASTER_SPECIFICATION;
+		}
+	}
+
+	Gvrs* reference;
+	int status = GvrsHandlePoolAcquire(stack->pool, stack->members[0], &reference);
+	if (status) {
+		return status;
+	}
+	GvrsElement* element = GvrsGetElementByName(reference, stack->elementName);
+	if (!element) {
+		GvrsHandlePoolRelease(stack->pool, reference);
+		return GVRSERR_ELEMENT_NOT_FOUND;
+	}
+
+	GvrsBuilder* builder;
+	status = GvrsBuilderInit(&builder, (int)nRows, stack->nColsInRaster);
+	if (!status) {
+		status = GvrsBuilderSetTileSize(builder, stack->nRowsInTile, stack->nColsInTile);
+	}
+	if (!status && compress) {
+		status = GvrsBuilderRegisterStandardDataCompressionCodecs(builder);
+	}
+	if (!status) {
+		if (layout == GvrsStackLayoutTimeAsElements) {
+			copyCoordinateSystem(reference, builder);
+			int t;
+			for (t = 0; t < stack->nMembers && !status; t++) {
+				char name[GVRS_ELEMENT_NAME_SZ + 4];
+				snprintf(name, sizeof(name), "t%04d", t);
+				status = GvrsBuilderAddElementCopy(builder, name, element, 0);
+			}
+		}
+		else {
+			status = GvrsBuilderAddElementCopy(builder, stack->elementName, element, 0);
+		}
+	}
+	if (!status) {
+		status = GvrsBuilderOpenNewGvrs(builder, path, output);
+	}
+	GvrsBuilderFree(builder);
+	GvrsHandlePoolRelease(stack->pool, reference);
+	return status;
+}
+
+static int writeLayoutRecords(GvrsStack* stack, Gvrs* output, GvrsStackLayout layout) {
+	GvrsMetadata* m;
+	int32_t spec[6];
+	spec[0] = (int32_t)layout;
+	spec[1] = stack->nMembers;
+	spec[2] = stack->nRowsInRaster;
+	spec[3] = stack->nColsInRaster;
+	spec[4] = stack->nRowsInTile;
+	spec[5] = stack->nColsInTile;
+	int status = GvrsMetadataInit(STACK_LAYOUT_RECORD, 0, &m);
+	if (status) {
+		return status;
+	}
+	status = GvrsMetadataSetData(m, GvrsMetadataTypeInt, sizeof(spec), spec);
+	if (!status) {
+		status = GvrsMetadataSetDescription(m, "Layout, member count, rows, columns, rows in tile, columns in tile");
+	}
+	if (!status) {
+		status = GvrsMetadataWrite(output, m);
+	}
+	GvrsMetadataFree(m);
+
+	int t;
+	for (t = 0; t < stack->nMembers && !status; t++) {
+		status = GvrsMetadataInit(STACK_MEMBER_RECORD, t, &m);
+		if (status) {
+			return status;
+		}
+		status = GvrsMetadataSetAscii(m, stack->members[t]);
+		if (!status) {
+			status = GvrsMetadataWrite(output, m);
+		}
+		GvrsMetadataFree(m);
+	}
+	return status;
+}
+
+// Tests whether the values for a tile are all fill values.
+static int isFill(GvrsElement* e, int readInt, void* buffer, int64_t index, int nRows, int nCols, int64_t rowStride) {
+	int row, col;
+	for (row = 0; row < nRows; row++) {
+		int64_t k = index + row * rowStride;
+		for (col = 0; col < nCols; col++) {
+			if (readInt) {
+				if (((int32_t*)buffer)[k + col] != e->fillValueInt) {
+					return 0;
+				}
+			}
+			else {
+				float f = ((float*)buffer)[k + col];
+				if (f == f && f != e->fillValueFloat) {
+					return 0;
+				}
+			}
+		}
+	}
+	return 1;
+}
+
+static int writeTile(GvrsElement* e, int readInt, void* buffer, int64_t index, int outputRow0, int col0, int nRows, int nCols, int64_t rowStride) {
+	int row, col;
+	if (!readInt) {
+		for (row = 0; row < nRows; row++) {
+			int status = GvrsElementWriteBlockFloat(e, outputRow0 + row, col0, 1, nCols, (float*)buffer + index + row * rowStride);
+			if (status) {
+				return status;
+			}
+		}
+		return 0;
+	}
+	for (row = 0; row < nRows; row++) {
+		int64_t k = index + row * rowStride;
+		for (col = 0; col < nCols; col++) {
+			int status = GvrsElementWriteInt(e, outputRow0 + row, col0 + col, ((int32_t*)buffer)[k + col]);
+			if (status) {
+				return status;
+			}
+		}
+	}
+	return 0;
+}
+
+static int transcodeRun(GvrsStack* stack, Gvrs* output, GvrsStackLayout layout, GvrsStackReadJob* job) {
+	int status = runJob(job);
+	if (status) {
+		return status;
+	}
+
+	int tileRow = job->row0 / stack->nRowsInTile;
+	int tileCol0 = job->col0 / stack->nColsInTile;
+	int tileCol1 = (job->col0 + job->nCols - 1) / stack->nColsInTile;
+	int tileCol, t;
+	for (tileCol = tileCol0; tileCol <= tileCol1; tileCol++) {
+		int col0 = tileCol * stack->nColsInTile;
+		int nCols = stack->nColsInTile;
+		if (col0 + nCols > stack->nColsInRaster) {
+			nCols = stack->nColsInRaster - col0;
+		}
+		int64_t index = col0 - job->col0;
+		if (layout == GvrsStackLayoutTimeAsElements) {
+			int allFill = 1;
+			for (t = 0; t < job->nTimes && allFill; t++) {
+				allFill = isFill(output->elements[t], job->readInt, job->values,
+					index + t * job->timeStride, job->nRows, nCols, job->rowStride);
+			}
+			for (t = 0; t < job->nTimes && !allFill; t++) {
+				status = writeTile(output->elements[t], job->readInt, job->values, index + t * job->timeStride,
+					job->row0, col0, job->nRows, nCols, job->rowStride);
+				if (status) {
+					return status;
+				}
+			}
+		}
+		else {
+			GvrsElement* e = output->elements[0];
+			for (t = 0; t < job->nTimes; t++) {
+				int64_t k = index + t * job->timeStride;
+				if (isFill(e, job->readInt, job->values, k, job->nRows, nCols, job->rowStride)) {
+					continue;
+				}
+				int outputRow0 = (tileRow * job->nTimes + t) * stack->nRowsInTile;
+				status = writeTile(e, job->readInt, job->values, k, outputRow0, col0, job->nRows, nCols, job->rowStride);
+				if (status) {
+					return status;
+				}
+			}
+		}
+	}
+	return 0;
+}
+
+
+int GvrsStackTranscode(GvrsStack* stack, const char* path, GvrsStackLayout layout, int compress) {
+	if (!stack || !path) {
+		return GVRSERR_NULL_ARGUMENT;
+	}
+	if (layout != GvrsStackLayoutTimeAsElements && layout != GvrsStackLayoutInterleavedPlanes) {
+		return GVRSERR_INVALID_PARAMETER;
+	}
+	if (stack->nMembers == 0) {
+		return GVRSERR_INVALID_PARAMETER;
+	}
+
+	Gvrs* output;
+	int status = openOutput(stack, path, layout, compress, &output);
+	if (status) {
+		return status;
+	}
+
+	// determine the number of tile columns that can be buffered for all members
+	int64_t nBytesPerTile = (int64_t)stack->nRowsInTile * stack->nColsInTile * 4;
+	int64_t nBytesPerColumn = nBytesPerTile * stack->nMembers;
+	int nColsOfTiles = (stack->nColsInRaster + stack->nColsInTile - 1) / stack->nColsInTile;
+	int nTileColsInRun = (int)(STACK_TRANSCODE_BUFFER_SIZE / nBytesPerColumn);
+	if (nTileColsInRun < 1) {
+		nTileColsInRun = 1;
+	}
+	else if (nTileColsInRun > nColsOfTiles) {
+		nTileColsInRun = nColsOfTiles;
+	}
+	void* buffer = malloc((size_t)(nBytesPerColumn * nTileColsInRun));
+	if (!buffer) {
+		GvrsClose(output);
+		return GVRSERR_NOMEM;
+	}
+
+	GvrsStackReadJob job;
+	memset(&job, 0, sizeof(job));
+	job.stack = stack;
+	job.t0 = 0;
+	job.nTimes = stack->nMembers;
+	job.readInt = stack->elementType != GvrsElementTypeFloat;
+	job.values = buffer;
+
+	int nRowsOfTiles = (stack->nRowsInRaster + stack->nRowsInTile - 1) / stack->nRowsInTile;
+	int tileRow, tileCol;
+	for (tileRow = 0; tileRow < nRowsOfTiles && !status; tileRow++) {
+		for (tileCol = 0; tileCol < nColsOfTiles && !status; tileCol += nTileColsInRun) {
+			job.row0 = tileRow * stack->nRowsInTile;
+			job.col0 = tileCol * stack->nColsInTile;
+			job.nRows = stack->nRowsInTile;
+			job.nCols = nTileColsInRun * stack->nColsInTile;
+			if (job.row0 + job.nRows > stack->nRowsInRaster) {
+				job.nRows = stack->nRowsInRaster - job.row0;
+			}
+			if (job.col0 + job.nCols > stack->nColsInRaster) {
+				job.nCols = stack->nColsInRaster - job.col0;
+			}
+			// time-major order, so that the values for each member are stored as a block
+			job.colStride = 1;
+			job.rowStride = job.nCols;
+			job.timeStride = (int64_t)job.nRows * job.nCols;
+			status = transcodeRun(stack, output, layout, &job);
+		}
+	}
+	free(buffer);
+
+	if (!status) {
+		status = writeLayoutRecords(stack, output, layout);
+	}
+	int closeStatus = GvrsClose(output);
+	return status ? status : closeStatus;
+}
+
+
+int GvrsStackReadLayout(Gvrs* gvrs, GvrsStackLayoutSpec* spec) {
+	if (!gvrs || !spec) {
+		return GVRSERR_NULL_ARGUMENT;
+	}
+	memset(spec, 0, sizeof(GvrsStackLayoutSpec));
+	GvrsMetadataResultSet* rs;
+	int status = GvrsReadMetadataByNameAndID(gvrs, STACK_LAYOUT_RECORD, 0, &rs);
+	if (status) {
+		return status;
+	}
+	int nValues = 0;
+	int32_t* values = 0;
+	if (rs->nRecords > 0) {
+		GvrsMetadataGetIntArray(rs->records[0], &nValues, &values);
+	}
+	if (nValues < 6) {
+		GvrsMetadataResultSetFree(rs);
+		return GVRSERR_INVALID_PARAMETER;
+	}
+	spec->layout = (GvrsStackLayout)values[0];
+	spec->nTimes = values[1];
+	spec->nRowsInRaster = values[2];
+	spec->nColsInRaster = values[3];
+	spec->nRowsInTile = values[4];
+	spec->nColsInTile = values[5];
+	GvrsMetadataResultSetFree(rs);
+
+	int nElements = spec->layout == GvrsStackLayoutTimeAsElements ? spec->nTimes : 1;
+	if (spec->nTimes < 1 || gvrs->nElementsInTupple != nElements
+		|| gvrs->nRowsInTile != spec->nRowsInTile || gvrs->nColsInTile != spec->nColsInTile) {
+		return GVRSERR_INVALID_PARAMETER;
+	}
+	return 0;
+}
+
+
+int GvrsStackReadTranscodedSeries(Gvrs* gvrs, GvrsStackLayoutSpec* spec, int row, int column, int t0, int nTimes, float* values) {
+	if (!gvrs || !spec || !values) {
+		return GVRSERR_NULL_ARGUMENT;
+	}
+	if (nTimes < 1) {
+		return GVRSERR_INVALID_PARAMETER;
+	}
+	if (row < 0 || column < 0 || t0 < 0
+		|| row >= spec->nRowsInRaster || column >= spec->nColsInRaster
+		|| t0 > spec->nTimes - nTimes) {
+		return GVRSERR_COORDINATE_OUT_OF_BOUNDS;
+	}
+	int t, status;
+	if (spec->layout == GvrsStackLayoutTimeAsElements) {
+		for (t = 0; t < nTimes; t++) {
+			status = GvrsElementReadFloat(gvrs->elements[t0 + t], row, column, values + t);
+			if (status) {
+				return status;
+			}
+		}
+		return 0;
+	}
+
+	GvrsElement* e = gvrs->elements[0];
+	int tileRow = row / spec->nRowsInTile;
+	int rowInTile = row - tileRow * spec->nRowsInTile;
+	for (t = 0; t < nTimes; t++) {
+		int outputRow = (tileRow * spec->nTimes + t0 + t) * spec->nRowsInTile + rowInTile;
+		status = GvrsElementReadFloat(e, outputRow, column, values + t);
+		if (status) {
+			return status;
+		}
+	}
+	return 0;
+}
+
+
+GvrsStack* GvrsStackFree(GvrsStack* stack) {
+	if (stack) {
+		int i;
+		for (i = 0; i < stack->nMembers; i++) {
+			free(stack->members[i]);
+		}
+		free(stack->members);
+		stack->members = 0;
+		if (stack->poolIsOwned) {
+			GvrsHandlePoolFree(stack->pool);
+		}
+		stack->pool = 0;
+		free(stack);
+	}
+	return 0;
+}
@@ -0,0 +1,175 @@
+/* --------------------------------------------------------------------
+ *
+ * The MIT License
+ *
+ * Copyright (C) 2024  Gary W. Lucas.
+
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ * ---------------------------------------------------------------------
+ */
+
+// Development Note:
+//    While timing is enabled, the GVRS instance carries a GvrsStatistics structure
+// that accumulates the timing values.  The counters are maintained by the tile
+// cache and the codecs at all times, so they are copied into the result when
+// the statistics are requested.  The instrumented code checks for a null
+// statistics pointer before reading the clock, so an instance that does not enable
+// timing does not pay for it.
+
+#include "GvrsFramework.h"
+
+#include "GvrsPrimaryIo.h"
+#include "Gvrs.h"
+#include "GvrsInternal.h"
+#include "GvrsStatistics.h"
+#include "GvrsError.h"
+
+int GvrsSetTimingEnabled(Gvrs* gvrs, int enabled) {
+	if (!gvrs) {
+		return GVRSERR_NULL_ARGUMENT;
+	}
+	free(gvrs->statistics);
+	gvrs->statistics = 0;
+	if (enabled) {
+		GvrsStatistics* s = calloc(1, sizeof(GvrsStatistics));
+		if (!s) {
+			return GVRSERR_NOMEM;
+		}
+		s->timingEnabled = 1;
+		gvrs->statistics = s;
+	}
+	return 0;
+}
+
+void GvrsStatisticsRecordMiss(Gvrs* gvrs, int64_t ns) {
+	GvrsStatistics* s = gvrs->statistics;
+	s->nMisses++;
+	s->nsMissTotal += ns;
+	if (ns > s->nsMissMax) {
+		s->nsMissMax = ns;
+	}
+	int64_t us = ns / 1000;
+	int k = 0;
+	while (us > 0 && k < GVRS_STATISTICS_LATENCY_BINS - 1) {
+		us >>= 1;
+		k++;
+	}
+	s->missLatency[k]++;
+}
+
+int GvrsGetStatistics(Gvrs* gvrs, GvrsStatistics* statistics) {
+	if (!gvrs || !statistics) {
+		return GVRSERR_NULL_ARGUMENT;
+	}
+	if (gvrs->statistics) {
+		memcpy(statistics, gvrs->statistics, sizeof(GvrsStatistics));
+	}
+	else {
+		memset(statistics, 0, sizeof(GvrsStatistics));
+	}
+	GvrsTileCache* tc = gvrs->tileCache;
+	if (tc) {
+		statistics->nRasterReads = tc->nRasterReads;
+		statistics->nRasterWrites = tc->nRasterWrites;
+		statistics->nCacheSearches = tc->nCacheSearches;
+		statistics->nNotFound = tc->nNotFound;
+		statistics->nTileReads = tc->nTileReads;
+		statistics->nTileWrites = tc->nTileWrites;
+		statistics->nReadAheadFills = tc->nReadAheadFills;
+		statistics->nReadAheadHits = tc->nReadAheadHits;
+	}
+	int i;
+	int n = gvrs->nDataCompressionCodecs;
+	if (n > GVRS_STATISTICS_MAX_CODECS) {
+		n = GVRS_STATISTICS_MAX_CODECS;
+	}
+	statistics->nCodecs = n;
+	for (i = 0; i < n; i++) {
+		GvrsCodec* codec = gvrs->dataCompressionCodecs[i];
+		GvrsCodecStatistics* cs = statistics->codecs + i;
+		GvrsStrncpy(cs->identification, sizeof(cs->identification), codec->identification);
+		cs->nTimesEncoded = codec->nTimesEncoded;
+		cs->nBytesEncoded = codec->nBytesEncoded;
+	}
+	return 0;
+}
+
+int GvrsWriteStatisticsJSON(Gvrs* gvrs, FILE* fp) {
+	if (!gvrs || !fp) {
+		return GVRSERR_NULL_ARGUMENT;
+	}
+	GvrsStatistics s;
+	int status = GvrsGetStatistics(gvrs, &s);
+	if (status) {
+		return status;
+	}
+	int i;
+	fprintf(fp, "{\n");
+	fprintf(fp, "  \"timingEnabled\": %s,\n", s.timingEnabled ? "true" : "false");
+	fprintf(fp, "  \"counters\": {\n");
+	fprintf(fp, "    \"rasterReads\": %lld,\n", (long long)s.nRasterReads);
+	fprintf(fp, "    \"rasterWrites\": %lld,\n", (long long)s.nRasterWrites);
+	fprintf(fp, "    \"cacheSearches\": %lld,\n", (long long)s.nCacheSearches);
+	fprintf(fp, "    \"notFound\": %lld,\n", (long long)s.nNotFound);
+	fprintf(fp, "    \"tileReads\": %lld,\n", (long long)s.nTileReads);
+	fprintf(fp, "    \"tileWrites\": %lld,\n", (long long)s.nTileWrites);
+	fprintf(fp, "    \"readAheadFills\": %lld,\n", (long long)s.nReadAheadFills);
+	fprintf(fp, "    \"readAheadHits\": %lld\n", (long long)s.nReadAheadHits);
+	fprintf(fp, "  },\n");
+	fprintf(fp, "  \"io\": {\n");
+	fprintf(fp, "    \"readNs\": %lld,\n", (long long)s.nsFileRead);
+	fprintf(fp, "    \"bytesRead\": %lld,\n", (long long)s.nBytesRead);
+	fprintf(fp, "    \"writeNs\": %lld,\n", (long long)s.nsFileWrite);
+	fprintf(fp, "    \"bytesWritten\": %lld,\n", (long long)s.nBytesWritten);
+	fprintf(fp, "    \"allocationNs\": %lld,\n", (long long)s.nsAllocation);
+	fprintf(fp, "    \"allocations\": %lld,\n", (long long)s.nAllocations);
+	fprintf(fp, "    \"checksumNs\": %lld\n", (long long)s.nsChecksum);
+	fprintf(fp, "  },\n");
+	fprintf(fp, "  \"codecs\": [");
+	for (i = 0; i < s.nCodecs; i++) {
+		GvrsCodecStatistics* cs = s.codecs + i;
+		fprintf(fp, "%s\n    {\"identification\": \"%s\", \"decoded\": %lld, \"decodeNs\": %lld, "
+			"\"encodeAttempts\": %lld, \"encodeNs\": %lld, \"timesEncoded\": %lld, \"bytesEncoded\": %lld}",
+			i == 0 ? "" : ",",
+			cs->identification,
+			(long long)cs->nDecoded, (long long)cs->nsDecoding,
+			(long long)cs->nEncodeAttempts, (long long)cs->nsEncoding,
+			(long long)cs->nTimesEncoded, (long long)cs->nBytesEncoded);
+	}
+	fprintf(fp, "%s],\n", s.nCodecs ? "\n  " : "");
+	fprintf(fp, "  \"misses\": {\n");
+	fprintf(fp, "    \"count\": %lld,\n", (long long)s.nMisses);
+	fprintf(fp, "    \"totalNs\": %lld,\n", (long long)s.nsMissTotal);
+	fprintf(fp, "    \"maxNs\": %lld,\n", (long long)s.nsMissMax);
+	// the histogram is given as the upper bound of each bin in microseconds and its count.
+	// trailing empty bins are omitted.
+	int nBins = GVRS_STATISTICS_LATENCY_BINS;
+	while (nBins > 1 && s.missLatency[nBins - 1] == 0) {
+		nBins--;
+	}
+	fprintf(fp, "    \"latencyHistogram\": [");
+	for (i = 0; i < nBins; i++) {
+		fprintf(fp, "%s{\"upperUs\": %lld, \"count\": %lld}",
+			i == 0 ? "" : ", ", 1LL << i, (long long)s.missLatency[i]);
+	}
+	fprintf(fp, "]\n");
+	fprintf(fp, "  }\n");
+	fprintf(fp, "}\n");
+	return ferror(fp) ? GVRSERR_FILE_ERROR : 0;
+}
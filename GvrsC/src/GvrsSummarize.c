@@ -29,6 +29,7 @@
 #include "GvrsPrimaryIo.h"
 #include "Gvrs.h"
 #include "GvrsInternal.h"
+#include "GvrsStatistics.h"
 #include "GvrsError.h"
  
 
@@ -47,7 +48,7 @@ GvrsGetStringUUID(Gvrs* gvrs, size_t uuidStringSize, char* uuidString) {
 
 static const char* elementTypeStr[] = { "Integer", "Integer-Coded Float", "Float", "Short" };
 
-static const char* tileCacheSizeStr[] = { "Small", "Medium", "Large", "Extra Large" };
+static const char* tileCacheSizeStr[] = { "Small", "Medium", "Large", "Extra Large", "Automatic" };
  
 static const char* strspec(const char* s) {
 	if (s && *s) {
@@ -177,6 +178,10 @@ GvrsSummarize(Gvrs* gvrs, FILE* fp) {
 		tileCacheSizeStr[(int)gvrs->tileCacheSize], 
 		maxTileCacheAllocation/1048576.0,
 		(long)gvrs->nBytesForTileData);
+	if (tc->automaticSize) {
+		fprintf(fp, "Automatic size: %d tiles, ceiling %d tiles\n",
+			(int)tc->currentTileCacheSize, (int)tc->maxTileCacheSize);
+	}
 	fprintf(fp,"Options for standard cache sizes\n");
 	fprintf(fp, "    Size              Max Tiles      Max Memory (MiB)\n");
 	for (i = 0; i < 4; i++) {
@@ -194,6 +199,7 @@ GvrsSummarize(Gvrs* gvrs, FILE* fp) {
 
 	fprintf(fp, "Metadata ----------------------------------------\n");
 	fprintf(fp, "     Name                           Record ID    Type\n");
+	GvrsLoadMetadataDirectory(gvrs);
 	GvrsMetadataDirectory* md = gvrs->metadataDirectory;
 	if (md) {
 		for (i = 0; i < md->nMetadataReferences; i++) {
@@ -251,6 +257,25 @@ GvrsSummarizeAccessStatistics(Gvrs* gvrs, FILE* fp) {
 		fprintf(fp, "    Number of deallocations: %8lld\n", (long long)fsm->nDeallocations);
 	}
 
+	if (gvrs->statistics) {
+		GvrsStatistics s;
+		GvrsGetStatistics(gvrs, &s);
+		fprintf(fp, "\nTiming (milliseconds)\n");
+		fprintf(fp, "    File read:               %10.3f  (%lld bytes)\n", s.nsFileRead / 1.0e+6, (long long)s.nBytesRead);
+		fprintf(fp, "    File write:              %10.3f  (%lld bytes)\n", s.nsFileWrite / 1.0e+6, (long long)s.nBytesWritten);
+		fprintf(fp, "    File-space allocation:   %10.3f\n", s.nsAllocation / 1.0e+6);
+		fprintf(fp, "    Checksums:               %10.3f\n", s.nsChecksum / 1.0e+6);
+		int i;
+		for (i = 0; i < s.nCodecs; i++) {
+			fprintf(fp, "    %-16.16s decode:  %10.3f  encode: %10.3f\n",
+				s.codecs[i].identification, s.codecs[i].nsDecoding / 1.0e+6, s.codecs[i].nsEncoding / 1.0e+6);
+		}
+		if (s.nMisses) {
+			fprintf(fp, "    Tile misses:  %lld,  mean latency %.1f us,  max %.1f us\n",
+				(long long)s.nMisses, s.nsMissTotal / 1.0e+3 / (double)s.nMisses, s.nsMissMax / 1.0e+3);
+		}
+	}
+
 	if (gvrs->timeOpenedForWritingMS && gvrs->nDataCompressionCodecs) {
 		    int i;
 			fprintf(fp, "\n");
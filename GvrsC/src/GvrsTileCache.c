@@ -30,6 +30,8 @@
 #include "GvrsError.h"
 #include "Gvrs.h"
 #include "GvrsInternal.h"
+#include "GvrsStatistics.h"
+#include "GvrsEvents.h"
 
  
 
@@ -216,21 +218,18 @@ static int hashTableRemove(GvrsTileCache* tc, GvrsTile* tile) {
 
 
 
-static int readAndDecomp(Gvrs *gvrs, int32_t n, GvrsElement* element, uint8_t* data) {
-	uint8_t* packing = (uint8_t*)malloc(n);
-	if (!packing) {
-		return GVRSERR_NOMEM;
-	}
-	int status = GvrsReadByteArray(gvrs->fp, n, packing);
-	if (status) {
-		free(packing);
-		return status;
-	}
+static int decodeSegment(Gvrs* gvrs, int tileIndex, int32_t n, GvrsElement* element, uint8_t* packing, uint8_t* data, int64_t* nsDecoding) {
+	int status;
 	int i;
 	int nRows = gvrs->nRowsInTile;
 	int nCols = gvrs->nColsInTile;
 	int nCells = nRows * nCols;
 	int compressorIndex = (int)packing[0];
+	GvrsStatistics* statistics = gvrs->statistics;
+	int64_t time0 = statistics || gvrs->eventHooks ? GvrsTimeNS() : 0;
+	if (gvrs->eventHooks) {
+		GvrsEventReport(gvrs, GvrsEventDecodeStart, tileIndex, element->elementIndex, compressorIndex, n, -1, 0, 0);
+	}
 	status = GVRSERR_COMPRESSION_NOT_IMPLEMENTED;
 	if (gvrs->nDataCompressionCodecs > compressorIndex) {
 		GvrsCodec* codec = gvrs->dataCompressionCodecs[compressorIndex];
@@ -259,60 +258,274 @@ static int readAndDecomp(Gvrs *gvrs, int32_t n, GvrsElement* element, uint8_t* d
 			}
 		}
 	}
-	free(packing);
+	if (gvrs->eventHooks) {
+		GvrsEventReport(gvrs, GvrsEventDecodeEnd, tileIndex, element->elementIndex, compressorIndex, n, -1, GvrsTimeNS() - time0, status);
+	}
+	if (statistics) {
+		int64_t ns = GvrsTimeNS() - time0;
+		*nsDecoding += ns;
+		if (compressorIndex < GVRS_STATISTICS_MAX_CODECS) {
+			statistics->codecs[compressorIndex].nDecoded++;
+			statistics->codecs[compressorIndex].nsDecoding += ns;
+		}
+	}
 	return status;
+}
+
+// Read-ahead:
+//    When tiles are accessed in the order in which they are stored in the file
+// (a sweep over a file written in row-major order or along a space-filling curve),
+// each tile record starts where the previous one ended.  When a read follows
+// that pattern, a single block of the file starting at the header of the record
+// is read into the read-ahead buffer.  The records for subsequent tiles that lie
+// entirely within the block are decoded from memory without accessing the file.
+// The operating system is also advised that the portion of the file following
+// the block will be needed soon.
+//    Read-ahead is used only for instances that are opened for read-only access
+// because a record held in the buffer would not reflect changes written to the file.
+
+#define RECORD_HEADER_SIZE 8
+#define RECORD_OVERHEAD_SIZE 12
+
+// Gets a pointer to the content of a tile record if the complete record is in the
+// read-ahead buffer.  The size of the content, including any padding, is also obtained.
+static uint8_t* readAheadLookup(GvrsTileCache* tc, int64_t tileOffset, int32_t* nBytesInRecord) {
+	int64_t recordPos = tileOffset - RECORD_HEADER_SIZE;
+	if (!tc->readAheadLength || recordPos < tc->readAheadPosition
+		|| tileOffset > tc->readAheadPosition + tc->readAheadLength) {
+		return 0;
+	}
+	uint8_t* record = tc->readAheadBuffer + (recordPos - tc->readAheadPosition);
+	int32_t blockSize;
+	memcpy(&blockSize, record, 4);
+	if (record[4] != (uint8_t)GvrsRecordTypeTile || blockSize < RECORD_OVERHEAD_SIZE + 4
+		|| recordPos + blockSize > tc->readAheadPosition + tc->readAheadLength) {
+		return 0;
+	}
+	*nBytesInRecord = blockSize - RECORD_OVERHEAD_SIZE;
+	return record + RECORD_HEADER_SIZE;
+}
+
+static uint8_t* readAheadFill(Gvrs* gvrs, GvrsTileCache* tc, int64_t tileOffset, int32_t* nBytesInRecord) {
+	if (!tc->readAheadBuffer) {
+		// the buffer must hold at least one record for a tile that is stored without compression
+		int capacity = gvrs->readAheadSize;
+		int minCapacity = 2 * (gvrs->nBytesForTileData + 4 * gvrs->nElementsInTupple + 32);
+		if (capacity < minCapacity) {
+			capacity = minCapacity;
+		}
+		tc->readAheadBuffer = malloc((size_t)capacity);
+		if (!tc->readAheadBuffer) {
+			return 0;
+		}
+		tc->readAheadCapacity = capacity;
+	}
+	int64_t recordPos = tileOffset - RECORD_HEADER_SIZE;
+	tc->readAheadLength = 0;
+	if (GvrsSetFilePosition(gvrs->fp, recordPos)) {
+		return 0;
+	}
+	size_t n = fread(tc->readAheadBuffer, 1, (size_t)tc->readAheadCapacity, gvrs->fp);
+	tc->readAheadPosition = recordPos;
+	tc->readAheadLength = (int32_t)n;
+	tc->nReadAheadFills++;
+	if (n == (size_t)tc->readAheadCapacity) {
+		GvrsAdviseWillNeed(gvrs->fp, recordPos + n, n);
+	}
+	return readAheadLookup(tc, tileOffset, nBytesInRecord);
+}
 
+// Decodes a tile record from memory.  The content of the record is the tile
+// index followed by a length and the content for each element.
+static int parseTile(Gvrs* gvrs, uint8_t* record, int32_t nBytesInRecord, GvrsTile* tile, int32_t* totalBytes, int64_t* nsDecoding) {
+	int i;
+	int32_t tileIndexFromFile;
+	int32_t pos = 4;
+	memcpy(&tileIndexFromFile, record, 4);
+	for (i = 0; i < gvrs->nElementsInTupple; i++) {
+		GvrsElement* element = gvrs->elements[i];
+		int32_t n;
+		if (pos + 4 > nBytesInRecord) {
+			return GVRSERR_FILE_ERROR;
+		}
+		memcpy(&n, record + pos, 4);
+		pos += 4;
+		if (n <= 0 || n > nBytesInRecord - pos) {
+			return GVRSERR_FILE_ERROR;
+		}
+		int status;
+		if (n < element->dataSize) {
+			status = decodeSegment(gvrs, tileIndexFromFile, n, element, record + pos, tile->data + element->dataOffset, nsDecoding);
+			if (status) {
+				return status;
+			}
+		}
+		else {
+			memcpy(tile->data + element->dataOffset, record + pos, (size_t)element->dataSize);
+		}
+		pos += n;
+	}
+	*totalBytes = pos;
+	return 0;
 }
 
+
  
 
 
-static int readTile(Gvrs* gvrs, int64_t tileOffset, GvrsTile*tile) {
-	int i;
+// Gets the largest size for a tile record, which occurs when all
+// elements are stored without compression.
+static int32_t getMaxRecordSize(Gvrs* gvrs) {
+	return GvrsFileSpaceRecordSize(4 + 4 * gvrs->nElementsInTupple + gvrs->nBytesForTileData);
+}
+
+// Stores a record size that was obtained from the file in the tile directory, where
+// it is available to all instances that share the directory.  If a writer moved the
+// tile to a new position after it was read, the size is not stored.
+static void retainRecordSize(Gvrs* gvrs, int tileIndex, int64_t tileOffset, int32_t recordSize) {
+	GvrsDirectoryLock(gvrs);
+	if (GvrsTileDirectoryGetFilePosition(gvrs->tileDirectory, tileIndex) == tileOffset
+		&& !GvrsTileDirectoryGetRecordSize(gvrs->tileDirectory, tileIndex)) {
+		GvrsTileDirectorySetRecordSize(gvrs->tileDirectory, tileIndex, recordSize);
+	}
+	GvrsDirectoryUnlock(gvrs);
+}
+
+// Reads a tile record in a single operation.  The size of the record is taken from the
+// tile directory when it is known.  Otherwise, it is read from the record header,
+// which immediately precedes the content, and is retained for subsequent reads
+// when possible.  The content is read into a buffer that is retained by the tile cache.
+static int readTile(Gvrs* gvrs, int tileIndex, int64_t tileOffset, GvrsTile*tile) {
 	FILE* fp = gvrs->fp;
+	GvrsStatistics* statistics = gvrs->statistics;
+	int64_t time0 = statistics ? GvrsTimeNS() : 0;
+	int64_t nsDecoding = 0;
 
 	if (tileOffset == 0) {
 		return GVRSERR_FILE_ERROR;
 	}
-	int status = GvrsSetFilePosition(fp, tileOffset);
-	if (status) {
-		return GVRSERR_FILE_ERROR;
+
+	GvrsTileCache* tc = gvrs->tileCache;
+	if (tc && gvrs->readAheadSize > 0 && !gvrs->timeOpenedForWritingMS) {
+		int32_t nBytesInRecord = 0;
+		uint8_t* record = readAheadLookup(tc, tileOffset, &nBytesInRecord);
+		if (record) {
+			tc->nReadAheadHits++;
+		}
+		else if (tileOffset == tc->readAheadNext) {
+			record = readAheadFill(gvrs, tc, tileOffset, &nBytesInRecord);
+		}
+		if (record) {
+			if (!tile->data) {
+				tile->data = calloc(1, gvrs->nBytesForTileData);
+				if (!tile->data) {
+					return GVRSERR_NOMEM;
+				}
+			}
+			int32_t totalBytes;
+			int status = parseTile(gvrs, record, nBytesInRecord, tile, &totalBytes, &nsDecoding);
+			if (status) {
+				return status;
+			}
+			retainRecordSize(gvrs, tileIndex, tileOffset, nBytesInRecord + RECORD_OVERHEAD_SIZE);
+			tc->readAheadNext = tileOffset + nBytesInRecord + RECORD_OVERHEAD_SIZE;
+			tile->filePosition = tileOffset;
+			tile->fileRecordContentSize = totalBytes;
+			if (statistics) {
+				statistics->nsFileRead += GvrsTimeNS() - time0 - nsDecoding;
+				statistics->nBytesRead += totalBytes;
+			}
+			return 0;
+		}
 	}
-	int32_t tileIndexFromFile;
-	int32_t totalBytes = 4; // the tile index from file
-	status = GvrsReadInt(fp, &tileIndexFromFile); 
-	if (status) {
+
+	uint8_t* record = 0;
+	if (tc) {
+		if (!tc->recordBuffer) {
+			tc->recordBufferCapacity = getMaxRecordSize(gvrs) - RECORD_OVERHEAD_SIZE;
+			tc->recordBuffer = malloc((size_t)tc->recordBufferCapacity);
+			if (!tc->recordBuffer) {
+				tc->recordBufferCapacity = 0;
+				return GVRSERR_NOMEM;
+			}
+		}
+		record = tc->recordBuffer;
+	}
+
+	GvrsDirectoryLock(gvrs);
+	int32_t recordSize = GvrsTileDirectoryGetRecordSize(gvrs->tileDirectory, tileIndex);
+	GvrsDirectoryUnlock(gvrs);
+
+	// If writer clones share the file pointer, the positioning and read operations
+	// must be performed by one thread at a time.  The record is decoded after
+	// the lock is released.
+	int status;
+	GvrsWriteLock(gvrs);
+	if (recordSize) {
+		status = GvrsSetFilePosition(fp, tileOffset);
+	}
+	else {
+		uint8_t recordType = 0;
+		status = GvrsSetFilePosition(fp, tileOffset - RECORD_HEADER_SIZE);
+		if (!status) {
+			status = GvrsReadInt(fp, &recordSize);
+		}
+		if (!status) {
+			status = GvrsReadByte(fp, &recordType);
+		}
+		if (!status) {
+			status = GvrsSkipBytes(fp, 3);
+		}
+		if (!status && recordType != (uint8_t)GvrsRecordTypeTile) {
+			status = GVRSERR_FILE_ERROR;
+		}
+	}
+	if (status || recordSize <= RECORD_OVERHEAD_SIZE || recordSize > getMaxRecordSize(gvrs)) {
+		GvrsWriteUnlock(gvrs);
 		return GVRSERR_FILE_ERROR;
 	}
+	int32_t nBytesInRecord = recordSize - RECORD_OVERHEAD_SIZE;
 
-	if (!tile->data) {
-		tile->data = calloc(1, gvrs->nBytesForTileData);
-		if (!tile->data) {
+	if (!tc) {
+		record = malloc((size_t)nBytesInRecord);
+		if (!record) {
+			GvrsWriteUnlock(gvrs);
 			return GVRSERR_NOMEM;
 		}
 	}
-	
 
-	for (i = 0; i < gvrs->nElementsInTupple; i++) {
-		GvrsElement* element = gvrs->elements[i];
-		int32_t n;
-		GvrsReadInt(fp, &n);  // this will tell us if it's compressed or not
-		totalBytes += 4;
-		totalBytes += n;
-		if (n < element->dataSize) {
-			// a compressed segment
-			status = readAndDecomp(gvrs, n, element, tile->data + element->dataOffset);
-		}
-		else {
-			status = GvrsReadByteArray(fp, element->dataSize, tile->data + element->dataOffset);
-		}
-		if (status) {
-			return status;
+	int32_t totalBytes = 0;
+	status = GvrsReadByteArray(fp, nBytesInRecord, record);
+	GvrsWriteUnlock(gvrs);
+	if (status) {
+		status = GVRSERR_FILE_ERROR;
+	}
+	else if (!tile->data) {
+		tile->data = calloc(1, gvrs->nBytesForTileData);
+		if (!tile->data) {
+			status = GVRSERR_NOMEM;
 		}
 	}
+	if (!status) {
+		status = parseTile(gvrs, record, nBytesInRecord, tile, &totalBytes, &nsDecoding);
+	}
+	if (!tc) {
+		free(record);
+	}
+	if (status) {
+		return status;
+	}
 
+	retainRecordSize(gvrs, tileIndex, tileOffset, recordSize);
 	tile->filePosition = tileOffset;
 	tile->fileRecordContentSize = totalBytes;
+	if (tc) {
+		tc->readAheadNext = tileOffset + recordSize;
+	}
+	if (statistics) {
+		statistics->nsFileRead += GvrsTimeNS() - time0 - nsDecoding;
+		statistics->nBytesRead += totalBytes;
+	}
 
 	return 0;
 }
@@ -320,6 +533,12 @@ static int readTile(Gvrs* gvrs, int64_t tileOffset, GvrsTile*tile) {
  
 
 static void moveTileToHeadOfMainList(GvrsTileCache* tc, GvrsTile* node) {
+	if (node->pinCount) {
+		// pinned tiles are not on the main list
+		tc->firstTile = node;
+		tc->firstTileIndex = node->tileIndex;
+		return;
+	}
 	GvrsTile* n = node->next;
 	GvrsTile* p = node->prior;
 	n->prior = p;
@@ -336,6 +555,190 @@ static void moveTileToHeadOfMainList(GvrsTileCache* tc, GvrsTile* node) {
 
  
 
+// In-memory cell layouts:
+//    The index tables give the position of a cell as the sum of a term for its row and a term
+// for its column.  For the Morton layout, the bits of the row and column indices are interleaved
+// (column bits in the even positions, row bits in the odd positions).  When one dimension
+// of the tile is larger than the other, its excess high-order bits are placed above the
+// interleaved bits.  Because the tile dimensions are powers of two, the mapping is a
+// permutation of the cells in the tile.
+
+static int isPowerOfTwo(int n) {
+	return n > 0 && (n & (n - 1)) == 0;
+}
+
+static int log2OfPowerOfTwo(int n) {
+	int k = 0;
+	while ((1 << k) < n) {
+		k++;
+	}
+	return k;
+}
+
+static int32_t mortonTerm(int index, int nInterleaved, int firstBit, int extraBits) {
+	int32_t term = 0;
+	int i;
+	for (i = 0; i < nInterleaved; i++) {
+		term |= ((index >> i) & 1) << (2 * i + firstBit);
+	}
+	if (extraBits) {
+		term |= (index >> nInterleaved) << (2 * nInterleaved);
+	}
+	return term;
+}
+
+static void freeLayout(GvrsTileCache* tc) {
+	free(tc->cellRowIndex);
+	free(tc->cellColIndex);
+	free(tc->layoutBuffer);
+	tc->cellRowIndex = 0;
+	tc->cellColIndex = 0;
+	tc->layoutBuffer = 0;
+	tc->tileLayout = GvrsTileLayoutRowMajor;
+}
+
+static int buildLayout(GvrsTileCache* tc, GvrsTileLayout tileLayout) {
+	freeLayout(tc);
+	if (tileLayout == GvrsTileLayoutRowMajor) {
+		return 0;
+	}
+	if (tileLayout != GvrsTileLayoutMorton || !isPowerOfTwo(tc->nRowsInTile) || !isPowerOfTwo(tc->nColsInTile)) {
+		return GVRSERR_INVALID_PARAMETER;
+	}
+	Gvrs* gvrs = tc->gvrs;
+	tc->cellRowIndex = malloc((size_t)tc->nRowsInTile * sizeof(int32_t));
+	tc->cellColIndex = malloc((size_t)tc->nColsInTile * sizeof(int32_t));
+	tc->layoutBuffer = calloc(1, (size_t)gvrs->nBytesForTileData);
+	if (!tc->cellRowIndex || !tc->cellColIndex || !tc->layoutBuffer) {
+		freeLayout(tc);
+		return GVRSERR_NOMEM;
+	}
+	int rowBits = log2OfPowerOfTwo(tc->nRowsInTile);
+	int colBits = log2OfPowerOfTwo(tc->nColsInTile);
+	int nInterleaved = rowBits < colBits ? rowBits : colBits;
+	int i;
+	for (i = 0; i < tc->nRowsInTile; i++) {
+		tc->cellRowIndex[i] = mortonTerm(i, nInterleaved, 1, rowBits > colBits);
+	}
+	for (i = 0; i < tc->nColsInTile; i++) {
+		tc->cellColIndex[i] = mortonTerm(i, nInterleaved, 0, colBits > rowBits);
+	}
+	tc->tileLayout = tileLayout;
+	return 0;
+}
+
+// Copies tile data between row-major order and the layout given by the index tables.
+static void transferLayout(GvrsTileCache* tc, const uint8_t* source, uint8_t* target, int toLayout) {
+	Gvrs* gvrs = tc->gvrs;
+	int nRows = tc->nRowsInTile;
+	int nCols = tc->nColsInTile;
+	int iElement, row, col;
+	for (iElement = 0; iElement < gvrs->nElementsInTupple; iElement++) {
+		GvrsElement* e = gvrs->elements[iElement];
+		const uint8_t* s = source + e->dataOffset;
+		uint8_t* t = target + e->dataOffset;
+		int nBytesInCells = tc->nCellsInTile * e->typeSize;
+		if (e->dataSize > nBytesInCells) {
+			memcpy(t + nBytesInCells, s + nBytesInCells, (size_t)(e->dataSize - nBytesInCells));
+		}
+		for (row = 0; row < nRows; row++) {
+			int32_t rowIndex = tc->cellRowIndex[row];
+			int k = row * nCols;
+			if (e->typeSize == 2) {
+				const int16_t* s16 = (const int16_t*)s;
+				int16_t* t16 = (int16_t*)t;
+				for (col = 0; col < nCols; col++, k++) {
+					int32_t m = rowIndex + tc->cellColIndex[col];
+					if (toLayout) {
+						t16[m] = s16[k];
+					}
+					else {
+						t16[k] = s16[m];
+					}
+				}
+			}
+			else {
+				const int32_t* s32 = (const int32_t*)s;
+				int32_t* t32 = (int32_t*)t;
+				for (col = 0; col < nCols; col++, k++) {
+					int32_t m = rowIndex + tc->cellColIndex[col];
+					if (toLayout) {
+						t32[m] = s32[k];
+					}
+					else {
+						t32[k] = s32[m];
+					}
+				}
+			}
+		}
+	}
+}
+
+void GvrsTileCacheApplyLayout(GvrsTileCache* tc, uint8_t** data) {
+	if (!tc->cellRowIndex) {
+		return;
+	}
+	uint8_t* p = *data;
+	transferLayout(tc, p, tc->layoutBuffer, 1);
+	*data = tc->layoutBuffer;
+	tc->layoutBuffer = p;
+}
+
+int GvrsTileCacheSetLayout(GvrsTileCache* tc, GvrsTileLayout tileLayout) {
+	if (!tc) {
+		return GVRSERR_NULL_ARGUMENT;
+	}
+	if (tileLayout == tc->tileLayout) {
+		return 0;
+	}
+	if (tileLayout != GvrsTileLayoutRowMajor && tileLayout != GvrsTileLayoutMorton) {
+		return GVRSERR_INVALID_PARAMETER;
+	}
+	if (tileLayout == GvrsTileLayoutMorton && (!isPowerOfTwo(tc->nRowsInTile) || !isPowerOfTwo(tc->nColsInTile))) {
+		return GVRSERR_INVALID_PARAMETER;
+	}
+	int status = GvrsTileCacheWritePendingTiles(tc);
+	if (status) {
+		return status;
+	}
+
+	// Collect the tiles that are resident, converting any that are in the
+	// old layout back to row-major order.
+	Gvrs* gvrs = tc->gvrs;
+	uint8_t* rowMajor = malloc((size_t)gvrs->nBytesForTileData);
+	if (!rowMajor) {
+		return GVRSERR_NOMEM;
+	}
+	GvrsTile* tile;
+	if (tc->cellRowIndex) {
+		for (tile = tc->head->next; tile != tc->tail; tile = tile->next) {
+			if (tile->data) {
+				transferLayout(tc, tile->data, rowMajor, 0);
+				memcpy(tile->data, rowMajor, (size_t)gvrs->nBytesForTileData);
+			}
+		}
+		for (tile = tc->pinnedTiles; tile; tile = tile->next) {
+			transferLayout(tc, tile->data, rowMajor, 0);
+			memcpy(tile->data, rowMajor, (size_t)gvrs->nBytesForTileData);
+		}
+	}
+	free(rowMajor);
+
+	status = buildLayout(tc, tileLayout);
+	if (!status && tc->cellRowIndex) {
+		for (tile = tc->head->next; tile != tc->tail; tile = tile->next) {
+			if (tile->data) {
+				GvrsTileCacheApplyLayout(tc, &tile->data);
+			}
+		}
+		for (tile = tc->pinnedTiles; tile; tile = tile->next) {
+			GvrsTileCacheApplyLayout(tc, &tile->data);
+		}
+	}
+	return status;
+}
+
+
 int GvrsTileCacheAlloc(void* gvrspointer, int maxTileCacheSize, GvrsTileCache** tileCacheReference) {
 	if (!gvrspointer || !tileCacheReference) {
 		return GVRSERR_NULL_ARGUMENT;
@@ -410,6 +813,12 @@ int GvrsTileCacheAlloc(void* gvrspointer, int maxTileCacheSize, GvrsTileCache**
 		return GVRSERR_NOMEM;
 	}
 
+	int status = buildLayout(tc, gvrs->tileLayout);
+	if (status) {
+		GvrsTileCacheFree(tc);
+		return status;
+	}
+
 	*tileCacheReference = tc;
 	return 0;
 }
@@ -430,7 +839,15 @@ static void clearOutputBlock(GvrsTileCache *tc) {
 		memset(blocks, 0, tc->nElementsInTupple * sizeof(GvrsTileOutputBlock));
 	}
 }
-static int compressElements(Gvrs* gvrs, GvrsTile *tile) {
+static void recordEncoding(Gvrs* gvrs, int codecIndex, int64_t ns) {
+	GvrsStatistics* statistics = gvrs->statistics;
+	if (codecIndex < GVRS_STATISTICS_MAX_CODECS) {
+		statistics->codecs[codecIndex].nEncodeAttempts++;
+		statistics->codecs[codecIndex].nsEncoding += ns;
+	}
+}
+
+static int compressElements(Gvrs* gvrs, uint8_t* data) {
 	GvrsTileCache* tc = gvrs->tileCache;
 	if (gvrs->nDataCompressionCodecs == 0) {
 		return 0;
@@ -452,13 +869,13 @@ static int compressElements(Gvrs* gvrs, GvrsTile *tile) {
 				if (!iData) {
 					return GVRSERR_NOMEM;
 				}
-			    sData = (int16_t* )(tile->data + element->dataOffset);
+			    sData = (int16_t* )(data + element->dataOffset);
 				for (int iCell = 0; iCell < nCells; iCell++) {
 					iData[iCell] = sData[iCell];
 				}
 			}
 			else {
-				iData = (int32_t* )(tile->data + element->dataOffset);
+				iData = (int32_t* )(data + element->dataOffset);
 			}
 			int packingLength = 0;
 			uint8_t* packing = 0;
@@ -467,10 +884,21 @@ static int compressElements(Gvrs* gvrs, GvrsTile *tile) {
 				if (c->encodeInt) {
 					int bLen = 0;
 					uint8_t* b;
+					int64_t time0 = gvrs->statistics ? GvrsTimeNS() : 0;
 				    int status = c->encodeInt(nRows, nCols, iData, i, &bLen, &b, c->appInfo);
+					if (gvrs->statistics) {
+						recordEncoding(gvrs, i, GvrsTimeNS() - time0);
+					}
+					if (status == GVRSERR_COMPRESSION_FAILURE) {
+						// the codec was not able to reduce the size of the data
+						continue;
+					}
 					if (status) {
 						if (sData) {
-							free(sData);
+							free(iData);
+						}
+						if (packing) {
+							free(packing);
 						}
 						return status;
 					}
@@ -492,6 +920,12 @@ static int compressElements(Gvrs* gvrs, GvrsTile *tile) {
 					}
 				}
 			}
+			// A segment is recognized as compressed only when it is smaller than
+			// the uncompressed data.  If the codecs did not achieve that, the data is stored as is.
+			if (packingLength > 0 && packingLength >= element->dataSize) {
+				free(packing);
+				packingLength = 0;
+			}
 			if (packingLength > 0) {
 				blocks[iElement].compressed = 1;
 				blocks[iElement].nBytesInOutput = packingLength;
@@ -506,7 +940,7 @@ static int compressElements(Gvrs* gvrs, GvrsTile *tile) {
 			}
 		}
 		else if (GvrsElementIsFloat(element)) {
-			float* fData = (float*)(tile->data + element->dataOffset);
+			float* fData = (float*)(data + element->dataOffset);
 			int packingLength = 0;
 			uint8_t* packing = 0;
 
@@ -515,8 +949,19 @@ static int compressElements(Gvrs* gvrs, GvrsTile *tile) {
 				if (c->encodeFloat) {
 					int bLen = 0;
 					uint8_t* b;
+					int64_t time0 = gvrs->statistics ? GvrsTimeNS() : 0;
 					int status = c->encodeFloat(nRows, nCols, fData, i, &bLen, &b, c->appInfo);
+					if (gvrs->statistics) {
+						recordEncoding(gvrs, i, GvrsTimeNS() - time0);
+					}
+					if (status == GVRSERR_COMPRESSION_FAILURE) {
+						// the codec was not able to reduce the size of the data
+						continue;
+					}
 					if (status) {
+						if (packing) {
+							free(packing);
+						}
 						return status;
 					}
 					if (packing) {
@@ -537,6 +982,12 @@ static int compressElements(Gvrs* gvrs, GvrsTile *tile) {
 					}
 				}
 			}
+			// A segment is recognized as compressed only when it is smaller than
+			// the uncompressed data.  If the codecs did not achieve that, the data is stored as is.
+			if (packingLength > 0 && packingLength >= element->dataSize) {
+				free(packing);
+				packingLength = 0;
+			}
 			if (packingLength > 0) {
 				blocks[iElement].compressed = 1;
 				blocks[iElement].nBytesInOutput = packingLength;
@@ -553,6 +1004,8 @@ static int compressElements(Gvrs* gvrs, GvrsTile *tile) {
 }
 
  
+static int writeTileRecord(GvrsTileCache* tc, GvrsTile* tile, int nBytesForOutput);
+
 static int writeTile(GvrsTileCache* tc, GvrsTile* tile) {
 	// TO DO: If the tile is entirely populated with fill values, there is no need
 	//        to store it in the file.  If this is the first time the tile is being
@@ -565,16 +1018,20 @@ static int writeTile(GvrsTileCache* tc, GvrsTile* tile) {
 	tc->nTileWrites++;
 
 	Gvrs* gvrs = tc->gvrs;
-	FILE* fp = gvrs->fp;
-
-	int tileIndex = tile->tileIndex;
-	int64_t filePosition;
+	int64_t time0 = gvrs->eventHooks ? GvrsTimeNS() : 0;
 	int status;
 
 	clearOutputBlock(tc);
 
+	uint8_t* data = tile->data;
+	if (tc->cellRowIndex) {
+		// the codecs and the tile records use row-major order
+		transferLayout(tc, tile->data, tc->layoutBuffer, 0);
+		data = tc->layoutBuffer;
+	}
+
 	if (gvrs->nDataCompressionCodecs) {
-		status = compressElements(gvrs, tile);
+		status = compressElements(gvrs, data);
 		if (status) {
 			return status;
 		}
@@ -594,13 +1051,43 @@ static int writeTile(GvrsTileCache* tc, GvrsTile* tile) {
 			GvrsElement* e = gvrs->elements[iElement];
 			nBytesForOutput += e->dataSize;
 			blocks[iElement].nBytesInOutput = e->dataSize;
-			blocks[iElement].output = tile->data + e->dataOffset;
+			blocks[iElement].output = data + e->dataOffset;
 		}
 	}
 
+	// When writer clones are in use, the file-space allocation, file access,
+	// and tile-directory update must be performed by one thread at a time.
+	// The compression operations above are performed independently by each thread.
+	GvrsWriteLock(gvrs);
+	status = writeTileRecord(tc, tile, nBytesForOutput);
+	GvrsWriteUnlock(gvrs);
+	if (gvrs->eventHooks) {
+		GvrsEventReport(gvrs, GvrsEventWriteBack, tile->tileIndex, -1, -1, nBytesForOutput, tile->filePosition, GvrsTimeNS() - time0, status);
+	}
+	return status;
+}
+
+static int writeTileRecord(GvrsTileCache* tc, GvrsTile* tile, int nBytesForOutput) {
+	Gvrs* gvrs = tc->gvrs;
+	GvrsStatistics* statistics = gvrs->statistics;
+	int64_t time0 = statistics ? GvrsTimeNS() : 0;
+	int64_t nsAllocation = 0;
+	FILE* fp = gvrs->fp;
+	int tileIndex = tile->tileIndex;
+	int64_t filePosition;
+	int status;
+
 	// standard data size, plus one integer per each element, plus the tile index
 	if (tile->filePosition && nBytesForOutput != tile->fileRecordContentSize) {
+		int64_t timeD = statistics || gvrs->eventHooks ? GvrsTimeNS() : 0;
 		GvrsFileSpaceDealloc(gvrs->fileSpaceManager, tile->filePosition);
+		if (statistics) {
+			nsAllocation = GvrsTimeNS() - timeD;
+			statistics->nsAllocation += nsAllocation;
+		}
+		if (gvrs->eventHooks) {
+			GvrsEventReport(gvrs, GvrsEventFileSpaceDealloc, tileIndex, -1, -1, tile->fileRecordContentSize, tile->filePosition, GvrsTimeNS() - timeD, 0);
+		}
 		tile->fileRecordContentSize = 0;
 		tile->filePosition = 0;
 	}
@@ -618,7 +1105,17 @@ static int writeTile(GvrsTileCache* tc, GvrsTile* tile) {
 		// This tile has never been written before.  Allocate space for it
 		// and update the tile directory.  Note that the file-space alloction function
 		// sets the file position to the indicate position
+		int64_t timeA = statistics || gvrs->eventHooks ? GvrsTimeNS() : 0;
 		status = GvrsFileSpaceAlloc(gvrs->fileSpaceManager, GvrsRecordTypeTile, nBytesForOutput, &filePosition);
+		if (statistics) {
+			int64_t ns = GvrsTimeNS() - timeA;
+			nsAllocation += ns;
+			statistics->nsAllocation += ns;
+			statistics->nAllocations++;
+		}
+		if (gvrs->eventHooks) {
+			GvrsEventReport(gvrs, GvrsEventFileSpaceAlloc, tileIndex, -1, -1, nBytesForOutput, filePosition, GvrsTimeNS() - timeA, status);
+		}
 		allocated = 1;
 		//filePosition = GvrsFileSpaceAlloc(gvrs->fileSpaceManager, GvrsRecordTypeTile, gvrs->nBytesForTileData+32);
 		if (filePosition == 0) {
@@ -626,13 +1123,17 @@ static int writeTile(GvrsTileCache* tc, GvrsTile* tile) {
 		}
 		tile->filePosition = filePosition;
 		tile->fileRecordContentSize = nBytesForOutput;
-		GvrsTileDirectoryRegisterFilePosition(gvrs->tileDirectory, tileIndex, filePosition);
+		GvrsDirectoryLock(gvrs);
+		GvrsTileDirectoryRegisterFilePosition(gvrs->tileDirectory, tileIndex, filePosition, GvrsFileSpaceRecordSize(nBytesForOutput));
+		GvrsDirectoryUnlock(gvrs);
 		status = GvrsWriteInt(fp, tileIndex);
 	}
 
 	if (status) {
 		// Mark the directory cell as zero to reflect the failure
-		GvrsTileDirectoryRegisterFilePosition(gvrs->tileDirectory, tileIndex, 0);
+		GvrsDirectoryLock(gvrs);
+		GvrsTileDirectoryRegisterFilePosition(gvrs->tileDirectory, tileIndex, 0, 0);
+		GvrsDirectoryUnlock(gvrs);
 		return status;
 	}
 	 
@@ -650,63 +1151,242 @@ static int writeTile(GvrsTileCache* tc, GvrsTile* tile) {
 	if (allocated) {
 		  GvrsFileSpaceFinish(gvrs->fileSpaceManager, filePosition);
 	}
+	if (statistics) {
+		statistics->nsFileWrite += GvrsTimeNS() - time0 - nsAllocation;
+		statistics->nBytesWritten += nBytesForOutput;
+	}
 
 	return 0;
 }
 
+static int writePendingTile(GvrsTileCache* tc, GvrsTile* tile) {
+	int status = writeTile(tc, tile);
+	tile->writePending = 0;
+	return status;
+}
+
 int
 GvrsTileCacheWritePendingTiles(GvrsTileCache* tc) {
-	GvrsTile* tile = tc->firstTile;
-	while (tile) {
+	// The pending tiles may be on either the main list or the pinned list.
+	GvrsTile* tile;
+	int status;
+	for (tile = tc->head->next; tile != tc->tail; tile = tile->next) {
+		if (tile->writePending) {
+			status = writePendingTile(tc, tile);
+			if (status) {
+				return status;
+			}
+		}
+	}
+	for (tile = tc->pinnedTiles; tile; tile = tile->next) {
 		if (tile->writePending) {
-			int status = writeTile(tc, tile);
-			tile->writePending = 0;
+			status = writePendingTile(tc, tile);
 			if (status) {
 				return status;
 			}
 		}
-		tile = tile->next;
 	}
 	return 0;
 }
 
-// Get an uncommitted tile from the tile cache and place it at
-// the head of the priority queue.  If there is a tile on the free list,
-// use it. Otherwise, discard the least-recently used tile on the priority queue.
-// If tile-writing is enabled, the content of the discarded tile may be written
-// to the backing file.
-static GvrsTile* getWorkingTile(GvrsTileCache* tc, int tileIndex, int *errorCode) {
-	GvrsTile* node;
-	if (tc->freeList) {
-		// take a node from the free list
-		node = tc->freeList;
-		tc->freeList = node->next;
-		// add the node to the start of the cache queue
-		GvrsTile* p = tc->head;
-		GvrsTile* n = p->next;
-		p->next = node;
-		n->prior = node;
-		node->prior = p;
-		node->next = n;
-		node->tileIndex = tileIndex;
-		tc->firstTileIndex = tileIndex;
-		tc->firstTile = node;
+// Automatic sizing:
+//    The cache is evaluated over a window of accesses.  A miss on a tile that
+// is found in the ghost list (the ring buffer of recently evicted tile indices)
+// is a "re-miss", a miss that would not have occurred if the cache were larger.
+// The number of evictions since the tile was evicted gives the additional
+// capacity that would have retained it.  When re-misses account for a substantial
+// part of a window that has a significant miss rate, the cache is grown enough to
+// retain the deepest of them (up to the ceiling).  When a series of windows is
+// saturated (very few misses, none of them re-misses), the cache is reduced by
+// one eighth.  Each time the cache is grown, the number of saturated windows
+// required before it is reduced again is doubled so that a cache that is sized
+// just large enough for a cyclic access pattern does not oscillate.
+//    Tiles removed from the cache when it is reduced release their memory.
+
+#define AUTOMATIC_MIN_SIZE 2
+#define AUTOMATIC_MIN_WINDOW 64
+#define AUTOMATIC_SHRINK_DELAY 4
+#define AUTOMATIC_SHRINK_DELAY_MAX 1024
+
+static void recordGhost(GvrsTileCache* tc, int tileIndex) {
+	tc->ghostIndices[tc->ghostNext] = tileIndex;
+	tc->ghostSerials[tc->ghostNext] = tc->nEvictions++;
+	tc->ghostNext++;
+	if (tc->ghostNext == tc->maxTileCacheSize) {
+		tc->ghostNext = 0;
 	}
-	else {
-		// all tiles are already committed.  we need to remove the
-		// least-recently-used tile from the cache. 
-		node = tc->tail->prior; // last tile in queue
-		hashTableRemove(tc, node);
-		// Process any pending data, re-assign the tile index
+	if (tc->nGhosts < tc->maxTileCacheSize) {
+		tc->nGhosts++;
+	}
+}
+
+static void countGhost(GvrsTileCache* tc, int tileIndex) {
+	int i, k = tc->ghostNext;
+	for (i = 0; i < tc->nGhosts; i++) {
+		k = k == 0 ? tc->maxTileCacheSize - 1 : k - 1;
+		if (tc->ghostIndices[k] == tileIndex) {
+			int64_t depth = tc->nEvictions - tc->ghostSerials[k];
+			if (depth > tc->windowMaxDepth) {
+				tc->windowMaxDepth = depth > tc->maxTileCacheSize ? tc->maxTileCacheSize : (int32_t)depth;
+			}
+			tc->windowGhostHits++;
+			tc->ghostIndices[k] = -1; // so that it is counted only once
+			return;
+		}
+	}
+}
+
+static void resizeTileCache(GvrsTileCache* tc, int n) {
+	GvrsTile* node;
+	while (tc->currentTileCacheSize < n && tc->reserveList) {
+		node = tc->reserveList;
+		tc->reserveList = node->next;
+		node->next = tc->freeList;
+		tc->freeList = node;
+		tc->currentTileCacheSize++;
+	}
+	while (tc->currentTileCacheSize > n) {
+		if (tc->freeList) {
+			node = tc->freeList;
+			tc->freeList = node->next;
+		}
+		else {
+			node = tc->tail->prior;
+			if (node == tc->head) {
+				break;
+			}
+			hashTableRemove(tc, node);
+			if (node->writePending) {
+				writeTile(tc, node);
+			}
+			if (((Gvrs*)tc->gvrs)->eventHooks) {
+				GvrsEventReport(tc->gvrs, GvrsEventEvict, node->tileIndex, -1, -1, -1, node->filePosition, 0, 0);
+			}
+			recordGhost(tc, node->tileIndex);
+			node->prior->next = node->next;
+			node->next->prior = node->prior;
+			node->prior = 0;
+			if (tc->firstTile == node) {
+				tc->firstTile = 0;
+				tc->firstTileIndex = -1;
+			}
+			node->tileIndex = -1;
+			node->filePosition = 0;
+			node->writePending = 0;
+		}
+		free(node->data);
+		node->data = 0;
+		node->next = tc->reserveList;
+		tc->reserveList = node;
+		tc->currentTileCacheSize--;
+	}
+}
+
+static void adjustAutomaticSize(GvrsTileCache* tc) {
+	int n = tc->currentTileCacheSize;
+	if (tc->windowMisses * 20 > tc->windowAccesses && tc->windowGhostHits * 4 >= tc->windowMisses) {
+		int target = n + tc->windowMaxDepth;
+		if (target > tc->maxTileCacheSize) {
+			target = tc->maxTileCacheSize;
+		}
+		if (target > n) {
+			resizeTileCache(tc, target);
+			// the ghosts were evicted from the smaller cache, so their depths
+			// no longer indicate the capacity that is required
+			tc->nGhosts = 0;
+			tc->shrinkDelay *= 2;
+			if (tc->shrinkDelay > AUTOMATIC_SHRINK_DELAY_MAX) {
+				tc->shrinkDelay = AUTOMATIC_SHRINK_DELAY_MAX;
+			}
+		}
+		tc->nSaturatedWindows = 0;
+	}
+	else if (tc->windowGhostHits == 0 && tc->windowMisses * 100 <= tc->windowAccesses) {
+		tc->nSaturatedWindows++;
+		if (tc->nSaturatedWindows >= tc->shrinkDelay && n > AUTOMATIC_MIN_SIZE) {
+			int target = n - (n + 7) / 8;
+			resizeTileCache(tc, target < AUTOMATIC_MIN_SIZE ? AUTOMATIC_MIN_SIZE : target);
+			tc->nSaturatedWindows = 0;
+		}
+	}
+	else {
+		tc->nSaturatedWindows = 0;
+	}
+	tc->windowAccesses = 0;
+	tc->windowMisses = 0;
+	tc->windowGhostHits = 0;
+	tc->windowMaxDepth = 0;
+}
+
+int GvrsTileCacheEnableAutomaticSize(GvrsTileCache* tc, int initialSize) {
+	tc->ghostIndices = calloc((size_t)tc->maxTileCacheSize, sizeof(int32_t));
+	tc->ghostSerials = calloc((size_t)tc->maxTileCacheSize, sizeof(int64_t));
+	if (!tc->ghostIndices || !tc->ghostSerials) {
+		free(tc->ghostIndices);
+		free(tc->ghostSerials);
+		tc->ghostIndices = 0;
+		tc->ghostSerials = 0;
+		return GVRSERR_NOMEM;
+	}
+	tc->automaticSize = 1;
+	tc->shrinkDelay = AUTOMATIC_SHRINK_DELAY;
+	tc->currentTileCacheSize = tc->maxTileCacheSize;
+	if (initialSize < AUTOMATIC_MIN_SIZE) {
+		initialSize = AUTOMATIC_MIN_SIZE;
+	}
+	resizeTileCache(tc, initialSize);
+	return 0;
+}
+
+
+// Get an uncommitted tile from the tile cache and place it at
+// the head of the priority queue.  If there is a tile on the free list,
+// use it. Otherwise, discard the least-recently used tile on the priority queue.
+// If tile-writing is enabled, the content of the discarded tile may be written
+// to the backing file.
+static GvrsTile* takeTile(GvrsTileCache* tc, int tileIndex) {
+	GvrsTile* node;
+	if (tc->freeList) {
+		// take a node from the free list
+		node = tc->freeList;
+		tc->freeList = node->next;
+		// add the node to the start of the cache queue
+		GvrsTile* p = tc->head;
+		GvrsTile* n = p->next;
+		p->next = node;
+		n->prior = node;
+		node->prior = p;
+		node->next = n;
+		node->tileIndex = tileIndex;
+		tc->firstTileIndex = tileIndex;
+		tc->firstTile = node;
+	}
+	else {
+		// all tiles are already committed.  we need to remove the
+		// least-recently-used tile from the cache. 
+		node = tc->tail->prior; // last tile in queue
+		hashTableRemove(tc, node);
+		if (tc->automaticSize) {
+			recordGhost(tc, node->tileIndex);
+		}
+		// Process any pending data, re-assign the tile index
 		// TO DO: if a write is pending, write the tile to the backing storage
 		if (node->writePending) {
 			writeTile(tc, node);
 		}
+		if (((Gvrs*)tc->gvrs)->eventHooks) {
+			GvrsEventReport(tc->gvrs, GvrsEventEvict, node->tileIndex, -1, -1, -1, node->filePosition, 0, 0);
+		}
 		node->filePosition = 0;
 		node->writePending = 0;
 		node->tileIndex = tileIndex;
 		moveTileToHeadOfMainList(tc, node); // will also set firstTile and firstTileIndex
 	}
+	return node;
+}
+
+static GvrsTile* getWorkingTile(GvrsTileCache* tc, int tileIndex, int *errorCode) {
+	GvrsTile* node = takeTile(tc, tileIndex);
 
 	// The tile "objects" from the cache are reused.  If this one was already used,
 	// then the data pointer will be populated with a reference to the previously
@@ -747,34 +1427,146 @@ GvrsTile* GvrsTileCacheStartNewTile(GvrsTileCache* tc, int tileIndex, int* errCo
 	return tile; 
 }
 
+GvrsTile* GvrsTileCacheLookup(GvrsTileCache* tc, int tileIndex) {
+	tc->nCacheSearches++;
+	GvrsTile* node = hashTableLookup(tc, tileIndex);
+	if (node) {
+		moveTileToHeadOfMainList(tc, node); // will also set firstTile and firstTileIndex
+	}
+	return node;
+}
+
+GvrsTile* GvrsTileCacheInstallTile(GvrsTileCache* tc, int tileIndex, int64_t filePos, uint8_t** data) {
+	GvrsTile* node = hashTableLookup(tc, tileIndex);
+	if (node) {
+		return node;
+	}
+	node = takeTile(tc, tileIndex);
+	uint8_t* p = node->data;
+	node->data = *data;
+	*data = p;
+	node->filePosition = filePos;
+	node->fileRecordContentSize = 0;
+	hashTablePut(tc, node);
+	return node;
+}
+
 GvrsTile* GvrsTileCacheFetchTile(GvrsTileCache* tc, int tileIndex, int* errCode) {
 	tc->nCacheSearches++;
+	if (tc->automaticSize) {
+		// the size is adjusted before the search so that the tile that is
+		// returned is not removed by a reduction
+		int windowSize = tc->currentTileCacheSize * 4;
+		if (tc->windowAccesses >= (windowSize > AUTOMATIC_MIN_WINDOW ? windowSize : AUTOMATIC_MIN_WINDOW)) {
+			adjustAutomaticSize(tc);
+		}
+		tc->windowAccesses++;
+	}
 	GvrsTile* node = hashTableLookup(tc, tileIndex);
 	if (node) {
 		// the node is already in the cache
 		moveTileToHeadOfMainList(tc, node); // will also set firstTile and firstTileIndex
+		if (((Gvrs*)tc->gvrs)->accessTrace) {
+			GvrsAccessTraceRecord(tc->gvrs, tileIndex, 0);
+		}
 		return node;
 	}
 
+	if (((Gvrs*)tc->gvrs)->tileLoader) {
+		// the background loader may have already decoded the tile.  If the loader failed
+		// to read the tile, the read is attempted again below.
+		int loaderStatus;
+		node = GvrsTileLoaderInstall(tc->gvrs, tileIndex, &loaderStatus);
+		if (node) {
+			if (((Gvrs*)tc->gvrs)->accessTrace) {
+				GvrsAccessTraceRecord(tc->gvrs, tileIndex, 0);
+			}
+			return node;
+		}
+	}
  
 	// The tile does not exist in the cache.  It will need to be read
 	// from the source file.  Check to see if it is populated at all.
+	// If writer clones are in use, the tile directory may be modified by another thread,
+	// so the directory lock is held for the lookup.
+	if (!tc->tileDirectory) {
+		// the tile directory is loaded on first use
+		int status = GvrsLoadTileDirectory(tc->gvrs);
+		if (status) {
+			*errCode = status;
+			return 0;
+		}
+		tc->tileDirectory = ((Gvrs*)tc->gvrs)->tileDirectory;
+	}
+	GvrsDirectoryLock(tc->gvrs);
 	int64_t tileOffset = GvrsTileDirectoryGetFilePosition(tc->tileDirectory, tileIndex);
+	GvrsDirectoryUnlock(tc->gvrs);
 	if (!tileOffset) {
 		*errCode = 0;
 		return 0; // tile not found
 	}
+	if (tc->automaticSize) {
+		tc->windowMisses++;
+		countGhost(tc, tileIndex);
+	}
+	Gvrs* gvrs = tc->gvrs;
+	int64_t missTime0 = gvrs->statistics || gvrs->eventHooks ? GvrsTimeNS() : 0;
+	if (gvrs->eventHooks) {
+		GvrsEventReport(gvrs, GvrsEventMissStart, tileIndex, -1, -1, -1, tileOffset, 0, 0);
+	}
 
 	// The target tile is not in the cache.  We need to take a tile from the
 	// free list or repurpose a tile that is in the cache. In either case,
 	// the "working" tile will be placed at the head of the queue.
 	node = getWorkingTile(tc, tileIndex, errCode);
 	if (!node) {
+		if (gvrs->eventHooks) {
+			GvrsEventReport(gvrs, GvrsEventMissEnd, tileIndex, -1, -1, -1, tileOffset, GvrsTimeNS() - missTime0, *errCode);
+		}
 		return 0;
 	}
 
 	tc->nTileReads++;
-	int status = readTile(tc->gvrs, tileOffset, node);
+	int status;
+	if (gvrs->sharedTileCache) {
+		// check to see if another instance (or process) has already decoded the tile.
+		status = 0;
+		if (!node->data) {
+			node->data = calloc(1, gvrs->nBytesForTileData);
+			if (!node->data) {
+				status = GVRSERR_NOMEM;
+			}
+		}
+		if (!status && GvrsSharedTileCacheGet(gvrs, tileIndex, tileOffset, node->data)) {
+			GvrsTileCacheApplyLayout(tc, &node->data);
+			node->filePosition = tileOffset;
+			node->fileRecordContentSize = 0;
+			hashTablePut(tc, node);
+			if (gvrs->accessTrace) {
+				GvrsAccessTraceRecord(gvrs, tileIndex, 0);
+			}
+			if (gvrs->statistics) {
+				GvrsStatisticsRecordMiss(gvrs, GvrsTimeNS() - missTime0);
+			}
+			if (gvrs->eventHooks) {
+				GvrsEventReport(gvrs, GvrsEventMissEnd, tileIndex, -1, -1, 0, tileOffset, GvrsTimeNS() - missTime0, 0);
+			}
+			return node;
+		}
+		if (!status) {
+			status = readTile(gvrs, tileIndex, tileOffset, node);
+			if (!status) {
+				GvrsSharedTileCachePut(gvrs, tileIndex, tileOffset, node->data);
+			}
+		}
+	}
+	else {
+		status = readTile(gvrs, tileIndex, tileOffset, node);
+	}
+	if (!status) {
+		// the data from the file is in row-major order
+		GvrsTileCacheApplyLayout(tc, &node->data);
+	}
 	if (status) {
 		// The read operation failed
 		// Restore the node to the free list for future use
@@ -791,12 +1583,24 @@ GvrsTile* GvrsTileCacheFetchTile(GvrsTileCache* tc, int tileIndex, int* errCode)
 		node->next = tc->freeList;
 		tc->freeList = node;
 		*errCode = status;
+		if (gvrs->eventHooks) {
+			GvrsEventReport(gvrs, GvrsEventMissEnd, tileIndex, -1, -1, -1, tileOffset, GvrsTimeNS() - missTime0, status);
+		}
 		return 0;
 	}
 
 	// The content was sucessfully read into the target node.
 	// Add it to the hash table
 	hashTablePut(tc, node);
+	if (gvrs->accessTrace) {
+		GvrsAccessTraceRecord(gvrs, tileIndex, node->fileRecordContentSize);
+	}
+	if (gvrs->statistics) {
+		GvrsStatisticsRecordMiss(gvrs, GvrsTimeNS() - missTime0);
+	}
+	if (gvrs->eventHooks) {
+		GvrsEventReport(gvrs, GvrsEventMissEnd, tileIndex, -1, -1, node->fileRecordContentSize, tileOffset, GvrsTimeNS() - missTime0, 0);
+	}
 	return node;
 }
 
@@ -807,6 +1611,19 @@ GvrsTileCache* GvrsTileCacheFree(GvrsTileCache* cache) {
 	if (cache) {
 		int i;
 		cache->hashTable = hashTableFree(cache->hashTable);
+		GvrsTile* pinned = cache->pinnedTiles;
+		while (pinned) {
+			GvrsTile* next = pinned->next;
+			free(pinned->data);
+			free(pinned);
+			pinned = next;
+		}
+		cache->pinnedTiles = 0;
+		cache->nPinnedTiles = 0;
+		free(cache->ghostIndices);
+		free(cache->ghostSerials);
+		cache->ghostIndices = 0;
+		cache->ghostSerials = 0;
 		for (i = 0; i < cache->maxTileCacheSize; i++) {
 			if (cache->tileReferenceArray[i].data) {
 				free(cache->tileReferenceArray[i].data);
@@ -818,6 +1635,11 @@ GvrsTileCache* GvrsTileCacheFree(GvrsTileCache* cache) {
 ;
 		clearOutputBlock(cache);
 		free(cache->outputBlocks);
+		freeLayout(cache);
+		free(cache->readAheadBuffer);
+		cache->readAheadBuffer = 0;
+		free(cache->recordBuffer);
+		cache->recordBuffer = 0;
 		
 		cache->head = 0;
 		cache->tail = 0;
@@ -849,6 +1671,7 @@ int GvrsTileCacheComputeStandardSize(int nRowsOfTiles, int nColsOfTiles, GvrsTil
 	case GvrsTileCacheSizeLarge:
 		return nMax;
 	case GvrsTileCacheSizeExtraLarge:
+	case GvrsTileCacheSizeAutomatic:
 		return nMax * 2;
 	default:
 		return 9;
@@ -866,7 +1689,15 @@ int GvrsIsTilePopulated(Gvrs* gvrs, int tileIndex) {
 	if (node) {
 		return 1;
 	}
+	if (!tc->tileDirectory) {
+		if (GvrsLoadTileDirectory(gvrs)) {
+			return 0;
+		}
+		tc->tileDirectory = gvrs->tileDirectory;
+	}
+	GvrsDirectoryLock(gvrs);
 	int64_t tileOffset = GvrsTileDirectoryGetFilePosition(tc->tileDirectory, tileIndex);
+	GvrsDirectoryUnlock(gvrs);
 	if (tileOffset) {
 		return 1;
 	}
@@ -874,3 +1705,611 @@ int GvrsIsTilePopulated(Gvrs* gvrs, int tileIndex) {
 	return 0;
 }
 
+
+
+// Pinned regions:
+//    Tiles that are not already in memory are read by a set of workers that take
+// tiles from a list sorted by file position.  Worker zero uses the source instance.
+// The others use reader clones, so each has its own file pointer and codecs.
+// The pinned tiles are installed only after all reads succeed, so a failure leaves
+// the cache unchanged.
+
+typedef struct GvrsPinLoadTag {
+	int tileIndex;
+	int64_t filePos;
+	GvrsTile* tile;
+}GvrsPinLoad;
+
+typedef struct GvrsPinJobTag {
+	GvrsPinLoad* loads;
+	int nLoads;
+	GvrsMutex* mutex;
+	int next;
+	int status;
+}GvrsPinJob;
+
+typedef struct GvrsPinWorkerTag {
+	GvrsPinJob* job;
+	Gvrs* gvrs;
+	GvrsThread* thread;
+}GvrsPinWorker;
+
+static int comparePinLoads(const void* p1, const void* p2) {
+	int64_t a = ((const GvrsPinLoad*)p1)->filePos;
+	int64_t b = ((const GvrsPinLoad*)p2)->filePos;
+	return (a > b) - (a < b);
+}
+
+static int runPinWorker(void* argument) {
+	GvrsPinWorker* worker = (GvrsPinWorker*)argument;
+	GvrsPinJob* job = worker->job;
+	for (;;) {
+		GvrsMutexLock(job->mutex);
+		if (job->status || job->next >= job->nLoads) {
+			GvrsMutexUnlock(job->mutex);
+			break;
+		}
+		GvrsPinLoad* load = job->loads + job->next++;
+		GvrsMutexUnlock(job->mutex);
+
+		int status = readTile(worker->gvrs, load->tileIndex, load->filePos, load->tile);
+		if (status) {
+			GvrsMutexLock(job->mutex);
+			if (!job->status) {
+				job->status = status;
+			}
+			GvrsMutexUnlock(job->mutex);
+			break;
+		}
+	}
+	return 0;
+}
+
+static int loadPinnedTiles(Gvrs* gvrs, GvrsPinLoad* loads, int nLoads) {
+	GvrsPinJob job;
+	memset(&job, 0, sizeof(job));
+	job.loads = loads;
+	job.nLoads = nLoads;
+	qsort(loads, (size_t)nLoads, sizeof(GvrsPinLoad), comparePinLoads);
+
+	int nWorkers = GvrsGetProcessorCount();
+	if (nWorkers > (nLoads + 3) / 4) {
+		nWorkers = (nLoads + 3) / 4;
+	}
+	if (nWorkers < 1) {
+		nWorkers = 1;
+	}
+	GvrsPinWorker* workers = calloc((size_t)nWorkers, sizeof(GvrsPinWorker));
+	if (!workers) {
+		return GVRSERR_NOMEM;
+	}
+	int status = GvrsMutexInit(&job.mutex);
+	if (status) {
+		free(workers);
+		return status;
+	}
+
+	int i;
+	workers[0].job = &job;
+	workers[0].gvrs = gvrs;
+	for (i = 1; i < nWorkers; i++) {
+		workers[i].job = &job;
+		if (GvrsOpenReaderClone(gvrs, &workers[i].gvrs)) {
+			// the tiles will be loaded by the workers that were established
+			break;
+		}
+		if (GvrsThreadStart(&workers[i].thread, runPinWorker, workers + i)) {
+			break;
+		}
+	}
+	runPinWorker(workers);
+	for (i = 1; i < nWorkers; i++) {
+		if (workers[i].thread) {
+			GvrsThreadJoin(workers[i].thread);
+		}
+		if (workers[i].gvrs) {
+			GvrsClose(workers[i].gvrs);
+		}
+	}
+	free(workers);
+	GvrsMutexFree(job.mutex);
+	return job.status;
+}
+
+static int checkRegion(Gvrs* gvrs, int row0, int col0, int row1, int col1) {
+	if (!gvrs) {
+		return GVRSERR_NULL_ARGUMENT;
+	}
+	if (row0 < 0 || col0 < 0 || row0 > row1 || col0 > col1
+		|| row1 >= gvrs->nRowsInRaster || col1 >= gvrs->nColsInRaster) {
+		return GVRSERR_COORDINATE_OUT_OF_BOUNDS;
+	}
+	return 0;
+}
+
+static int64_t getPinnedMemory(Gvrs* gvrs) {
+	GvrsTileCache* tc = gvrs->tileCache;
+	return (int64_t)tc->nPinnedTiles * ((int64_t)gvrs->nBytesForTileData + (int64_t)sizeof(GvrsTile));
+}
+
+static void freePinLoads(GvrsPinLoad* loads, int nLoads) {
+	int i;
+	for (i = 0; i < nLoads; i++) {
+		if (loads[i].tile) {
+			free(loads[i].tile->data);
+			free(loads[i].tile);
+		}
+	}
+	free(loads);
+}
+
+int GvrsPinRegion(Gvrs* gvrs, int row0, int col0, int row1, int col1, int64_t* nBytesPinned) {
+	int status = checkRegion(gvrs, row0, col0, row1, col1);
+	if (status) {
+		return status;
+	}
+	if (gvrs->timeOpenedForWritingMS) {
+		return GVRSERR_INVALID_PARAMETER;
+	}
+	status = GvrsLoadTileDirectory(gvrs);
+	if (status) {
+		return status;
+	}
+	GvrsTileCache* tc = gvrs->tileCache;
+	tc->tileDirectory = gvrs->tileDirectory;
+
+	int tileRow0 = row0 / gvrs->nRowsInTile;
+	int tileRow1 = row1 / gvrs->nRowsInTile;
+	int tileCol0 = col0 / gvrs->nColsInTile;
+	int tileCol1 = col1 / gvrs->nColsInTile;
+	int nTiles = (tileRow1 - tileRow0 + 1) * (tileCol1 - tileCol0 + 1);
+	GvrsPinLoad* loads = calloc((size_t)nTiles, sizeof(GvrsPinLoad));
+	if (!loads) {
+		return GVRSERR_NOMEM;
+	}
+
+	// Identify the tiles that are not already pinned and allocate storage for them.
+	// Tiles that are in the tile cache are copied rather than read.
+	int nLoads = 0;
+	int nCopies = 0;
+	int tileRow, tileCol, i;
+	for (tileRow = tileRow0; tileRow <= tileRow1; tileRow++) {
+		for (tileCol = tileCol0; tileCol <= tileCol1; tileCol++) {
+			int tileIndex = tileRow * gvrs->nColsOfTiles + tileCol;
+			GvrsTile* node = hashTableLookup(tc, tileIndex);
+			if (node && node->pinCount) {
+				continue;
+			}
+			int64_t filePos = node ? node->filePosition : GvrsTileDirectoryGetFilePosition(tc->tileDirectory, tileIndex);
+			if (!filePos) {
+				continue;
+			}
+			GvrsTile* tile = calloc(1, sizeof(GvrsTile));
+			if (tile) {
+				tile->data = malloc(gvrs->nBytesForTileData);
+			}
+			if (!tile || !tile->data) {
+				free(tile);
+				freePinLoads(loads, nTiles);
+				return GVRSERR_NOMEM;
+			}
+			tile->tileIndex = tileIndex;
+			tile->referenceArrayIndex = -1;
+			tile->filePosition = filePos;
+			if (node) {
+				memcpy(tile->data, node->data, gvrs->nBytesForTileData);
+				// copies are stored at the end of the array, reads at the beginning
+				loads[nTiles - 1 - nCopies].tile = tile;
+				loads[nTiles - 1 - nCopies].tileIndex = tileIndex;
+				nCopies++;
+			}
+			else {
+				loads[nLoads].tile = tile;
+				loads[nLoads].tileIndex = tileIndex;
+				loads[nLoads].filePos = filePos;
+				nLoads++;
+			}
+		}
+	}
+
+	if (nLoads > 0) {
+		status = loadPinnedTiles(gvrs, loads, nLoads);
+		if (status) {
+			freePinLoads(loads, nTiles);
+			return status;
+		}
+		tc->nTileReads += nLoads;
+		// the tiles that were read are in row-major order, the copies are already in the cache layout
+		for (i = 0; i < nLoads; i++) {
+			GvrsTileCacheApplyLayout(tc, &loads[i].tile->data);
+		}
+	}
+
+	// All tiles are available.  Install the pins.
+	for (tileRow = tileRow0; tileRow <= tileRow1; tileRow++) {
+		for (tileCol = tileCol0; tileCol <= tileCol1; tileCol++) {
+			int tileIndex = tileRow * gvrs->nColsOfTiles + tileCol;
+			GvrsTile* node = hashTableLookup(tc, tileIndex);
+			if (node && node->pinCount) {
+				node->pinCount++;
+			}
+			else if (node) {
+				// remove the tile from the main list and return it to the free list
+				hashTableRemove(tc, node);
+				node->prior->next = node->next;
+				node->next->prior = node->prior;
+				node->prior = 0;
+				node->next = tc->freeList;
+				node->tileIndex = -1;
+				node->writePending = 0;
+				node->filePosition = 0;
+				tc->freeList = node;
+			}
+		}
+	}
+	for (i = 0; i < nTiles; i++) {
+		GvrsTile* tile = loads[i].tile;
+		if (tile) {
+			tile->pinCount = 1;
+			tile->prior = 0;
+			tile->next = tc->pinnedTiles;
+			if (tc->pinnedTiles) {
+				tc->pinnedTiles->prior = tile;
+			}
+			tc->pinnedTiles = tile;
+			tc->nPinnedTiles++;
+			hashTablePut(tc, tile);
+			loads[i].tile = 0;
+		}
+	}
+	free(loads);
+	tc->firstTile = 0;
+	tc->firstTileIndex = -1;
+
+	if (nBytesPinned) {
+		*nBytesPinned = getPinnedMemory(gvrs);
+	}
+	return 0;
+}
+
+int GvrsUnpinRegion(Gvrs* gvrs, int row0, int col0, int row1, int col1, int64_t* nBytesPinned) {
+	int status = checkRegion(gvrs, row0, col0, row1, col1);
+	if (status) {
+		return status;
+	}
+	GvrsTileCache* tc = gvrs->tileCache;
+	int tileRow0 = row0 / gvrs->nRowsInTile;
+	int tileRow1 = row1 / gvrs->nRowsInTile;
+	int tileCol0 = col0 / gvrs->nColsInTile;
+	int tileCol1 = col1 / gvrs->nColsInTile;
+	int tileRow, tileCol;
+	for (tileRow = tileRow0; tileRow <= tileRow1; tileRow++) {
+		for (tileCol = tileCol0; tileCol <= tileCol1; tileCol++) {
+			int tileIndex = tileRow * gvrs->nColsOfTiles + tileCol;
+			GvrsTile* node = hashTableLookup(tc, tileIndex);
+			if (!node || !node->pinCount) {
+				continue;
+			}
+			node->pinCount--;
+			if (node->pinCount) {
+				continue;
+			}
+			if (node->prior) {
+				node->prior->next = node->next;
+			}
+			else {
+				tc->pinnedTiles = node->next;
+			}
+			if (node->next) {
+				node->next->prior = node->prior;
+			}
+			tc->nPinnedTiles--;
+			hashTableRemove(tc, node);
+			if (tc->firstTile == node) {
+				tc->firstTile = 0;
+				tc->firstTileIndex = -1;
+			}
+			// Transfer the content to the tile cache.  The installation
+			// returns a buffer that is no longer needed by the cache.
+			GvrsTileCacheInstallTile(tc, tileIndex, node->filePosition, &node->data);
+			free(node->data);
+			free(node);
+		}
+	}
+	if (nBytesPinned) {
+		*nBytesPinned = getPinnedMemory(gvrs);
+	}
+	return 0;
+}
+
+int GvrsTileCacheTransferPins(GvrsTileCache* source, GvrsTileCache* target) {
+	int status = 0;
+	GvrsTile* tile;
+	for (tile = source->pinnedTiles; tile; tile = tile->next) {
+		int s = hashTablePut(target, tile);
+		if (s && !status) {
+			status = s;
+		}
+	}
+	target->pinnedTiles = source->pinnedTiles;
+	target->nPinnedTiles = source->nPinnedTiles;
+	source->pinnedTiles = 0;
+	source->nPinnedTiles = 0;
+	return status;
+}
+
+
+
+// Cache manifests:
+//    A manifest is a list of the tile indices that are resident in the tile cache,
+// given from most-recently used to least-recently used.  It is stored either in a
+// small file of its own or as a metadata record in the GVRS file.  The file form is
+//     identifier        GVRS string  "GvrsCacheManifest"
+//     version           int          (currently 1)
+//     uuidLow, uuidHigh long         (identify the GVRS file)
+//     nRowsOfTiles      int
+//     nColsOfTiles      int
+//     nTiles            int
+//     tile indices      int[nTiles]
+// The metadata form is an integer array giving the tile indices.
+//    When a manifest is loaded, the tiles are read using the same parallel,
+// file-position-ordered procedure that is used for pinned regions.  The tiles
+// are then installed from least-recently used to most-recently used so that the
+// order of the cache matches the order at the time the manifest was saved.
+
+#define CACHE_MANIFEST_NAME "GvrsCacheManifest"
+#define CACHE_MANIFEST_VERSION 1
+
+static int collectManifest(Gvrs* gvrs, int* nTiles, int32_t** tileIndices) {
+	GvrsTileCache* tc = gvrs->tileCache;
+	int32_t* indices = malloc((size_t)(tc->maxTileCacheSize + 1) * sizeof(int32_t));
+	if (!indices) {
+		return GVRSERR_NOMEM;
+	}
+	int n = 0;
+	GvrsTile* node;
+	for (node = tc->head->next; node != tc->tail && n < tc->maxTileCacheSize; node = node->next) {
+		indices[n++] = node->tileIndex;
+	}
+	*nTiles = n;
+	*tileIndices = indices;
+	return 0;
+}
+
+int GvrsSaveCacheManifest(Gvrs* gvrs, const char* path) {
+	if (!gvrs) {
+		return GVRSERR_NULL_ARGUMENT;
+	}
+	int nTiles;
+	int32_t* indices;
+	int status = collectManifest(gvrs, &nTiles, &indices);
+	if (status) {
+		return status;
+	}
+
+	if (!path) {
+		GvrsMetadata* m;
+		status = GvrsMetadataInit(CACHE_MANIFEST_NAME, 0, &m);
+		if (!status) {
+			status = GvrsMetadataSetData(m, GvrsMetadataTypeInt, nTiles * 4, indices);
+			if (!status) {
+				GvrsMetadataSetDescription(m, "Tile indices resident in the tile cache, most-recently used first");
+				status = GvrsMetadataWrite(gvrs, m);
+			}
+			GvrsMetadataFree(m);
+		}
+		free(indices);
+		return status;
+	}
+
+	FILE* fp = fopen(path, "wb");
+	if (!fp) {
+		free(indices);
+		return GVRSERR_FILE_ACCESS;
+	}
+	status = GvrsWriteString(fp, CACHE_MANIFEST_NAME);
+	status |= GvrsWriteInt(fp, CACHE_MANIFEST_VERSION);
+	status |= GvrsWriteLong(fp, gvrs->uuidLow);
+	status |= GvrsWriteLong(fp, gvrs->uuidHigh);
+	status |= GvrsWriteInt(fp, gvrs->nRowsOfTiles);
+	status |= GvrsWriteInt(fp, gvrs->nColsOfTiles);
+	status |= GvrsWriteInt(fp, nTiles);
+	int i;
+	for (i = 0; i < nTiles && !status; i++) {
+		status = GvrsWriteInt(fp, indices[i]);
+	}
+	free(indices);
+	if (fclose(fp) || status) {
+		return GVRSERR_FILE_ERROR;
+	}
+	return 0;
+}
+
+static int readManifestFile(Gvrs* gvrs, const char* path, int* nTiles, int32_t** tileIndices) {
+	FILE* fp = fopen(path, "rb");
+	if (!fp) {
+		return GVRSERR_FILENOTFOUND;
+	}
+	char identifier[32];
+	int32_t version = 0, nRowsOfTiles = 0, nColsOfTiles = 0, n = 0;
+	int64_t uuidLow = 0, uuidHigh = 0;
+	int status = GvrsReadIdentifier(fp, sizeof(identifier), identifier);
+	if (!status) {
+		if (strcmp(identifier, CACHE_MANIFEST_NAME)) {
+			status = GVRSERR_INVALID_FILE;
+		}
+		else {
+			GvrsReadInt(fp, &version);
+			GvrsReadLong(fp, &uuidLow);
+			GvrsReadLong(fp, &uuidHigh);
+			GvrsReadInt(fp, &nRowsOfTiles);
+			GvrsReadInt(fp, &nColsOfTiles);
+			status = GvrsReadInt(fp, &n);
+		}
+	}
+	if (!status) {
+		if (version != CACHE_MANIFEST_VERSION) {
+			status = GVRSERR_VERSION_NOT_SUPPORTED;
+		}
+		else if (uuidLow != gvrs->uuidLow || uuidHigh != gvrs->uuidHigh
+			|| nRowsOfTiles != gvrs->nRowsOfTiles || nColsOfTiles != gvrs->nColsOfTiles) {
+			// the manifest was saved for a different file
+			status = GVRSERR_INVALID_PARAMETER;
+		}
+		else if (n < 0 || n > nRowsOfTiles * nColsOfTiles) {
+			status = GVRSERR_INVALID_FILE;
+		}
+	}
+	int32_t* indices = 0;
+	if (!status) {
+		indices = malloc((size_t)(n + 1) * sizeof(int32_t));
+		if (!indices) {
+			status = GVRSERR_NOMEM;
+		}
+	}
+	int i;
+	for (i = 0; i < n && !status; i++) {
+		status = GvrsReadInt(fp, indices + i);
+	}
+	fclose(fp);
+	if (status) {
+		free(indices);
+		return status;
+	}
+	*nTiles = n;
+	*tileIndices = indices;
+	return 0;
+}
+
+static int readManifestMetadata(Gvrs* gvrs, int* nTiles, int32_t** tileIndices) {
+	GvrsMetadataResultSet* rs;
+	int status = GvrsReadMetadataByNameAndID(gvrs, CACHE_MANIFEST_NAME, 0, &rs);
+	if (status) {
+		return status;
+	}
+	if (rs->nRecords == 0) {
+		GvrsMetadataResultSetFree(rs);
+		return GVRSERR_ELEMENT_NOT_FOUND;
+	}
+	int n = 0;
+	int32_t* values = 0;
+	status = GvrsMetadataGetIntArray(rs->records[0], &n, &values);
+	int32_t* indices = 0;
+	if (!status) {
+		indices = malloc((size_t)(n + 1) * sizeof(int32_t));
+		if (indices) {
+			memcpy(indices, values, (size_t)n * sizeof(int32_t));
+		}
+		else {
+			status = GVRSERR_NOMEM;
+		}
+	}
+	GvrsMetadataResultSetFree(rs);
+	if (status) {
+		return status;
+	}
+	*nTiles = n;
+	*tileIndices = indices;
+	return 0;
+}
+
+int GvrsLoadCacheManifest(Gvrs* gvrs, const char* path, int* nTilesLoaded) {
+	if (nTilesLoaded) {
+		*nTilesLoaded = 0;
+	}
+	if (!gvrs) {
+		return GVRSERR_NULL_ARGUMENT;
+	}
+	if (gvrs->timeOpenedForWritingMS) {
+		return GVRSERR_INVALID_PARAMETER;
+	}
+	int nTiles = 0;
+	int32_t* indices = 0;
+	int status = path ? readManifestFile(gvrs, path, &nTiles, &indices) : readManifestMetadata(gvrs, &nTiles, &indices);
+	if (status) {
+		return status;
+	}
+	status = GvrsLoadTileDirectory(gvrs);
+	if (status) {
+		free(indices);
+		return status;
+	}
+	GvrsTileCache* tc = gvrs->tileCache;
+	tc->tileDirectory = gvrs->tileDirectory;
+
+	// The manifest may have been saved with a larger cache, so only the
+	// most-recently used tiles are loaded.  Tiles that are already in memory,
+	// or that are not populated, are skipped.
+	if (nTiles > tc->maxTileCacheSize) {
+		nTiles = tc->maxTileCacheSize;
+	}
+	int nTilesInRaster = gvrs->nRowsOfTiles * gvrs->nColsOfTiles;
+	GvrsPinLoad* loads = calloc((size_t)nTiles + 1, sizeof(GvrsPinLoad));
+	GvrsTile** order = calloc((size_t)nTiles + 1, sizeof(GvrsTile*));
+	if (!loads || !order) {
+		free(loads);
+		free(order);
+		free(indices);
+		return GVRSERR_NOMEM;
+	}
+	int nLoads = 0;
+	int i;
+	for (i = 0; i < nTiles; i++) {
+		int tileIndex = indices[i];
+		if (tileIndex < 0 || tileIndex >= nTilesInRaster || hashTableLookup(tc, tileIndex)) {
+			continue;
+		}
+		int64_t filePos = GvrsTileDirectoryGetFilePosition(tc->tileDirectory, tileIndex);
+		if (!filePos) {
+			continue;
+		}
+		GvrsTile* tile = calloc(1, sizeof(GvrsTile));
+		if (tile) {
+			tile->data = malloc(gvrs->nBytesForTileData);
+		}
+		if (!tile || !tile->data) {
+			free(tile);
+			status = GVRSERR_NOMEM;
+			break;
+		}
+		tile->tileIndex = tileIndex;
+		tile->referenceArrayIndex = -1;
+		tile->filePosition = filePos;
+		loads[nLoads].tile = tile;
+		loads[nLoads].tileIndex = tileIndex;
+		loads[nLoads].filePos = filePos;
+		order[nLoads] = tile;
+		nLoads++;
+	}
+	free(indices);
+
+	if (!status && nLoads > 0) {
+		status = loadPinnedTiles(gvrs, loads, nLoads);
+		if (!status) {
+			tc->nTileReads += nLoads;
+			for (i = 0; i < nLoads; i++) {
+				GvrsTileCacheApplyLayout(tc, &loads[i].tile->data);
+			}
+		}
+	}
+	if (status) {
+		free(order);
+		freePinLoads(loads, nLoads);
+		return status;
+	}
+
+	// Install the tiles from least-recently used to most-recently used.
+	// Each installation returns a buffer that is no longer needed by the cache.
+	for (i = nLoads - 1; i >= 0; i--) {
+		GvrsTile* tile = order[i];
+		GvrsTileCacheInstallTile(tc, tile->tileIndex, tile->filePosition, &tile->data);
+		free(tile->data);
+		free(tile);
+	}
+	free(order);
+	free(loads);
+	if (nTilesLoaded) {
+		*nTilesLoaded = nLoads;
+	}
+	return 0;
+}
@@ -128,6 +128,11 @@ GvrsTileDirectoryRead(Gvrs* gvrs, int64_t filePosTileDirectory, GvrsTileDirector
 	if (status) {
 		return readFailed(td, status);
 	}
+	// the record sizes are obtained from the file as they are needed
+	td->recordSizes = calloc(nTilesInTable, sizeof(int32_t));
+	if (!td->recordSizes) {
+		return readFailed(td, GVRSERR_NOMEM);
+	}
 	*tileDirectoryReference = td;
 	return 0;
 }
@@ -143,6 +148,8 @@ GvrsTileDirectory* GvrsTileDirectoryFree(GvrsTileDirectory* tileDirectory) {
 			free(tileDirectory->lOffsets);
 			tileDirectory->lOffsets = 0;
 		}
+		free(tileDirectory->recordSizes);
+		tileDirectory->recordSizes = 0;
 		free(tileDirectory);
 	}
 	return 0;
@@ -151,19 +158,28 @@ GvrsTileDirectory* GvrsTileDirectoryFree(GvrsTileDirectory* tileDirectory) {
  
 
 
-int64_t GvrsTileDirectoryGetFilePosition(GvrsTileDirectory* tileDir, int tileIndex) {
+// Gets the index of the directory cell for a tile, or -1 if the tile
+// lies outside the region covered by the directory.
+static int getCellIndex(GvrsTileDirectory* tileDir, int tileIndex) {
 	int tileRow = tileIndex / tileDir->nColsOfTiles;
 	int tileCol = tileIndex % tileDir->nColsOfTiles;
 
 	if (tileRow < tileDir->row0 || tileCol < tileDir->col0) {
-		return 0;
+		return -1;
 	}
 	int iRow = tileRow - tileDir->row0;
 	int iCol = tileCol - tileDir->col0;
 	if (iRow >= tileDir->nRows || iCol >= tileDir->nCols) {
+		return -1;
+	}
+	return iRow * tileDir->nCols + iCol;
+}
+
+int64_t GvrsTileDirectoryGetFilePosition(GvrsTileDirectory* tileDir, int tileIndex) {
+	int offsetTableIndex = getCellIndex(tileDir, tileIndex);
+	if (offsetTableIndex < 0) {
 		return 0;
 	}
-	int offsetTableIndex = iRow * tileDir->nCols + iCol;
 	if (tileDir->iOffsets) {
 		int64_t t = (int64_t)(tileDir->iOffsets[offsetTableIndex]);
 		return t << 3;
@@ -179,6 +195,90 @@ int64_t GvrsTileDirectoryGetFilePosition(GvrsTileDirectory* tileDir, int tileInd
 }
 
 
+int32_t GvrsTileDirectoryGetRecordSize(GvrsTileDirectory* tileDir, int tileIndex) {
+	if (!tileDir) {
+		return 0;
+	}
+	int cellIndex = getCellIndex(tileDir, tileIndex);
+	if (cellIndex < 0 || !tileDir->recordSizes) {
+		return 0;
+	}
+	return tileDir->recordSizes[cellIndex];
+}
+
+
+void GvrsTileDirectorySetRecordSize(GvrsTileDirectory* tileDir, int tileIndex, int32_t recordSize) {
+	if (!tileDir) {
+		return;
+	}
+	int cellIndex = getCellIndex(tileDir, tileIndex);
+	if (cellIndex >= 0 && tileDir->recordSizes) {
+		tileDir->recordSizes[cellIndex] = recordSize;
+	}
+}
+
+
+typedef struct GvrsRecordRefTag {
+	int64_t filePos;
+	int cellIndex;
+}GvrsRecordRef;
+
+static int compareRecordRefs(const void* p1, const void* p2) {
+	int64_t a = ((const GvrsRecordRef*)p1)->filePos;
+	int64_t b = ((const GvrsRecordRef*)p2)->filePos;
+	return (a > b) - (a < b);
+}
+
+int GvrsTileDirectoryLoadRecordSizes(Gvrs* gvrs) {
+	GvrsTileDirectory* td = gvrs->tileDirectory;
+	if (!td || !td->recordSizes) {
+		return 0;
+	}
+	FILE* fp = gvrs->fp;
+	int n = td->nRows * td->nCols;
+	GvrsRecordRef* refs = malloc((size_t)n * sizeof(GvrsRecordRef));
+	if (!refs) {
+		return GVRSERR_NOMEM;
+	}
+	int i;
+	int nRefs = 0;
+	for (i = 0; i < n; i++) {
+		int64_t filePos = td->iOffsets ? ((int64_t)td->iOffsets[i]) << 3 : td->lOffsets[i];
+		if (filePos && !td->recordSizes[i]) {
+			refs[nRefs].filePos = filePos;
+			refs[nRefs].cellIndex = i;
+			nRefs++;
+		}
+	}
+	qsort(refs, (size_t)nRefs, sizeof(GvrsRecordRef), compareRecordRefs);
+
+	// the record header is the 8 bytes preceding the tile content:
+	// the record size (4 bytes), the record type (1 byte), and 3 reserved bytes.
+	int status = 0;
+	for (i = 0; i < nRefs; i++) {
+		int32_t recordSize;
+		uint8_t recordType;
+		status = GvrsSetFilePosition(fp, refs[i].filePos - 8);
+		if (!status) {
+			status = GvrsReadInt(fp, &recordSize);
+		}
+		if (!status) {
+			status = GvrsReadByte(fp, &recordType);
+		}
+		if (status) {
+			break;
+		}
+		if (recordType != (uint8_t)GvrsRecordTypeTile || recordSize <= 12) {
+			status = GVRSERR_INVALID_FILE;
+			break;
+		}
+		td->recordSizes[refs[i].cellIndex] = recordSize;
+	}
+	free(refs);
+	return status;
+}
+
+
 int GvrsTileDirectoryWrite(Gvrs* gvrs, int64_t* tileDirectoryPos) {
 	//int32_t row0;
 	//int32_t col0;
@@ -253,7 +353,7 @@ int GvrsTileDirectoryWrite(Gvrs* gvrs, int64_t* tileDirectoryPos) {
 }
 
 
-int GvrsTileDirectoryRegisterFilePosition(GvrsTileDirectory* td, int32_t tileIndex, int64_t filePosition) {
+int GvrsTileDirectoryRegisterFilePosition(GvrsTileDirectory* td, int32_t tileIndex, int64_t filePosition, int32_t recordSize) {
 	// Test for filePos greater than 32 GB threshold that is too big for iOffset and requires lOffset 
 	if (filePosition >= (1LL << 35) && td->iOffsets) {
 		// The "compact" representation stores file position in a 4-byte unsigned integer.
@@ -283,7 +383,12 @@ int GvrsTileDirectoryRegisterFilePosition(GvrsTileDirectory* td, int32_t tileInd
 		td->col0 = col;
 		td->row1 = row;
 		td->iOffsets = calloc(1, sizeof(uint32_t));
+		td->recordSizes = calloc(1, sizeof(int32_t));
+		if (!td->iOffsets || !td->recordSizes) {
+			return GVRSERR_NOMEM;
+		}
 		td->iOffsets[0] = (uint32_t)(filePosition >> 3);
+		td->recordSizes[0] = recordSize;
 	}
 	else {
 		int adjustmentNeeded = 0;
@@ -319,11 +424,16 @@ int GvrsTileDirectoryRegisterFilePosition(GvrsTileDirectory* td, int32_t tileInd
 			nRowsX = row1X - row0X + 1;
 			nColsX = col1X - col0X + 1;
 			int n = nRowsX * nColsX;
+			int32_t* xSizes = calloc(n, sizeof(int32_t));
+			if (!xSizes) {
+				return GVRSERR_NOMEM;
+			}
 			if (td->iOffsets) {
 				int iRow, iCol;
 				uint32_t* iOffsets = td->iOffsets;
 				uint32_t* xOffsets = calloc(n, sizeof(uint32_t));
 				if (!xOffsets) {
+					free(xSizes);
 					return GVRSERR_NOMEM;
 				}
 				// TO DO:  replace col loop with memmove?  memcpy?
@@ -342,6 +452,7 @@ int GvrsTileDirectoryRegisterFilePosition(GvrsTileDirectory* td, int32_t tileInd
 				int64_t* lOffsets = td->lOffsets;
 				int64_t* xOffsets = calloc(n, sizeof(int64_t));
 				if (!xOffsets) {
+					free(xSizes);
 					return GVRSERR_NOMEM;
 				}
 				// TO DO:  replace col loop with memmove?  memcpy?  
@@ -355,6 +466,15 @@ int GvrsTileDirectoryRegisterFilePosition(GvrsTileDirectory* td, int32_t tileInd
 				free(td->lOffsets);
 				td->lOffsets = xOffsets;
 			}
+			if (td->recordSizes) {
+				int iRow;
+				for (iRow = 0; iRow < nRows; iRow++) {
+					int xRowOffset = (iRow + row0 - row0X) * nColsX + (col0 - col0X);
+					memcpy(xSizes + xRowOffset, td->recordSizes + iRow * nCols, (size_t)nCols * sizeof(int32_t));
+				}
+				free(td->recordSizes);
+			}
+			td->recordSizes = xSizes;
 			td->row0 = row0X;
 			td->col0 = col0X;
 			td->row1 = row1X;
@@ -369,8 +489,66 @@ int GvrsTileDirectoryRegisterFilePosition(GvrsTileDirectory* td, int32_t tileInd
 		else {
 			td->lOffsets[index] = filePosition;
 		}
+		if (td->recordSizes) {
+			td->recordSizes[index] = recordSize;
+		}
 	}
 
 	return 0;
 
 }
+
+
+// Tile placement:
+//    The Morton key interleaves the bits of the tile column (even positions)
+// and tile row (odd positions).  The Hilbert key is computed over the smallest
+// power-of-two square that contains the grid of tiles.  Unlike the Morton curve,
+// the Hilbert curve has no long jumps between successive tiles, so a compact
+// region of the grid maps to fewer separate ranges of file positions.
+static int64_t mortonKey(uint32_t row, uint32_t col) {
+	int64_t key = 0;
+	int i;
+	for (i = 0; i < 32; i++) {
+		key |= (int64_t)((col >> i) & 1) << (2 * i);
+		key |= (int64_t)((row >> i) & 1) << (2 * i + 1);
+	}
+	return key;
+}
+
+static int64_t hilbertKey(uint32_t n, uint32_t x, uint32_t y) {
+	int64_t key = 0;
+	uint32_t s, t;
+	for (s = n / 2; s > 0; s /= 2) {
+		uint32_t rx = (x & s) ? 1 : 0;
+		uint32_t ry = (y & s) ? 1 : 0;
+		key += (int64_t)s * s * ((3 * rx) ^ ry);
+		// rotate the quadrant so that the curve within it has the standard orientation
+		if (ry == 0) {
+			if (rx == 1) {
+				x = n - 1 - x;
+				y = n - 1 - y;
+			}
+			t = x;
+			x = y;
+			y = t;
+		}
+	}
+	return key;
+}
+
+int64_t GvrsTilePlacementKey(GvrsTilePlacement tilePlacement, int nRowsOfTiles, int nColsOfTiles, int tileIndex) {
+	uint32_t row = (uint32_t)(tileIndex / nColsOfTiles);
+	uint32_t col = (uint32_t)(tileIndex - (int)row * nColsOfTiles);
+	uint32_t n = 1;
+	switch (tilePlacement) {
+	case GvrsTilePlacementMorton:
+		return mortonKey(row, col);
+	case GvrsTilePlacementHilbert:
+		while (n < (uint32_t)nRowsOfTiles || n < (uint32_t)nColsOfTiles) {
+			n *= 2;
+		}
+		return hilbertKey(n, col, row);
+	default:
+		return 0;
+	}
+}
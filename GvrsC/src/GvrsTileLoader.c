@@ -0,0 +1,518 @@
+/* --------------------------------------------------------------------
+ *
+ * The MIT License
+ *
+ * Copyright (C) 2024  Gary W. Lucas.
+
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ * ---------------------------------------------------------------------
+ */
+
+// Development Note:
+//    The loader thread has a reader clone of its own so that it never touches the
+// tile cache or file pointer of the foreground instance.  Requests pass through
+// three lists:  the queue (waiting for the loader), the request in progress,
+// and the completed list (decoded, waiting for installation).  Only the
+// foreground thread modifies the tile cache, so completed tiles are installed
+// by the foreground thread when it next misses the cache.  Installation exchanges
+// the data buffer of the request with that of the cache tile it replaces,
+// so no copying is required and the request keeps the old buffer for reuse.
+//    The request structures are recycled through a free list.  A set of requests
+// equal to the tile-cache size is allocated when the loader is started so that
+// the try-read functions do not need to allocate memory.
+
+#include "GvrsFramework.h"
+
+#include "GvrsPrimaryIo.h"
+#include "Gvrs.h"
+#include "GvrsInternal.h"
+#include "GvrsTileLoader.h"
+#include "GvrsError.h"
+
+typedef struct GvrsPreloadGroupTag {
+	int nRemaining;
+	int status;
+	GvrsPreloadCallback callback;
+	void* appData;
+}GvrsPreloadGroup;
+
+typedef struct GvrsLoadRequestTag {
+	struct GvrsLoadRequestTag* next;
+	int tileIndex;
+	int64_t filePos;
+	int status;
+	uint8_t* data;
+	GvrsPreloadGroup* group;
+}GvrsLoadRequest;
+
+typedef struct GvrsTileLoaderTag {
+	Gvrs* gvrs;    // the foreground instance
+	Gvrs* clone;   // the instance used by the loader thread
+	GvrsThread* thread;
+	GvrsMutex* mutex;
+	GvrsCondition* condition;
+	int stopRequested;
+
+	int maxPending;  // the limit for requests from the try-read functions
+	int nPending;    // the number of requests that are queued, in progress, or completed
+	int tileInProgress;
+	GvrsLoadRequest* queueHead;
+	GvrsLoadRequest* queueTail;
+	GvrsLoadRequest* completedHead;
+	GvrsLoadRequest* completedTail;
+	GvrsLoadRequest* freeList;
+}GvrsTileLoader;
+
+
+static void appendRequest(GvrsLoadRequest** head, GvrsLoadRequest** tail, GvrsLoadRequest* r) {
+	r->next = 0;
+	if (*tail) {
+		(*tail)->next = r;
+	}
+	else {
+		*head = r;
+	}
+	*tail = r;
+}
+
+static void freeRequests(GvrsLoadRequest* r) {
+	while (r) {
+		GvrsLoadRequest* next = r->next;
+		if (r->group && --r->group->nRemaining == 0) {
+			free(r->group);
+		}
+		free(r->data);
+		free(r);
+		r = next;
+	}
+}
+
+static int loadTile(GvrsTileLoader* loader, GvrsLoadRequest* r) {
+	Gvrs* clone = loader->clone;
+	int status = 0;
+	GvrsTile* tile = GvrsTileCacheFetchTile(clone->tileCache, r->tileIndex, &status);
+	if (!tile) {
+		// a tile that is not populated is not installed
+		r->filePos = 0;
+		return status;
+	}
+	if (!r->data) {
+		r->data = malloc(clone->nBytesForTileData);
+		if (!r->data) {
+			return GVRSERR_NOMEM;
+		}
+	}
+	memcpy(r->data, tile->data, clone->nBytesForTileData);
+	return 0;
+}
+
+static int runLoader(void* argument) {
+	GvrsTileLoader* loader = (GvrsTileLoader*)argument;
+	GvrsMutexLock(loader->mutex);
+	for (;;) {
+		while (!loader->stopRequested && !loader->queueHead) {
+			GvrsConditionWait(loader->condition, loader->mutex);
+		}
+		if (loader->stopRequested) {
+			break;
+		}
+		GvrsLoadRequest* r = loader->queueHead;
+		loader->queueHead = r->next;
+		if (!loader->queueHead) {
+			loader->queueTail = 0;
+		}
+		loader->tileInProgress = r->tileIndex;
+		GvrsMutexUnlock(loader->mutex);
+
+		r->status = loadTile(loader, r);
+
+		GvrsMutexLock(loader->mutex);
+		loader->tileInProgress = -1;
+		appendRequest(&loader->completedHead, &loader->completedTail, r);
+		GvrsPreloadGroup* group = r->group;
+		r->group = 0;
+		if (group) {
+			if (r->status && !group->status) {
+				group->status = r->status;
+			}
+			if (--group->nRemaining == 0) {
+				GvrsMutexUnlock(loader->mutex);
+				if (group->callback) {
+					group->callback(loader->gvrs, group->status, group->appData);
+				}
+				free(group);
+				GvrsMutexLock(loader->mutex);
+			}
+		}
+	}
+	GvrsMutexUnlock(loader->mutex);
+	return 0;
+}
+
+// Gets a request from the free list.  If the list is empty and allocation
+// is permitted, a new request is allocated.
+static GvrsLoadRequest* takeRequest(GvrsTileLoader* loader, int allowAllocation) {
+	GvrsLoadRequest* r = loader->freeList;
+	if (r) {
+		loader->freeList = r->next;
+	}
+	else if (allowAllocation) {
+		r = calloc(1, sizeof(GvrsLoadRequest));
+	}
+	if (r) {
+		r->next = 0;
+		r->status = 0;
+		r->group = 0;
+	}
+	return r;
+}
+
+static int isRequested(GvrsTileLoader* loader, int tileIndex) {
+	if (loader->tileInProgress == tileIndex) {
+		return 1;
+	}
+	GvrsLoadRequest* r;
+	for (r = loader->queueHead; r; r = r->next) {
+		if (r->tileIndex == tileIndex) {
+			return 1;
+		}
+	}
+	return 0;
+}
+
+
+GvrsTile* GvrsTileLoaderInstall(Gvrs* gvrs, int tileIndex, int* errCode) {
+	GvrsTileLoader* loader = (GvrsTileLoader*)gvrs->tileLoader;
+	GvrsTileCache* tc = gvrs->tileCache;
+	*errCode = 0;
+	if (!loader) {
+		return 0;
+	}
+
+	GvrsMutexLock(loader->mutex);
+	GvrsLoadRequest* completed = loader->completedHead;
+	loader->completedHead = 0;
+	loader->completedTail = 0;
+	GvrsMutexUnlock(loader->mutex);
+	if (!completed) {
+		return 0;
+	}
+
+	int nCompleted = 0;
+	GvrsLoadRequest* last = 0;
+	GvrsLoadRequest* r;
+	for (r = completed; r; r = r->next) {
+		nCompleted++;
+		last = r;
+		if (r->status) {
+			if (r->tileIndex == tileIndex) {
+				*errCode = r->status;
+			}
+		}
+		else if (r->filePos) {
+			GvrsTileCacheInstallTile(tc, r->tileIndex, r->filePos, &r->data);
+		}
+	}
+
+	GvrsMutexLock(loader->mutex);
+	last->next = loader->freeList;
+	loader->freeList = completed;
+	loader->nPending -= nCompleted;
+	GvrsMutexUnlock(loader->mutex);
+
+	if (*errCode || tileIndex < 0) {
+		return 0;
+	}
+	// the target tile is looked up after all installations are complete
+	// because it may have been displaced by one installed later.
+	return GvrsTileCacheLookup(tc, tileIndex);
+}
+
+
+int GvrsTileLoaderStart(Gvrs* gvrs) {
+	if (!gvrs) {
+		return GVRSERR_NULL_ARGUMENT;
+	}
+	if (gvrs->tileLoader) {
+		return 0;
+	}
+	if (gvrs->timeOpenedForWritingMS) {
+		return GVRSERR_INVALID_PARAMETER;
+	}
+	int status = GvrsLoadTileDirectory(gvrs);
+	if (status) {
+		return status;
+	}
+	GvrsTileCache* tc = gvrs->tileCache;
+	tc->tileDirectory = gvrs->tileDirectory;
+
+	GvrsTileLoader* loader = calloc(1, sizeof(GvrsTileLoader));
+	if (!loader) {
+		return GVRSERR_NOMEM;
+	}
+	loader->gvrs = gvrs;
+	loader->tileInProgress = -1;
+	loader->maxPending = tc->maxTileCacheSize;
+	int i;
+	for (i = 0; i < loader->maxPending; i++) {
+		GvrsLoadRequest* r = calloc(1, sizeof(GvrsLoadRequest));
+		if (!r) {
+			status = GVRSERR_NOMEM;
+			break;
+		}
+		r->next = loader->freeList;
+		loader->freeList = r;
+	}
+	if (!status) {
+		status = GvrsMutexInit(&loader->mutex);
+	}
+	if (!status) {
+		status = GvrsConditionInit(&loader->condition);
+	}
+	if (!status) {
+		status = GvrsOpenReaderClone(gvrs, &loader->clone);
+	}
+	if (!status) {
+		status = GvrsSetTileCacheSize(loader->clone, GvrsTileCacheSizeSmall);
+	}
+	if (!status) {
+		status = GvrsThreadStart(&loader->thread, runLoader, loader);
+	}
+	if (status) {
+		if (loader->clone) {
+			GvrsClose(loader->clone);
+		}
+		GvrsConditionFree(loader->condition);
+		GvrsMutexFree(loader->mutex);
+		freeRequests(loader->freeList);
+		free(loader);
+		return status;
+	}
+	gvrs->tileLoader = loader;
+	return 0;
+}
+
+
+int GvrsTileLoaderStop(Gvrs* gvrs) {
+	if (!gvrs) {
+		return GVRSERR_NULL_ARGUMENT;
+	}
+	GvrsTileLoader* loader = (GvrsTileLoader*)gvrs->tileLoader;
+	if (!loader) {
+		return 0;
+	}
+	gvrs->tileLoader = 0;
+	GvrsMutexLock(loader->mutex);
+	loader->stopRequested = 1;
+	GvrsConditionSignal(loader->condition);
+	GvrsMutexUnlock(loader->mutex);
+	int status = GvrsThreadJoin(loader->thread);
+
+	freeRequests(loader->queueHead);
+	freeRequests(loader->completedHead);
+	freeRequests(loader->freeList);
+	int closeStatus = GvrsClose(loader->clone);
+	GvrsConditionFree(loader->condition);
+	GvrsMutexFree(loader->mutex);
+	free(loader);
+	return status ? status : closeStatus;
+}
+
+
+int GvrsElementTryReadFloat(GvrsElement* element, int gridRow, int gridColumn, float* value) {
+	if (!element || !value) {
+		return GVRSERR_NULL_ARGUMENT;
+	}
+
+	GvrsTileCache* tc = (GvrsTileCache*)element->tileCache;
+	if ((unsigned int)gridRow >= tc->nRowsInRaster || (unsigned int)gridColumn >= tc->nColsInRaster) {
+		return GVRSERR_COORDINATE_OUT_OF_BOUNDS;
+	}
+	tc->nRasterReads++;
+
+	int nRowsInTile = tc->nRowsInTile;
+	int nColsInTile = tc->nColsInTile;
+	int tileRow = gridRow / nRowsInTile;
+	int tileCol = gridColumn / nColsInTile;
+	int tileIndex = tileRow * tc->nColsOfTiles + tileCol;
+	int indexInTile = GVRS_CELL_INDEX(tc, gridRow - tileRow * nRowsInTile, gridColumn - tileCol * nColsInTile);
+
+	GvrsTile* tile;
+	if (tc->firstTileIndex == tileIndex) {
+		tile = tc->firstTile;
+	}
+	else {
+		tile = GvrsTileCacheLookup(tc, tileIndex);
+	}
+	if (!tile) {
+		Gvrs* gvrs = element->gvrs;
+		int status;
+		if (!gvrs->tileLoader) {
+			status = GvrsTileLoaderStart(gvrs);
+			if (status) {
+				return status;
+			}
+		}
+		tile = GvrsTileLoaderInstall(gvrs, tileIndex, &status);
+		if (status) {
+			return status;
+		}
+		if (!tile) {
+			int64_t filePos = GvrsTileDirectoryGetFilePosition(tc->tileDirectory, tileIndex);
+			if (!filePos) {
+				*value = element->fillValueFloat;
+				return 0;
+			}
+			GvrsTileLoader* loader = (GvrsTileLoader*)gvrs->tileLoader;
+			GvrsMutexLock(loader->mutex);
+			if (loader->nPending < loader->maxPending && !isRequested(loader, tileIndex)) {
+				GvrsLoadRequest* r = takeRequest(loader, 0);
+				if (r) {
+					r->tileIndex = tileIndex;
+					r->filePos = filePos;
+					appendRequest(&loader->queueHead, &loader->queueTail, r);
+					loader->nPending++;
+					GvrsConditionSignal(loader->condition);
+				}
+			}
+			GvrsMutexUnlock(loader->mutex);
+			return GVRS_NOT_CACHED;
+		}
+	}
+
+	uint8_t* data = tile->data + element->dataOffset;
+	switch (element->elementType) {
+	case GvrsElementTypeInt:
+		*value = (float)(((int*)data)[indexInTile]);
+		return 0;
+	case GvrsElementTypeIntCodedFloat:
+	{
+		GvrsElementSpecIntCodedFloat s = element->elementSpec.intFloatSpec;
+		int i = ((int*)data)[indexInTile];
+		if (i == s.iFillValue) {
+			*value = s.fillValue;
+		}
+		else {
+			*value = (float)i * element->icfInverseScale + s.offset;
+		}
+	}
+	return 0;
+	case GvrsElementTypeFloat:
+		*value = ((float*)data)[indexInTile];
+		return 0;
+	case GvrsElementTypeShort:
+		*value = (float)(((short*)data)[indexInTile]);
+		return 0;
+	default:
+		*value = element->fillValueFloat;
+		return GVRSERR_FILE_ERROR;
+	}
+}
+
+
+int GvrsPreloadRegion(Gvrs* gvrs, int row0, int col0, int row1, int col1, GvrsPreloadCallback callback, void* appData) {
+	if (!gvrs) {
+		return GVRSERR_NULL_ARGUMENT;
+	}
+	if (row0 < 0 || col0 < 0 || row0 > row1 || col0 > col1
+		|| row1 >= gvrs->nRowsInRaster || col1 >= gvrs->nColsInRaster) {
+		return GVRSERR_COORDINATE_OUT_OF_BOUNDS;
+	}
+	int status = GvrsTileLoaderStart(gvrs);
+	if (status) {
+		return status;
+	}
+	GvrsTileLoader* loader = (GvrsTileLoader*)gvrs->tileLoader;
+	GvrsTileCache* tc = gvrs->tileCache;
+
+	// install any completed tiles so that they are not loaded a second time
+	GvrsTileLoaderInstall(gvrs, -1, &status);
+
+	int tileRow0 = row0 / gvrs->nRowsInTile;
+	int tileRow1 = row1 / gvrs->nRowsInTile;
+	int tileCol0 = col0 / gvrs->nColsInTile;
+	int tileCol1 = col1 / gvrs->nColsInTile;
+
+	// tiles beyond the capacity of the cache would displace one another when installed
+	int maxTiles = tc->maxTileCacheSize;
+
+	GvrsPreloadGroup* group = calloc(1, sizeof(GvrsPreloadGroup));
+	if (!group) {
+		return GVRSERR_NOMEM;
+	}
+	group->callback = callback;
+	group->appData = appData;
+
+	// assemble the requests in a local list before posting them so that the
+	// loader does not complete the group before all its requests are posted.
+	GvrsLoadRequest* head = 0;
+	GvrsLoadRequest* tail = 0;
+	int tileRow, tileCol;
+	for (tileRow = tileRow0; tileRow <= tileRow1 && group->nRemaining < maxTiles; tileRow++) {
+		for (tileCol = tileCol0; tileCol <= tileCol1 && group->nRemaining < maxTiles; tileCol++) {
+			int tileIndex = tileRow * gvrs->nColsOfTiles + tileCol;
+			if (GvrsTileCacheLookup(tc, tileIndex)) {
+				continue;
+			}
+			int64_t filePos = GvrsTileDirectoryGetFilePosition(tc->tileDirectory, tileIndex);
+			if (!filePos) {
+				continue;
+			}
+			GvrsMutexLock(loader->mutex);
+			GvrsLoadRequest* r = takeRequest(loader, 1);
+			GvrsMutexUnlock(loader->mutex);
+			if (!r) {
+				// freeing the requests also frees the group
+				if (head) {
+					freeRequests(head);
+				}
+				else {
+					free(group);
+				}
+				return GVRSERR_NOMEM;
+			}
+			r->tileIndex = tileIndex;
+			r->filePos = filePos;
+			r->group = group;
+			group->nRemaining++;
+			appendRequest(&head, &tail, r);
+		}
+	}
+
+	if (!head) {
+		free(group);
+		if (callback) {
+			callback(gvrs, 0, appData);
+		}
+		return 0;
+	}
+
+	GvrsMutexLock(loader->mutex);
+	if (loader->queueTail) {
+		loader->queueTail->next = head;
+	}
+	else {
+		loader->queueHead = head;
+	}
+	loader->queueTail = tail;
+	loader->nPending += group->nRemaining;
+	GvrsConditionSignal(loader->condition);
+	GvrsMutexUnlock(loader->mutex);
+	return 0;
+}
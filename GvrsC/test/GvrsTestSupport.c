@@ -0,0 +1,102 @@
+/* --------------------------------------------------------------------
+ *
+ * The MIT License
+ *
+ * Copyright (C) 2024  Gary W. Lucas.
+
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ * ---------------------------------------------------------------------
+ */
+
+#include "GvrsTestSupport.h"
+
+static int nChecks;
+static int nFailures;
+
+int GvrsTestCheck(int condition, const char* text, const char* file, int line) {
+	nChecks++;
+	if (!condition) {
+		nFailures++;
+		fprintf(stderr, "FAILED: %s (%s, line %d)\n", text, file, line);
+	}
+	return condition;
+}
+
+float GvrsTestValue(int row, int column) {
+	return (float)((row * 37 + column * 11) % 1009);
+}
+
+int GvrsTestCreateFile(const char* path, int nRows, int nColumns, int nRowsInTile, int nColumnsInTile, double x0, float bias) {
+	GvrsBuilder* builder;
+	GvrsElementSpec* spec;
+	Gvrs* gvrs;
+	int status = GvrsBuilderInit(&builder, nRows, nColumns);
+	if (status) {
+		return status;
+	}
+	GvrsBuilderSetTileSize(builder, nRowsInTile, nColumnsInTile);
+	GvrsBuilderSetCartesianCoordinates(builder, x0, 0, x0 + nColumns - 1, nRows - 1);
+	GvrsBuilderRegisterStandardDataCompressionCodecs(builder);
+	GvrsBuilderAddElementFloat(builder, "z", &spec);
+	status = GvrsBuilderOpenNewGvrs(builder, path, &gvrs);
+	GvrsBuilderFree(builder);
+	if (status) {
+		return status;
+	}
+	GvrsElement* z = GvrsGetElementByName(gvrs, "z");
+	for (int iRow = 0; iRow < nRows && !status; iRow++) {
+		for (int iCol = 0; iCol < nColumns && !status; iCol++) {
+			status = GvrsElementWriteFloat(z, iRow, iCol, GvrsTestValue(iRow, iCol) + bias);
+		}
+	}
+	if (status) {
+		GvrsClose(gvrs);
+		return status;
+	}
+	return GvrsClose(gvrs);
+}
+
+int GvrsTestCountMismatches(Gvrs* gvrs, int rowOffset, int colOffset, float bias) {
+	GvrsElement* z = GvrsGetElementByName(gvrs, "z");
+	if (!z) {
+		return -1;
+	}
+	int nMismatches = 0;
+	for (int iRow = 0; iRow < gvrs->nRowsInRaster; iRow++) {
+		for (int iCol = 0; iCol < gvrs->nColsInRaster; iCol++) {
+			float value;
+			if (GvrsElementReadFloat(z, iRow, iCol, &value)) {
+				return -1;
+			}
+			if (value != GvrsTestValue(iRow + rowOffset, iCol + colOffset) + bias) {
+				nMismatches++;
+			}
+		}
+	}
+	return nMismatches;
+}
+
+int GvrsTestFinish(const char* testName) {
+	if (nFailures) {
+		printf("%s: %d of %d checks failed\n", testName, nFailures, nChecks);
+		return 1;
+	}
+	printf("%s: %d checks passed\n", testName, nChecks);
+	return 0;
+}
@@ -0,0 +1,111 @@
+/* --------------------------------------------------------------------
+ *
+ * The MIT License
+ *
+ * Copyright (C) 2024  Gary W. Lucas.
+
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ * ---------------------------------------------------------------------
+ */
+
+#ifndef GVRS_TEST_SUPPORT_H
+#define GVRS_TEST_SUPPORT_H
+
+#include "GvrsFramework.h"
+#include "Gvrs.h"
+#include "GvrsBuilder.h"
+#include "GvrsError.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/**
+* Provides utilities shared by the test programs.  Each test program is registered
+* with CTest and is run in the build directory.  The test programs create small GVRS files
+* with names that begin with the name of the program so that they may be run concurrently.
+* The files have a single floating-point element named "z" populated with values
+* obtained from GvrsTestValue.
+*/
+
+/**
+* Evaluates a test condition.  If the condition is false, the failure is reported
+* with the text of the condition and its location in the test source.
+*/
+#define GVRS_TEST_CHECK(condition) GvrsTestCheck((condition), #condition, __FILE__, __LINE__)
+
+/**
+* Records the result of a test condition (see GVRS_TEST_CHECK).
+* @param condition non-zero if the test passed.
+* @param text the text of the condition.
+* @param file the source file for the test.
+* @param line the line number of the test.
+* @return the value of the condition.
+*/
+int GvrsTestCheck(int condition, const char* text, const char* file, int line);
+
+/**
+* Gets the value used to populate the cell at the specified row and column of a test file.
+* The values are integral, so they can be compared exactly after a round trip through
+* any of the codecs.
+* @param row the row of the cell.
+* @param column the column of the cell.
+* @return a floating-point value.
+*/
+float GvrsTestValue(int row, int column);
+
+/**
+* Creates a test file using Cartesian coordinates with a cell size of one unit.
+* Each cell is populated with GvrsTestValue(row, column) plus the specified bias.
+* @param path the path for the file; an existing file is replaced.
+* @param nRows the number of rows in the raster.
+* @param nColumns the number of columns in the raster.
+* @param nRowsInTile the number of rows in a tile.
+* @param nColumnsInTile the number of columns in a tile.
+* @param x0 the x coordinate of the first column; the y coordinate of the first row is zero.
+* @param bias a value to be added to the value for each cell.
+* @return if successful, zero; otherwise an error code.
+*/
+int GvrsTestCreateFile(const char* path, int nRows, int nColumns, int nRowsInTile, int nColumnsInTile, double x0, float bias);
+
+/**
+* Counts the cells of element "z" of a GVRS instance that do not match the values
+* of a test file.  The cell at (row, column) in the instance is compared to
+* GvrsTestValue(row + rowOffset, column + colOffset) plus the bias.
+* @param gvrs a valid instance.
+* @param rowOffset the row in the test file corresponding to the first row of the instance.
+* @param colOffset the column in the test file corresponding to the first column of the instance.
+* @param bias the bias that was used to create the test file.
+* @return the number of mismatched values; or -1 if the element could not be read.
+*/
+int GvrsTestCountMismatches(Gvrs* gvrs, int rowOffset, int colOffset, float bias);
+
+/**
+* Reports the outcome of a test program.
+* @param testName the name of the test program.
+* @return the exit code for the test program: zero if all checks passed; otherwise, one.
+*/
+int GvrsTestFinish(const char* testName);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
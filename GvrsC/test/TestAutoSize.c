@@ -0,0 +1,86 @@
+/* --------------------------------------------------------------------
+ *
+ * The MIT License
+ *
+ * Copyright (C) 2024  Gary W. Lucas.
+
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ * ---------------------------------------------------------------------
+ */
+
+// Tests the automatic sizing of the tile cache.  The raster is traversed
+// in column-major order, so each column of cells touches every row of tiles.
+// The cache grows until it holds a full column of tiles, subject to its ceiling.
+
+#include "GvrsTestSupport.h"
+#include "GvrsInternal.h"
+
+#define INPUT "TestAutoSize.gvrs"
+#define N_ROWS 200
+#define N_COLS 60
+
+static int readColumnMajor(Gvrs* gvrs) {
+	GvrsElement* z = GvrsGetElementByName(gvrs, "z");
+	int nMismatches = 0;
+	for (int iCol = 0; iCol < N_COLS; iCol++) {
+		for (int iRow = 0; iRow < N_ROWS; iRow++) {
+			float value;
+			if (GvrsElementReadFloat(z, iRow, iCol, &value) || value != GvrsTestValue(iRow, iCol)) {
+				nMismatches++;
+			}
+		}
+	}
+	return nMismatches;
+}
+
+int main(int argc, char* argv[]) {
+	Gvrs* gvrs;
+
+	// 20 rows of tiles and 6 columns of tiles
+	GVRS_TEST_CHECK(GvrsTestCreateFile(INPUT, N_ROWS, N_COLS, 10, 10, 0, 0) == 0);
+	if (!GVRS_TEST_CHECK(GvrsOpen(&gvrs, INPUT, "r") == 0)) {
+		return GvrsTestFinish("TestAutoSize");
+	}
+	GVRS_TEST_CHECK(GvrsSetTileCacheSize(gvrs, GvrsTileCacheSizeAutomatic) == 0);
+	GvrsTileCache* tc = gvrs->tileCache;
+	GVRS_TEST_CHECK(tc->automaticSize && tc->currentTileCacheSize < 20);
+	GVRS_TEST_CHECK(readColumnMajor(gvrs) == 0);
+	GVRS_TEST_CHECK(tc->currentTileCacheSize >= 20 && tc->currentTileCacheSize <= tc->maxTileCacheSize);
+	// once the cache holds a column of tiles, each tile is read only a few times
+	GVRS_TEST_CHECK(tc->nTileReads < 6 * 120);
+
+	// a ceiling smaller than a column of tiles limits the growth of the cache
+	GVRS_TEST_CHECK(GvrsSetTileCacheCeiling(gvrs, 12) == 0);
+	tc = gvrs->tileCache;
+	GVRS_TEST_CHECK(tc->automaticSize && tc->maxTileCacheSize == 12);
+	GVRS_TEST_CHECK(readColumnMajor(gvrs) == 0);
+	GVRS_TEST_CHECK(tc->currentTileCacheSize <= 12);
+
+	// the ceiling applies only to the automatic setting
+	GVRS_TEST_CHECK(GvrsSetTileCacheSize(gvrs, GvrsTileCacheSizeLarge) == 0);
+	tc = gvrs->tileCache;
+	GVRS_TEST_CHECK(!tc->automaticSize && tc->maxTileCacheSize == 20);
+
+	// error path
+	GVRS_TEST_CHECK(GvrsSetTileCacheCeiling(0, 12) == GVRSERR_NULL_ARGUMENT);
+
+	GvrsClose(gvrs);
+	remove(INPUT);
+	return GvrsTestFinish("TestAutoSize");
+}
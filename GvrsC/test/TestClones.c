@@ -0,0 +1,103 @@
+/* --------------------------------------------------------------------
+ *
+ * The MIT License
+ *
+ * Copyright (C) 2024  Gary W. Lucas.
+
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ * ---------------------------------------------------------------------
+ */
+
+// Tests reader clones and writer clones.  Two threads write disjoint halves
+// of a new file using the source instance and a writer clone.  The file is
+// then read using a reader clone.
+
+#include "GvrsTestSupport.h"
+#include "GvrsCrossPlatform.h"
+
+#define OUTPUT "TestClones.gvrs"
+#define N_ROWS 96
+#define N_COLS 80
+
+typedef struct WriterTaskTag {
+	Gvrs* gvrs;
+	int row0;
+	int row1;
+	int status;
+}WriterTask;
+
+static int writeRows(void* argument) {
+	WriterTask* task = (WriterTask*)argument;
+	GvrsElement* z = GvrsGetElementByName(task->gvrs, "z");
+	for (int iRow = task->row0; iRow < task->row1 && !task->status; iRow++) {
+		for (int iCol = 0; iCol < N_COLS && !task->status; iCol++) {
+			task->status = GvrsElementWriteFloat(z, iRow, iCol, GvrsTestValue(iRow, iCol));
+		}
+	}
+	return task->status;
+}
+
+int main(int argc, char* argv[]) {
+	GvrsBuilder* builder;
+	GvrsElementSpec* spec;
+	Gvrs* gvrs;
+	Gvrs* writer;
+	Gvrs* reader;
+	GvrsThread* thread;
+
+	GvrsBuilderInit(&builder, N_ROWS, N_COLS);
+	GvrsBuilderSetTileSize(builder, 16, 16);
+	GvrsBuilderRegisterStandardDataCompressionCodecs(builder);
+	GvrsBuilderAddElementFloat(builder, "z", &spec);
+	int status = GvrsBuilderOpenNewGvrs(builder, OUTPUT, &gvrs);
+	GvrsBuilderFree(builder);
+	if (!GVRS_TEST_CHECK(status == 0)) {
+		return GvrsTestFinish("TestClones");
+	}
+
+	// the tile rows written by the two threads are disjoint
+	GVRS_TEST_CHECK(GvrsOpenWriterClone(gvrs, &writer) == 0);
+	WriterTask sourceTask = { gvrs, 0, N_ROWS / 2, 0 };
+	WriterTask cloneTask = { writer, N_ROWS / 2, N_ROWS, 0 };
+	GVRS_TEST_CHECK(GvrsThreadStart(&thread, writeRows, &cloneTask) == 0);
+	writeRows(&sourceTask);
+	GVRS_TEST_CHECK(GvrsThreadJoin(thread) == 0);
+	GVRS_TEST_CHECK(sourceTask.status == 0 && cloneTask.status == 0);
+
+	// the source may not be closed while a writer clone is open
+	GVRS_TEST_CHECK(GvrsClose(gvrs) != 0);
+	GVRS_TEST_CHECK(GvrsClose(writer) == 0);
+	GVRS_TEST_CHECK(GvrsClose(gvrs) == 0);
+
+	// read the file through a reader clone, closing the source first
+	if (GVRS_TEST_CHECK(GvrsOpen(&gvrs, OUTPUT, "r") == 0)) {
+		GVRS_TEST_CHECK(GvrsOpenReaderClone(gvrs, &reader) == 0);
+		GVRS_TEST_CHECK(GvrsOpenWriterClone(gvrs, &writer) == GVRSERR_NOT_OPENED_FOR_WRITING);
+		GVRS_TEST_CHECK(GvrsClose(gvrs) == 0);
+		GVRS_TEST_CHECK(GvrsTestCountMismatches(reader, 0, 0, 0) == 0);
+		GVRS_TEST_CHECK(GvrsClose(reader) == 0);
+	}
+
+	// error paths
+	GVRS_TEST_CHECK(GvrsOpenReaderClone(0, &reader) == GVRSERR_NULL_ARGUMENT);
+	GVRS_TEST_CHECK(GvrsOpenWriterClone(0, &writer) == GVRSERR_NULL_ARGUMENT);
+
+	remove(OUTPUT);
+	return GvrsTestFinish("TestClones");
+}
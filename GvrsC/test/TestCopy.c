@@ -0,0 +1,86 @@
+/* --------------------------------------------------------------------
+ *
+ * The MIT License
+ *
+ * Copyright (C) 2024  Gary W. Lucas.
+
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ * ---------------------------------------------------------------------
+ */
+
+// Tests GvrsCopy and GvrsExtractSubset: a copy that transfers tile records as
+// stored, a copy that re-tiles the data, and the extraction of a subset.
+
+#include "GvrsTestSupport.h"
+
+#define SOURCE "TestCopy_source.gvrs"
+#define OUTPUT "TestCopy_output.gvrs"
+
+static void checkOutput(int rowOffset, int colOffset, int nRows, int nCols, int nRowsInTile, int nColsInTile) {
+	Gvrs* output;
+	if (!GVRS_TEST_CHECK(GvrsOpen(&output, OUTPUT, "r") == 0)) {
+		return;
+	}
+	GVRS_TEST_CHECK(output->nRowsInRaster == nRows && output->nColsInRaster == nCols);
+	GVRS_TEST_CHECK(output->nRowsInTile == nRowsInTile && output->nColsInTile == nColsInTile);
+	GVRS_TEST_CHECK(GvrsTestCountMismatches(output, rowOffset, colOffset, 0) == 0);
+	GvrsClose(output);
+}
+
+int main(int argc, char* argv[]) {
+	Gvrs* source;
+	GvrsCopyOptions options;
+
+	GVRS_TEST_CHECK(GvrsTestCreateFile(SOURCE, 100, 120, 20, 30, 0, 0) == 0);
+	if (!GVRS_TEST_CHECK(GvrsOpen(&source, SOURCE, "r") == 0)) {
+		return GvrsTestFinish("TestCopy");
+	}
+
+	// a copy with the tile size and codecs of the source transfers every tile as stored
+	GVRS_TEST_CHECK(GvrsCopyOptionsInit(source, &options) == 0);
+	GVRS_TEST_CHECK(GvrsCopy(source, OUTPUT, &options) == 0);
+	GVRS_TEST_CHECK(options.nTilesCopiedRaw == 20 && options.nTilesTranscoded == 0);
+	checkOutput(0, 0, 100, 120, 20, 30);
+
+	// a change of tile size requires the tiles to be decoded and re-tiled
+	GVRS_TEST_CHECK(GvrsCopyOptionsInit(source, &options) == 0);
+	options.nRowsInTile = 32;
+	options.nColsInTile = 32;
+	options.nThreads = 2;
+	GVRS_TEST_CHECK(GvrsCopy(source, OUTPUT, &options) == 0);
+	GVRS_TEST_CHECK(options.nTilesCopiedRaw == 0 && options.nTilesTranscoded > 0);
+	checkOutput(0, 0, 100, 120, 32, 32);
+
+	// a subset aligned with the tiles of the source transfers its interior tiles as stored
+	GVRS_TEST_CHECK(GvrsCopyOptionsInit(source, &options) == 0);
+	GVRS_TEST_CHECK(GvrsExtractSubset(source, 20, 30, 69, 109, OUTPUT, &options) == 0);
+	GVRS_TEST_CHECK(options.nTilesCopiedRaw > 0 && options.nTilesTranscoded > 0);
+	checkOutput(20, 30, 50, 80, 20, 30);
+
+	// error paths
+	GVRS_TEST_CHECK(GvrsCopy(source, SOURCE, 0) == GVRSERR_INVALID_PARAMETER);
+	GVRS_TEST_CHECK(GvrsExtractSubset(source, 20, 30, 100, 109, OUTPUT, 0) == GVRSERR_COORDINATE_OUT_OF_BOUNDS);
+	GVRS_TEST_CHECK(GvrsExtractSubset(source, 50, 30, 20, 109, OUTPUT, 0) == GVRSERR_COORDINATE_OUT_OF_BOUNDS);
+	GVRS_TEST_CHECK(GvrsCopy(source, 0, 0) == GVRSERR_NULL_ARGUMENT);
+
+	GvrsClose(source);
+	remove(SOURCE);
+	remove(OUTPUT);
+	return GvrsTestFinish("TestCopy");
+}
@@ -0,0 +1,86 @@
+/* --------------------------------------------------------------------
+ *
+ * The MIT License
+ *
+ * Copyright (C) 2024  Gary W. Lucas.
+
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ * ---------------------------------------------------------------------
+ */
+
+// Tests the handle pool: reuse of released handles, the limit on the number
+// of open handles, and the eviction of idle handles.
+
+#include "GvrsTestSupport.h"
+#include "GvrsHandlePool.h"
+
+#define FILE_A "TestHandlePool_a.gvrs"
+#define FILE_B "TestHandlePool_b.gvrs"
+#define FILE_C "TestHandlePool_c.gvrs"
+
+int main(int argc, char* argv[]) {
+	GvrsHandlePool* pool;
+	Gvrs* a;
+	Gvrs* b;
+	Gvrs* c;
+
+	GVRS_TEST_CHECK(GvrsTestCreateFile(FILE_A, 40, 50, 20, 25, 0, 0) == 0);
+	GVRS_TEST_CHECK(GvrsTestCreateFile(FILE_B, 40, 50, 20, 25, 0, 1) == 0);
+	GVRS_TEST_CHECK(GvrsTestCreateFile(FILE_C, 40, 50, 20, 25, 0, 2) == 0);
+	if (!GVRS_TEST_CHECK(GvrsHandlePoolAlloc(2, 0, &pool) == 0)) {
+		return GvrsTestFinish("TestHandlePool");
+	}
+
+	// a released handle is reused for the same path
+	if (GVRS_TEST_CHECK(GvrsHandlePoolAcquire(pool, FILE_A, &a) == 0)) {
+		GVRS_TEST_CHECK(GvrsTestCountMismatches(a, 0, 0, 0) == 0);
+		GVRS_TEST_CHECK(GvrsHandlePoolRelease(pool, a) == 0);
+	}
+	GVRS_TEST_CHECK(GvrsHandlePoolAcquire(pool, FILE_A, &a) == 0);
+	GVRS_TEST_CHECK(pool->nOpens == 1 && pool->nReuses == 1);
+
+	// when all the handles are in use, no more files can be opened
+	if (GVRS_TEST_CHECK(GvrsHandlePoolAcquire(pool, FILE_B, &b) == 0)) {
+		GVRS_TEST_CHECK(GvrsTestCountMismatches(b, 0, 0, 1) == 0);
+	}
+	GVRS_TEST_CHECK(GvrsHandlePoolAcquire(pool, FILE_C, &c) == GVRSERR_HANDLE_LIMIT);
+	GVRS_TEST_CHECK(pool->nOpenHandles == 2 && pool->nHandlesInUse == 2);
+
+	// releasing a handle lets the pool close it to open another file
+	GVRS_TEST_CHECK(GvrsHandlePoolRelease(pool, a) == 0);
+	if (GVRS_TEST_CHECK(GvrsHandlePoolAcquire(pool, FILE_C, &c) == 0)) {
+		GVRS_TEST_CHECK(GvrsTestCountMismatches(c, 0, 0, 2) == 0);
+		GVRS_TEST_CHECK(GvrsHandlePoolRelease(pool, c) == 0);
+	}
+	GVRS_TEST_CHECK(pool->nEvictions == 1 && pool->nOpenHandles == 2);
+	GVRS_TEST_CHECK(GvrsHandlePoolRelease(pool, b) == 0);
+	GVRS_TEST_CHECK(GvrsHandlePoolCloseIdle(pool, 0) == 2);
+	GVRS_TEST_CHECK(pool->nOpenHandles == 0);
+
+	// error paths
+	GVRS_TEST_CHECK(GvrsHandlePoolAcquire(pool, "TestHandlePool_missing.gvrs", &a) != 0);
+	GVRS_TEST_CHECK(pool->nHandlesInUse == 0);
+	GvrsHandlePoolFree(pool);
+	GVRS_TEST_CHECK(GvrsHandlePoolAlloc(0, 0, &pool) == GVRSERR_INVALID_PARAMETER);
+
+	remove(FILE_A);
+	remove(FILE_B);
+	remove(FILE_C);
+	return GvrsTestFinish("TestHandlePool");
+}
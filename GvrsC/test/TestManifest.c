@@ -0,0 +1,103 @@
+/* --------------------------------------------------------------------
+ *
+ * The MIT License
+ *
+ * Copyright (C) 2024  Gary W. Lucas.
+
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ * ---------------------------------------------------------------------
+ */
+
+// Tests the saving and loading of tile-cache manifests, both as separate
+// files and as metadata stored in the GVRS file.
+
+#include "GvrsTestSupport.h"
+#include "GvrsInternal.h"
+
+#define INPUT "TestManifest.gvrs"
+#define OTHER "TestManifest_other.gvrs"
+#define MANIFEST "TestManifest.manifest"
+
+// reads one cell from each of five tiles
+static int readTiles(Gvrs* gvrs) {
+	GvrsElement* z = GvrsGetElementByName(gvrs, "z");
+	int nMismatches = 0;
+	for (int i = 0; i < 5; i++) {
+		float value;
+		int row = i * 20 + 3;
+		int column = i * 10 + 7;
+		if (GvrsElementReadFloat(z, row, column, &value) || value != GvrsTestValue(row, column)) {
+			nMismatches++;
+		}
+	}
+	return nMismatches;
+}
+
+// opens the input file and restores its cache from a manifest
+static void checkLoad(const char* path) {
+	Gvrs* gvrs;
+	int nTilesLoaded = 0;
+	if (!GVRS_TEST_CHECK(GvrsOpen(&gvrs, INPUT, "r") == 0)) {
+		return;
+	}
+	GVRS_TEST_CHECK(GvrsLoadCacheManifest(gvrs, path, &nTilesLoaded) == 0);
+	GVRS_TEST_CHECK(nTilesLoaded == 5);
+	GvrsTileCache* tc = gvrs->tileCache;
+	int64_t nTileReads = tc->nTileReads;
+	GVRS_TEST_CHECK(readTiles(gvrs) == 0);
+	GVRS_TEST_CHECK(tc->nTileReads == nTileReads);
+	GvrsClose(gvrs);
+}
+
+int main(int argc, char* argv[]) {
+	Gvrs* gvrs;
+
+	GVRS_TEST_CHECK(GvrsTestCreateFile(INPUT, 100, 100, 10, 10, 0, 0) == 0);
+	GVRS_TEST_CHECK(GvrsTestCreateFile(OTHER, 100, 100, 10, 10, 0, 0) == 0);
+
+	// a manifest saved as a file
+	if (GVRS_TEST_CHECK(GvrsOpen(&gvrs, INPUT, "r") == 0)) {
+		GVRS_TEST_CHECK(readTiles(gvrs) == 0);
+		GVRS_TEST_CHECK(GvrsSaveCacheManifest(gvrs, MANIFEST) == 0);
+		GVRS_TEST_CHECK(GvrsSaveCacheManifest(gvrs, 0) == GVRSERR_NOT_OPENED_FOR_WRITING);
+		GvrsClose(gvrs);
+	}
+	checkLoad(MANIFEST);
+
+	// a manifest saved as metadata
+	if (GVRS_TEST_CHECK(GvrsOpen(&gvrs, INPUT, "rw") == 0)) {
+		GVRS_TEST_CHECK(readTiles(gvrs) == 0);
+		GVRS_TEST_CHECK(GvrsSaveCacheManifest(gvrs, 0) == 0);
+		GVRS_TEST_CHECK(GvrsLoadCacheManifest(gvrs, MANIFEST, 0) == GVRSERR_INVALID_PARAMETER);
+		GvrsClose(gvrs);
+	}
+	checkLoad(0);
+
+	// error paths: a manifest for another file, and a file without a manifest record
+	if (GVRS_TEST_CHECK(GvrsOpen(&gvrs, OTHER, "r") == 0)) {
+		GVRS_TEST_CHECK(GvrsLoadCacheManifest(gvrs, MANIFEST, 0) == GVRSERR_INVALID_PARAMETER);
+		GVRS_TEST_CHECK(GvrsLoadCacheManifest(gvrs, 0, 0) != 0);
+		GvrsClose(gvrs);
+	}
+
+	remove(INPUT);
+	remove(OTHER);
+	remove(MANIFEST);
+	return GvrsTestFinish("TestManifest");
+}
@@ -0,0 +1,110 @@
+/* --------------------------------------------------------------------
+ *
+ * The MIT License
+ *
+ * Copyright (C) 2024  Gary W. Lucas.
+
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ * ---------------------------------------------------------------------
+ */
+
+// Tests a mosaic of two files that lie side by side with a gap of ten columns
+// between them.  Values are read by grid cell, by coordinates, and by block.
+
+#include "GvrsTestSupport.h"
+#include "GvrsMosaic.h"
+#include <math.h>
+
+#define FILE_A "TestMosaic_a.gvrs"
+#define FILE_B "TestMosaic_b.gvrs"
+#define FILE_C "TestMosaic_c.gvrs"
+
+// the values expected for the mosaic grid.  File B starts at column 70.
+static float expected(int row, int column) {
+	if (column < 60) {
+		return GvrsTestValue(row, column);
+	}
+	if (column < 70) {
+		return NAN;
+	}
+	return GvrsTestValue(row, column - 70) + 1000;
+}
+
+static int sameValue(float a, float b) {
+	return a == b || (isnan(a) && isnan(b));
+}
+
+int main(int argc, char* argv[]) {
+	GvrsMosaic* mosaic;
+	float value;
+
+	GVRS_TEST_CHECK(GvrsTestCreateFile(FILE_A, 50, 60, 25, 20, 0, 0) == 0);
+	GVRS_TEST_CHECK(GvrsTestCreateFile(FILE_B, 50, 60, 25, 20, 70, 1000) == 0);
+	GVRS_TEST_CHECK(GvrsTestCreateFile(FILE_C, 50, 60, 25, 20, 0.5, 0) == 0);
+	if (!GVRS_TEST_CHECK(GvrsMosaicAlloc(0, "z", &mosaic) == 0)) {
+		return GvrsTestFinish("TestMosaic");
+	}
+	GVRS_TEST_CHECK(GvrsMosaicAddFile(mosaic, FILE_A) == 0);
+	GVRS_TEST_CHECK(GvrsMosaicAddFile(mosaic, FILE_B) == 0);
+	GVRS_TEST_CHECK(mosaic->nRowsInMosaic == 50 && mosaic->nColsInMosaic == 130);
+
+	int nMismatches = 0;
+	for (int iRow = 0; iRow < 50; iRow++) {
+		for (int iCol = 0; iCol < 130; iCol++) {
+			if (GvrsMosaicReadGridFloat(mosaic, iRow, iCol, &value) || !sameValue(value, expected(iRow, iCol))) {
+				nMismatches++;
+			}
+		}
+	}
+	GVRS_TEST_CHECK(nMismatches == 0);
+
+	// the grid and the coordinates share a cell size of one unit
+	GVRS_TEST_CHECK(GvrsMosaicReadFloat(mosaic, 85, 12, &value) == 0);
+	GVRS_TEST_CHECK(value == expected(12, 85));
+
+	// a block that spans both members, the gap, and the edge of the mosaic
+	float block[20 * 100];
+	GVRS_TEST_CHECK(GvrsMosaicReadBlock(mosaic, 40, 40, 20, 100, block) == 0);
+	nMismatches = 0;
+	for (int iRow = 0; iRow < 20; iRow++) {
+		for (int iCol = 0; iCol < 100; iCol++) {
+			int row = iRow + 40;
+			int column = iCol + 40;
+			float v = row < 50 && column < 130 ? expected(row, column) : NAN;
+			if (!sameValue(block[iRow * 100 + iCol], v)) {
+				nMismatches++;
+			}
+		}
+	}
+	GVRS_TEST_CHECK(nMismatches == 0);
+
+	// error paths
+	GVRS_TEST_CHECK(GvrsMosaicReadGridFloat(mosaic, 50, 0, &value) == GVRSERR_COORDINATE_OUT_OF_BOUNDS);
+	GVRS_TEST_CHECK(GvrsMosaicAddFile(mosaic, FILE_C) == GVRSERR_BAD_RASTER_SPECIFICATION);
+	GvrsMosaicFree(mosaic);
+	if (GVRS_TEST_CHECK(GvrsMosaicAlloc(0, "q", &mosaic) == 0)) {
+		GVRS_TEST_CHECK(GvrsMosaicAddFile(mosaic, FILE_A) == GVRSERR_ELEMENT_NOT_FOUND);
+		GvrsMosaicFree(mosaic);
+	}
+
+	remove(FILE_A);
+	remove(FILE_B);
+	remove(FILE_C);
+	return GvrsTestFinish("TestMosaic");
+}
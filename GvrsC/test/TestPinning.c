@@ -0,0 +1,93 @@
+/* --------------------------------------------------------------------
+ *
+ * The MIT License
+ *
+ * Copyright (C) 2024  Gary W. Lucas.
+
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ * ---------------------------------------------------------------------
+ */
+
+// Tests the pinning of tiles in memory.  Reads from a pinned region do not
+// access the file even when the tile cache is too small to hold the region.
+
+#include "GvrsTestSupport.h"
+#include "GvrsInternal.h"
+
+#define INPUT "TestPinning.gvrs"
+
+static int countRegionMismatches(GvrsElement* z, int row0, int col0, int row1, int col1) {
+	int nMismatches = 0;
+	for (int iRow = row0; iRow <= row1; iRow++) {
+		for (int iCol = col0; iCol <= col1; iCol++) {
+			float value;
+			if (GvrsElementReadFloat(z, iRow, iCol, &value) || value != GvrsTestValue(iRow, iCol)) {
+				nMismatches++;
+			}
+		}
+	}
+	return nMismatches;
+}
+
+int main(int argc, char* argv[]) {
+	Gvrs* gvrs;
+	int64_t nBytesPinned;
+
+	GVRS_TEST_CHECK(GvrsTestCreateFile(INPUT, 100, 100, 10, 10, 0, 0) == 0);
+	if (!GVRS_TEST_CHECK(GvrsOpen(&gvrs, INPUT, "r") == 0)) {
+		return GvrsTestFinish("TestPinning");
+	}
+	GvrsSetTileCacheSize(gvrs, GvrsTileCacheSizeSmall);
+	GvrsElement* z = GvrsGetElementByName(gvrs, "z");
+
+	// the region covers 25 tiles, more than the 4 tiles held by the small cache
+	GVRS_TEST_CHECK(GvrsPinRegion(gvrs, 0, 0, 49, 49, &nBytesPinned) == 0);
+	GVRS_TEST_CHECK(nBytesPinned >= 25 * 10 * 10 * 4);
+	GvrsTileCache* tc = gvrs->tileCache;
+	GVRS_TEST_CHECK(tc->nPinnedTiles == 25);
+	int64_t nTileReads = tc->nTileReads;
+	GVRS_TEST_CHECK(countRegionMismatches(z, 0, 0, 49, 49) == 0);
+	GVRS_TEST_CHECK(tc->nTileReads == nTileReads);
+
+	// changing the cache size retains the pins
+	GvrsSetTileCacheSize(gvrs, GvrsTileCacheSizeMedium);
+	tc = gvrs->tileCache;
+	GVRS_TEST_CHECK(tc->nPinnedTiles == 25);
+	GVRS_TEST_CHECK(countRegionMismatches(z, 0, 0, 99, 99) == 0);
+
+	// pins are nested
+	GVRS_TEST_CHECK(GvrsPinRegion(gvrs, 0, 0, 19, 19, 0) == 0);
+	GVRS_TEST_CHECK(GvrsUnpinRegion(gvrs, 0, 0, 49, 49, &nBytesPinned) == 0);
+	GVRS_TEST_CHECK(tc->nPinnedTiles == 4 && nBytesPinned > 0);
+	GVRS_TEST_CHECK(GvrsUnpinRegion(gvrs, 0, 0, 49, 49, &nBytesPinned) == 0);
+	GVRS_TEST_CHECK(tc->nPinnedTiles == 0 && nBytesPinned == 0);
+	GVRS_TEST_CHECK(countRegionMismatches(z, 0, 0, 49, 49) == 0);
+
+	// error paths
+	GVRS_TEST_CHECK(GvrsPinRegion(gvrs, 0, 0, 100, 49, 0) == GVRSERR_COORDINATE_OUT_OF_BOUNDS);
+	GVRS_TEST_CHECK(GvrsUnpinRegion(gvrs, 20, 0, 10, 49, 0) == GVRSERR_COORDINATE_OUT_OF_BOUNDS);
+	GvrsClose(gvrs);
+	if (GVRS_TEST_CHECK(GvrsOpen(&gvrs, INPUT, "rw") == 0)) {
+		GVRS_TEST_CHECK(GvrsPinRegion(gvrs, 0, 0, 9, 9, 0) == GVRSERR_INVALID_PARAMETER);
+		GvrsClose(gvrs);
+	}
+
+	remove(INPUT);
+	return GvrsTestFinish("TestPinning");
+}
@@ -0,0 +1,93 @@
+/* --------------------------------------------------------------------
+ *
+ * The MIT License
+ *
+ * Copyright (C) 2024  Gary W. Lucas.
+
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ * ---------------------------------------------------------------------
+ */
+
+// Tests read-ahead for tiles that are read in the order in which they are stored.
+
+#include "GvrsTestSupport.h"
+#include "GvrsInternal.h"
+
+#define INPUT "TestReadAhead.gvrs"
+
+// reads one cell from each tile in the order in which the tiles are stored
+// and reports the number of tiles that were obtained from a read-ahead block.
+// Then verifies the values of all cells.
+static int64_t readWithReadAhead(int nBytes) {
+	Gvrs* gvrs;
+	if (!GVRS_TEST_CHECK(GvrsOpen(&gvrs, INPUT, "r") == 0)) {
+		return -1;
+	}
+	GVRS_TEST_CHECK(GvrsSetReadAhead(gvrs, nBytes) == 0);
+	GVRS_TEST_CHECK(GvrsLoadTileDirectory(gvrs) == 0);
+	GvrsElement* z = GvrsGetElementByName(gvrs, "z");
+	int nTiles = gvrs->nRowsOfTiles * gvrs->nColsOfTiles;
+	int64_t priorPosition = 0;
+	for (int k = 0; k < nTiles; k++) {
+		// find the tile stored after the prior one
+		int next = -1;
+		int64_t nextPosition = INT64_MAX;
+		for (int i = 0; i < nTiles; i++) {
+			int64_t position = GvrsTileDirectoryGetFilePosition(gvrs->tileDirectory, i);
+			if (position > priorPosition && position < nextPosition) {
+				next = i;
+				nextPosition = position;
+			}
+		}
+		float value;
+		int row = (next / gvrs->nColsOfTiles) * gvrs->nRowsInTile;
+		int column = (next % gvrs->nColsOfTiles) * gvrs->nColsInTile;
+		GVRS_TEST_CHECK(next >= 0 && GvrsElementReadFloat(z, row, column, &value) == 0);
+		priorPosition = nextPosition;
+	}
+	GvrsTileCache* tc = gvrs->tileCache;
+	int64_t nHits = tc->nReadAheadHits;
+	GVRS_TEST_CHECK(tc->nTileReads == nTiles);
+	// the first tile is read individually, every later tile either fills a block or is found in it
+	GVRS_TEST_CHECK(nHits == 0 || nHits + tc->nReadAheadFills == nTiles - 1);
+	GVRS_TEST_CHECK(GvrsTestCountMismatches(gvrs, 0, 0, 0) == 0);
+	GvrsClose(gvrs);
+	return nHits;
+}
+
+int main(int argc, char* argv[]) {
+	// 48 tiles of 1600 bytes each (before compression)
+	GVRS_TEST_CHECK(GvrsTestCreateFile(INPUT, 120, 160, 20, 20, 0, 0) == 0);
+
+	// the whole file fits in one default-sized block
+	GVRS_TEST_CHECK(readWithReadAhead(GVRS_READ_AHEAD_DEFAULT_SIZE) == 46);
+	// a size smaller than a tile is enlarged
+	GVRS_TEST_CHECK(readWithReadAhead(16) > 0);
+	GVRS_TEST_CHECK(readWithReadAhead(0) == 0);
+
+	// error path
+	Gvrs* gvrs;
+	if (GVRS_TEST_CHECK(GvrsOpen(&gvrs, INPUT, "r") == 0)) {
+		GVRS_TEST_CHECK(GvrsSetReadAhead(gvrs, -1) == GVRSERR_INVALID_PARAMETER);
+		GvrsClose(gvrs);
+	}
+
+	remove(INPUT);
+	return GvrsTestFinish("TestReadAhead");
+}
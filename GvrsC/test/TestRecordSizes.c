@@ -0,0 +1,86 @@
+/* --------------------------------------------------------------------
+ *
+ * The MIT License
+ *
+ * Copyright (C) 2024  Gary W. Lucas.
+
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ * ---------------------------------------------------------------------
+ */
+
+// Tests the retention of tile record sizes, both when they are loaded in advance
+// and when they are learned as tiles are read.
+
+#include "GvrsTestSupport.h"
+#include "GvrsInternal.h"
+
+#define INPUT "TestRecordSizes.gvrs"
+
+int main(int argc, char* argv[]) {
+	Gvrs* gvrs;
+	Gvrs* clone;
+
+	GVRS_TEST_CHECK(GvrsTestCreateFile(INPUT, 90, 100, 30, 20, 0, 0) == 0);
+	if (!GVRS_TEST_CHECK(GvrsOpen(&gvrs, INPUT, "r") == 0)) {
+		return GvrsTestFinish("TestRecordSizes");
+	}
+
+	// the size of a record becomes known when its tile is read
+	GVRS_TEST_CHECK(GvrsLoadTileDirectory(gvrs) == 0);
+	GvrsTileDirectory* td = gvrs->tileDirectory;
+	int nTiles = gvrs->nRowsOfTiles * gvrs->nColsOfTiles;
+	GVRS_TEST_CHECK(GvrsTileDirectoryGetRecordSize(td, 0) == 0);
+	GvrsElement* z = GvrsGetElementByName(gvrs, "z");
+	float value;
+	GVRS_TEST_CHECK(GvrsElementReadFloat(z, 0, 0, &value) == 0);
+	int32_t learnedSize = GvrsTileDirectoryGetRecordSize(td, 0);
+	GVRS_TEST_CHECK(learnedSize > 0);
+
+	// loading the sizes obtains all of them, and the records do not overlap
+	GVRS_TEST_CHECK(GvrsLoadTileRecordSizes(gvrs) == 0);
+	GVRS_TEST_CHECK(GvrsTileDirectoryGetRecordSize(td, 0) == learnedSize);
+	int nOverlaps = 0;
+	for (int i = 0; i < nTiles; i++) {
+		int64_t position = GvrsTileDirectoryGetFilePosition(td, i);
+		int32_t size = GvrsTileDirectoryGetRecordSize(td, i);
+		GVRS_TEST_CHECK(position > 0 && size > 0);
+		for (int j = 0; j < nTiles; j++) {
+			int64_t p = GvrsTileDirectoryGetFilePosition(td, j);
+			if (j != i && p >= position && p < position + size) {
+				nOverlaps++;
+			}
+		}
+	}
+	GVRS_TEST_CHECK(nOverlaps == 0);
+
+	// clones share the sizes and read the tiles using them
+	if (GVRS_TEST_CHECK(GvrsOpenReaderClone(gvrs, &clone) == 0)) {
+		GVRS_TEST_CHECK(clone->tileDirectory == td);
+		GVRS_TEST_CHECK(GvrsTestCountMismatches(clone, 0, 0, 0) == 0);
+		GvrsClose(clone);
+	}
+	GVRS_TEST_CHECK(GvrsTestCountMismatches(gvrs, 0, 0, 0) == 0);
+
+	// error path
+	GVRS_TEST_CHECK(GvrsLoadTileRecordSizes(0) == GVRSERR_NULL_ARGUMENT);
+
+	GvrsClose(gvrs);
+	remove(INPUT);
+	return GvrsTestFinish("TestRecordSizes");
+}
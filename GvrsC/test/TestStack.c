@@ -0,0 +1,117 @@
+/* --------------------------------------------------------------------
+ *
+ * The MIT License
+ *
+ * Copyright (C) 2024  Gary W. Lucas.
+
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ * ---------------------------------------------------------------------
+ */
+
+// Tests a stack of three files.  The value for a grid cell in each member
+// is the test value plus 100 times the index of the member.
+
+#include "GvrsTestSupport.h"
+#include "GvrsStack.h"
+
+#define N_MEMBERS 3
+#define N_ROWS 60
+#define N_COLS 70
+#define OUTPUT "TestStack_output.gvrs"
+#define OTHER "TestStack_other.gvrs"
+
+static void memberPath(int index, char* path, size_t pathSize) {
+	snprintf(path, pathSize, "TestStack_%d.gvrs", index);
+}
+
+int main(int argc, char* argv[]) {
+	GvrsStack* stack;
+	char path[64];
+	float values[N_MEMBERS];
+
+	if (!GVRS_TEST_CHECK(GvrsStackAlloc(0, "z", &stack) == 0)) {
+		return GvrsTestFinish("TestStack");
+	}
+	stack->nThreads = 2;
+	for (int i = 0; i < N_MEMBERS; i++) {
+		memberPath(i, path, sizeof(path));
+		GVRS_TEST_CHECK(GvrsTestCreateFile(path, N_ROWS, N_COLS, 20, 35, 0, 100.0f * i) == 0);
+		GVRS_TEST_CHECK(GvrsStackAddFile(stack, path) == 0);
+	}
+	GVRS_TEST_CHECK(stack->nMembers == N_MEMBERS);
+
+	int nMismatches = 0;
+	for (int iRow = 0; iRow < N_ROWS; iRow += 7) {
+		for (int iCol = 0; iCol < N_COLS; iCol += 5) {
+			if (GvrsStackReadSeries(stack, iRow, iCol, 0, N_MEMBERS, values)) {
+				nMismatches++;
+				continue;
+			}
+			for (int t = 0; t < N_MEMBERS; t++) {
+				if (values[t] != GvrsTestValue(iRow, iCol) + 100.0f * t) {
+					nMismatches++;
+				}
+			}
+		}
+	}
+	GVRS_TEST_CHECK(nMismatches == 0);
+
+	// a block for the last two members, spanning several tiles
+	float block[25 * 40 * 2];
+	GVRS_TEST_CHECK(GvrsStackReadBlock(stack, 10, 20, 25, 40, 1, 2, block) == 0);
+	nMismatches = 0;
+	for (int iRow = 0; iRow < 25; iRow++) {
+		for (int iCol = 0; iCol < 40; iCol++) {
+			for (int t = 0; t < 2; t++) {
+				if (block[(iRow * 40 + iCol) * 2 + t] != GvrsTestValue(iRow + 10, iCol + 20) + 100.0f * (t + 1)) {
+					nMismatches++;
+				}
+			}
+		}
+	}
+	GVRS_TEST_CHECK(nMismatches == 0);
+
+	// transcode the stack and read the series back from the output
+	GVRS_TEST_CHECK(GvrsStackTranscode(stack, OUTPUT, GvrsStackLayoutInterleavedPlanes, 1) == 0);
+	Gvrs* output;
+	if (GVRS_TEST_CHECK(GvrsOpen(&output, OUTPUT, "r") == 0)) {
+		GvrsStackLayoutSpec spec;
+		GVRS_TEST_CHECK(GvrsStackReadLayout(output, &spec) == 0);
+		GVRS_TEST_CHECK(spec.nTimes == N_MEMBERS && spec.nRowsInRaster == N_ROWS && spec.nColsInRaster == N_COLS);
+		GVRS_TEST_CHECK(GvrsStackReadTranscodedSeries(output, &spec, 45, 66, 0, N_MEMBERS, values) == 0);
+		GVRS_TEST_CHECK(values[0] == GvrsTestValue(45, 66) && values[2] == GvrsTestValue(45, 66) + 200);
+		GvrsClose(output);
+	}
+
+	// error paths
+	GVRS_TEST_CHECK(GvrsStackReadSeries(stack, N_ROWS, 0, 0, N_MEMBERS, values) == GVRSERR_COORDINATE_OUT_OF_BOUNDS);
+	GVRS_TEST_CHECK(GvrsStackReadSeries(stack, 0, 0, 1, N_MEMBERS, values) == GVRSERR_COORDINATE_OUT_OF_BOUNDS);
+	GVRS_TEST_CHECK(GvrsTestCreateFile(OTHER, N_ROWS, N_COLS + 1, 20, 35, 0, 0) == 0);
+	GVRS_TEST_CHECK(GvrsStackAddFile(stack, OTHER) == GVRSERR_BAD_RASTER_SPECIFICATION);
+	GVRS_TEST_CHECK(stack->nMembers == N_MEMBERS);
+	GvrsStackFree(stack);
+
+	for (int i = 0; i < N_MEMBERS; i++) {
+		memberPath(i, path, sizeof(path));
+		remove(path);
+	}
+	remove(OUTPUT);
+	remove(OTHER);
+	return GvrsTestFinish("TestStack");
+}
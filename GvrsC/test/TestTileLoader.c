@@ -0,0 +1,107 @@
+/* --------------------------------------------------------------------
+ *
+ * The MIT License
+ *
+ * Copyright (C) 2024  Gary W. Lucas.
+
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ * ---------------------------------------------------------------------
+ */
+
+// Tests the background tile loader: non-blocking reads that queue tiles
+// for loading and the preloading of a region.
+
+#include "GvrsTestSupport.h"
+#include "GvrsTileLoader.h"
+#include "GvrsCrossPlatform.h"
+
+#define INPUT "TestTileLoader.gvrs"
+
+typedef struct PreloadResultTag {
+	GvrsMutex* mutex;
+	GvrsCondition* condition;
+	int done;
+	int status;
+}PreloadResult;
+
+static void preloadComplete(Gvrs* gvrs, int status, void* appData) {
+	PreloadResult* result = (PreloadResult*)appData;
+	GvrsMutexLock(result->mutex);
+	result->done = 1;
+	result->status = status;
+	GvrsConditionSignal(result->condition);
+	GvrsMutexUnlock(result->mutex);
+}
+
+int main(int argc, char* argv[]) {
+	Gvrs* gvrs;
+	float value;
+
+	GVRS_TEST_CHECK(GvrsTestCreateFile(INPUT, 120, 120, 20, 20, 0, 0) == 0);
+	if (!GVRS_TEST_CHECK(GvrsOpen(&gvrs, INPUT, "r") == 0)) {
+		return GvrsTestFinish("TestTileLoader");
+	}
+	GvrsSetTileCacheSize(gvrs, GvrsTileCacheSizeExtraLarge);
+	GvrsElement* z = GvrsGetElementByName(gvrs, "z");
+	GVRS_TEST_CHECK(GvrsTileLoaderStart(gvrs) == 0);
+
+	// a cell in a tile that is not in memory is queued and obtained once the tile is loaded
+	GVRS_TEST_CHECK(GvrsElementTryReadFloat(z, 5, 5, &value) == GVRS_NOT_CACHED);
+	int status;
+	int64_t timeLimit = GvrsTimeMS() + 10000;
+	while ((status = GvrsElementTryReadFloat(z, 5, 5, &value)) == GVRS_NOT_CACHED && GvrsTimeMS() < timeLimit);
+	GVRS_TEST_CHECK(status == 0 && value == GvrsTestValue(5, 5));
+
+	// preload a region of six tiles; after the callback all its cells are obtained without waiting
+	PreloadResult result;
+	memset(&result, 0, sizeof(result));
+	GvrsMutexInit(&result.mutex);
+	GvrsConditionInit(&result.condition);
+	GVRS_TEST_CHECK(GvrsPreloadRegion(gvrs, 60, 0, 99, 59, preloadComplete, &result) == 0);
+	GvrsMutexLock(result.mutex);
+	while (!result.done) {
+		GvrsConditionWait(result.condition, result.mutex);
+	}
+	GvrsMutexUnlock(result.mutex);
+	GVRS_TEST_CHECK(result.status == 0);
+	int nMismatches = 0;
+	for (int iRow = 60; iRow <= 99; iRow++) {
+		for (int iCol = 0; iCol <= 59; iCol++) {
+			if (GvrsElementTryReadFloat(z, iRow, iCol, &value) || value != GvrsTestValue(iRow, iCol)) {
+				nMismatches++;
+			}
+		}
+	}
+	GVRS_TEST_CHECK(nMismatches == 0);
+
+	// error paths
+	GVRS_TEST_CHECK(GvrsPreloadRegion(gvrs, 60, 0, 120, 59, 0, 0) == GVRSERR_COORDINATE_OUT_OF_BOUNDS);
+	GVRS_TEST_CHECK(GvrsElementTryReadFloat(z, 120, 0, &value) == GVRSERR_COORDINATE_OUT_OF_BOUNDS);
+	GVRS_TEST_CHECK(GvrsTileLoaderStop(gvrs) == 0);
+	GVRS_TEST_CHECK(GvrsClose(gvrs) == 0);
+	if (GVRS_TEST_CHECK(GvrsOpen(&gvrs, INPUT, "rw") == 0)) {
+		GVRS_TEST_CHECK(GvrsTileLoaderStart(gvrs) == GVRSERR_INVALID_PARAMETER);
+		GvrsClose(gvrs);
+	}
+
+	GvrsConditionFree(result.condition);
+	GvrsMutexFree(result.mutex);
+	remove(INPUT);
+	return GvrsTestFinish("TestTileLoader");
+}
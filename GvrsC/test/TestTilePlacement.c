@@ -0,0 +1,114 @@
+/* --------------------------------------------------------------------
+ *
+ * The MIT License
+ *
+ * Copyright (C) 2024  Gary W. Lucas.
+
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ * ---------------------------------------------------------------------
+ */
+
+// Tests the tile placement options for GvrsCopy.  The sequential placement
+// keeps the order of the tile records in the source file.  When a space-filling
+// curve is specified, the four tiles of the 2-by-2 block at the start of the grid
+// precede all other tiles in the output file.
+
+#include "GvrsTestSupport.h"
+#include "GvrsInternal.h"
+
+#define SOURCE "TestTilePlacement_source.gvrs"
+#define OUTPUT "TestTilePlacement_output.gvrs"
+
+static void checkPlacement(Gvrs* source, GvrsTilePlacement placement) {
+	GvrsCopyOptions options;
+	Gvrs* output;
+	GVRS_TEST_CHECK(GvrsCopyOptionsInit(source, &options) == 0);
+	options.tilePlacement = placement;
+	GVRS_TEST_CHECK(GvrsCopy(source, OUTPUT, &options) == 0);
+	if (!GVRS_TEST_CHECK(GvrsOpen(&output, OUTPUT, "r") == 0)) {
+		return;
+	}
+	GVRS_TEST_CHECK(GvrsTestCountMismatches(output, 0, 0, 0) == 0);
+	GVRS_TEST_CHECK(GvrsLoadTileDirectory(output) == 0);
+
+	// compare the order of each pair of tiles in the output to their order in the source.
+	GvrsTileDirectory* sd = source->tileDirectory;
+	GvrsTileDirectory* td = output->tileDirectory;
+	int nTiles = output->nRowsOfTiles * output->nColsOfTiles;
+	int nOrderChanges = 0;
+	for (int i = 0; i < nTiles; i++) {
+		for (int j = i + 1; j < nTiles; j++) {
+			int sourceOrder = GvrsTileDirectoryGetFilePosition(sd, i) < GvrsTileDirectoryGetFilePosition(sd, j);
+			int outputOrder = GvrsTileDirectoryGetFilePosition(td, i) < GvrsTileDirectoryGetFilePosition(td, j);
+			if (sourceOrder != outputOrder) {
+				nOrderChanges++;
+			}
+		}
+	}
+
+	// find the last position of the tiles in the first 2-by-2 block
+	// and the first position of the others.
+	int64_t blockLast = 0;
+	int64_t othersFirst = INT64_MAX;
+	for (int tileRow = 0; tileRow < output->nRowsOfTiles; tileRow++) {
+		for (int tileCol = 0; tileCol < output->nColsOfTiles; tileCol++) {
+			int64_t position = GvrsTileDirectoryGetFilePosition(td, tileRow * output->nColsOfTiles + tileCol);
+			GVRS_TEST_CHECK(position > 0);
+			if (tileRow < 2 && tileCol < 2) {
+				if (position > blockLast) {
+					blockLast = position;
+				}
+			}
+			else if (position < othersFirst) {
+				othersFirst = position;
+			}
+		}
+	}
+	if (placement == GvrsTilePlacementSequential) {
+		GVRS_TEST_CHECK(nOrderChanges == 0);
+	}
+	else {
+		GVRS_TEST_CHECK(blockLast < othersFirst);
+	}
+	GvrsClose(output);
+}
+
+int main(int argc, char* argv[]) {
+	Gvrs* source;
+	GvrsCopyOptions options;
+
+	GVRS_TEST_CHECK(GvrsTestCreateFile(SOURCE, 64, 64, 16, 16, 0, 0) == 0);
+	if (!GVRS_TEST_CHECK(GvrsOpen(&source, SOURCE, "r") == 0)) {
+		return GvrsTestFinish("TestTilePlacement");
+	}
+	GVRS_TEST_CHECK(GvrsLoadTileDirectory(source) == 0);
+	checkPlacement(source, GvrsTilePlacementSequential);
+	checkPlacement(source, GvrsTilePlacementMorton);
+	checkPlacement(source, GvrsTilePlacementHilbert);
+
+	// error path
+	GVRS_TEST_CHECK(GvrsCopyOptionsInit(source, &options) == 0);
+	options.tilePlacement = (GvrsTilePlacement)7;
+	GVRS_TEST_CHECK(GvrsCopy(source, OUTPUT, &options) == GVRSERR_INVALID_PARAMETER);
+
+	GvrsClose(source);
+	remove(SOURCE);
+	remove(OUTPUT);
+	return GvrsTestFinish("TestTilePlacement");
+}